@@ -0,0 +1,170 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define WARMUP_NS       50000000ULL  /* Per benchmark          */
+#define SAMPLE_NS        2000000ULL  /* Duration of one sample */
+#define SAMPLES_DEFAULT  51
+#define SAMPLES_MAX      1001
+
+volatile uint64_t  bench_sink = 0;
+
+static const char *filter  = NULL;
+static int         samples = SAMPLES_DEFAULT;
+
+
+static uint64_t
+now_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int
+cmp_double (const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+static double
+percentile (double *sorted, int n, int p)
+{
+    return sorted[((n - 1) * p) / 100];
+}
+
+/* Times a benchmark and prints a line with its ns/op percentiles and
+ * throughput. The batch size is calibrated so that each sample lasts
+ * about SAMPLE_NS, which keeps the clock overhead out of the figures.
+ */
+void
+bench_run (bench_t *bench)
+{
+    int      i;
+    uint64_t t0, elapsed;
+    uint64_t iterations = 1;
+    double   ns[SAMPLES_MAX];
+    double   p50;
+
+    if ((filter != NULL) && (strstr (bench->name, filter) == NULL)) {
+        return;
+    }
+
+    /* Calibration
+     */
+    while (true) {
+        t0 = now_ns();
+        bench->func (bench->param, iterations);
+        elapsed = now_ns() - t0;
+
+        if (elapsed >= SAMPLE_NS / 8) {
+            iterations = MAX (1, (iterations * SAMPLE_NS) / MAX (elapsed, 1));
+            break;
+        }
+        iterations *= 2;
+    }
+
+    /* Warmup
+     */
+    t0 = now_ns();
+    while (now_ns() - t0 < WARMUP_NS) {
+        bench->func (bench->param, iterations);
+    }
+
+    /* Samples
+     */
+    for (i = 0; i < samples; i++) {
+        t0 = now_ns();
+        bench->func (bench->param, iterations);
+        elapsed = now_ns() - t0;
+
+        ns[i] = (double)elapsed / iterations;
+    }
+
+    qsort (ns, samples, sizeof(double), cmp_double);
+    p50 = percentile (ns, samples, 50);
+
+    printf ("%-36s %9.1f ns/op  min %9.1f  p90 %9.1f  p99 %9.1f",
+            bench->name, p50, ns[0],
+            percentile (ns, samples, 90),
+            percentile (ns, samples, 99));
+
+    if (bench->bytes > 0) {
+        printf ("  %9.1f MB/s", (bench->bytes * 1000.0) / p50);
+    }
+
+    printf ("\n");
+    fflush (stdout);
+}
+
+static void
+usage (const char *prog)
+{
+    fprintf (stderr, "Usage: %s [-r samples] [filter]\n", prog);
+    exit (1);
+}
+
+int
+main (int argc, char *argv[])
+{
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp (argv[i], "-r") == 0) {
+            if (++i >= argc) usage (argv[0]);
+
+            samples = atoi (argv[i]);
+            if ((samples < 1) || (samples > SAMPLES_MAX)) usage (argv[0]);
+        } else if (argv[i][0] == '-') {
+            usage (argv[0]);
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    integer_bench();
+    buffer_bench();
+    header_bench();
+    literal_bench();
+
+    return 0;
+}
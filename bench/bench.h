@@ -0,0 +1,66 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBHPACK_BENCH_H
+#define LIBHPACK_BENCH_H
+
+#include <libhpack/common.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Runs the measured operation @iterations times
+ */
+typedef void (*bench_func_t) (void *param, cuint_t iterations);
+
+typedef struct {
+    const char   *name;      /**< Name of the measured operation     */
+    bench_func_t  func;      /**< Runs the operation N times         */
+    void         *param;     /**< Operation argument                 */
+    size_t        bytes;     /**< Bytes processed per op, 0 if none  */
+} bench_t;
+
+/* Keeps the compiler from discarding results
+ */
+extern volatile uint64_t bench_sink;
+
+#define bench_consume(x) (bench_sink += (uint64_t)(x))
+
+void bench_run (bench_t *bench);
+
+/* Benchmark suites
+ */
+void integer_bench (void);
+void buffer_bench  (void);
+void header_bench  (void);
+void literal_bench (void);
+
+#endif /* LIBHPACK_BENCH_H */
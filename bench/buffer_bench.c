@@ -0,0 +1,150 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "bench.h"
+
+#include <libchula/buffer.h>
+#include <libchula/crc32.h>
+
+/* Appenders write to a buffer that is emptied every few KB, so the
+ * figures do not include its growth.
+ */
+#define APPEND_LIMIT 8192
+
+static chula_buffer_t out   = CHULA_BUF_INIT;
+static chula_buffer_t value = CHULA_BUF_INIT_FAKE ("application/json");
+
+#define APPEND_LOOP(call)                           \
+    do {                                            \
+        cuint_t _i;                                 \
+        for (_i = 0; _i < iterations; _i++) {       \
+            if (out.len > APPEND_LIMIT) {           \
+                chula_buffer_clean (&out);          \
+            }                                       \
+            call;                                   \
+        }                                           \
+        bench_consume (out.len);                    \
+    } while (0)
+
+static void
+run_add (void *param, cuint_t iterations)
+{
+    UNUSED (param);
+    APPEND_LOOP (chula_buffer_add (&out, value.buf, value.len));
+}
+
+static void
+run_add_buffer (void *param, cuint_t iterations)
+{
+    UNUSED (param);
+    APPEND_LOOP (chula_buffer_add_buffer (&out, &value));
+}
+
+static void
+run_add_char (void *param, cuint_t iterations)
+{
+    UNUSED (param);
+    APPEND_LOOP (chula_buffer_add_char (&out, ':'));
+}
+
+static void
+run_add_long10 (void *param, cuint_t iterations)
+{
+    UNUSED (param);
+    APPEND_LOOP (chula_buffer_add_long10 (&out, 1412345678L + _i));
+}
+
+static void
+run_add_ulong16 (void *param, cuint_t iterations)
+{
+    UNUSED (param);
+    APPEND_LOOP (chula_buffer_add_ulong16 (&out, 0xdeadbeefUL + _i));
+}
+
+static void
+run_add_uint32be (void *param, cuint_t iterations)
+{
+    UNUSED (param);
+    APPEND_LOOP (chula_buffer_add_uint32be (&out, _i));
+}
+
+static void
+run_crc32 (void *param, cuint_t iterations)
+{
+    cuint_t         i;
+    chula_buffer_t *data = param;
+
+    for (i = 0; i < iterations; i++) {
+        bench_consume (crc32_sz (data->buf, data->len));
+    }
+}
+
+static chula_buffer_t crc_small = CHULA_BUF_INIT;
+static chula_buffer_t crc_large = CHULA_BUF_INIT;
+
+static bench_t benches[] = {
+    {"chula_buffer_add/16",             run_add,          NULL,       16},
+    {"chula_buffer_add_buffer/16",      run_add_buffer,   NULL,       16},
+    {"chula_buffer_add_char",           run_add_char,     NULL,       1},
+    {"chula_buffer_add_long10",         run_add_long10,   NULL,       0},
+    {"chula_buffer_add_ulong16",        run_add_ulong16,  NULL,       0},
+    {"chula_buffer_add_uint32be",       run_add_uint32be, NULL,       4},
+    {"crc32_sz/1k",                     run_crc32,        &crc_small, 1024},
+    {"crc32_sz/16k",                    run_crc32,        &crc_large, 16384},
+};
+
+static void
+fill (chula_buffer_t *buf, cuint_t len)
+{
+    cuint_t i;
+
+    for (i = 0; i < len; i++) {
+        chula_buffer_add_char (buf, (char)(i * 31 + 7));
+    }
+}
+
+void
+buffer_bench (void)
+{
+    cuint_t i;
+
+    fill (&crc_small, 1024);
+    fill (&crc_large, 16384);
+
+    for (i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        bench_run (&benches[i]);
+    }
+
+    chula_buffer_mrproper (&out);
+    chula_buffer_mrproper (&crc_small);
+    chula_buffer_mrproper (&crc_large);
+}
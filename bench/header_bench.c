@@ -0,0 +1,493 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "bench.h"
+#include "corpus.h"
+#include "libhpack/huffman.h"
+#include "libhpack/header_parser.h"
+#include "libhpack/header_encoder.h"
+#include "libhpack/context_pool.h"
+
+#include <libchula/arena.h>
+#include <string.h>
+
+typedef struct {
+    corpus_msg_t *msgs;
+    cuint_t       num;
+    bool          arena;
+    bool          list;
+} decode_param_t;
+
+/* Decodes every block of a connection with a fresh decoding context
+ */
+static void
+run_decode (void *param, cuint_t iterations)
+{
+    cuint_t                i, n;
+    ret_t                  ret;
+    cuint_t                consumed;
+    chula_buffer_t         raw;
+    hpack_header_parser_t  parser;
+    chula_arena_t          arena;
+    hpack_header_list_t    list;
+    chula_list_t           fields = LIST_HEAD_INIT(fields);
+    decode_param_t        *p      = param;
+
+    chula_arena_init (&arena);
+    hpack_header_list_init (&list);
+
+    for (i = 0; i < iterations; i++) {
+        hpack_header_parser_init (&parser);
+
+        if (p->arena) {
+            hpack_header_parser_set_arena (&parser, &arena);
+            hpack_header_parser_set_views (&parser, true);
+        }
+
+        if (p->list) {
+            hpack_header_parser_set_list (&parser, &list);
+        }
+
+        for (n = 0; n < p->num; n++) {
+            chula_buffer_fake (&raw, (const char *)p->msgs[n].block, p->msgs[n].block_len);
+
+            ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+            bench_consume (ret + consumed);
+
+            if (p->list) {
+                hpack_header_list_clean (&list);
+            } else if (p->arena) {
+                INIT_LIST_HEAD (&fields);
+                chula_arena_reset (&arena);
+            } else {
+                hpack_header_field_list_free (&fields);
+            }
+        }
+
+        hpack_header_parser_mrproper (&parser);
+    }
+
+    hpack_header_list_mrproper (&list);
+    chula_arena_mrproper (&arena);
+}
+
+typedef struct {
+    corpus_msg_t            *msgs;
+    cuint_t                  num;
+    chula_list_t             lists[16];
+    hpack_header_list_t      packed[16];
+    hpack_header_template_t  templates[16];
+} encode_param_t;
+
+/* Encodes every header list of a connection with a fresh encoding
+ * context
+ */
+static void
+run_encode (void *param, cuint_t iterations)
+{
+    cuint_t                 i, n;
+    ret_t                   ret;
+    hpack_header_encoder_t  encoder;
+    chula_buffer_t          out = CHULA_BUF_INIT;
+    encode_param_t         *p   = param;
+
+    for (i = 0; i < iterations; i++) {
+        hpack_header_encoder_init (&encoder);
+
+        for (n = 0; n < p->num; n++) {
+            chula_buffer_clean (&out);
+            ret = hpack_header_encoder_all (&encoder, &p->lists[n], &out);
+            bench_consume (ret + out.len);
+        }
+
+        hpack_header_encoder_mrproper (&encoder);
+    }
+
+    chula_buffer_mrproper (&out);
+}
+
+/* Same, with encoders recycled from one connection to the next
+ */
+static void
+run_encode_pooled (void *param, cuint_t iterations)
+{
+    cuint_t                 i, n;
+    ret_t                   ret;
+    hpack_header_encoder_t *encoder;
+    chula_buffer_t          out = CHULA_BUF_INIT;
+    encode_param_t         *p   = param;
+
+    for (i = 0; i < iterations; i++) {
+        hpack_context_pool_get_encoder (&encoder);
+
+        for (n = 0; n < p->num; n++) {
+            chula_buffer_clean (&out);
+            ret = hpack_header_encoder_all (encoder, &p->lists[n], &out);
+            bench_consume (ret + out.len);
+        }
+
+        hpack_context_pool_put_encoder (encoder);
+    }
+
+    hpack_context_pool_flush ();
+    chula_buffer_mrproper (&out);
+}
+
+/* Same, with all the header lists of the connection in one call
+ */
+static void
+run_encode_batch (void *param, cuint_t iterations)
+{
+    cuint_t                 i;
+    ret_t                   ret;
+    cuint_t                 ends[16];
+    hpack_header_encoder_t  encoder;
+    chula_buffer_t          out = CHULA_BUF_INIT;
+    encode_param_t         *p   = param;
+
+    for (i = 0; i < iterations; i++) {
+        hpack_header_encoder_init (&encoder);
+
+        chula_buffer_clean (&out);
+        ret = hpack_header_encoder_batch (&encoder, p->lists, p->num, &out, ends);
+        bench_consume (ret + ends[p->num - 1]);
+
+        hpack_header_encoder_mrproper (&encoder);
+    }
+
+    chula_buffer_mrproper (&out);
+}
+
+/* Same, from packed header lists
+ */
+static void
+run_encode_list (void *param, cuint_t iterations)
+{
+    cuint_t                 i, n;
+    ret_t                   ret;
+    hpack_header_encoder_t  encoder;
+    chula_buffer_t          out = CHULA_BUF_INIT;
+    encode_param_t         *p   = param;
+
+    for (i = 0; i < iterations; i++) {
+        hpack_header_encoder_init (&encoder);
+
+        for (n = 0; n < p->num; n++) {
+            chula_buffer_clean (&out);
+            ret = hpack_header_encoder_list (&encoder, &p->packed[n], &out);
+            bench_consume (ret + out.len);
+        }
+
+        hpack_header_encoder_mrproper (&encoder);
+    }
+
+    chula_buffer_mrproper (&out);
+}
+
+/* Same, from header templates compiled beforehand
+ */
+static void
+run_encode_template (void *param, cuint_t iterations)
+{
+    cuint_t                 i, n;
+    ret_t                   ret;
+    hpack_header_encoder_t  encoder;
+    chula_buffer_t          out = CHULA_BUF_INIT;
+    encode_param_t         *p   = param;
+
+    for (i = 0; i < iterations; i++) {
+        hpack_header_encoder_init (&encoder);
+
+        for (n = 0; n < p->num; n++) {
+            chula_buffer_clean (&out);
+            ret = hpack_header_encoder_template (&encoder, &p->templates[n], &out);
+            bench_consume (ret + out.len);
+        }
+
+        hpack_header_encoder_mrproper (&encoder);
+    }
+
+    chula_buffer_mrproper (&out);
+}
+
+/* Encodes every header list as literals without indexing, as a
+ * connection with no dynamic table does, optionally through a Huffman
+ * encoding cache kept across connections.
+ */
+typedef struct {
+    encode_param_t        *enc;
+    hpack_huffman_cache_t *cache;
+} literal_param_t;
+
+static void
+run_encode_literal (void *param, cuint_t iterations)
+{
+    cuint_t                 i, n;
+    ret_t                   ret;
+    hpack_header_encoder_t  encoder;
+    chula_buffer_t          out = CHULA_BUF_INIT;
+    literal_param_t        *p   = param;
+
+    for (i = 0; i < iterations; i++) {
+        hpack_header_encoder_init (&encoder);
+        hpack_header_encoder_set_max_size (&encoder, 0);
+        hpack_header_encoder_set_cache (&encoder, p->cache);
+
+        for (n = 0; n < p->enc->num; n++) {
+            chula_buffer_clean (&out);
+            ret = hpack_header_encoder_all (&encoder, &p->enc->lists[n], &out);
+            bench_consume (ret + out.len);
+        }
+
+        hpack_header_encoder_mrproper (&encoder);
+    }
+
+    chula_buffer_mrproper (&out);
+}
+
+static size_t
+encode_param_init (encode_param_t *p, corpus_msg_t *msgs, cuint_t num)
+{
+    cuint_t                n, f;
+    hpack_header_field_t  *field;
+    hpack_header_encoder_t encoder;
+    size_t                 total = 0;
+
+    p->msgs = msgs;
+    p->num  = MIN (num, 16);
+
+    for (n = 0; n < p->num; n++) {
+        INIT_LIST_HEAD (&p->lists[n]);
+        hpack_header_list_init (&p->packed[n]);
+
+        for (f = 0; f < msgs[n].num_fields; f++) {
+            hpack_header_field_new (&field);
+            chula_buffer_add (&field->name,  msgs[n].fields[f].name,  strlen (msgs[n].fields[f].name));
+            chula_buffer_add (&field->value, msgs[n].fields[f].value, strlen (msgs[n].fields[f].value));
+            chula_list_add_tail (&field->entry, &p->lists[n]);
+            hpack_header_list_add_field (&p->packed[n], field);
+
+            total += field->name.len + field->value.len;
+        }
+    }
+
+    /* Compiled with the settings of the encoders that replay them */
+    hpack_header_encoder_init (&encoder);
+
+    for (n = 0; n < p->num; n++) {
+        hpack_header_template_init (&p->templates[n]);
+        hpack_header_encoder_compile (&encoder, &p->packed[n], &p->templates[n]);
+    }
+
+    hpack_header_encoder_mrproper (&encoder);
+    return total;
+}
+
+static void
+encode_param_mrproper (encode_param_t *p)
+{
+    cuint_t n;
+
+    for (n = 0; n < p->num; n++) {
+        hpack_header_field_list_free (&p->lists[n]);
+        hpack_header_list_mrproper (&p->packed[n]);
+        hpack_header_template_mrproper (&p->templates[n]);
+    }
+}
+
+typedef struct {
+    chula_buffer_t plain[64];
+    chula_buffer_t encoded[64];
+    cuint_t        num;
+} huffman_param_t;
+
+static void
+run_huffman_encode (void *param, cuint_t iterations)
+{
+    cuint_t          i, n;
+    chula_buffer_t   out = CHULA_BUF_INIT;
+    huffman_param_t *p   = param;
+
+    for (i = 0; i < iterations; i++) {
+        for (n = 0; n < p->num; n++) {
+            chula_buffer_clean (&out);
+            hpack_huffman_encode (&p->plain[n], &out);
+            bench_consume (out.len);
+        }
+    }
+
+    chula_buffer_mrproper (&out);
+}
+
+static void
+run_huffman_decode (void *param, cuint_t iterations)
+{
+    cuint_t          i, n;
+    chula_buffer_t   out = CHULA_BUF_INIT;
+    huffman_param_t *p   = param;
+
+    for (i = 0; i < iterations; i++) {
+        for (n = 0; n < p->num; n++) {
+            chula_buffer_clean (&out);
+            hpack_huffman_decode (&p->encoded[n], &out);
+            bench_consume (out.len);
+        }
+    }
+
+    chula_buffer_mrproper (&out);
+}
+
+static size_t
+corpus_block_bytes (corpus_msg_t *msgs, cuint_t num)
+{
+    cuint_t n;
+    size_t  total = 0;
+
+    for (n = 0; n < num; n++) {
+        total += msgs[n].block_len;
+    }
+
+    return total;
+}
+
+/* Every distinct value of the request corpus
+ */
+static void
+huffman_param_init (huffman_param_t *p, size_t *plain_bytes, size_t *encoded_bytes)
+{
+    cuint_t n, f, k;
+    bool    dup;
+
+    p->num = 0;
+    *plain_bytes = 0;
+    *encoded_bytes = 0;
+
+    for (n = 0; n < CORPUS_LEN(requests); n++) {
+        for (f = 0; f < requests[n].num_fields; f++) {
+            const char *value = requests[n].fields[f].value;
+
+            for (dup = false, k = 0; k < p->num; k++) {
+                dup |= (strcmp (p->plain[k].buf, value) == 0);
+            }
+            if (dup || (p->num >= 64)) {
+                continue;
+            }
+
+            chula_buffer_init (&p->plain[p->num]);
+            chula_buffer_init (&p->encoded[p->num]);
+            chula_buffer_add (&p->plain[p->num], value, strlen (value));
+            hpack_huffman_encode (&p->plain[p->num], &p->encoded[p->num]);
+
+            *plain_bytes   += p->plain[p->num].len;
+            *encoded_bytes += p->encoded[p->num].len;
+            p->num++;
+        }
+    }
+}
+
+static void
+huffman_param_mrproper (huffman_param_t *p)
+{
+    cuint_t n;
+
+    for (n = 0; n < p->num; n++) {
+        chula_buffer_mrproper (&p->plain[n]);
+        chula_buffer_mrproper (&p->encoded[n]);
+    }
+}
+
+void
+header_bench (void)
+{
+    cuint_t               i;
+    size_t                plain_bytes;
+    size_t                encoded_bytes;
+    huffman_param_t       huffman;
+    encode_param_t        enc_req;
+    encode_param_t        enc_res;
+    size_t                enc_req_bytes;
+    size_t                enc_res_bytes;
+    hpack_huffman_cache_t cache;
+    literal_param_t       res_literal;
+    literal_param_t       res_cached;
+    decode_param_t        req_heap  = {requests,  CORPUS_LEN(requests),  false, false};
+    decode_param_t        req_arena = {requests,  CORPUS_LEN(requests),  true,  false};
+    decode_param_t        req_list  = {requests,  CORPUS_LEN(requests),  false, true};
+    decode_param_t        res_heap  = {responses, CORPUS_LEN(responses), false, false};
+    decode_param_t        res_arena = {responses, CORPUS_LEN(responses), true,  false};
+    decode_param_t        res_list  = {responses, CORPUS_LEN(responses), false, true};
+
+    huffman_param_init (&huffman, &plain_bytes, &encoded_bytes);
+    enc_req_bytes = encode_param_init (&enc_req, requests,  CORPUS_LEN(requests));
+    enc_res_bytes = encode_param_init (&enc_res, responses, CORPUS_LEN(responses));
+
+    hpack_huffman_cache_init (&cache);
+    hpack_huffman_cache_set_limits (&cache, 256, 128);
+    res_literal.enc   = &enc_res;
+    res_literal.cache = NULL;
+    res_cached.enc    = &enc_res;
+    res_cached.cache  = &cache;
+
+    {
+        bench_t benches[] = {
+            {"huffman_encode/request-values",    run_huffman_encode,  &huffman,     plain_bytes},
+            {"huffman_decode/request-values",    run_huffman_decode,  &huffman,     encoded_bytes},
+            {"header_encode/requests",           run_encode,          &enc_req,     enc_req_bytes},
+            {"header_encode/responses",          run_encode,          &enc_res,     enc_res_bytes},
+            {"header_encode/requests-pooled",    run_encode_pooled,   &enc_req,     enc_req_bytes},
+            {"header_encode/responses-pooled",   run_encode_pooled,   &enc_res,     enc_res_bytes},
+            {"header_encode/requests-batch",     run_encode_batch,    &enc_req,     enc_req_bytes},
+            {"header_encode/responses-batch",    run_encode_batch,    &enc_res,     enc_res_bytes},
+            {"header_encode/requests-list",      run_encode_list,     &enc_req,     enc_req_bytes},
+            {"header_encode/responses-list",     run_encode_list,     &enc_res,     enc_res_bytes},
+            {"header_encode/requests-template",  run_encode_template, &enc_req,     enc_req_bytes},
+            {"header_encode/responses-template", run_encode_template, &enc_res,     enc_res_bytes},
+            {"header_encode/responses-literal",  run_encode_literal,  &res_literal, enc_res_bytes},
+            {"header_encode/responses-cached",   run_encode_literal,  &res_cached,  enc_res_bytes},
+            {"header_decode/requests",           run_decode,          &req_heap,    corpus_block_bytes (requests,  CORPUS_LEN(requests))},
+            {"header_decode/requests-arena",     run_decode,          &req_arena,   corpus_block_bytes (requests,  CORPUS_LEN(requests))},
+            {"header_decode/requests-list",      run_decode,          &req_list,    corpus_block_bytes (requests,  CORPUS_LEN(requests))},
+            {"header_decode/responses",          run_decode,          &res_heap,    corpus_block_bytes (responses, CORPUS_LEN(responses))},
+            {"header_decode/responses-arena",    run_decode,          &res_arena,   corpus_block_bytes (responses, CORPUS_LEN(responses))},
+            {"header_decode/responses-list",     run_decode,          &res_list,    corpus_block_bytes (responses, CORPUS_LEN(responses))},
+        };
+
+        for (i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+            bench_run (&benches[i]);
+        }
+    }
+
+    huffman_param_mrproper (&huffman);
+    encode_param_mrproper (&enc_req);
+    encode_param_mrproper (&enc_res);
+    hpack_huffman_cache_mrproper (&cache);
+}
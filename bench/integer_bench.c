@@ -0,0 +1,284 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "bench.h"
+#include "libhpack/integer.h"
+
+#include <string.h>
+
+#define NUM_VALUES 64
+
+/* Encoded integers sit in rows with readable octets past them, as
+ * within a header block
+ */
+#define ROW_SIZE   16
+
+typedef struct {
+    int           N;
+    int           values[NUM_VALUES];
+    unsigned char encoded[NUM_VALUES][ROW_SIZE];
+    unsigned char lens[NUM_VALUES];
+} integer_corpus_t;
+
+static void
+corpus_init (integer_corpus_t *c, int N, int max)
+{
+    int      i;
+    uint32_t seed = 12345;
+
+    c->N = N;
+
+    for (i = 0; i < NUM_VALUES; i++) {
+        seed = seed * 1103515245 + 12345;
+        c->values[i] = (seed >> 8) % max;
+        integer_encode (N, c->values[i], c->encoded[i], &c->lens[i]);
+    }
+}
+
+static void
+run_encode (void *param, cuint_t iterations)
+{
+    cuint_t           i;
+    unsigned char     mem[8];
+    unsigned char     len;
+    integer_corpus_t *c = param;
+
+    for (i = 0; i < iterations; i++) {
+        integer_encode (c->N, c->values[i % NUM_VALUES], mem, &len);
+        bench_consume (mem[0] + len);
+    }
+}
+
+static void
+run_decode (void *param, cuint_t iterations)
+{
+    cuint_t           i;
+    int               value;
+    integer_corpus_t *c = param;
+
+    for (i = 0; i < iterations; i++) {
+        integer_decode (c->N, c->encoded[i % NUM_VALUES], c->lens[i % NUM_VALUES], &value);
+        bench_consume (value);
+    }
+}
+
+static void
+run_decode_bounded (void *param, cuint_t iterations)
+{
+    cuint_t           i;
+    uint32_t          value;
+    size_t            consumed;
+    integer_corpus_t *c = param;
+
+    for (i = 0; i < iterations; i++) {
+        integer_decode_bounded (c->N, c->encoded[i % NUM_VALUES], ROW_SIZE, &value, &consumed);
+        bench_consume (value + consumed);
+    }
+}
+
+/* Codecs specialized for 7 bits prefixes: indexes and string lengths
+ */
+static void
+run_encode_7 (void *param, cuint_t iterations)
+{
+    cuint_t           i;
+    unsigned char     mem[8];
+    size_t            len;
+    integer_corpus_t *c = param;
+
+    for (i = 0; i < iterations; i++) {
+        len = integer_encode_7 (0, c->values[i % NUM_VALUES], mem);
+        bench_consume (mem[0] + len);
+    }
+}
+
+static void
+run_decode_7 (void *param, cuint_t iterations)
+{
+    cuint_t           i;
+    uint32_t          value;
+    size_t            consumed;
+    integer_corpus_t *c = param;
+
+    for (i = 0; i < iterations; i++) {
+        integer_decode_7 (c->encoded[i % NUM_VALUES], ROW_SIZE, &value, &consumed);
+        bench_consume (value + consumed);
+    }
+}
+
+/* Runs of integers back to back, as found when pre-scanning blocks
+ */
+#define RUN_LEN 4096
+
+typedef struct {
+    integer_impl_t impl;
+    int            N;
+    uint32_t       values[RUN_LEN];
+    unsigned char  encoded[RUN_LEN * INTEGER_MAX_LEN];
+    size_t         len;
+} integer_run_t;
+
+static void
+run_init (integer_run_t *r, integer_impl_t impl, int N, int large_every)
+{
+    int      i;
+    uint32_t seed = 54321;
+
+    r->impl = impl;
+    r->N    = N;
+
+    for (i = 0; i < RUN_LEN; i++) {
+        seed = seed * 1103515245 + 12345;
+        r->values[i] = ((large_every > 0) && (i % large_every == 0)) ? (seed >> 12) : (seed >> 16) % 100;
+    }
+
+    integer_set_impl (integer_impl_scalar);
+    integer_encode_batch (N, 0, r->values, RUN_LEN, r->encoded, &r->len);
+}
+
+static void
+run_encode_batch (void *param, cuint_t iterations)
+{
+    cuint_t        i;
+    size_t         len;
+    unsigned char  mem[RUN_LEN * INTEGER_MAX_LEN];
+    integer_run_t *r = param;
+
+    integer_set_impl (r->impl);
+
+    for (i = 0; i < iterations; i++) {
+        integer_encode_batch (r->N, 0, r->values, RUN_LEN, mem, &len);
+        bench_consume (mem[i % len] + len);
+    }
+}
+
+static void
+run_decode_batch (void *param, cuint_t iterations)
+{
+    cuint_t        i;
+    size_t         num;
+    size_t         consumed;
+    uint32_t       values[RUN_LEN];
+    integer_run_t *r = param;
+
+    integer_set_impl (r->impl);
+
+    for (i = 0; i < iterations; i++) {
+        integer_decode_batch (r->N, r->encoded, r->len, values, RUN_LEN, &num, &consumed);
+        bench_consume (values[i % RUN_LEN] + consumed);
+    }
+}
+
+static integer_run_t run_small_scalar;
+static integer_run_t run_small_sse2;
+static integer_run_t run_small_avx2;
+static integer_run_t run_mixed_scalar;
+static integer_run_t run_mixed_sse2;
+static integer_run_t run_mixed_avx2;
+
+/* Table indexes, string lengths and table sizes
+ */
+static integer_corpus_t small;
+static integer_corpus_t medium;
+static integer_corpus_t large;
+
+static bench_t benches[] = {
+    {"integer_encode/small",         run_encode,         &small,  0},
+    {"integer_encode/medium",        run_encode,         &medium, 0},
+    {"integer_encode/large",         run_encode,         &large,  0},
+    {"integer_decode/small",         run_decode,         &small,  0},
+    {"integer_decode/medium",        run_decode,         &medium, 0},
+    {"integer_decode/large",         run_decode,         &large,  0},
+    {"integer_decode_bounded/small", run_decode_bounded, &small,  0},
+    {"integer_decode_bounded/medium", run_decode_bounded, &medium, 0},
+    {"integer_decode_bounded/large", run_decode_bounded, &large,  0},
+    {"integer_encode_7/small",       run_encode_7,       &small,  0},
+    {"integer_encode_7/medium",      run_encode_7,       &medium, 0},
+    {"integer_decode_7/small",       run_decode_7,       &small,  0},
+    {"integer_decode_7/medium",      run_decode_7,       &medium, 0},
+};
+
+static bench_t run_benches[] = {
+    {"integer_encode_batch/small-scalar", run_encode_batch, &run_small_scalar, 0},
+    {"integer_encode_batch/small-sse2",   run_encode_batch, &run_small_sse2,   0},
+    {"integer_encode_batch/small-avx2",   run_encode_batch, &run_small_avx2,   0},
+    {"integer_encode_batch/mixed-scalar", run_encode_batch, &run_mixed_scalar, 0},
+    {"integer_encode_batch/mixed-sse2",   run_encode_batch, &run_mixed_sse2,   0},
+    {"integer_encode_batch/mixed-avx2",   run_encode_batch, &run_mixed_avx2,   0},
+    {"integer_decode_batch/small-scalar", run_decode_batch, &run_small_scalar, 0},
+    {"integer_decode_batch/small-sse2",   run_decode_batch, &run_small_sse2,   0},
+    {"integer_decode_batch/small-avx2",   run_decode_batch, &run_small_avx2,   0},
+    {"integer_decode_batch/mixed-scalar", run_decode_batch, &run_mixed_scalar, 0},
+    {"integer_decode_batch/mixed-sse2",   run_decode_batch, &run_mixed_sse2,   0},
+    {"integer_decode_batch/mixed-avx2",   run_decode_batch, &run_mixed_avx2,   0},
+};
+
+void
+integer_bench (void)
+{
+    cuint_t i;
+
+    corpus_init (&small,  7, 127);
+    corpus_init (&medium, 7, 16384);
+    corpus_init (&large,  5, 1 << 30);
+
+    for (i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        bench_run (&benches[i]);
+    }
+
+    /* One in eight integers needs continuation octets in the mixed runs
+     */
+    run_init (&run_small_scalar, integer_impl_scalar, 7, 0);
+    run_init (&run_small_sse2,   integer_impl_sse2,   7, 0);
+    run_init (&run_small_avx2,   integer_impl_avx2,   7, 0);
+    run_init (&run_mixed_scalar, integer_impl_scalar, 7, 8);
+    run_init (&run_mixed_sse2,   integer_impl_sse2,   7, 8);
+    run_init (&run_mixed_avx2,   integer_impl_avx2,   7, 8);
+
+    for (i = 0; i < sizeof(run_benches) / sizeof(run_benches[0]); i++) {
+        integer_run_t *r = run_benches[i].param;
+
+        /* Not supported by this build or CPU */
+        if (integer_set_impl (r->impl) != ret_OK) {
+            continue;
+        }
+
+        run_benches[i].bytes = run_small_scalar.len;
+        if (strstr (run_benches[i].name, "mixed") != NULL) {
+            run_benches[i].bytes = run_mixed_scalar.len;
+        }
+
+        bench_run (&run_benches[i]);
+    }
+
+    integer_set_impl (integer_impl_auto);
+}
@@ -0,0 +1,135 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "bench.h"
+#include "corpus.h"
+#include "libhpack/literal.h"
+
+#include <string.h>
+
+/* Names and values of every field of the corpus, copied and checked
+ * as the decoder does with raw literals
+ */
+typedef struct {
+    hpack_literal_impl_t impl;
+    bool                 check;
+} literal_param_t;
+
+static size_t
+corpus_bytes (corpus_msg_t *msgs, cuint_t num)
+{
+    cuint_t n, f;
+    size_t  total = 0;
+
+    for (n = 0; n < num; n++) {
+        for (f = 0; f < msgs[n].num_fields; f++) {
+            total += strlen (msgs[n].fields[f].name) + strlen (msgs[n].fields[f].value);
+        }
+    }
+
+    return total;
+}
+
+static void
+copy_corpus (literal_param_t *p, corpus_msg_t *msgs, cuint_t num, char *dst)
+{
+    cuint_t         n, f;
+    ret_t           ret = ret_ok;
+    corpus_field_t *field;
+
+    for (n = 0; n < num; n++) {
+        for (f = 0; f < msgs[n].num_fields; f++) {
+            field = &msgs[n].fields[f];
+
+            if (p->check) {
+                ret += hpack_literal_copy_name  (dst, field->name,  strlen (field->name), 0);
+                ret += hpack_literal_copy_value (dst, field->value, strlen (field->value));
+            } else {
+                memcpy (dst, field->name,  strlen (field->name));
+                memcpy (dst, field->value, strlen (field->value));
+            }
+
+            bench_consume (ret + dst[0]);
+        }
+    }
+}
+
+static void
+run_copy (void *param, cuint_t iterations)
+{
+    cuint_t          i;
+    char             dst[512];
+    literal_param_t *p = param;
+
+    hpack_literal_set_impl (p->impl);
+
+    for (i = 0; i < iterations; i++) {
+        copy_corpus (p, requests,  CORPUS_LEN(requests),  dst);
+        copy_corpus (p, responses, CORPUS_LEN(responses), dst);
+    }
+}
+
+static literal_param_t copy_memcpy = {hpack_literal_impl_auto,   false};
+static literal_param_t copy_scalar = {hpack_literal_impl_scalar, true};
+static literal_param_t copy_sse2   = {hpack_literal_impl_sse2,   true};
+static literal_param_t copy_avx2   = {hpack_literal_impl_avx2,   true};
+
+static bench_t benches[] = {
+    {"literal_copy/corpus-memcpy", run_copy, &copy_memcpy, 0},
+    {"literal_copy/corpus-scalar", run_copy, &copy_scalar, 0},
+    {"literal_copy/corpus-sse2",   run_copy, &copy_sse2,   0},
+    {"literal_copy/corpus-avx2",   run_copy, &copy_avx2,   0},
+};
+
+void
+literal_bench (void)
+{
+    cuint_t i;
+    size_t  bytes;
+
+    bytes = corpus_bytes (requests,  CORPUS_LEN(requests)) +
+            corpus_bytes (responses, CORPUS_LEN(responses));
+
+    for (i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        literal_param_t *p = benches[i].param;
+
+        /* Not supported by this build or CPU */
+        if (hpack_literal_set_impl (p->impl) != ret_ok) {
+            continue;
+        }
+
+        benches[i].bytes = bytes;
+        bench_run (&benches[i]);
+    }
+
+    hpack_literal_set_impl (hpack_literal_impl_auto);
+}
@@ -0,0 +1,193 @@
+#!/usr/bin/env python
+
+# Generates libhpack/static_table_data.h: the HPACK static table
+# [RFC 7541, Appendix A], the name ID of every entry, plus two perfect
+# hash tables used to look up names and name/value pairs.
+#
+# Usage: ./gen-static-table.py > libhpack/static_table_data.h
+
+import sys
+
+STATIC_TABLE = [
+    (":authority",                  ""),
+    (":method",                     "GET"),
+    (":method",                     "POST"),
+    (":path",                       "/"),
+    (":path",                       "/index.html"),
+    (":scheme",                     "http"),
+    (":scheme",                     "https"),
+    (":status",                     "200"),
+    (":status",                     "204"),
+    (":status",                     "206"),
+    (":status",                     "304"),
+    (":status",                     "400"),
+    (":status",                     "404"),
+    (":status",                     "500"),
+    ("accept-charset",              ""),
+    ("accept-encoding",             "gzip, deflate"),
+    ("accept-language",             ""),
+    ("accept-ranges",               ""),
+    ("accept",                      ""),
+    ("access-control-allow-origin", ""),
+    ("age",                         ""),
+    ("allow",                       ""),
+    ("authorization",               ""),
+    ("cache-control",               ""),
+    ("content-disposition",         ""),
+    ("content-encoding",            ""),
+    ("content-language",            ""),
+    ("content-length",              ""),
+    ("content-location",            ""),
+    ("content-range",               ""),
+    ("content-type",                ""),
+    ("cookie",                      ""),
+    ("date",                        ""),
+    ("etag",                        ""),
+    ("expect",                      ""),
+    ("expires",                     ""),
+    ("from",                        ""),
+    ("host",                        ""),
+    ("if-match",                    ""),
+    ("if-modified-since",           ""),
+    ("if-none-match",               ""),
+    ("if-range",                    ""),
+    ("if-unmodified-since",         ""),
+    ("last-modified",               ""),
+    ("link",                        ""),
+    ("location",                    ""),
+    ("max-forwards",                ""),
+    ("proxy-authenticate",          ""),
+    ("proxy-authorization",         ""),
+    ("range",                       ""),
+    ("referer",                     ""),
+    ("refresh",                     ""),
+    ("retry-after",                 ""),
+    ("server",                      ""),
+    ("set-cookie",                  ""),
+    ("strict-transport-security",   ""),
+    ("transfer-encoding",           ""),
+    ("user-agent",                  ""),
+    ("vary",                        ""),
+    ("via",                         ""),
+    ("www-authenticate",            ""),
+]
+
+# Must match libhpack/hash.h
+HASH_INIT  = 2166136261
+HASH_PRIME = 16777619
+MIX_PRIME  = 2654435761
+SLOTS_BITS = 8
+SLOTS      = 1 << SLOTS_BITS
+MASK32     = 0xFFFFFFFF
+
+def hpack_hash (s, h):
+    for c in bytearray(s.encode('ascii')):
+        h = ((h ^ c) * HASH_PRIME) & MASK32
+    return h
+
+def slot (h, seed):
+    return (((h ^ seed) * MIX_PRIME) & MASK32) >> (32 - SLOTS_BITS)
+
+def find_seed (keys):
+    # keys: list of (hash, static index)
+    for seed in range(1, 1 << 24):
+        slots = {}
+        for h, index in keys:
+            s = slot (h, seed)
+            if s in slots:
+                break
+            slots[s] = index
+        else:
+            return seed, slots
+    raise Exception ("No seed found")
+
+# Names: the first static index of every name
+names = []
+seen  = set()
+for n, (name, value) in enumerate(STATIC_TABLE):
+    if name not in seen:
+        seen.add (name)
+        names.append ((hpack_hash (name, HASH_INIT), n + 1))
+
+# Name IDs: the first static index of the name of every entry
+first = {}
+for n, (name, value) in enumerate(STATIC_TABLE):
+    first.setdefault (name, n + 1)
+name_ids = [0] + [first[name] for name, value in STATIC_TABLE]
+
+# Pairs: every static entry
+pairs = []
+for n, (name, value) in enumerate(STATIC_TABLE):
+    pairs.append ((hpack_hash (value, hpack_hash (name, HASH_INIT)), n + 1))
+
+name_seed, name_slots = find_seed (names)
+pair_seed, pair_slots = find_seed (pairs)
+
+def c_slots (slots):
+    out = ''
+    for n in range(SLOTS):
+        if n % 16 == 0:
+            out += '    '
+        out += '%2d,' %(slots.get(n, 0))
+        out += '\n' if n % 16 == 15 else ' '
+    return out
+
+def c_ids (ids):
+    out = ''
+    for n, i in enumerate(ids):
+        if n % 16 == 0:
+            out += '    '
+        out += '%2d,' %(i)
+        out += '\n' if (n % 16 == 15 or n == len(ids) - 1) else ' '
+    return out
+
+def c_entries ():
+    out = ''
+    for name, value in STATIC_TABLE:
+        out += '    E(%-30s %s),\n' %('"%s",' %(name), '"%s"' %(value))
+    return out
+
+sys.stdout.write ("""\
+/* Generated by gen-static-table.py. DO NOT EDIT. */
+
+#ifndef LIBHPACK_STATIC_TABLE_DATA_H
+#define LIBHPACK_STATIC_TABLE_DATA_H
+
+#define E(n,v) {n, sizeof(n)-1, v, sizeof(v)-1}
+
+/* Static table [Appendix A.]
+ */
+const hpack_static_entry_t hpack_static_table[HPACK_STATIC_TABLE_LEN] = {
+%(entries)s};
+
+#undef E
+
+/* Name ID of every static index: the lowest index with the same name
+ */
+static const unsigned char name_ids[HPACK_STATIC_TABLE_LEN + 1] = {
+%(name_ids)s};
+
+/* Perfect hash of the names. Slots hold the lowest static index
+ * with that name, or 0 if empty.
+ */
+#define NAME_SEED 0x%(name_seed)08xu
+
+static const unsigned char name_slots[%(slots)d] = {
+%(name_slots)s};
+
+/* Perfect hash of the name/value pairs. Slots hold the static index
+ * of the entry, or 0 if empty.
+ */
+#define PAIR_SEED 0x%(pair_seed)08xu
+
+static const unsigned char pair_slots[%(slots)d] = {
+%(pair_slots)s};
+
+#endif /* LIBHPACK_STATIC_TABLE_DATA_H */
+""" % {'entries':    c_entries(),
+       'name_ids':   c_ids (name_ids),
+       'slots':      SLOTS,
+       'name_seed':  name_seed,
+       'name_slots': c_slots (name_slots),
+       'pair_seed':  pair_seed,
+       'pair_slots': c_slots (pair_slots)})
@@ -0,0 +1,193 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libchula are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@alobbs.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "common-internal.h"
+#include "arena.h"
+
+/* Implements _new() and _free()
+ */
+CHULA_ADD_FUNC_NEW  (arena);
+CHULA_ADD_FUNC_FREE (arena);
+
+#define ALIGN_UP(n) (((n) + (CHULA_ARENA_ALIGN - 1)) & ~((size_t)CHULA_ARENA_ALIGN - 1))
+#define CHUNK_HEAD  ALIGN_UP(sizeof(chula_arena_chunk_t))
+#define CHUNK_DATA(c) ((char *)(c) + CHUNK_HEAD)
+
+ret_t
+chula_arena_init (chula_arena_t *arena)
+{
+	arena->chunk      = NULL;
+	arena->pos        = NULL;
+	arena->end        = NULL;
+	arena->chunk_size = CHULA_ARENA_CHUNK_SIZE;
+
+	return ret_ok;
+}
+
+ret_t
+chula_arena_mrproper (chula_arena_t *arena)
+{
+	chula_arena_chunk_t *c, *prev;
+
+	for (c = arena->chunk; c != NULL; c = prev) {
+		prev = c->prev;
+		free (c);
+	}
+
+	return chula_arena_init (arena);
+}
+
+static ret_t
+chunk_new (size_t size, chula_arena_chunk_t **chunk)
+{
+	chula_arena_chunk_t *c;
+
+	c = (chula_arena_chunk_t *) malloc (CHUNK_HEAD + size);
+	if (unlikely (c == NULL))
+		return ret_nomem;
+
+	c->prev = NULL;
+	c->size = size;
+
+	*chunk = c;
+	return ret_ok;
+}
+
+/*
+ * Slow path of chula_arena_alloc(): the current chunk is full.
+ * Allocations larger than a quarter of a chunk get a chunk of their
+ * own, linked behind the current one so its free room is not lost.
+ */
+static ret_t
+alloc_slow (chula_arena_t *arena, size_t size, void **mem)
+{
+	ret_t                ret;
+	chula_arena_chunk_t *c;
+
+	if ((size > arena->chunk_size / 4) && (arena->chunk != NULL)) {
+		ret = chunk_new (size, &c);
+		if (unlikely (ret != ret_ok))
+			return ret;
+
+		c->prev = arena->chunk->prev;
+		arena->chunk->prev = c;
+
+		*mem = CHUNK_DATA(c);
+		return ret_ok;
+	}
+
+	ret = chunk_new (MAX (arena->chunk_size, size), &c);
+	if (unlikely (ret != ret_ok))
+		return ret;
+
+	c->prev      = arena->chunk;
+	arena->chunk = c;
+	arena->pos   = CHUNK_DATA(c) + size;
+	arena->end   = CHUNK_DATA(c) + c->size;
+
+	*mem = CHUNK_DATA(c);
+	return ret_ok;
+}
+
+/*
+ * Allocate (size) bytes, aligned to CHULA_ARENA_ALIGN. The memory is
+ * not released individually; it goes away with chula_arena_reset()
+ * or chula_arena_mrproper().
+ */
+ret_t
+chula_arena_alloc (chula_arena_t *arena, size_t size, void **mem)
+{
+	size = ALIGN_UP (size);
+
+	if (likely ((size_t)(arena->end - arena->pos) >= size)) {
+		*mem = arena->pos;
+		arena->pos += size;
+		return ret_ok;
+	}
+
+	return alloc_slow (arena, size, mem);
+}
+
+/*
+ * Copy (len) bytes of (str) into the arena, NUL terminated.
+ */
+ret_t
+chula_arena_dup (chula_arena_t *arena, const char *str, size_t len, char **copy)
+{
+	ret_t  ret;
+	void  *mem;
+
+	ret = chula_arena_alloc (arena, len + 1, &mem);
+	if (unlikely (ret != ret_ok))
+		return ret;
+
+	memcpy (mem, str, len);
+	((char *)mem)[len] = '\0';
+
+	*copy = mem;
+	return ret_ok;
+}
+
+/*
+ * Release everything allocated from the arena at once. A regular
+ * chunk is kept, so an arena reused for similar workloads settles
+ * without going back to malloc().
+ */
+void
+chula_arena_reset (chula_arena_t *arena)
+{
+	chula_arena_chunk_t *c, *prev;
+	chula_arena_chunk_t *keep = NULL;
+
+	for (c = arena->chunk; c != NULL; c = prev) {
+		prev = c->prev;
+
+		if ((keep == NULL) && (c->size == arena->chunk_size)) {
+			keep = c;
+			continue;
+		}
+
+		free (c);
+	}
+
+	arena->chunk = keep;
+
+	if (keep == NULL) {
+		arena->pos = NULL;
+		arena->end = NULL;
+		return;
+	}
+
+	keep->prev = NULL;
+	arena->pos = CHUNK_DATA(keep);
+	arena->end = CHUNK_DATA(keep) + keep->size;
+}
@@ -0,0 +1,67 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libchula are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@alobbs.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CHULA_ARENA_H
+#define CHULA_ARENA_H
+
+#include "common.h"
+#include <stddef.h>
+
+typedef struct chula_arena_chunk chula_arena_chunk_t;
+
+struct chula_arena_chunk {
+	chula_arena_chunk_t *prev;       /**< Previously filled chunk */
+	size_t               size;       /**< Usable memory           */
+};
+
+typedef struct {
+	chula_arena_chunk_t *chunk;      /**< Chunk being filled         */
+	char                *pos;        /**< Next free byte in @chunk   */
+	char                *end;        /**< End of @chunk              */
+	size_t               chunk_size; /**< Size of the regular chunks */
+} chula_arena_t;
+
+#define ARENA(a) ((chula_arena_t *)(a))
+
+#define CHULA_ARENA_CHUNK_SIZE 4096
+#define CHULA_ARENA_ALIGN      16
+
+ret_t chula_arena_new      (chula_arena_t **arena);
+ret_t chula_arena_free     (chula_arena_t  *arena);
+ret_t chula_arena_init     (chula_arena_t  *arena);
+ret_t chula_arena_mrproper (chula_arena_t  *arena);
+
+ret_t chula_arena_alloc    (chula_arena_t *arena, size_t size, void **mem);
+ret_t chula_arena_dup      (chula_arena_t *arena, const char *str, size_t len, char **copy);
+void  chula_arena_reset    (chula_arena_t *arena);
+
+#endif /* CHULA_ARENA_H */
@@ -0,0 +1,135 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libchula are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@alobbs.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "test.h"
+#include "libchula/arena.h"
+
+#include <string.h>
+#include <stdint.h>
+
+
+START_TEST (alloc)
+{
+    ret_t          ret;
+    chula_arena_t  arena;
+    void          *a, *b;
+
+    chula_arena_init (&arena);
+
+    ret = chula_arena_alloc (&arena, 3, &a);
+    ck_assert (ret == ret_ok);
+    ret = chula_arena_alloc (&arena, 5, &b);
+    ck_assert (ret == ret_ok);
+
+    /* Aligned, bumped in the same chunk */
+    ck_assert (((uintptr_t)a % CHULA_ARENA_ALIGN) == 0);
+    ck_assert (((uintptr_t)b % CHULA_ARENA_ALIGN) == 0);
+    ck_assert ((char *)b == (char *)a + CHULA_ARENA_ALIGN);
+    ck_assert (arena.chunk->prev == NULL);
+
+    chula_arena_mrproper (&arena);
+    ck_assert (arena.chunk == NULL);
+}
+END_TEST
+
+START_TEST (chunks)
+{
+    ret_t          ret;
+    int            i;
+    chula_arena_t  arena;
+    char          *s;
+    void          *big;
+    chula_arena_chunk_t *current;
+
+    chula_arena_init (&arena);
+    arena.chunk_size = 256;
+
+    /* Fill several chunks */
+    for (i = 0; i < 100; i++) {
+        ret = chula_arena_dup (&arena, "0123456789", 10, &s);
+        ck_assert (ret == ret_ok);
+        ck_assert_str_eq (s, "0123456789");
+    }
+    ck_assert (arena.chunk->prev != NULL);
+
+    /* Large allocations do not replace the current chunk */
+    current = arena.chunk;
+    ret = chula_arena_alloc (&arena, 1024, &big);
+    ck_assert (ret == ret_ok);
+    memset (big, 0xAA, 1024);
+    ck_assert (arena.chunk == current);
+    ck_assert (arena.chunk->prev->size == 1024);
+
+    /* A single regular chunk survives a reset */
+    chula_arena_reset (&arena);
+    ck_assert (arena.chunk != NULL);
+    ck_assert (arena.chunk->prev == NULL);
+    ck_assert (arena.chunk->size == 256);
+
+    ret = chula_arena_dup (&arena, "abc", 3, &s);
+    ck_assert (ret == ret_ok);
+    ck_assert ((s > (char *)arena.chunk) && (s < arena.end));
+    ck_assert_str_eq (s, "abc");
+
+    chula_arena_mrproper (&arena);
+}
+END_TEST
+
+START_TEST (new_free)
+{
+    ret_t          ret;
+    chula_arena_t *arena = NULL;
+    void          *mem;
+
+    ret = chula_arena_new (&arena);
+    ck_assert (ret == ret_ok);
+
+    ret = chula_arena_alloc (arena, CHULA_ARENA_CHUNK_SIZE * 2, &mem);
+    ck_assert (ret == ret_ok);
+    memset (mem, 0, CHULA_ARENA_CHUNK_SIZE * 2);
+
+    chula_arena_reset (arena);
+    ck_assert (arena->chunk == NULL);
+
+    chula_arena_free (arena);
+}
+END_TEST
+
+int
+arena_tests (void)
+{
+    Suite *s1 = suite_create("Arena");
+    check_add (s1, alloc);
+    check_add (s1, chunks);
+    check_add (s1, new_free);
+    run_test (s1);
+}
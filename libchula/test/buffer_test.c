@@ -30,19 +30,9 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <check.h>
+#include "test.h"
 #include "libchula/buffer.h"
 
-#define check_add(suit,func)                             \
-    TCase *testcase_ ## func = tcase_create(#func);      \
-    suite_add_tcase (suit, testcase_ ## func);           \
-    tcase_add_test (testcase_ ##func, func);
-
-#define run_test(suit)                          \
-    SRunner *sr = srunner_create(suit);         \
-    srunner_run_all(sr, CK_VERBOSE);            \
-    return srunner_ntests_failed(sr);
-
 
 START_TEST (init_heap)
 {
@@ -728,13 +718,3 @@ buffer_tests (void)
     check_add (s1, cmp);
     run_test (s1);
 }
-
-int
-main (void)
-{
-    int ret;
-
-    ret = buffer_tests();
-
-    return ret;
-}
@@ -33,12 +33,51 @@
 #ifndef LIBHPACK_COMMON_H
 #define LIBHPACK_COMMON_H
 
+#include <libchula/common.h>
+
 /**
  * Return values for functions
+ *
+ * libhpack shares the ret_t enumeration with libchula, so both
+ * libraries can be used from the same compilation unit. The original
+ * names are kept as aliases of their libchula counterparts.
  */
-typedef enum {
-    ret_ERROR = -1, /**< Generic error return value */
-    ret_OK    = 0,  /**< Success return value       */
-} ret_t;
+#define ret_ERROR ret_error /**< Generic error return value */
+#define ret_OK    ret_ok    /**< Success return value       */
+
+/* Automatic functions:
+ * These macros implement _new/_free by using _init/_mrproper.
+ */
+#define HPACK_ADD_FUNC_NEW(klass)                                   \
+    ret_t                                                           \
+    hpack_ ## klass ## _new (hpack_ ## klass ## _t **obj) {         \
+        ret_t ret;                                                  \
+        hpack_ ## klass ## _t *n;                                   \
+                                                                    \
+        n = (hpack_ ## klass ## _t *) malloc (sizeof(*n));          \
+        if (unlikely (n == NULL))                                   \
+            return ret_nomem;                                       \
+                                                                    \
+        ret = hpack_ ## klass ## _init (n);                         \
+        if (unlikely (ret != ret_ok)) {                             \
+            free (n);                                               \
+            return ret;                                             \
+        }                                                           \
+                                                                    \
+        *obj = n;                                                   \
+        return ret_ok;                                              \
+    }
+
+#define HPACK_ADD_FUNC_FREE(klass)                                  \
+    ret_t                                                           \
+    hpack_ ## klass ## _free (hpack_ ## klass ## _t *obj) {         \
+        if (obj == NULL)                                            \
+            return ret_ok;                                          \
+                                                                    \
+        hpack_ ## klass ## _mrproper (obj);                         \
+                                                                    \
+        free (obj);                                                 \
+        return ret_ok;                                              \
+    }
 
 #endif /* LIBHPACK_COMMON_H */
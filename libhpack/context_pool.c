@@ -0,0 +1,217 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "context_pool.h"
+
+#include <libchula/macros.h>
+
+/* Limits shared by every thread. They are meant to be set once, before
+ * the threads using the pool start.
+ */
+static hpack_context_pool_limits_t pool_limits = {
+    16,                                   /* max_free       */
+    4 * HPACK_HEADER_TABLE_SIZE_DEFAULT   /* max_table_size */
+};
+
+/* Free lists of the calling thread
+ */
+static __thread hpack_header_encoder_t *free_encoders[HPACK_CONTEXT_POOL_MAX];
+static __thread cuint_t                 num_encoders = 0;
+static __thread hpack_header_parser_t  *free_parsers[HPACK_CONTEXT_POOL_MAX];
+static __thread cuint_t                 num_parsers  = 0;
+
+
+/** Set the limits of the context pool
+ *
+ * Lowering @max_free does not free the contexts threads already keep
+ * past it; they are used up first.
+ *
+ * @param limits New limits. @max_free is capped to HPACK_CONTEXT_POOL_MAX
+ * @retval ret_ok Always
+ */
+ret_t
+hpack_context_pool_set_limits (const hpack_context_pool_limits_t *limits)
+{
+    pool_limits          = *limits;
+    pool_limits.max_free = MIN (pool_limits.max_free, HPACK_CONTEXT_POOL_MAX);
+
+    return ret_ok;
+}
+
+/** Free the contexts kept by the calling thread
+ *
+ * Must be called by every thread using the pool before it exits.
+ */
+void
+hpack_context_pool_flush (void)
+{
+    while (num_encoders > 0) {
+        hpack_header_encoder_free (free_encoders[--num_encoders]);
+    }
+
+    while (num_parsers > 0) {
+        hpack_header_parser_free (free_parsers[--num_parsers]);
+    }
+}
+
+/* Whether the memory of a table (and of a reverse index, which is
+ * sized for twice as many entries as the table can hold) is over the
+ * limit.
+ */
+static bool
+table_too_large (hpack_header_table_t *table)
+{
+    return (table->data_size > 2 * pool_limits.max_table_size);
+}
+
+static bool
+index_too_large (hpack_header_index_t *index)
+{
+    return ((size_t)1 << index->bits) > 4 * (pool_limits.max_table_size / HPACK_HEADER_ENTRY_OVERHEAD);
+}
+
+/** Acquire a header encoder
+ *
+ * Returns an encoder in the same state as a new one, recycled when the
+ * thread has one.
+ *
+ * @param[out] encoder Header encoder
+ * @retval ret_ok    The encoder is ready
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_context_pool_get_encoder (hpack_header_encoder_t **encoder)
+{
+    if (num_encoders > 0) {
+        *encoder = free_encoders[--num_encoders];
+        return ret_ok;
+    }
+
+    return hpack_header_encoder_new (encoder);
+}
+
+/** Release a header encoder
+ *
+ * Resets the encoder and keeps it for the next acquisition, or frees
+ * it when the thread keeps enough of them already.
+ *
+ * @param encoder Header encoder, or NULL
+ * @retval ret_ok Always
+ */
+ret_t
+hpack_context_pool_put_encoder (hpack_header_encoder_t *encoder)
+{
+    if (encoder == NULL) {
+        return ret_ok;
+    }
+
+    if (num_encoders >= pool_limits.max_free) {
+        return hpack_header_encoder_free (encoder);
+    }
+
+    hpack_header_encoder_reset (encoder);
+
+    if (table_too_large (&encoder->table)) {
+        hpack_header_table_mrproper (&encoder->table);
+    }
+
+    if (index_too_large (&encoder->index)) {
+        hpack_header_index_mrproper (&encoder->index);
+    }
+
+    if (encoder->name.size > pool_limits.max_table_size) {
+        chula_buffer_mrproper (&encoder->name);
+    }
+
+    free_encoders[num_encoders++] = encoder;
+    return ret_ok;
+}
+
+/** Acquire a header parser
+ *
+ * Returns a parser in the same state as a new one, recycled when the
+ * thread has one.
+ *
+ * @param[out] parser Header parser
+ * @retval ret_ok    The parser is ready
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_context_pool_get_parser (hpack_header_parser_t **parser)
+{
+    if (num_parsers > 0) {
+        *parser = free_parsers[--num_parsers];
+        return ret_ok;
+    }
+
+    return hpack_header_parser_new (parser);
+}
+
+/** Release a header parser
+ *
+ * Resets the parser and keeps it for the next acquisition, or frees it
+ * when the thread keeps enough of them already.
+ *
+ * @param parser Header parser, or NULL
+ * @retval ret_ok Always
+ */
+ret_t
+hpack_context_pool_put_parser (hpack_header_parser_t *parser)
+{
+    hpack_header_field_t *field;
+
+    if (parser == NULL) {
+        return ret_ok;
+    }
+
+    if (num_parsers >= pool_limits.max_free) {
+        return hpack_header_parser_free (parser);
+    }
+
+    hpack_header_parser_reset (parser);
+
+    if (table_too_large (&parser->table)) {
+        hpack_header_table_mrproper (&parser->table);
+    }
+
+    field = parser->field;
+    if ((field != NULL) &&
+        ((field->name.size > pool_limits.max_table_size) ||
+         (field->value.size > pool_limits.max_table_size)))
+    {
+        hpack_header_field_free (field);
+        parser->field = NULL;
+    }
+
+    free_parsers[num_parsers++] = parser;
+    return ret_ok;
+}
@@ -0,0 +1,69 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBHPACK_CONTEXT_POOL_H
+#define LIBHPACK_CONTEXT_POOL_H
+
+#include <libhpack/common.h>
+#include <libhpack/header_encoder.h>
+#include <libhpack/header_parser.h>
+
+/* Context pool
+ *
+ * Recycles the encoders and parsers of closed connections. A released
+ * context is reset and kept with the memory of its dynamic table,
+ * reverse index and scratch buffers, unless they outgrew the limits.
+ * The next connection acquiring a context gets it back ready to use.
+ *
+ * Each thread has its own free lists, so acquiring and releasing never
+ * lock. A context may be released by another thread than the one that
+ * acquired it; it then joins the lists of the releasing thread.
+ */
+
+/* Contexts of each kind a thread can keep
+ */
+#define HPACK_CONTEXT_POOL_MAX 64
+
+typedef struct {
+    cuint_t max_free;       /**< Contexts of each kind a thread keeps    */
+    size_t  max_table_size; /**< Largest table whose memory is kept      */
+} hpack_context_pool_limits_t;
+
+ret_t hpack_context_pool_set_limits (const hpack_context_pool_limits_t *limits);
+void  hpack_context_pool_flush      (void);
+
+ret_t hpack_context_pool_get_encoder (hpack_header_encoder_t **encoder);
+ret_t hpack_context_pool_put_encoder (hpack_header_encoder_t  *encoder);
+ret_t hpack_context_pool_get_parser  (hpack_header_parser_t  **parser);
+ret_t hpack_context_pool_put_parser  (hpack_header_parser_t   *parser);
+
+#endif /* LIBHPACK_CONTEXT_POOL_H */
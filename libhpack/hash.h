@@ -0,0 +1,64 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBHPACK_HASH_H
+#define LIBHPACK_HASH_H
+
+#include <libhpack/common.h>
+#include <stdint.h>
+
+/* 32 bits FNV-1a. gen-static-table.py relies on these values.
+ */
+#define HPACK_HASH_INIT  2166136261u
+#define HPACK_HASH_PRIME 16777619u
+#define HPACK_MIX_PRIME  2654435761u
+
+/* Slot of a hash in a table of 2^bits entries
+ */
+#define HPACK_HASH_SLOT(h,seed,bits) \
+    ((((uint32_t)(h) ^ (seed)) * HPACK_MIX_PRIME) >> (32 - (bits)))
+
+static inline uint32_t
+hpack_hash (const char *str, cuint_t len, uint32_t hash)
+{
+    const unsigned char *p   = (const unsigned char *) str;
+    const unsigned char *end = p + len;
+
+    while (p < end) {
+        hash ^= *p++;
+        hash *= HPACK_HASH_PRIME;
+    }
+
+    return hash;
+}
+
+#endif /* LIBHPACK_HASH_H */
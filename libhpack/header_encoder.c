@@ -0,0 +1,1107 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Current ref:
+ * http://tools.ietf.org/html/rfc7541
+ */
+
+#include "header_encoder.h"
+#include "integer.h"
+#include "huffman.h"
+#include "hash.h"
+#include "literal.h"
+
+#include <libchula/macros.h>
+#include <string.h>
+
+/* Implements _new() and _free()
+ */
+HPACK_ADD_FUNC_NEW  (header_encoder);
+HPACK_ADD_FUNC_FREE (header_encoder);
+
+ret_t
+hpack_header_encoder_init (hpack_header_encoder_t *encoder)
+{
+    hpack_encoder_policy_init (&encoder->default_policy);
+
+    encoder->policy          = &encoder->default_policy;
+    encoder->huffman         = true;
+    encoder->cache           = NULL;
+    encoder->lowercase       = false;
+    encoder->size_update     = false;
+    encoder->size_update_min = 0;
+
+    chula_buffer_init (&encoder->name);
+    hpack_header_index_init (&encoder->index);
+    return hpack_header_table_init (&encoder->table);
+}
+
+ret_t
+hpack_header_encoder_mrproper (hpack_header_encoder_t *encoder)
+{
+    chula_buffer_mrproper (&encoder->name);
+    hpack_header_index_mrproper (&encoder->index);
+    return hpack_header_table_mrproper (&encoder->table);
+}
+
+/** Reset a header encoder
+ *
+ * Brings an encoder back to its initial state, as for a new
+ * connection, while keeping the memory of its dynamic table, reverse
+ * index and scratch buffer.
+ *
+ * @param encoder Header encoder
+ * @retval ret_ok Always
+ */
+ret_t
+hpack_header_encoder_reset (hpack_header_encoder_t *encoder)
+{
+    encoder->policy          = &encoder->default_policy;
+    encoder->huffman         = true;
+    encoder->cache           = NULL;
+    encoder->lowercase       = false;
+    encoder->size_update     = false;
+    encoder->size_update_min = 0;
+
+    chula_buffer_clean (&encoder->name);
+    hpack_header_table_reset (&encoder->table);
+    hpack_header_index_clean (&encoder->index);
+
+    return ret_ok;
+}
+
+
+/* Indexing policy
+ */
+
+#define name_is(f,s) (chula_buffer_cmp_str (&(f)->name, s) == 0)
+
+ret_t
+hpack_encoder_policy_init (hpack_encoder_policy_t *policy)
+{
+    policy->rep = hpack_encoder_policy_default_rep;
+    return ret_ok;
+}
+
+/** Default indexing policy
+ *
+ * Chooses the literal representation of a header field that is not
+ * fully matched by the header table [6.2.]:
+ *
+ * - Credentials and short cookies are never indexed, so they can not
+ *   be guessed by probing the table [7.1.3.]
+ * - Values that seldom repeat (paths with a query string, lengths,
+ *   entity tags, dates of the resource) are not indexed, so they do
+ *   not evict useful entries.
+ * - Fields larger than half the table are not indexed either.
+ * - Everything else, :authority included, is indexed.
+ *
+ * Custom policies can fall back on it for the fields they do not
+ * care about.
+ *
+ * @param policy  Indexing policy
+ * @param encoder Header encoder
+ * @param field   Header field to encode
+ * @return The representation for @field
+ */
+hpack_field_rep_t
+hpack_encoder_policy_default_rep (hpack_encoder_policy_t *policy,
+                                  hpack_header_encoder_t *encoder,
+                                  hpack_header_field_t   *field)
+{
+    size_t size;
+
+    UNUSED (policy);
+
+    if (name_is (field, "authorization") ||
+        name_is (field, "proxy-authorization"))
+    {
+        return hpack_field_rep_literal_never_index;
+    }
+
+    if (name_is (field, "cookie") && (field->value.len < 20)) {
+        return hpack_field_rep_literal_never_index;
+    }
+
+    if (name_is (field, ":path") &&
+        (memchr (field->value.buf, '?', field->value.len) != NULL))
+    {
+        return hpack_field_rep_literal_without_index;
+    }
+
+    if (name_is (field, "content-length")    ||
+        name_is (field, "etag")              ||
+        name_is (field, "if-none-match")     ||
+        name_is (field, "if-modified-since") ||
+        name_is (field, "last-modified")     ||
+        name_is (field, "age"))
+    {
+        return hpack_field_rep_literal_without_index;
+    }
+
+    hpack_header_field_get_size (field, &size);
+    if (size > encoder->table.max_size / 2) {
+        return hpack_field_rep_literal_without_index;
+    }
+
+    return hpack_field_rep_literal_inc_index;
+}
+
+/** Set the indexing policy
+ *
+ * Policies are tables of virtual methods. A custom policy embeds an
+ * hpack_encoder_policy_t as its first member, initializes it with
+ * hpack_encoder_policy_init() and overrides the methods it needs. The
+ * policy is not owned by the encoder.
+ *
+ * @param encoder Header encoder
+ * @param policy  Indexing policy, or NULL for the default one
+ * @retval ret_ok Always
+ */
+ret_t
+hpack_header_encoder_set_policy (hpack_header_encoder_t *encoder,
+                                 hpack_encoder_policy_t *policy)
+{
+    encoder->policy = (policy != NULL) ? policy : &encoder->default_policy;
+    return ret_ok;
+}
+
+/** Change the size of the dynamic table
+ *
+ * Resizes the dynamic table of the encoding context. The change is
+ * signaled to the decoder at the beginning of the next header block.
+ * If the size was lowered and raised again in between, the smallest
+ * size is signaled first so the decoder evicts the same entries
+ * [4.2.].
+ *
+ * @param encoder  Header encoder
+ * @param max_size New maximum size of the dynamic table
+ * @retval ret_ok    The size was changed
+ * @retval ret_error The size exceeds SETTINGS_HEADER_TABLE_SIZE
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_header_encoder_set_max_size (hpack_header_encoder_t *encoder,
+                                   size_t                  max_size)
+{
+    ret_t ret;
+
+    ret = hpack_header_table_set_max_size (&encoder->table, max_size);
+    if (unlikely (ret != ret_ok)) {
+        return ret;
+    }
+
+    if ((! encoder->size_update) || (max_size < encoder->size_update_min)) {
+        encoder->size_update_min = max_size;
+    }
+
+    encoder->size_update = true;
+    return ret_ok;
+}
+
+/** Lowercase header names
+ *
+ * HTTP/1.1 field names are case insensitive, HTTP/2 ones must be
+ * lowercase [RFC 7540, 8.1.2.]. When enabled, each name is lowercased,
+ * checked and hashed in one pass, straight into the output, for
+ * gateways translating HTTP/1.1 messages. The fields themselves are
+ * not modified. A name that is not a valid token fails encoding with
+ * ret_error.
+ *
+ * @param encoder   Header encoder
+ * @param lowercase Whether to lowercase names
+ * @retval ret_ok Always
+ */
+ret_t
+hpack_header_encoder_set_lowercase (hpack_header_encoder_t *encoder,
+                                    bool                    lowercase)
+{
+    encoder->lowercase = lowercase;
+    return ret_ok;
+}
+
+/** Set the Huffman encoding cache of an encoder
+ *
+ * Strings found in the cache are appended as they were encoded the
+ * previous time. Unless the cache is frozen, the strings the encoder
+ * Huffman encodes are added to it, so it must not be shared. The
+ * encoder does not own the cache.
+ *
+ * @param encoder Header encoder
+ * @param cache   Huffman encoding cache, or NULL to stop using one
+ * @retval ret_ok Always
+ */
+ret_t
+hpack_header_encoder_set_cache (hpack_header_encoder_t *encoder,
+                                hpack_huffman_cache_t  *cache)
+{
+    encoder->cache = cache;
+    return ret_ok;
+}
+
+
+/* Representations
+ */
+
+/* Prefixed integer [5.1.], encoded in place. Every caller passes a
+ * constant N, so this inlines to the prefix specialized codec. Sizes
+ * past 32 bits take the 64 bits one.
+ */
+static inline ret_t
+add_integer (chula_buffer_t *out,
+             int             N,
+             unsigned char   pattern,
+             size_t          value)
+{
+    ret_t  ret;
+    size_t written;
+
+    if (unlikely (out->size - out->len <= INTEGER_MAX_LEN_64)) {
+        ret = chula_buffer_ensure_addlen (out, INTEGER_MAX_LEN_64);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    if (likely (value <= UINT32_MAX)) {
+        written = integer_encode_prefix (N, pattern, (uint32_t) value,
+                                         (unsigned char *) out->buf + out->len);
+    } else {
+        ret = integer_encode_64 (N, pattern, value, (unsigned char *) out->buf + out->len,
+                                 out->size - out->len - 1, &written);
+        if (unlikely (ret != ret_ok)) return ret_error;
+    }
+
+    out->len += written;
+    out->buf[out->len] = '\0';
+
+    return ret_ok;
+}
+
+/* String Literal Representation [5.2.]. The Huffman encoding is only
+ * used when it is shorter.
+ */
+static ret_t
+encode_string (hpack_header_encoder_t *encoder,
+               chula_buffer_t         *out,
+               chula_buffer_t         *str)
+{
+    ret_t  ret;
+    size_t len;
+
+    if (encoder->huffman) {
+        len = hpack_huffman_encoded_length (str);
+
+        if (len < str->len) {
+            ret = add_integer (out, 7, 0x80, len);
+            if (unlikely (ret != ret_ok)) return ret;
+
+            return hpack_huffman_encode (str, out);
+        }
+    }
+
+    ret = add_integer (out, 7, 0x00, str->len);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    return chula_buffer_add_buffer (out, str);
+}
+
+/* Same, through the Huffman encoding cache when there is one. A
+ * string missing from it is added once encoded.
+ */
+static ret_t
+add_string (hpack_header_encoder_t *encoder,
+            chula_buffer_t         *out,
+            chula_buffer_t         *str)
+{
+    ret_t                  ret;
+    uint32_t               hash;
+    cuint_t                start;
+    hpack_huffman_cache_t *cache = encoder->cache;
+
+    if ((cache == NULL) || (! encoder->huffman) || (str->len > cache->max_len)) {
+        return encode_string (encoder, out, str);
+    }
+
+    hash = hpack_hash (str->buf, str->len, HPACK_HASH_INIT);
+
+    ret = hpack_huffman_cache_get (cache, str->buf, str->len, hash, out);
+    if (ret != ret_not_found) return ret;
+
+    start = out->len;
+
+    ret = encode_string (encoder, out, str);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    if (! cache->frozen) {
+        hpack_huffman_cache_add (cache, str->buf, str->len, hash,
+                                 out->buf + start, out->len - start);
+    }
+
+    return ret_ok;
+}
+
+/* Looks a field up in the static table and, through the reverse
+ * index, in the dynamic table. Same preference order as
+ * hpack_header_table_find(). Both lookups share the hashes of the
+ * field. The static table is skipped when @in_static tells that it
+ * has no entry with that name.
+ */
+static ret_t
+find (hpack_header_encoder_t *encoder,
+      chula_buffer_t         *name,
+      chula_buffer_t         *value,
+      uint32_t                name_hash,
+      uint32_t                pair_hash,
+      bool                    in_static,
+      cuint_t                *index,
+      bool                   *value_match)
+{
+    ret_t   ret;
+    cuint_t n;
+    bool    match;
+    cuint_t name_index = 0;
+
+    if (in_static) {
+        ret = hpack_static_table_find_hashed (name, value, name_hash, pair_hash, &n, &match);
+        if (ret == ret_ok) {
+            if (match) {
+                *index       = n;
+                *value_match = true;
+                return ret_ok;
+            }
+            name_index = n;
+        }
+    }
+
+    ret = hpack_header_index_find_hashed (&encoder->index, &encoder->table, name, value,
+                                          name_hash, pair_hash, &n, &match);
+    if (ret == ret_ok) {
+        if (match) {
+            *index       = HPACK_STATIC_TABLE_LEN + n;
+            *value_match = true;
+            return ret_ok;
+        }
+        if (name_index == 0) {
+            name_index = HPACK_STATIC_TABLE_LEN + n;
+        }
+    }
+
+    if (name_index == 0) {
+        return ret_not_found;
+    }
+
+    *index       = name_index;
+    *value_match = false;
+    return ret_ok;
+}
+
+/** Begin a header block
+ *
+ * Writes the dynamic table size updates pending since the previous
+ * header block [6.3.]. hpack_header_encoder_all() calls it; it is
+ * only needed when a block is encoded field by field.
+ *
+ * @param      encoder Header encoder
+ * @param[out] out     Buffer to append the header block to
+ * @retval ret_ok    Done
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_header_encoder_begin (hpack_header_encoder_t *encoder,
+                            chula_buffer_t         *out)
+{
+    ret_t ret;
+
+    if (! encoder->size_update) {
+        return ret_ok;
+    }
+
+    if (encoder->size_update_min < encoder->table.max_size) {
+        ret = add_integer (out, 5, 0x20, encoder->size_update_min);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    ret = add_integer (out, 5, 0x20, encoder->table.max_size);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    encoder->size_update = false;
+    return ret_ok;
+}
+
+/* Literal Header Field Representation [6.2.] of a field, given the
+ * index of its name (0 for a new name). The strings are encoded unless
+ * their representations are passed in @name_rep and @value_rep. A
+ * name representation found one octet into the free space of @out has
+ * been written in place by encode_lowercase().
+ */
+static ret_t
+emit_literal (hpack_header_encoder_t *encoder,
+              hpack_header_field_t   *field,
+              hpack_field_rep_t       rep,
+              cuint_t                 index,
+              uint32_t                name_hash,
+              uint32_t                pair_hash,
+              chula_buffer_t         *name_rep,
+              chula_buffer_t         *value_rep,
+              chula_buffer_t         *out)
+{
+    ret_t         ret;
+    size_t        size;
+    int           N;
+    unsigned char pattern;
+
+    /* Adding an entry larger than the table would just empty it [4.4.]
+     */
+    if ((rep == hpack_field_rep_literal_inc_index) ||
+        (rep == hpack_field_rep_indexed))
+    {
+        hpack_header_field_get_size (field, &size);
+
+        rep = (size <= encoder->table.max_size) ?
+            hpack_field_rep_literal_inc_index :
+            hpack_field_rep_literal_without_index;
+    }
+
+    switch (rep) {
+    case hpack_field_rep_literal_inc_index:
+        N       = 6;
+        pattern = 0x40;
+        break;
+    case hpack_field_rep_literal_never_index:
+        N       = 4;
+        pattern = 0x10;
+        break;
+    default:
+        N       = 4;
+        pattern = 0x00;
+        break;
+    }
+
+    if ((index == 0) && (name_rep != NULL) &&
+        (name_rep->buf == out->buf + out->len + 1))
+    {
+        /* The index of a new name fits in the first octet */
+        out->buf[out->len] = pattern;
+        out->len += 1 + name_rep->len;
+        out->buf[out->len] = '\0';
+    } else {
+        ret = add_integer (out, N, pattern, index);
+        if (unlikely (ret != ret_ok)) return ret;
+
+        if (index == 0) {
+            ret = (name_rep != NULL) ?
+                chula_buffer_add_buffer (out, name_rep) :
+                add_string (encoder, out, &field->name);
+            if (unlikely (ret != ret_ok)) return ret;
+        }
+    }
+
+    ret = (value_rep != NULL) ?
+        chula_buffer_add_buffer (out, value_rep) :
+        add_string (encoder, out, &field->value);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    /* Incremental indexing [6.2.1.]
+     */
+    if (rep == hpack_field_rep_literal_inc_index) {
+        ret = hpack_header_table_add (&encoder->table, &field->name, &field->value);
+        if (unlikely (ret != ret_ok)) return ret;
+
+        return hpack_header_index_add_hashed (&encoder->index, &encoder->table,
+                                              name_hash, pair_hash);
+    }
+
+    return ret_ok;
+}
+
+/* A name lowercased into @out by encode_lowercase() stays there when
+ * it is written raw as a new name. Otherwise it is moved to the
+ * encoder while it is still needed, before the index or its Huffman
+ * encoding are written over it.
+ */
+static ret_t
+place_name (hpack_header_encoder_t *encoder,
+            hpack_header_field_t   *field,
+            hpack_field_rep_t       rep,
+            cuint_t                 index,
+            chula_buffer_t        **name_rep)
+{
+    ret_t ret;
+
+    if ((index == 0) && (! encoder->huffman)) {
+        return ret_ok;
+    }
+
+    *name_rep = NULL;
+
+    /* An indexed name is only read again to add the field to the table
+     */
+    if ((index != 0) &&
+        (rep != hpack_field_rep_literal_inc_index) &&
+        (rep != hpack_field_rep_indexed))
+    {
+        return ret_ok;
+    }
+
+    chula_buffer_clean (&encoder->name);
+    ret = chula_buffer_add (&encoder->name, field->name.buf, field->name.len);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    chula_buffer_fake (&field->name, encoder->name.buf, encoder->name.len);
+    return ret_ok;
+}
+
+/* Body of hpack_header_encoder_field(), given the hash of the name.
+ * The name and pair hashes serve the lookups and the reverse index.
+ * @in_static is false when the name is known to be missing from the
+ * static table. @name_rep is the representation of the name when
+ * encode_lowercase() wrote it to @out, NULL otherwise.
+ */
+static ret_t
+encode_field (hpack_header_encoder_t *encoder,
+              hpack_header_field_t   *field,
+              uint32_t                name_hash,
+              bool                    in_static,
+              chula_buffer_t         *name_rep,
+              chula_buffer_t         *out)
+{
+    ret_t             ret;
+    hpack_field_rep_t rep;
+    cuint_t           index = 0;
+    bool              value_match = false;
+    uint32_t          pair_hash;
+
+    if (field->rep == hpack_field_rep_literal_never_index) {
+        rep = hpack_field_rep_literal_never_index;
+    } else {
+        rep = encoder->policy->rep (encoder->policy, encoder, field);
+    }
+
+    pair_hash = hpack_hash (field->value.buf, field->value.len, name_hash);
+
+    ret = find (encoder, &field->name,
+                (rep != hpack_field_rep_literal_never_index) ? &field->value : NULL,
+                name_hash, pair_hash, in_static, &index, &value_match);
+    if (ret != ret_ok) {
+        index = 0;
+    }
+
+    /* Indexed Header Field Representation [6.1.]
+     */
+    if (value_match) {
+        return add_integer (out, 7, 0x80, index);
+    }
+
+    if (name_rep != NULL) {
+        ret = place_name (encoder, field, rep, index, &name_rep);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    return emit_literal (encoder, field, rep, index, name_hash, pair_hash, name_rep, NULL, out);
+}
+
+/* Encodes a field under a lowercased copy of its name. The name is
+ * lowercased, checked and hashed in a single pass, straight into @out
+ * where a raw new name goes: behind the first octet of the field and
+ * the length of the string. Nothing is written to @out before
+ * place_name() decides where the name goes, and room for the whole
+ * field is made first so that it does not move either.
+ */
+static ret_t
+encode_lowercase (hpack_header_encoder_t *encoder,
+                  hpack_header_field_t   *field,
+                  chula_buffer_t         *out)
+{
+    ret_t                ret;
+    size_t               head;
+    char                *dst;
+    uint32_t             name_hash = HPACK_HASH_INIT;
+    chula_buffer_t       name_rep;
+    hpack_header_field_t lowered;
+
+    ret = chula_buffer_ensure_addlen (out, 1 + 2 * INTEGER_MAX_LEN_64 +
+                                      (size_t) field->name.len + field->value.len);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    head = integer_encode_prefix (7, 0x00, field->name.len,
+                                  (unsigned char *) out->buf + out->len + 1);
+    dst  = out->buf + out->len + 1 + head;
+
+    ret = hpack_literal_lower_name_hash (dst, field->name.buf, field->name.len, &name_hash);
+    if (unlikely (ret != ret_ok)) return ret_error;
+
+    chula_buffer_fake (&name_rep, out->buf + out->len + 1, head + field->name.len);
+
+    lowered = *field;
+    chula_buffer_fake (&lowered.name, dst, field->name.len);
+    lowered.name_view = true;
+
+    return encode_field (encoder, &lowered, name_hash, true, &name_rep, out);
+}
+
+/** Encode a header field
+ *
+ * Appends the representation of a header field to a header block
+ * [6.]. A field matching a header table entry is indexed. Otherwise
+ * the indexing policy picks the literal representation, reusing the
+ * name of a table entry when there is one. Fields decoded as never
+ * indexed keep that representation whatever the policy says, as
+ * intermediaries must [6.2.3.].
+ *
+ * @param      encoder Header encoder
+ * @param      field   Header field to encode
+ * @param[out] out     Buffer to append the representation to
+ * @retval ret_ok    The field was encoded
+ * @retval ret_error The name is not valid, when lowercasing names
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_header_encoder_field (hpack_header_encoder_t *encoder,
+                            hpack_header_field_t   *field,
+                            chula_buffer_t         *out)
+{
+    if (encoder->lowercase) {
+        return encode_lowercase (encoder, field, out);
+    }
+
+    return encode_field (encoder, field,
+                         hpack_hash (field->name.buf, field->name.len, HPACK_HASH_INIT),
+                         true, NULL, out);
+}
+
+/** Encode a header list
+ *
+ * Appends a header block encoding every field of a list of
+ * hpack_header_field_t objects, in order.
+ *
+ * @param      encoder Header encoder
+ * @param      fields  Header fields to encode
+ * @param[out] out     Buffer to append the header block to
+ * @retval ret_ok    The list was encoded
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_header_encoder_all (hpack_header_encoder_t *encoder,
+                          chula_list_t           *fields,
+                          chula_buffer_t         *out)
+{
+    ret_t         ret;
+    chula_list_t *i;
+
+    ret = hpack_header_encoder_begin (encoder, out);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    list_for_each (i, fields) {
+        ret = hpack_header_encoder_field (encoder, HDR_FIELD(i), out);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    return ret_ok;
+}
+
+/* Upper bound of the representation of a field besides its strings: a
+ * literal with a new name, that is a first octet and two string
+ * lengths [5.1.]. Strings are only Huffman encoded when shorter. A
+ * block starts with up to two table size updates [6.3.].
+ */
+#define FIELD_MAX_OVERHEAD (1 + 2 * INTEGER_MAX_LEN)
+#define BLOCK_MAX_OVERHEAD (2 * INTEGER_MAX_LEN)
+
+/* Names seen in a batch, and what encoding them involves regardless
+ * of the value: their hash, and whether the static table has them.
+ * Direct mapped on the length and the outer octets of the name.
+ */
+#define BATCH_NAMES_BITS 6
+
+typedef struct {
+    const char *buf;
+    cuint_t     len;
+    uint32_t    hash;
+    bool        in_static;
+} batch_name_t;
+
+static ret_t
+encode_batch_field (hpack_header_encoder_t *encoder,
+                    batch_name_t           *names,
+                    hpack_header_field_t   *field,
+                    chula_buffer_t         *out)
+{
+    cuint_t       slot;
+    batch_name_t *seen;
+    cuint_t       len = field->name.len;
+
+    if (unlikely (len == 0)) {
+        return hpack_header_encoder_field (encoder, field, out);
+    }
+
+    slot = (len ^ ((unsigned char) field->name.buf[0] << 1) ^
+            ((unsigned char) field->name.buf[len - 1] << 3)) & ((1u << BATCH_NAMES_BITS) - 1);
+    seen = &names[slot];
+
+    if ((seen->len != len) || (memcmp (seen->buf, field->name.buf, len) != 0)) {
+        seen->buf       = field->name.buf;
+        seen->len       = len;
+        seen->hash      = hpack_hash (field->name.buf, len, HPACK_HASH_INIT);
+        seen->in_static = (hpack_static_table_find_id (&field->name, seen->hash) !=
+                           hpack_header_id_unknown);
+    }
+
+    return encode_field (encoder, field, seen->hash, seen->in_static, NULL, out);
+}
+
+/** Encode a batch of header lists
+ *
+ * Appends one header block per list, back to back, as if
+ * hpack_header_encoder_all() had been called on each. The output is
+ * grown once for the whole batch, and pending table size updates are
+ * written in front of the first block only. A name repeated across
+ * the batch is hashed, and looked up in the static table, once.
+ *
+ * @param      encoder Header encoder
+ * @param      lists   Array of @num lists of hpack_header_field_t objects
+ * @param      num     Number of lists
+ * @param[out] out     Buffer to append the header blocks to
+ * @param[out] ends    If not NULL, length of @out after each block
+ * @retval ret_ok    The lists were encoded
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_header_encoder_batch (hpack_header_encoder_t *encoder,
+                            chula_list_t           *lists,
+                            cuint_t                 num,
+                            chula_buffer_t         *out,
+                            cuint_t                *ends)
+{
+    ret_t                 ret;
+    cuint_t               n;
+    chula_list_t         *i;
+    hpack_header_field_t *field;
+    size_t                len = BLOCK_MAX_OVERHEAD;
+    batch_name_t          names[1 << BATCH_NAMES_BITS];
+
+    for (n = 0; n < num; n++) {
+        list_for_each (i, &lists[n]) {
+            field = HDR_FIELD(i);
+            len += field->name.len + field->value.len + FIELD_MAX_OVERHEAD;
+        }
+    }
+
+    ret = chula_buffer_ensure_addlen (out, len);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    ret = hpack_header_encoder_begin (encoder, out);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    memset (names, 0, sizeof(names));
+
+    /* Lowercased names are hashed as they are written anyway
+     */
+    for (n = 0; n < num; n++) {
+        list_for_each (i, &lists[n]) {
+            ret = encoder->lowercase ?
+                hpack_header_encoder_field (encoder, HDR_FIELD(i), out) :
+                encode_batch_field (encoder, names, HDR_FIELD(i), out);
+            if (unlikely (ret != ret_ok)) return ret;
+        }
+
+        if (ends != NULL) {
+            ends[n] = out->len;
+        }
+    }
+
+    return ret_ok;
+}
+
+/** Encode a packed header list
+ *
+ * Appends a header block encoding every field of an
+ * hpack_header_list_t, in order. The hashes of the names cached by the
+ * list are used for the lookups, and the output is grown once.
+ *
+ * @param      encoder Header encoder
+ * @param      list    Header fields to encode
+ * @param[out] out     Buffer to append the header block to
+ * @retval ret_ok    The list was encoded
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_header_encoder_list (hpack_header_encoder_t *encoder,
+                           hpack_header_list_t    *list,
+                           chula_buffer_t         *out)
+{
+    ret_t                ret;
+    cuint_t              n;
+    hpack_header_field_t field;
+
+    ret = chula_buffer_ensure_addlen (out, BLOCK_MAX_OVERHEAD + list->data.len +
+                                      (size_t)list->num * FIELD_MAX_OVERHEAD);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    ret = hpack_header_encoder_begin (encoder, out);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    /* Each field is presented to the policy as a view into the list */
+    hpack_header_field_init (&field);
+    field.name_view  = true;
+    field.value_view = true;
+
+    for (n = 0; n < list->num; n++) {
+        chula_buffer_fake (&field.name,  HPACK_LIST_NAME(list, n),  list->name_len[n]);
+        chula_buffer_fake (&field.value, HPACK_LIST_VALUE(list, n), list->value_len[n]);
+        field.rep = HPACK_LIST_REP(list, n);
+
+        if (encoder->lowercase) {
+            ret = encode_lowercase (encoder, &field, out);
+        } else {
+            ret = encode_field (encoder, &field, list->name_hash[n], true, NULL, out);
+        }
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    return ret_ok;
+}
+
+/* Appends the String Literal Representation of a string to the
+ * representations of a template, and records where it went.
+ */
+static ret_t
+compile_string (hpack_header_encoder_t  *encoder,
+                hpack_header_template_t *tmpl,
+                const char              *str,
+                cuint_t                  len,
+                uint32_t                *off,
+                uint32_t                *rep_len)
+{
+    ret_t          ret;
+    chula_buffer_t buf;
+
+    chula_buffer_fake (&buf, str, len);
+
+    *off = tmpl->reps.len;
+
+    ret = encode_string (encoder, &tmpl->reps, &buf);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    *rep_len = tmpl->reps.len - *off;
+    return ret_ok;
+}
+
+/** Compile a header template
+ *
+ * Precomputes what encoding a header list involves regardless of the
+ * dynamic table: its static table matches, the hashes used for the
+ * dynamic table lookups, and the representations of the strings,
+ * Huffman encoded when the encoder would. Names are lowercased and
+ * checked when the encoder does so. The dynamic table of the encoder
+ * is not involved, and the template can be encoded by any encoder.
+ *
+ * @param      encoder Header encoder
+ * @param      list    Header fields of the template
+ * @param[out] tmpl    Header template, emptied first
+ * @retval ret_ok    The template was compiled
+ * @retval ret_error A name is not valid, when lowercasing names
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_header_encoder_compile (hpack_header_encoder_t  *encoder,
+                              hpack_header_list_t     *list,
+                              hpack_header_template_t *tmpl)
+{
+    ret_t                          ret;
+    cuint_t                        n;
+    bool                           match;
+    chula_buffer_t                 name;
+    chula_buffer_t                 value;
+    const char                    *str;
+    hpack_header_template_field_t *f;
+    hpack_header_list_t           *fields = &tmpl->list;
+
+    hpack_header_template_mrproper (tmpl);
+
+    for (n = 0; n < list->num; n++) {
+        str = HPACK_LIST_NAME(list, n);
+
+        if (encoder->lowercase) {
+            chula_buffer_clean (&encoder->name);
+            ret = chula_buffer_ensure_addlen (&encoder->name, list->name_len[n]);
+            if (unlikely (ret != ret_ok)) return ret;
+
+            ret = hpack_literal_lower_name (encoder->name.buf, str, list->name_len[n]);
+            if (unlikely (ret != ret_ok)) return ret_error;
+
+            str = encoder->name.buf;
+        }
+
+        ret = hpack_header_list_add (fields, str, list->name_len[n],
+                                     HPACK_LIST_VALUE(list, n), list->value_len[n],
+                                     HPACK_LIST_REP(list, n));
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    if (fields->num == 0) {
+        return ret_ok;
+    }
+
+    tmpl->fields = (hpack_header_template_field_t *) malloc (fields->num * sizeof(hpack_header_template_field_t));
+    if (unlikely (tmpl->fields == NULL)) {
+        return ret_nomem;
+    }
+
+    for (n = 0; n < fields->num; n++) {
+        f = &tmpl->fields[n];
+
+        chula_buffer_fake (&name,  HPACK_LIST_NAME(fields, n),  fields->name_len[n]);
+        chula_buffer_fake (&value, HPACK_LIST_VALUE(fields, n), fields->value_len[n]);
+
+        f->pair_hash   = hpack_hash (value.buf, value.len, fields->name_hash[n]);
+        f->static_pair = 0;
+        f->static_name = 0;
+        f->name_off    = 0;
+        f->name_len    = 0;
+
+        ret = hpack_static_table_find_hashed (&name, NULL, fields->name_hash[n], f->pair_hash,
+                                              &f->static_name, &match);
+        if (ret != ret_ok) {
+            f->static_name = 0;
+        }
+
+        if ((f->static_name != 0) && (HPACK_LIST_REP(fields, n) != hpack_field_rep_literal_never_index)) {
+            ret = hpack_static_table_find_hashed (&name, &value, fields->name_hash[n], f->pair_hash,
+                                                  &f->static_pair, &match);
+            if ((ret != ret_ok) || (! match)) {
+                f->static_pair = 0;
+            }
+        }
+
+        /* The policy may still pick a never indexed literal, so the
+         * value is needed even on a static match.
+         */
+        if (f->static_name == 0) {
+            ret = compile_string (encoder, tmpl, name.buf, name.len, &f->name_off, &f->name_len);
+            if (unlikely (ret != ret_ok)) return ret;
+        }
+
+        ret = compile_string (encoder, tmpl, value.buf, value.len, &f->value_off, &f->value_len);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    return ret_ok;
+}
+
+/** Encode a header template
+ *
+ * Appends a header block encoding the fields of a compiled template,
+ * exactly as hpack_header_encoder_list() would encode them. Only the
+ * indexing policy and the dynamic table are consulted; the strings are
+ * copied from the template.
+ *
+ * @param      encoder Header encoder
+ * @param      tmpl    Header template
+ * @param[out] out     Buffer to append the header block to
+ * @retval ret_ok    The template was encoded
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_header_encoder_template (hpack_header_encoder_t  *encoder,
+                               hpack_header_template_t *tmpl,
+                               chula_buffer_t          *out)
+{
+    ret_t                          ret;
+    cuint_t                        n;
+    cuint_t                        index;
+    bool                           match;
+    hpack_field_rep_t              rep;
+    hpack_header_field_t           field;
+    chula_buffer_t                 name_rep;
+    chula_buffer_t                 value_rep;
+    hpack_header_template_field_t *f;
+    hpack_header_list_t           *fields = &tmpl->list;
+
+    ret = chula_buffer_ensure_addlen (out, BLOCK_MAX_OVERHEAD + tmpl->reps.len +
+                                      (size_t)fields->num * FIELD_MAX_OVERHEAD);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    ret = hpack_header_encoder_begin (encoder, out);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    hpack_header_field_init (&field);
+    field.name_view  = true;
+    field.value_view = true;
+
+    for (n = 0; n < fields->num; n++) {
+        f = &tmpl->fields[n];
+
+        chula_buffer_fake (&field.name,  HPACK_LIST_NAME(fields, n),  fields->name_len[n]);
+        chula_buffer_fake (&field.value, HPACK_LIST_VALUE(fields, n), fields->value_len[n]);
+        field.rep = HPACK_LIST_REP(fields, n);
+
+        if (field.rep == hpack_field_rep_literal_never_index) {
+            rep = hpack_field_rep_literal_never_index;
+        } else {
+            rep = encoder->policy->rep (encoder->policy, encoder, &field);
+        }
+
+        /* Same preference order as find()
+         */
+        if ((f->static_pair != 0) && (rep != hpack_field_rep_literal_never_index)) {
+            ret = add_integer (out, 7, 0x80, f->static_pair);
+            if (unlikely (ret != ret_ok)) return ret;
+            continue;
+        }
+
+        ret = hpack_header_index_find_hashed (&encoder->index, &encoder->table, &field.name,
+                                              (rep != hpack_field_rep_literal_never_index) ? &field.value : NULL,
+                                              fields->name_hash[n], f->pair_hash, &index, &match);
+        if (ret == ret_ok) {
+            if (match) {
+                ret = add_integer (out, 7, 0x80, HPACK_STATIC_TABLE_LEN + index);
+                if (unlikely (ret != ret_ok)) return ret;
+                continue;
+            }
+            index += HPACK_STATIC_TABLE_LEN;
+        } else {
+            index = 0;
+        }
+
+        if (f->static_name != 0) {
+            index = f->static_name;
+        }
+
+        chula_buffer_fake (&name_rep,  tmpl->reps.buf + f->name_off,  f->name_len);
+        chula_buffer_fake (&value_rep, tmpl->reps.buf + f->value_off, f->value_len);
+
+        ret = emit_literal (encoder, &field, rep, index, fields->name_hash[n], f->pair_hash,
+                            &name_rep, &value_rep, out);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    return ret_ok;
+}
@@ -0,0 +1,119 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBHPACK_HEADER_ENCODER_H
+#define LIBHPACK_HEADER_ENCODER_H
+
+#include <libhpack/common.h>
+#include <libhpack/header_field.h>
+#include <libhpack/header_table.h>
+#include <libhpack/header_index.h>
+#include <libhpack/header_list.h>
+#include <libhpack/huffman_cache.h>
+#include <libhpack/header_template.h>
+#include <libchula/buffer.h>
+#include <libchula/list.h>
+
+typedef struct hpack_header_encoder hpack_header_encoder_t;
+typedef struct hpack_encoder_policy hpack_encoder_policy_t;
+
+/* Indexing policy
+ */
+typedef hpack_field_rep_t (*hpack_policy_rep_func_t) (hpack_encoder_policy_t *policy,
+                                                      hpack_header_encoder_t *encoder,
+                                                      hpack_header_field_t   *field);
+
+struct hpack_encoder_policy {
+    /* Virtual methods */
+    hpack_policy_rep_func_t rep;     /**< Literal representation of a field */
+};
+
+#define HPACK_POLICY(p) ((hpack_encoder_policy_t *)(p))
+
+ret_t             hpack_encoder_policy_init        (hpack_encoder_policy_t *policy);
+hpack_field_rep_t hpack_encoder_policy_default_rep (hpack_encoder_policy_t *policy,
+                                                    hpack_header_encoder_t *encoder,
+                                                    hpack_header_field_t   *field);
+
+/* Header encoder
+ */
+struct hpack_header_encoder {
+    hpack_header_table_t    table;           /**< Encoding context [2.2.]             */
+    hpack_header_index_t    index;           /**< Reverse index of the dynamic table  */
+    hpack_encoder_policy_t *policy;          /**< Indexing policy                     */
+    hpack_encoder_policy_t  default_policy;  /**< Policy used when none is set        */
+    bool                    huffman;         /**< Huffman encode when it is shorter   */
+    hpack_huffman_cache_t  *cache;           /**< Encoded strings, NULL if none       */
+    bool                    lowercase;       /**< Lowercase and check names           */
+    chula_buffer_t          name;            /**< Lowercased name, off the output     */
+    bool                    size_update;     /**< A table size update is pending      */
+    size_t                  size_update_min; /**< Smallest size since the last update */
+};
+
+#define HDR_ENCODER(e) ((hpack_header_encoder_t *)(e))
+
+ret_t hpack_header_encoder_new      (hpack_header_encoder_t **encoder);
+ret_t hpack_header_encoder_free     (hpack_header_encoder_t  *encoder);
+ret_t hpack_header_encoder_init     (hpack_header_encoder_t  *encoder);
+ret_t hpack_header_encoder_mrproper (hpack_header_encoder_t  *encoder);
+ret_t hpack_header_encoder_reset    (hpack_header_encoder_t  *encoder);
+
+ret_t hpack_header_encoder_set_policy   (hpack_header_encoder_t *encoder, hpack_encoder_policy_t *policy);
+ret_t hpack_header_encoder_set_max_size (hpack_header_encoder_t *encoder, size_t max_size);
+ret_t hpack_header_encoder_set_lowercase (hpack_header_encoder_t *encoder, bool lowercase);
+ret_t hpack_header_encoder_set_cache     (hpack_header_encoder_t *encoder, hpack_huffman_cache_t *cache);
+
+ret_t hpack_header_encoder_begin    (hpack_header_encoder_t *encoder,
+                                     chula_buffer_t         *out);
+ret_t hpack_header_encoder_field    (hpack_header_encoder_t *encoder,
+                                     hpack_header_field_t   *field,
+                                     chula_buffer_t         *out);
+ret_t hpack_header_encoder_all      (hpack_header_encoder_t *encoder,
+                                     chula_list_t           *fields,
+                                     chula_buffer_t         *out);
+ret_t hpack_header_encoder_batch    (hpack_header_encoder_t *encoder,
+                                     chula_list_t           *lists,
+                                     cuint_t                 num,
+                                     chula_buffer_t         *out,
+                                     cuint_t                *ends);
+ret_t hpack_header_encoder_list     (hpack_header_encoder_t *encoder,
+                                     hpack_header_list_t    *list,
+                                     chula_buffer_t         *out);
+
+ret_t hpack_header_encoder_compile  (hpack_header_encoder_t  *encoder,
+                                     hpack_header_list_t     *list,
+                                     hpack_header_template_t *tmpl);
+ret_t hpack_header_encoder_template (hpack_header_encoder_t  *encoder,
+                                     hpack_header_template_t *tmpl,
+                                     chula_buffer_t          *out);
+
+#endif /* LIBHPACK_HEADER_ENCODER_H */
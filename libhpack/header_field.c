@@ -0,0 +1,190 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "header_field.h"
+
+#include <libchula/macros.h>
+
+/* Implements _new() and _free()
+ */
+HPACK_ADD_FUNC_NEW  (header_field);
+HPACK_ADD_FUNC_FREE (header_field);
+
+ret_t
+hpack_header_field_init (hpack_header_field_t *field)
+{
+    INIT_LIST_HEAD (&field->entry);
+    chula_buffer_init (&field->name);
+    chula_buffer_init (&field->value);
+    field->rep        = hpack_field_rep_literal_without_index;
+    field->id         = hpack_header_id_unknown;
+    field->name_view  = false;
+    field->value_view = false;
+
+    return ret_ok;
+}
+
+/* Views do not own their memory: they are dropped, not freed
+ */
+static void
+buffer_release (chula_buffer_t *buf, bool *view)
+{
+    if (*view) {
+        chula_buffer_init (buf);
+        *view = false;
+        return;
+    }
+
+    chula_buffer_mrproper (buf);
+}
+
+static void
+buffer_clean (chula_buffer_t *buf, bool *view)
+{
+    if (*view) {
+        chula_buffer_init (buf);
+        *view = false;
+        return;
+    }
+
+    chula_buffer_clean (buf);
+}
+
+ret_t
+hpack_header_field_mrproper (hpack_header_field_t *field)
+{
+    buffer_release (&field->name,  &field->name_view);
+    buffer_release (&field->value, &field->value_view);
+
+    return ret_ok;
+}
+
+void
+hpack_header_field_clean (hpack_header_field_t *field)
+{
+    buffer_clean (&field->name,  &field->name_view);
+    buffer_clean (&field->value, &field->value_view);
+    field->rep = hpack_field_rep_literal_without_index;
+    field->id  = hpack_header_id_unknown;
+}
+
+/** Point a header field string to external memory
+ *
+ * Turns the name or value of a header field into a read-only view of
+ * @str, releasing the memory it owned. Views are not NUL terminated,
+ * and are only valid as long as @str is. They must not be written
+ * to; hpack_header_field_clean() drops them.
+ *
+ * @param buf  Name or value of a header field
+ * @param view View flag of @buf: name_view or value_view
+ * @param str  Memory to point to
+ * @param len  Length of @str
+ */
+void
+hpack_header_field_set_view (chula_buffer_t *buf,
+                             bool           *view,
+                             const char     *str,
+                             cuint_t         len)
+{
+    buffer_release (buf, view);
+
+    chula_buffer_fake (buf, str, len);
+    *view = true;
+}
+
+/** Copy a header field
+ *
+ * Copies the name, value and representation of a header field into
+ * another one. The list entry of the destination is left untouched.
+ *
+ * @param      field Header field to copy
+ * @param[out] copy  Header field to copy it to
+ * @retval ret_ok    The field was copied
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_header_field_copy (hpack_header_field_t *field,
+                         hpack_header_field_t *copy)
+{
+    ret_t ret;
+
+    buffer_clean (&copy->name,  &copy->name_view);
+    buffer_clean (&copy->value, &copy->value_view);
+
+    ret = chula_buffer_add_buffer (&copy->name, &field->name);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    ret = chula_buffer_add_buffer (&copy->value, &field->value);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    copy->rep = field->rep;
+    copy->id  = field->id;
+    return ret_ok;
+}
+
+/** Size of a header field
+ *
+ * The size of an entry is the sum of its name's length in octets, its
+ * value's length in octets and 32 [4.1.]
+ *
+ * @param      field Header field
+ * @param[out] size  Size of the field
+ * @retval ret_ok Always
+ */
+ret_t
+hpack_header_field_get_size (hpack_header_field_t *field,
+                             size_t               *size)
+{
+    *size = field->name.len + field->value.len + HPACK_HEADER_ENTRY_OVERHEAD;
+    return ret_ok;
+}
+
+/** Free a list of header fields
+ *
+ * Frees every header field of a chula_list_t, as the ones built by
+ * hpack_header_parser_all().
+ *
+ * @param fields List of hpack_header_field_t objects
+ * @retval ret_ok Always
+ */
+ret_t
+hpack_header_field_list_free (chula_list_t *fields)
+{
+    chula_list_t *i, *j;
+
+    list_for_each_safe (i, j, fields) {
+        chula_list_del (i);
+        hpack_header_field_free (HDR_FIELD(i));
+    }
+
+    return ret_ok;
+}
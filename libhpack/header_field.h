@@ -0,0 +1,77 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBHPACK_HEADER_FIELD_H
+#define LIBHPACK_HEADER_FIELD_H
+
+#include <libhpack/common.h>
+#include <libhpack/static_table.h>
+#include <libchula/buffer.h>
+#include <libchula/list.h>
+
+/** Header field representations [6.]
+ */
+typedef enum {
+    hpack_field_rep_indexed,               /**< Indexed header field               */
+    hpack_field_rep_literal_inc_index,     /**< Literal with incremental indexing  */
+    hpack_field_rep_literal_without_index, /**< Literal without indexing           */
+    hpack_field_rep_literal_never_index,   /**< Literal never indexed              */
+} hpack_field_rep_t;
+
+typedef struct {
+    chula_list_t      entry;
+    chula_buffer_t    name;
+    chula_buffer_t    value;
+    hpack_field_rep_t rep;
+    hpack_header_id_t id;         /**< ID of @name, set by the decoder      */
+    bool              name_view;  /**< @name points into the decoder input  */
+    bool              value_view; /**< @value points into the decoder input */
+} hpack_header_field_t;
+
+#define HDR_FIELD(f) ((hpack_header_field_t *)(f))
+
+/* Size of an entry of the header table [4.1.]
+ */
+#define HPACK_HEADER_ENTRY_OVERHEAD 32
+
+ret_t hpack_header_field_new      (hpack_header_field_t **field);
+ret_t hpack_header_field_free     (hpack_header_field_t  *field);
+ret_t hpack_header_field_init     (hpack_header_field_t  *field);
+ret_t hpack_header_field_mrproper (hpack_header_field_t  *field);
+void  hpack_header_field_clean    (hpack_header_field_t  *field);
+ret_t hpack_header_field_copy     (hpack_header_field_t  *field, hpack_header_field_t *copy);
+ret_t hpack_header_field_get_size (hpack_header_field_t  *field, size_t *size);
+void  hpack_header_field_set_view (chula_buffer_t *buf, bool *view, const char *str, cuint_t len);
+
+ret_t hpack_header_field_list_free (chula_list_t *fields);
+
+#endif /* LIBHPACK_HEADER_FIELD_H */
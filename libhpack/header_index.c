@@ -0,0 +1,441 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Current ref:
+ * http://tools.ietf.org/html/rfc7541
+ */
+
+#include "header_index.h"
+#include "hash.h"
+
+#include <libchula/macros.h>
+#include <string.h>
+
+/* Reverse index of the dynamic table, for the encoder.
+ *
+ * Two open addressing hash tables map a name/value pair and a name to
+ * the insertion counter of the newest entry holding them. The index of
+ * an entry is derived from its counter: the newest entry has the
+ * counter of the last insertion, and the one before it that counter
+ * minus one. An entry is live as long as that distance is within the
+ * number of entries of the table, so evicted entries just go stale:
+ * their slots are reused by later insertions, and the arrays are only
+ * rebuilt when stale slots pile up.
+ */
+
+#define MIN_BITS     4
+#define EMPTY        0
+#define USED_BIT     0x80000000u
+#define MAX_LOAD(i)  ((3u << (i)->bits) / 4)
+
+typedef enum {
+    key_pair,
+    key_name
+} index_key_t;
+
+ret_t
+hpack_header_index_init (hpack_header_index_t *index)
+{
+    index->pairs      = NULL;
+    index->names      = NULL;
+    index->bits       = 0;
+    index->used_pairs = 0;
+    index->used_names = 0;
+    index->last       = 0;
+
+    return ret_ok;
+}
+
+ret_t
+hpack_header_index_mrproper (hpack_header_index_t *index)
+{
+    free (index->pairs);
+    free (index->names);
+
+    return hpack_header_index_init (index);
+}
+
+/** Empty a reverse index
+ *
+ * Forgets every entry, keeping the arrays. The index can then follow
+ * a table that was emptied as well.
+ *
+ * @param index Reverse index
+ */
+void
+hpack_header_index_clean (hpack_header_index_t *index)
+{
+    if (index->pairs != NULL) {
+        memset (index->pairs, 0, sizeof(hpack_header_index_slot_t) << index->bits);
+        memset (index->names, 0, sizeof(hpack_header_index_slot_t) << index->bits);
+    }
+
+    index->used_pairs = 0;
+    index->used_names = 0;
+}
+
+/* Position in the dynamic table (1 is the newest entry) of the entry
+ * with a counter, or 0 if it has been evicted.
+ */
+static cuint_t
+position (hpack_header_table_t *table,
+          uint32_t              counter)
+{
+    uint32_t distance = table->inserted - counter;
+
+    if (distance >= table->num) {
+        return 0;
+    }
+
+    return distance + 1;
+}
+
+static bool
+entry_is (hpack_header_table_t *table,
+          cuint_t               pos,
+          index_key_t           key,
+          chula_buffer_t       *name,
+          chula_buffer_t       *value)
+{
+    chula_buffer_t ename;
+    chula_buffer_t evalue;
+
+    hpack_header_table_get (table, HPACK_STATIC_TABLE_LEN + pos, &ename, &evalue);
+
+    if ((ename.len != name->len) ||
+        (memcmp (ename.buf, name->buf, name->len) != 0))
+    {
+        return false;
+    }
+
+    if (key == key_name) {
+        return true;
+    }
+
+    return ((evalue.len == value->len) &&
+            (memcmp (evalue.buf, value->buf, value->len) == 0));
+}
+
+/* Points the slot of a key to a counter. Stale slots found on the
+ * probe sequence are reused.
+ */
+static void
+slot_set (hpack_header_index_t      *index,
+          hpack_header_index_slot_t *slots,
+          cuint_t                   *used,
+          hpack_header_table_t      *table,
+          index_key_t                key,
+          uint32_t                   hash,
+          uint32_t                   counter,
+          chula_buffer_t            *name,
+          chula_buffer_t            *value)
+{
+    cuint_t                    pos;
+    cuint_t                    mask  = (1u << index->bits) - 1;
+    cuint_t                    i     = HPACK_HASH_SLOT (hash, 0, index->bits);
+    hpack_header_index_slot_t *reuse = NULL;
+
+    while (slots[i].hash != EMPTY) {
+        pos = position (table, slots[i].counter);
+
+        if (pos == 0) {
+            if (reuse == NULL) {
+                reuse = &slots[i];
+            }
+        } else if ((slots[i].hash == hash) &&
+                   entry_is (table, pos, key, name, value))
+        {
+            slots[i].counter = counter;
+            return;
+        }
+
+        i = (i + 1) & mask;
+    }
+
+    if (reuse == NULL) {
+        reuse = &slots[i];
+        *used += 1;
+    }
+
+    reuse->hash    = hash;
+    reuse->counter = counter;
+}
+
+static void
+index_entry (hpack_header_index_t *index,
+             hpack_header_table_t *table,
+             cuint_t               pos,
+             uint32_t              name_hash,
+             uint32_t              pair_hash)
+{
+    uint32_t       counter;
+    chula_buffer_t name;
+    chula_buffer_t value;
+
+    hpack_header_table_get (table, HPACK_STATIC_TABLE_LEN + pos, &name, &value);
+
+    counter = table->inserted - (pos - 1);
+
+    slot_set (index, index->names, &index->used_names, table, key_name,
+              name_hash | USED_BIT, counter, &name, NULL);
+    slot_set (index, index->pairs, &index->used_pairs, table, key_pair,
+              pair_hash | USED_BIT, counter, &name, &value);
+}
+
+static void
+index_entry_hash (hpack_header_index_t *index,
+                  hpack_header_table_t *table,
+                  cuint_t               pos)
+{
+    uint32_t       hash;
+    chula_buffer_t name;
+    chula_buffer_t value;
+
+    hpack_header_table_get (table, HPACK_STATIC_TABLE_LEN + pos, &name, &value);
+
+    hash = hpack_hash (name.buf, name.len, HPACK_HASH_INIT);
+    index_entry (index, table, pos, hash, hpack_hash (value.buf, value.len, hash));
+}
+
+/* Sizes the arrays for the largest table allowed by the settings, and
+ * indexes the live entries again, oldest first, dropping stale slots.
+ */
+static ret_t
+rebuild (hpack_header_index_t *index,
+         hpack_header_table_t *table)
+{
+    cuint_t bits;
+    cuint_t n;
+    size_t  slots;
+
+    bits = MIN_BITS;
+    while ((1u << bits) < 2 * (table->settings_size / HPACK_HEADER_ENTRY_OVERHEAD)) {
+        bits++;
+    }
+
+    if ((index->pairs == NULL) || (bits != index->bits)) {
+        free (index->pairs);
+        free (index->names);
+
+        slots = (size_t)1 << bits;
+
+        index->pairs = (hpack_header_index_slot_t *) malloc (slots * sizeof(hpack_header_index_slot_t));
+        index->names = (hpack_header_index_slot_t *) malloc (slots * sizeof(hpack_header_index_slot_t));
+        index->bits  = bits;
+
+        if (unlikely ((index->pairs == NULL) || (index->names == NULL))) {
+            hpack_header_index_mrproper (index);
+            return ret_nomem;
+        }
+    }
+
+    memset (index->pairs, 0, sizeof(hpack_header_index_slot_t) << bits);
+    memset (index->names, 0, sizeof(hpack_header_index_slot_t) << bits);
+    index->used_pairs = 0;
+    index->used_names = 0;
+
+    for (n = table->num; n > 0; n--) {
+        index_entry_hash (index, table, n);
+    }
+
+    return ret_ok;
+}
+
+/** Index the newest entry of a header table
+ *
+ * Must be called after every insertion into the dynamic table the
+ * index follows. Evictions need no bookkeeping.
+ *
+ * @param index Reverse index
+ * @param table Header table
+ * @retval ret_ok    The entry was indexed
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_header_index_add (hpack_header_index_t *index,
+                        hpack_header_table_t *table)
+{
+    uint32_t       hash;
+    chula_buffer_t name;
+    chula_buffer_t value;
+
+    if ((table->inserted == index->last) || (table->num == 0)) {
+        index->last = table->inserted;
+        return ret_ok;
+    }
+
+    hpack_header_table_get (table, HPACK_STATIC_TABLE_LEN + 1, &name, &value);
+
+    hash = hpack_hash (name.buf, name.len, HPACK_HASH_INIT);
+    return hpack_header_index_add_hashed (index, table, hash,
+                                          hpack_hash (value.buf, value.len, hash));
+}
+
+/** Index the newest entry of a header table, given its hashes
+ *
+ * Same as hpack_header_index_add(), for callers that already hashed
+ * the entry with hpack_hash(): @name_hash from HPACK_HASH_INIT, and
+ * @pair_hash of the value from @name_hash.
+ *
+ * @param index     Reverse index
+ * @param table     Header table
+ * @param name_hash Hash of the name of the entry
+ * @param pair_hash Hash of the name and value of the entry
+ * @retval ret_ok    The entry was indexed
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_header_index_add_hashed (hpack_header_index_t *index,
+                               hpack_header_table_t *table,
+                               uint32_t              name_hash,
+                               uint32_t              pair_hash)
+{
+    /* Nothing was inserted: the entry did not fit in the table */
+    if (table->inserted == index->last) {
+        return ret_ok;
+    }
+
+    index->last = table->inserted;
+
+    if ((index->pairs == NULL) ||
+        (index->used_pairs >= MAX_LOAD(index)) ||
+        (index->used_names >= MAX_LOAD(index)) ||
+        ((1u << index->bits) < 2 * table->num))
+    {
+        return rebuild (index, table);
+    }
+
+    index_entry (index, table, 1, name_hash, pair_hash);
+    return ret_ok;
+}
+
+static cuint_t
+slot_find (hpack_header_index_t      *index,
+           hpack_header_index_slot_t *slots,
+           hpack_header_table_t      *table,
+           index_key_t                key,
+           uint32_t                   hash,
+           chula_buffer_t            *name,
+           chula_buffer_t            *value)
+{
+    cuint_t pos;
+    cuint_t mask = (1u << index->bits) - 1;
+    cuint_t i    = HPACK_HASH_SLOT (hash, 0, index->bits);
+
+    while (slots[i].hash != EMPTY) {
+        if (slots[i].hash == hash) {
+            pos = position (table, slots[i].counter);
+            if ((pos != 0) && entry_is (table, pos, key, name, value)) {
+                return pos;
+            }
+        }
+
+        i = (i + 1) & mask;
+    }
+
+    return 0;
+}
+
+/** Find a header field in the dynamic table
+ *
+ * Looks up the newest dynamic table entry holding a name/value pair
+ * or, failing that, a name. Costs a hash of the strings, a short probe
+ * and one comparison per candidate.
+ *
+ * @param      index       Reverse index
+ * @param      table       Header table followed by the index
+ * @param      name        Name of the header field
+ * @param      value       Value of the header field, or NULL to look up the name only
+ * @param[out] position    Position of the entry in the dynamic table (1 is the newest)
+ * @param[out] value_match Whether the value of the entry matches as well
+ * @retval ret_ok        An entry was found
+ * @retval ret_not_found No entry has that name
+ */
+ret_t
+hpack_header_index_find (hpack_header_index_t *index,
+                         hpack_header_table_t *table,
+                         chula_buffer_t       *name,
+                         chula_buffer_t       *value,
+                         cuint_t              *position,
+                         bool                 *value_match)
+{
+    uint32_t hash;
+
+    hash = hpack_hash (name->buf, name->len, HPACK_HASH_INIT);
+
+    return hpack_header_index_find_hashed (index, table, name, value, hash,
+                                           (value != NULL) ? hpack_hash (value->buf, value->len, hash) : 0,
+                                           position, value_match);
+}
+
+/** Find a header field in the dynamic table, given its hashes
+ *
+ * Same as hpack_header_index_find(), for callers that already hashed
+ * the field (see hpack_header_index_add_hashed()). @pair_hash is
+ * ignored when @value is NULL.
+ */
+ret_t
+hpack_header_index_find_hashed (hpack_header_index_t *index,
+                                hpack_header_table_t *table,
+                                chula_buffer_t       *name,
+                                chula_buffer_t       *value,
+                                uint32_t              name_hash,
+                                uint32_t              pair_hash,
+                                cuint_t              *position,
+                                bool                 *value_match)
+{
+    cuint_t pos;
+
+    if ((index->pairs == NULL) || (table->num == 0)) {
+        return ret_not_found;
+    }
+
+    if (value != NULL) {
+        pos = slot_find (index, index->pairs, table, key_pair,
+                         pair_hash | USED_BIT, name, value);
+        if (pos != 0) {
+            *position    = pos;
+            *value_match = true;
+            return ret_ok;
+        }
+    }
+
+    pos = slot_find (index, index->names, table, key_name,
+                     name_hash | USED_BIT, name, NULL);
+    if (pos != 0) {
+        *position    = pos;
+        *value_match = false;
+        return ret_ok;
+    }
+
+    return ret_not_found;
+}
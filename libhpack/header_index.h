@@ -0,0 +1,83 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBHPACK_HEADER_INDEX_H
+#define LIBHPACK_HEADER_INDEX_H
+
+#include <libhpack/common.h>
+#include <libhpack/header_table.h>
+#include <libchula/buffer.h>
+
+/* Used slots store the hash of their key with the top bit set, so that
+ * any hash, 0 included, tells them apart from empty slots, all zeros.
+ * Lookups compare the hash with that bit set.
+ */
+typedef struct {
+    uint32_t hash;     /**< Hash of the key with the top bit set, 0 if empty */
+    uint32_t counter;  /**< Insertion counter of the entry                   */
+} hpack_header_index_slot_t;
+
+typedef struct {
+    hpack_header_index_slot_t *pairs;      /**< Slots keyed on name and value */
+    hpack_header_index_slot_t *names;      /**< Slots keyed on name           */
+    cuint_t                    bits;       /**< Each array has 2^bits slots   */
+    cuint_t                    used_pairs; /**< Non-empty slots of @pairs     */
+    cuint_t                    used_names; /**< Non-empty slots of @names     */
+    uint32_t                   last;       /**< Counter of the last entry added */
+} hpack_header_index_t;
+
+ret_t hpack_header_index_init     (hpack_header_index_t *index);
+ret_t hpack_header_index_mrproper (hpack_header_index_t *index);
+void  hpack_header_index_clean    (hpack_header_index_t *index);
+
+ret_t hpack_header_index_add         (hpack_header_index_t *index,
+                                      hpack_header_table_t *table);
+ret_t hpack_header_index_add_hashed  (hpack_header_index_t *index,
+                                      hpack_header_table_t *table,
+                                      uint32_t              name_hash,
+                                      uint32_t              pair_hash);
+ret_t hpack_header_index_find        (hpack_header_index_t *index,
+                                      hpack_header_table_t *table,
+                                      chula_buffer_t       *name,
+                                      chula_buffer_t       *value,
+                                      cuint_t              *position,
+                                      bool                 *value_match);
+ret_t hpack_header_index_find_hashed (hpack_header_index_t *index,
+                                      hpack_header_table_t *table,
+                                      chula_buffer_t       *name,
+                                      chula_buffer_t       *value,
+                                      uint32_t              name_hash,
+                                      uint32_t              pair_hash,
+                                      cuint_t              *position,
+                                      bool                 *value_match);
+
+#endif /* LIBHPACK_HEADER_INDEX_H */
@@ -0,0 +1,280 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "header_list.h"
+#include "hash.h"
+
+#include <libchula/macros.h>
+#include <string.h>
+
+#define INITIAL_SIZE 16
+
+/* Implements _new() and _free()
+ */
+HPACK_ADD_FUNC_NEW  (header_list);
+HPACK_ADD_FUNC_FREE (header_list);
+
+ret_t
+hpack_header_list_init (hpack_header_list_t *list)
+{
+    chula_buffer_init (&list->data);
+
+    list->name_off  = NULL;
+    list->name_len  = NULL;
+    list->value_off = NULL;
+    list->value_len = NULL;
+    list->name_hash = NULL;
+    list->flags     = NULL;
+    list->num       = 0;
+    list->size      = 0;
+
+    return ret_ok;
+}
+
+ret_t
+hpack_header_list_mrproper (hpack_header_list_t *list)
+{
+    /* The arrays share the allocation of the first one */
+    free (list->name_off);
+    chula_buffer_mrproper (&list->data);
+
+    return hpack_header_list_init (list);
+}
+
+/** Empty a header list
+ *
+ * Drops the fields, keeping the memory for the next ones.
+ *
+ * @param list Header list
+ */
+void
+hpack_header_list_clean (hpack_header_list_t *list)
+{
+    list->num = 0;
+    chula_buffer_clean (&list->data);
+}
+
+/* Room for twice as many fields. The arrays are carved out of a single
+ * allocation, the 32 bits ones first so they stay aligned.
+ */
+static ret_t
+grow (hpack_header_list_t *list)
+{
+    char     *mem;
+    cuint_t   size;
+    uint32_t *arrays[5];
+    size_t    i;
+
+    size = (list->size > 0) ? list->size * 2 : INITIAL_SIZE;
+
+    mem = (char *) malloc ((size_t)size * (5 * sizeof(uint32_t) + sizeof(uint8_t)));
+    if (unlikely (mem == NULL)) {
+        return ret_nomem;
+    }
+
+    for (i = 0; i < 5; i++) {
+        arrays[i] = (uint32_t *)(mem + i * size * sizeof(uint32_t));
+    }
+
+    if (list->num > 0) {
+        memcpy (arrays[0], list->name_off,  list->num * sizeof(uint32_t));
+        memcpy (arrays[1], list->name_len,  list->num * sizeof(uint32_t));
+        memcpy (arrays[2], list->value_off, list->num * sizeof(uint32_t));
+        memcpy (arrays[3], list->value_len, list->num * sizeof(uint32_t));
+        memcpy (arrays[4], list->name_hash, list->num * sizeof(uint32_t));
+        memcpy (mem + 5 * size * sizeof(uint32_t), list->flags, list->num);
+    }
+
+    free (list->name_off);
+
+    list->name_off  = arrays[0];
+    list->name_len  = arrays[1];
+    list->value_off = arrays[2];
+    list->value_len = arrays[3];
+    list->name_hash = arrays[4];
+    list->flags     = (uint8_t *)(mem + 5 * size * sizeof(uint32_t));
+    list->size      = size;
+
+    return ret_ok;
+}
+
+/** Append a header field
+ *
+ * Copies the name and value of a field at the end of the backing
+ * region, and hashes the name.
+ *
+ * @param list      Header list
+ * @param name      Name of the field
+ * @param name_len  Length of @name
+ * @param value     Value of the field
+ * @param value_len Length of @value
+ * @param rep       Representation of the field
+ * @retval ret_ok    The field was added
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_header_list_add (hpack_header_list_t *list,
+                       const char          *name,
+                       cuint_t              name_len,
+                       const char          *value,
+                       cuint_t              value_len,
+                       hpack_field_rep_t    rep)
+{
+    ret_t    ret;
+    cuint_t  n   = list->num;
+    cuint_t  off = list->data.len;
+    char    *p;
+
+    if (unlikely (list->num >= list->size)) {
+        ret = grow (list);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    /* Both strings keep their terminator */
+    ret = chula_buffer_ensure_addlen (&list->data, (size_t)name_len + value_len + 2);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    p = list->data.buf + off;
+    if (name_len > 0) memcpy (p, name, name_len);
+    p[name_len] = '\0';
+
+    p += name_len + 1;
+    if (value_len > 0) memcpy (p, value, value_len);
+    p[value_len] = '\0';
+
+    list->data.len += name_len + value_len + 2;
+    list->data.buf[list->data.len] = '\0';
+
+    list->name_off[n]  = off;
+    list->name_len[n]  = name_len;
+    list->value_off[n] = off + name_len + 1;
+    list->value_len[n] = value_len;
+    list->name_hash[n] = hpack_hash (name, name_len, HPACK_HASH_INIT);
+    list->flags[n]     = (uint8_t) rep & HPACK_LIST_REP_MASK;
+
+    list->num++;
+    return ret_ok;
+}
+
+/** Append a header field object
+ *
+ * @param list  Header list
+ * @param field Header field to copy, along with the ID of its name
+ * @retval ret_ok    The field was added
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_header_list_add_field (hpack_header_list_t  *list,
+                             hpack_header_field_t *field)
+{
+    ret_t ret;
+
+    ret = hpack_header_list_add (list, field->name.buf, field->name.len,
+                                 field->value.buf, field->value.len, field->rep);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    list->flags[list->num - 1] |= (uint8_t) (field->id << HPACK_LIST_ID_SHIFT);
+    return ret_ok;
+}
+
+/** Get the strings of a field
+ *
+ * The buffers are views into the list: they must not be modified, and
+ * are only valid until the list is modified.
+ *
+ * @param      list  Header list
+ * @param      n     Position of the field, from 0
+ * @param[out] name  Name of the field, or NULL
+ * @param[out] value Value of the field, or NULL
+ * @retval ret_ok        Done
+ * @retval ret_not_found There is no such field
+ */
+ret_t
+hpack_header_list_get (hpack_header_list_t *list,
+                       cuint_t              n,
+                       chula_buffer_t      *name,
+                       chula_buffer_t      *value)
+{
+    if (unlikely (n >= list->num)) {
+        return ret_not_found;
+    }
+
+    if (name != NULL) {
+        chula_buffer_fake (name, HPACK_LIST_NAME(list, n), list->name_len[n]);
+    }
+
+    if (value != NULL) {
+        chula_buffer_fake (value, HPACK_LIST_VALUE(list, n), list->value_len[n]);
+    }
+
+    return ret_ok;
+}
+
+/** Find a field by name
+ *
+ * Sweeps the name hashes from a position on. The strings are only
+ * compared when the hashes match. Passing the previous result plus
+ * one as @from walks every field with the name.
+ *
+ * @param      list     Header list
+ * @param      name     Name to look for
+ * @param      name_len Length of @name
+ * @param      from     First position to look at
+ * @param[out] n        Position of the field
+ * @retval ret_ok        A field was found
+ * @retval ret_not_found No field has the name from @from on
+ */
+ret_t
+hpack_header_list_find (hpack_header_list_t *list,
+                        const char          *name,
+                        cuint_t              name_len,
+                        cuint_t              from,
+                        cuint_t             *n)
+{
+    cuint_t  i;
+    uint32_t hash = hpack_hash (name, name_len, HPACK_HASH_INIT);
+
+    for (i = from; i < list->num; i++) {
+        if (likely (list->name_hash[i] != hash)) {
+            continue;
+        }
+
+        if ((list->name_len[i] == name_len) &&
+            (memcmp (HPACK_LIST_NAME(list, i), name, name_len) == 0))
+        {
+            *n = i;
+            return ret_ok;
+        }
+    }
+
+    return ret_not_found;
+}
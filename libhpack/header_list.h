@@ -0,0 +1,99 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBHPACK_HEADER_LIST_H
+#define LIBHPACK_HEADER_LIST_H
+
+#include <libhpack/common.h>
+#include <libhpack/header_field.h>
+#include <libchula/buffer.h>
+#include <stdint.h>
+
+/* Packed header list
+ *
+ * Fields are stored as parallel arrays over a single backing region,
+ * so passes over the names are linear sweeps: a filter compares the
+ * cached name hashes first and touches the strings only on a match.
+ */
+typedef struct {
+    chula_buffer_t  data;      /**< Names and values, NUL terminated      */
+    uint32_t       *name_off;  /**< Offset of each name in @data          */
+    uint32_t       *name_len;  /**< Length of each name                   */
+    uint32_t       *value_off; /**< Offset of each value in @data         */
+    uint32_t       *value_len; /**< Length of each value                  */
+    uint32_t       *name_hash; /**< hpack_hash() of each name             */
+    uint8_t        *flags;     /**< HPACK_LIST_* flags of each field      */
+    cuint_t         num;       /**< Number of fields                      */
+    cuint_t         size;      /**< Number of fields the arrays can hold  */
+} hpack_header_list_t;
+
+#define HDR_LIST(l) ((hpack_header_list_t *)(l))
+
+/* Flags: the representation the field was decoded from or has to be
+ * encoded with, in the low bits, and the ID of its name above them
+ */
+#define HPACK_LIST_REP_MASK 0x03
+#define HPACK_LIST_REP(l,n) ((hpack_field_rep_t)((l)->flags[n] & HPACK_LIST_REP_MASK))
+#define HPACK_LIST_ID_SHIFT 2
+#define HPACK_LIST_ID(l,n)  ((hpack_header_id_t)((l)->flags[n] >> HPACK_LIST_ID_SHIFT))
+
+/* Strings of a field
+ */
+#define HPACK_LIST_NAME(l,n)  ((l)->data.buf + (l)->name_off[n])
+#define HPACK_LIST_VALUE(l,n) ((l)->data.buf + (l)->value_off[n])
+
+ret_t hpack_header_list_new       (hpack_header_list_t **list);
+ret_t hpack_header_list_free      (hpack_header_list_t  *list);
+ret_t hpack_header_list_init      (hpack_header_list_t  *list);
+ret_t hpack_header_list_mrproper  (hpack_header_list_t  *list);
+void  hpack_header_list_clean     (hpack_header_list_t  *list);
+
+ret_t hpack_header_list_add       (hpack_header_list_t  *list,
+                                   const char           *name,
+                                   cuint_t               name_len,
+                                   const char           *value,
+                                   cuint_t               value_len,
+                                   hpack_field_rep_t     rep);
+ret_t hpack_header_list_add_field (hpack_header_list_t  *list,
+                                   hpack_header_field_t *field);
+
+ret_t hpack_header_list_get       (hpack_header_list_t  *list,
+                                   cuint_t               n,
+                                   chula_buffer_t       *name,
+                                   chula_buffer_t       *value);
+ret_t hpack_header_list_find      (hpack_header_list_t  *list,
+                                   const char           *name,
+                                   cuint_t               name_len,
+                                   cuint_t               from,
+                                   cuint_t              *n);
+
+#endif /* LIBHPACK_HEADER_LIST_H */
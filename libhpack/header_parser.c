@@ -0,0 +1,1028 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Current ref:
+ * http://tools.ietf.org/html/rfc7541
+ */
+
+#include "header_parser.h"
+#include "integer.h"
+#include "huffman.h"
+#include "literal.h"
+#include "hash.h"
+
+#include <libchula/macros.h>
+#include <string.h>
+
+/* Implements _new() and _free()
+ */
+HPACK_ADD_FUNC_NEW  (header_parser);
+HPACK_ADD_FUNC_FREE (header_parser);
+
+static void
+reset_partial (hpack_header_parser_t *parser)
+{
+    parser->state       = hpack_parser_state_rep;
+    parser->size_update = false;
+    parser->int_prefix  = 0;
+    parser->int_partial = false;
+    parser->int_value   = 0;
+    parser->int_shift   = 0;
+    parser->str_left    = 0;
+    parser->str_huffman = false;
+    parser->str_budget  = SIZE_MAX;
+}
+
+ret_t
+hpack_header_parser_init (hpack_header_parser_t *parser)
+{
+    parser->block_fields = 0;
+    parser->block_size   = 0;
+    parser->views        = false;
+    parser->validate     = false;
+    parser->arena        = NULL;
+    parser->list         = NULL;
+    parser->field        = NULL;
+    memset (&parser->limits, 0, sizeof(parser->limits));
+    reset_partial (parser);
+
+    return hpack_header_table_init (&parser->table);
+}
+
+ret_t
+hpack_header_parser_mrproper (hpack_header_parser_t *parser)
+{
+    if (parser->field != NULL) {
+        hpack_header_field_free (parser->field);
+        parser->field = NULL;
+    }
+
+    return hpack_header_table_mrproper (&parser->table);
+}
+
+/** Reset a header parser
+ *
+ * Brings a parser back to its initial state, as for a new connection,
+ * while keeping the memory of its dynamic table and scratch field.
+ *
+ * @param parser Header parser
+ * @retval ret_ok Always
+ */
+ret_t
+hpack_header_parser_reset (hpack_header_parser_t *parser)
+{
+    parser->block_fields = 0;
+    parser->block_size   = 0;
+    parser->views        = false;
+    parser->validate     = false;
+    parser->arena        = NULL;
+    parser->list         = NULL;
+    memset (&parser->limits, 0, sizeof(parser->limits));
+    reset_partial (parser);
+
+    if (parser->field != NULL) {
+        hpack_header_field_clean (parser->field);
+    }
+
+    hpack_header_table_reset (&parser->table);
+    return ret_ok;
+}
+
+/** Zero-copy decoding
+ *
+ * When enabled, literals that are not Huffman encoded are not copied:
+ * the name or value of the decoded field is a view into the input
+ * (see hpack_header_field_set_view()), valid for as long as the
+ * caller keeps the header block or fragment around. Huffman encoded
+ * strings, strings split across fragments and strings referenced from
+ * the header table are still copied.
+ *
+ * @param parser Header parser
+ * @param views  Whether to decode raw literals as views
+ * @retval ret_ok Always
+ */
+ret_t
+hpack_header_parser_set_views (hpack_header_parser_t *parser,
+                               bool                   views)
+{
+    parser->views = views;
+    return ret_ok;
+}
+
+/** Decode into an arena
+ *
+ * When an arena is set, hpack_header_parser_all() and
+ * hpack_header_parser_feed() allocate the fields they emit, names and
+ * values included, from it. Fields are decoded into a scratch field
+ * owned by the parser and then copied to the arena in one go, so
+ * decoding a header block does not call malloc() once the parser and
+ * the arena have warmed up.
+ *
+ * Such fields must not be freed with hpack_header_field_list_free():
+ * the whole list is released by chula_arena_reset(), typically when
+ * the stream ends. The arena is not owned by the parser.
+ *
+ * @param parser Header parser
+ * @param arena  Arena, or NULL to allocate every field with malloc()
+ * @retval ret_ok Always
+ */
+ret_t
+hpack_header_parser_set_arena (hpack_header_parser_t *parser,
+                               chula_arena_t         *arena)
+{
+    parser->arena = arena;
+    return ret_ok;
+}
+
+/** Decode into a packed header list
+ *
+ * When a list is set, hpack_header_parser_all() and
+ * hpack_header_parser_feed() append the fields they emit to it, and
+ * their @fields argument is ignored. Fields are decoded into a scratch
+ * field owned by the parser and then copied to the backing region of
+ * the list. It takes precedence over an arena. The list is not owned
+ * by the parser.
+ *
+ * @param parser Header parser
+ * @param list   Header list, or NULL to emit hpack_header_field_t objects
+ * @retval ret_ok Always
+ */
+ret_t
+hpack_header_parser_set_list (hpack_header_parser_t *parser,
+                              hpack_header_list_t   *list)
+{
+    parser->list = list;
+    return ret_ok;
+}
+
+/** Validate header fields
+ *
+ * HPACK itself carries any octet in a string, but HTTP/2 requests and
+ * responses with uppercase or non token characters in a field name
+ * [RFC 7540, 8.1.2.], or with NUL, CR or LF in a value [10.3.], are
+ * malformed. When enabled, literals are checked while they are copied
+ * out of the header block, and a bad one fails decoding with
+ * ret_error. Strings taken from the header table were checked when
+ * they were added.
+ *
+ * @param parser   Header parser
+ * @param validate Whether to check literals
+ * @retval ret_ok Always
+ */
+ret_t
+hpack_header_parser_set_validate (hpack_header_parser_t *parser,
+                                  bool                   validate)
+{
+    parser->validate = validate;
+    return ret_ok;
+}
+
+/** Set decoding limits
+ *
+ * Limits are enforced as the header block is consumed: a field is
+ * dropped as soon as the length of one of its strings, or the entry
+ * it references in the header table, would take it past them, before
+ * its octets are copied or decoded. Huffman encoded strings are
+ * decoded in slices and dropped as soon as their output goes past
+ * the limits. The header list size is computed as in HTTP/2: name and
+ * value lengths plus 32 octets per field [RFC 7540, 6.5.2.].
+ *
+ * Exceeding a limit fails decoding with ret_deny. The rest of the
+ * block is not decoded, so the decoding context is out of sync with
+ * the peer and the connection must be torn down.
+ *
+ * @param parser Header parser
+ * @param limits Limits to enforce, or NULL for none
+ * @retval ret_ok Always
+ */
+ret_t
+hpack_header_parser_set_limits (hpack_header_parser_t       *parser,
+                                const hpack_parser_limits_t *limits)
+{
+    if (limits == NULL) {
+        memset (&parser->limits, 0, sizeof(parser->limits));
+    } else {
+        parser->limits = *limits;
+    }
+
+    return ret_ok;
+}
+
+/* Octets still allowed to the field being decoded, @used octets of
+ * which are already known. Fails with ret_deny when that is already
+ * past the limits.
+ */
+static inline ret_t
+field_budget (hpack_header_parser_t *parser,
+              size_t                 used,
+              size_t                *budget)
+{
+    size_t max = SIZE_MAX;
+
+    if (parser->limits.max_field_size > 0) {
+        max = parser->limits.max_field_size;
+    }
+
+    if (parser->limits.max_list_size > 0) {
+        if (unlikely (parser->block_size + HPACK_HEADER_ENTRY_OVERHEAD > parser->limits.max_list_size)) {
+            return ret_deny;
+        }
+
+        max = MIN (max, parser->limits.max_list_size - parser->block_size - HPACK_HEADER_ENTRY_OVERHEAD);
+    }
+
+    if (unlikely (used > max)) {
+        return ret_deny;
+    }
+
+    *budget = max - used;
+    return ret_ok;
+}
+
+
+/* Rest of a prefixed integer split across fragments. The octets read
+ * so far are accumulated in the parser until the last one arrives.
+ */
+static ret_t
+read_integer_partial (hpack_header_parser_t  *parser,
+                      const unsigned char   **pos,
+                      const unsigned char    *end,
+                      uint32_t               *value)
+{
+    unsigned char        c;
+    const unsigned char *p = *pos;
+
+    if (! parser->int_partial) {
+        /* Only a truncated integer gets here, so its prefix is full
+         */
+        parser->int_partial = true;
+        parser->int_value   = (1 << parser->int_prefix) - 1;
+        parser->int_shift   = 0;
+        p++;
+    }
+
+    while (p < end) {
+        c = *p++;
+
+        if (unlikely (parser->int_shift > 28)) {
+            return ret_error;
+        }
+
+        parser->int_value += (uint64_t)(c & 0x7F) << parser->int_shift;
+        parser->int_shift += 7;
+
+        if ((c & 0x80) == 0) {
+            if (unlikely (parser->int_value > UINT32_MAX)) {
+                return ret_error;
+            }
+
+            *value = (uint32_t) parser->int_value;
+            *pos   = p;
+
+            parser->int_partial = false;
+            return ret_ok;
+        }
+    }
+
+    *pos = p;
+    return ret_eagain;
+}
+
+/* Prefixed integer [5.1.]. The common case, an integer held in a
+ * single fragment, is decoded in one go, by the codec specialized for
+ * N when the caller passes a constant.
+ */
+static inline ret_t
+read_integer (hpack_header_parser_t  *parser,
+              int                     N,
+              const unsigned char   **pos,
+              const unsigned char    *end,
+              uint32_t               *value)
+{
+    ret_t                ret;
+    size_t               consumed;
+    const unsigned char *p = *pos;
+
+    if (likely (! parser->int_partial)) {
+        if (p >= end) {
+            return ret_eagain;
+        }
+
+        ret = integer_decode_prefix (N, p, end - p, value, &consumed);
+        if (likely (ret == ret_OK)) {
+            *pos = p + consumed;
+            return ret_ok;
+        }
+        if (ret != ret_eagain) {
+            return ret_error;
+        }
+    }
+
+    return read_integer_partial (parser, pos, end, value);
+}
+
+/* Huffman encoded string octets. Under limits they are decoded in
+ * slices, so a string going past its budget is dropped early: a slice
+ * decodes to 8/5 of its size at most.
+ */
+#define HUFFMAN_SLICE 256
+
+static ret_t
+read_huffman (hpack_header_parser_t *parser,
+              const unsigned char   *p,
+              cuint_t                len,
+              chula_buffer_t        *str)
+{
+    ret_t          ret;
+    cuint_t        slice;
+    chula_buffer_t encoded;
+
+    while (len > 0) {
+        slice = (parser->str_budget == SIZE_MAX) ? len : MIN (len, HUFFMAN_SLICE);
+
+        chula_buffer_fake (&encoded, (const char *)p, slice);
+        ret = hpack_huffman_decode_partial (&parser->huffman, &encoded, str);
+        if (unlikely (ret != ret_ok)) {
+            return ret;
+        }
+
+        if (unlikely (str->len > parser->str_budget)) {
+            return ret_deny;
+        }
+
+        p   += slice;
+        len -= slice;
+    }
+
+    return ret_ok;
+}
+
+/* Checks, and copies if @dst is not NULL, the octets of a name or a
+ * value, @offset being their position in the string
+ */
+static inline ret_t
+scan_literal (bool        name,
+              char       *dst,
+              const char *str,
+              size_t      len,
+              size_t      offset)
+{
+    if (name) {
+        return (dst != NULL) ? hpack_literal_copy_name (dst, str, len, offset) :
+                               hpack_literal_check_name (str, len, offset);
+    }
+
+    return (dst != NULL) ? hpack_literal_copy_value (dst, str, len) :
+                           hpack_literal_check_value (str, len);
+}
+
+/* String literal octets [5.2.]. Takes whatever part of the string is
+ * available; Huffman encoded strings are decoded fragment by fragment.
+ * A raw string held in a single fragment may be returned as a view.
+ * Strings are checked on the way when the parser validates them: raw
+ * octets as they are copied, Huffman ones right after being decoded.
+ */
+static ret_t
+read_string (hpack_header_parser_t  *parser,
+             const unsigned char   **pos,
+             const unsigned char    *end,
+             chula_buffer_t         *str,
+             bool                   *view)
+{
+    ret_t                ret;
+    cuint_t              len;
+    cuint_t              offset = str->len;
+    const unsigned char *p      = *pos;
+    bool                 check  = parser->validate;
+    bool                 name   = (parser->state == hpack_parser_state_name);
+
+    len = MIN ((size_t)(end - p), parser->str_left);
+
+    if (parser->views && (! parser->str_huffman) &&
+        (str->len == 0) && (len == parser->str_left) && (len > 0))
+    {
+        if (check && unlikely (scan_literal (name, NULL, (const char *)p, len, 0) != ret_ok)) {
+            return ret_error;
+        }
+
+        hpack_header_field_set_view (str, view, (const char *)p, len);
+
+        parser->str_left = 0;
+        *pos = p + len;
+        return ret_ok;
+    }
+
+    if (len > 0) {
+        if (parser->str_huffman) {
+            ret = read_huffman (parser, p, len, str);
+
+            if (check && (ret == ret_ok)) {
+                ret = scan_literal (name, NULL, str->buf + offset, str->len - offset, offset);
+            }
+        } else if (check) {
+            ret = chula_buffer_ensure_addlen (str, len);
+            if (likely (ret == ret_ok)) {
+                ret = scan_literal (name, str->buf + offset, (const char *)p, len, offset);
+                str->len += len;
+                str->buf[str->len] = '\0';
+            }
+        } else {
+            ret = chula_buffer_add (str, (const char *)p, len);
+        }
+
+        if (unlikely (ret != ret_ok)) {
+            return ret;
+        }
+
+        parser->str_left -= len;
+        *pos = p + len;
+    }
+
+    if (parser->str_left > 0) {
+        return ret_eagain;
+    }
+
+    /* Padding longer than 7 bits, or not made of 1s
+     */
+    if (parser->str_huffman && unlikely (! parser->huffman.accept)) {
+        return ret_error;
+    }
+
+    /* Names are tokens, at least one octet long
+     */
+    if (check && name && unlikely (str->len == 0)) {
+        return ret_error;
+    }
+
+    return ret_ok;
+}
+
+/* Starts reading a string of @len octets, @used octets of the field
+ * being already decoded. Strings that can not fit in the limits are
+ * refused here, before any of their octets is read: a Huffman code is
+ * 30 bits long at most, so each 4 octets decode to one at least.
+ */
+static ret_t
+begin_string (hpack_header_parser_t *parser,
+              uint32_t               len,
+              size_t                 used,
+              chula_buffer_t        *str)
+{
+    ret_t ret;
+
+    ret = field_budget (parser, used, &parser->str_budget);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    if (unlikely ((parser->str_huffman ? len / 4 : len) > parser->str_budget)) {
+        return ret_deny;
+    }
+
+    parser->str_left = len;
+    chula_buffer_clean (str);
+
+    if (parser->str_huffman) {
+        parser->huffman.state  = 0;
+        parser->huffman.accept = true;
+    }
+
+    /* Room is not reserved for @len up front: the length comes from
+     * the peer, and the octets may never arrive.
+     */
+    return ret_ok;
+}
+
+/* Copies a header table entry to the field being decoded, along with
+ * the ID of its name. @value is NULL for indexed names.
+ */
+static ret_t
+copy_from_table (hpack_header_parser_t *parser,
+                 cuint_t                index,
+                 hpack_header_field_t  *field,
+                 chula_buffer_t        *value)
+{
+    ret_t          ret;
+    size_t         budget;
+    chula_buffer_t tname;
+    chula_buffer_t tvalue;
+
+    ret = hpack_header_table_get (&parser->table, index,
+                                  &tname, (value != NULL) ? &tvalue : NULL);
+    if (unlikely (ret != ret_ok)) {
+        return ret_error;
+    }
+
+    /* A single octet may reference a whole entry: check it first */
+    ret = field_budget (parser, tname.len + ((value != NULL) ? tvalue.len : 0), &budget);
+    if (unlikely (ret != ret_ok)) {
+        return ret;
+    }
+
+    chula_buffer_clean (&field->name);
+    ret = chula_buffer_add_buffer (&field->name, &tname);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    field->id = hpack_header_table_get_id (&parser->table, index);
+
+    if (value != NULL) {
+        chula_buffer_clean (value);
+        ret = chula_buffer_add_buffer (value, &tvalue);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    return ret_ok;
+}
+
+/* Header field representation state machine [6.]. Consumes input
+ * until a header field is complete (ret_ok), the input runs out
+ * (ret_eof between representations, ret_eagain within one) or an
+ * error is found. The position reached is stored back in @pos. The
+ * decoding context is only modified once a representation has been
+ * completely read.
+ */
+static ret_t
+parse (hpack_header_parser_t  *parser,
+       const unsigned char   **pos,
+       const unsigned char    *end,
+       hpack_header_field_t   *field)
+{
+    ret_t                ret;
+    uint32_t             n;
+    const unsigned char *p = *pos;
+
+    while (true) {
+        switch (parser->state) {
+        case hpack_parser_state_rep:
+            if (p >= end) {
+                ret = ret_eof;
+                goto out;
+            }
+
+            parser->size_update = false;
+            hpack_header_field_clean (field);
+
+            if ((p[0] & 0xE0) == 0x20) {
+                /* Dynamic Table Size Update [6.3.] */
+                if (unlikely (parser->block_fields > 0)) {
+                    ret = ret_error;
+                    goto out;
+                }
+                parser->size_update = true;
+                parser->int_prefix  = 5;
+            } else if (p[0] & 0x80) {
+                /* Indexed Header Field Representation [6.1.] */
+                field->rep = hpack_field_rep_indexed;
+                parser->int_prefix = 7;
+            } else if (p[0] & 0x40) {
+                /* Literal Header Field Representation [6.2.] */
+                field->rep = hpack_field_rep_literal_inc_index;
+                parser->int_prefix = 6;
+            } else if (p[0] & 0x10) {
+                field->rep = hpack_field_rep_literal_never_index;
+                parser->int_prefix = 4;
+            } else {
+                field->rep = hpack_field_rep_literal_without_index;
+                parser->int_prefix = 4;
+            }
+
+            if ((! parser->size_update) && (parser->limits.max_fields > 0) &&
+                unlikely (parser->block_fields >= parser->limits.max_fields))
+            {
+                ret = ret_deny;
+                goto out;
+            }
+
+            parser->state = hpack_parser_state_index;
+            /* fall through */
+
+        case hpack_parser_state_index:
+            /* Indexed fields, the most common, get the 7 bits codec */
+            if (parser->int_prefix == 7) {
+                ret = read_integer (parser, 7, &p, end, &n);
+            } else {
+                ret = read_integer (parser, parser->int_prefix, &p, end, &n);
+            }
+            if (ret != ret_ok) goto out;
+
+            if (parser->size_update) {
+                ret = hpack_header_table_set_max_size (&parser->table, n);
+                if (unlikely (ret != ret_ok)) {
+                    if (ret != ret_nomem) ret = ret_error;
+                    goto out;
+                }
+
+                parser->state = hpack_parser_state_rep;
+                break;
+            }
+
+            if (field->rep == hpack_field_rep_indexed) {
+                if (unlikely (n == 0)) {
+                    ret = ret_error;
+                    goto out;
+                }
+
+                ret = copy_from_table (parser, n, field, &field->value);
+                if (unlikely (ret != ret_ok)) goto out;
+
+                goto done;
+            }
+
+            /* Name: Indexed or New Name
+             */
+            if (n > 0) {
+                ret = copy_from_table (parser, n, field, NULL);
+                if (unlikely (ret != ret_ok)) goto out;
+
+                parser->state = hpack_parser_state_value_len;
+                break;
+            }
+
+            parser->state = hpack_parser_state_name_len;
+            /* fall through */
+
+        case hpack_parser_state_name_len:
+            if (! parser->int_partial) {
+                if (p >= end) {
+                    ret = ret_eagain;
+                    goto out;
+                }
+                parser->str_huffman = (p[0] & 0x80);
+                parser->int_prefix  = 7;
+            }
+
+            ret = read_integer (parser, 7, &p, end, &n);
+            if (ret != ret_ok) goto out;
+
+            ret = begin_string (parser, n, 0, &field->name);
+            if (unlikely (ret != ret_ok)) goto out;
+
+            parser->state = hpack_parser_state_name;
+            /* fall through */
+
+        case hpack_parser_state_name:
+            ret = read_string (parser, &p, end, &field->name, &field->name_view);
+            if (ret != ret_ok) goto out;
+
+            /* New names get their ID through the static table hash */
+            field->id = hpack_static_table_find_id (&field->name,
+                                                    hpack_hash (field->name.buf, field->name.len, HPACK_HASH_INIT));
+
+            parser->state = hpack_parser_state_value_len;
+            /* fall through */
+
+        case hpack_parser_state_value_len:
+            if (! parser->int_partial) {
+                if (p >= end) {
+                    ret = ret_eagain;
+                    goto out;
+                }
+                parser->str_huffman = (p[0] & 0x80);
+                parser->int_prefix  = 7;
+            }
+
+            ret = read_integer (parser, 7, &p, end, &n);
+            if (ret != ret_ok) goto out;
+
+            ret = begin_string (parser, n, field->name.len, &field->value);
+            if (unlikely (ret != ret_ok)) goto out;
+
+            parser->state = hpack_parser_state_value;
+            /* fall through */
+
+        case hpack_parser_state_value:
+            ret = read_string (parser, &p, end, &field->value, &field->value_view);
+            if (ret != ret_ok) goto out;
+
+            /* Incremental indexing [6.2.1.]
+             */
+            if (field->rep == hpack_field_rep_literal_inc_index) {
+                ret = hpack_header_table_add_id (&parser->table, &field->name, &field->value, field->id);
+                if (unlikely (ret != ret_ok)) goto out;
+            }
+
+            goto done;
+
+        default:
+            SHOULDNT_HAPPEN;
+            ret = ret_error;
+            goto out;
+        }
+    }
+
+done:
+    parser->state         = hpack_parser_state_rep;
+    parser->block_fields += 1;
+    parser->block_size   += field->name.len + field->value.len + HPACK_HEADER_ENTRY_OVERHEAD;
+    ret = ret_ok;
+
+out:
+    *pos = p;
+    return ret;
+}
+
+static ret_t
+arena_string (chula_arena_t  *arena,
+              chula_buffer_t *str,
+              bool            view,
+              chula_buffer_t *copy,
+              bool           *copy_view)
+{
+    ret_t  ret;
+    char  *mem;
+
+    /* Views into the input stay as they are */
+    if (view) {
+        hpack_header_field_set_view (copy, copy_view, str->buf, str->len);
+        return ret_ok;
+    }
+
+    ret = chula_arena_dup (arena, str->buf, str->len, &mem);
+    if (unlikely (ret != ret_ok)) {
+        return ret;
+    }
+
+    hpack_header_field_set_view (copy, copy_view, mem, str->len);
+    return ret_ok;
+}
+
+/* Hands the field just decoded over to the caller: either the scratch
+ * field itself, a copy made in the arena, or a copy in the packed list.
+ */
+static ret_t
+emit (hpack_header_parser_t *parser,
+      chula_list_t          *fields)
+{
+    ret_t                 ret;
+    void                 *mem;
+    hpack_header_field_t *field = parser->field;
+    hpack_header_field_t *copy;
+
+    if (parser->list != NULL) {
+        return hpack_header_list_add_field (parser->list, field);
+    }
+
+    if (parser->arena == NULL) {
+        chula_list_add_tail (&field->entry, fields);
+        parser->field = NULL;
+        return ret_ok;
+    }
+
+    ret = chula_arena_alloc (parser->arena, sizeof(hpack_header_field_t), &mem);
+    if (unlikely (ret != ret_ok)) {
+        return ret;
+    }
+
+    copy = HDR_FIELD(mem);
+    hpack_header_field_init (copy);
+    copy->rep = field->rep;
+    copy->id  = field->id;
+
+    ret = arena_string (parser->arena, &field->name, field->name_view,
+                        &copy->name, &copy->name_view);
+    if (unlikely (ret != ret_ok)) {
+        return ret;
+    }
+
+    ret = arena_string (parser->arena, &field->value, field->value_view,
+                        &copy->value, &copy->value_view);
+    if (unlikely (ret != ret_ok)) {
+        return ret;
+    }
+
+    chula_list_add_tail (&copy->entry, fields);
+    return ret_ok;
+}
+
+/* Decodes and emits fields until the input runs out
+ */
+static ret_t
+parse_fields (hpack_header_parser_t  *parser,
+              const unsigned char   **pos,
+              const unsigned char    *end,
+              chula_list_t           *fields)
+{
+    ret_t ret;
+
+    while (true) {
+        if (parser->field == NULL) {
+            ret = hpack_header_field_new (&parser->field);
+            if (unlikely (ret != ret_ok)) return ret;
+        }
+
+        ret = parse (parser, pos, end, parser->field);
+        if (ret != ret_ok) {
+            return ret;
+        }
+
+        ret = emit (parser, fields);
+        if (unlikely (ret != ret_ok)) {
+            return ret;
+        }
+    }
+
+    SHOULDNT_HAPPEN;
+    return ret_error;
+}
+
+/** Parse a header field
+ *
+ * Parses the header field representation found at @offset in a header
+ * block [6.]. Dynamic table size updates preceding the field are
+ * applied on the way. The decoding context is only modified once the
+ * whole representation has been read, so a truncated field can be
+ * parsed again from the same offset when more data is available.
+ *
+ * Dynamic table size updates are only accepted before the first field
+ * of a header block [4.2.]. hpack_header_parser_begin() and
+ * hpack_header_parser_all() mark the beginning of a block.
+ *
+ * @param      parser   Header parser
+ * @param      raw      Header block
+ * @param      offset   Position of the representation in @raw
+ * @param[out] field    Header field to store the decoded field in
+ * @param[out] consumed Number of bytes consumed from @raw
+ * @retval ret_ok     A header field was decoded
+ * @retval ret_eof    The end of the block was reached, no field was decoded
+ * @retval ret_eagain The representation is truncated
+ * @retval ret_error  Decoding error
+ * @retval ret_deny   A decoding limit was exceeded
+ */
+ret_t
+hpack_header_parser_field (hpack_header_parser_t *parser,
+                           chula_buffer_t        *raw,
+                           cuint_t                offset,
+                           hpack_header_field_t  *field,
+                           cuint_t               *consumed)
+{
+    ret_t                ret;
+    const unsigned char *p     = (const unsigned char *)raw->buf + offset;
+    const unsigned char *begin = p;
+    const unsigned char *end   = (const unsigned char *)raw->buf + raw->len;
+
+    ret = parse (parser, &p, end, field);
+    if (unlikely ((ret != ret_ok) && (ret != ret_eof))) {
+        /* The representation will be parsed again from the start.
+         * Table size updates already applied are idempotent.
+         */
+        reset_partial (parser);
+        *consumed = 0;
+        return ret;
+    }
+
+    *consumed = p - begin;
+    return ret;
+}
+
+/** Parse a header block
+ *
+ * Decodes every header field of a header block in a single forward
+ * pass. Decoded fields are appended to @fields as newly allocated
+ * hpack_header_field_t objects, which can be released with
+ * hpack_header_field_list_free(), or taken from the parser arena if
+ * one was set with hpack_header_parser_set_arena().
+ *
+ * @param      parser   Header parser
+ * @param      raw      Header block
+ * @param      offset   Position of the block in @raw
+ * @param[out] fields   List to append the decoded fields to, unless a packed list is set
+ * @param[out] consumed Number of bytes consumed from @raw
+ * @retval ret_ok     The whole block was decoded
+ * @retval ret_error  Decoding error
+ * @retval ret_deny   A decoding limit was exceeded
+ */
+ret_t
+hpack_header_parser_all (hpack_header_parser_t *parser,
+                         chula_buffer_t        *raw,
+                         cuint_t                offset,
+                         chula_list_t          *fields,
+                         cuint_t               *consumed)
+{
+    ret_t                ret;
+    const unsigned char *p     = (const unsigned char *)raw->buf + offset;
+    const unsigned char *begin = p;
+    const unsigned char *end   = (const unsigned char *)raw->buf + raw->len;
+
+    hpack_header_parser_begin (parser);
+
+    ret = parse_fields (parser, &p, end, fields);
+    *consumed = p - begin;
+
+    switch (ret) {
+    case ret_eof:
+        return ret_ok;
+    case ret_eagain:
+        /* The block ends in the middle of a representation */
+        reset_partial (parser);
+        return ret_error;
+    default:
+        reset_partial (parser);
+        return ret;
+    }
+}
+
+/** Begin a fragmented header block
+ *
+ * Prepares the parser to receive a header block split in several
+ * fragments, such as a HEADERS frame followed by CONTINUATION frames.
+ * Any representation left incomplete by a previous block is dropped.
+ *
+ * @param parser Header parser
+ * @retval ret_ok Always
+ */
+ret_t
+hpack_header_parser_begin (hpack_header_parser_t *parser)
+{
+    parser->block_fields = 0;
+    parser->block_size   = 0;
+    reset_partial (parser);
+
+    return ret_ok;
+}
+
+/** Feed a header block fragment
+ *
+ * Decodes a fragment of the header block started by
+ * hpack_header_parser_begin(). Fragments may be split anywhere, even
+ * in the middle of an integer or a Huffman code: the parser saves the
+ * partial representation and resumes exactly where it stopped when
+ * the next fragment is fed. Fragments are never reassembled; string
+ * octets are appended to the field being decoded as they arrive.
+ *
+ * Completely decoded fields are appended to @fields as newly
+ * allocated hpack_header_field_t objects, or taken from the parser
+ * arena.
+ *
+ * @param      parser Header parser
+ * @param      chunk  Header block fragment. It is entirely consumed.
+ * @param[out] fields List to append the decoded fields to, unless a packed list is set
+ * @retval ret_ok    The fragment was consumed
+ * @retval ret_error Decoding error. The connection must be torn down [2.2.]
+ * @retval ret_deny  A decoding limit was exceeded. Same as above.
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_header_parser_feed (hpack_header_parser_t *parser,
+                          chula_buffer_t        *chunk,
+                          chula_list_t          *fields)
+{
+    ret_t                ret;
+    const unsigned char *p   = (const unsigned char *)chunk->buf;
+    const unsigned char *end = p + chunk->len;
+
+    ret = parse_fields (parser, &p, end, fields);
+    switch (ret) {
+    case ret_eof:
+    case ret_eagain:
+        return ret_ok;
+    default:
+        return ret;
+    }
+}
+
+/** End a fragmented header block
+ *
+ * Marks the end of the header block, once the fragment carrying the
+ * END_HEADERS flag has been fed.
+ *
+ * @param parser Header parser
+ * @retval ret_ok    The block ended on a representation boundary
+ * @retval ret_error The last representation of the block is incomplete
+ */
+ret_t
+hpack_header_parser_end (hpack_header_parser_t *parser)
+{
+    if (unlikely (parser->state != hpack_parser_state_rep)) {
+        reset_partial (parser);
+        return ret_error;
+    }
+
+    return ret_ok;
+}
@@ -0,0 +1,118 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBHPACK_HEADER_PARSER_H
+#define LIBHPACK_HEADER_PARSER_H
+
+#include <libhpack/common.h>
+#include <libhpack/header_field.h>
+#include <libhpack/header_table.h>
+#include <libhpack/header_list.h>
+#include <libhpack/huffman.h>
+#include <libchula/buffer.h>
+#include <libchula/list.h>
+#include <libchula/arena.h>
+
+typedef enum {
+    hpack_parser_state_rep,            /**< Start of a representation       */
+    hpack_parser_state_index,          /**< Index or table size integer     */
+    hpack_parser_state_name_len,       /**< Length of a literal name        */
+    hpack_parser_state_name,           /**< Octets of a literal name        */
+    hpack_parser_state_value_len,      /**< Length of a literal value       */
+    hpack_parser_state_value           /**< Octets of a literal value       */
+} hpack_parser_state_t;
+
+/* Decoding limits. Zero means no limit.
+ */
+typedef struct {
+    size_t                 max_list_size;  /**< SETTINGS_MAX_HEADER_LIST_SIZE [RFC 7540, 6.5.2.] */
+    size_t                 max_field_size; /**< Name and value octets of a field                 */
+    cuint_t                max_fields;     /**< Fields in a header block                         */
+} hpack_parser_limits_t;
+
+typedef struct {
+    hpack_header_table_t   table;        /**< Decoding context [2.2.]            */
+    cuint_t                block_fields; /**< Fields parsed in the current block */
+    size_t                 block_size;   /**< Header list size of the block      */
+    hpack_parser_limits_t  limits;       /**< Limits enforced while decoding     */
+    bool                   views;        /**< Return raw literals as input views */
+    bool                   validate;     /**< Reject literals HTTP/2 forbids     */
+    chula_arena_t         *arena;        /**< Memory for the decoded fields      */
+    hpack_header_list_t   *list;         /**< Packed list to decode into         */
+
+    /* Representation being decoded, kept across fragments */
+    hpack_parser_state_t   state;        /**< Position in the representation     */
+    bool                   size_update;  /**< It is a table size update [6.3.]   */
+    int                    int_prefix;   /**< Prefix of the integer being read   */
+    bool                   int_partial;  /**< Integer split across fragments     */
+    uint64_t               int_value;    /**< Partial integer value              */
+    cuint_t                int_shift;    /**< Shift of the next continuation     */
+    uint32_t               str_left;     /**< String octets still to be read     */
+    bool                   str_huffman;  /**< The string is Huffman encoded      */
+    size_t                 str_budget;   /**< Octets the string may decode to    */
+    hpack_huffman_state_t  huffman;      /**< Partial Huffman decoding state     */
+    hpack_header_field_t  *field;        /**< Field being decoded by _feed()     */
+} hpack_header_parser_t;
+
+#define HDR_PARSER(p) ((hpack_header_parser_t *)(p))
+
+ret_t hpack_header_parser_new      (hpack_header_parser_t **parser);
+ret_t hpack_header_parser_free     (hpack_header_parser_t  *parser);
+ret_t hpack_header_parser_init     (hpack_header_parser_t  *parser);
+ret_t hpack_header_parser_mrproper (hpack_header_parser_t  *parser);
+ret_t hpack_header_parser_reset    (hpack_header_parser_t  *parser);
+ret_t hpack_header_parser_set_views (hpack_header_parser_t *parser, bool views);
+ret_t hpack_header_parser_set_arena (hpack_header_parser_t *parser, chula_arena_t *arena);
+ret_t hpack_header_parser_set_list  (hpack_header_parser_t *parser, hpack_header_list_t *list);
+ret_t hpack_header_parser_set_validate (hpack_header_parser_t *parser, bool validate);
+ret_t hpack_header_parser_set_limits   (hpack_header_parser_t *parser, const hpack_parser_limits_t *limits);
+
+ret_t hpack_header_parser_field    (hpack_header_parser_t *parser,
+                                    chula_buffer_t        *raw,
+                                    cuint_t                offset,
+                                    hpack_header_field_t  *field,
+                                    cuint_t               *consumed);
+
+ret_t hpack_header_parser_all      (hpack_header_parser_t *parser,
+                                    chula_buffer_t        *raw,
+                                    cuint_t                offset,
+                                    chula_list_t          *fields,
+                                    cuint_t               *consumed);
+
+/* Fragmented header blocks */
+ret_t hpack_header_parser_begin    (hpack_header_parser_t *parser);
+ret_t hpack_header_parser_feed     (hpack_header_parser_t *parser,
+                                    chula_buffer_t        *chunk,
+                                    chula_list_t          *fields);
+ret_t hpack_header_parser_end      (hpack_header_parser_t *parser);
+
+#endif /* LIBHPACK_HEADER_PARSER_H */
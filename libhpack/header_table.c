@@ -0,0 +1,525 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Current ref:
+ * http://tools.ietf.org/html/rfc7541
+ */
+
+#include "header_table.h"
+#include "static_table.h"
+
+#include <libchula/macros.h>
+#include <string.h>
+
+/* Entry of the dynamic table by its position (1 is the newest one)
+ */
+#define ENTRY(t,n) (&(t)->entries[((t)->first + (n) - 1) % (t)->entries_size])
+#define ENTRY_LEN(e) ((e)->name_len + (e)->value_len)
+
+
+/* Implements _new() and _free()
+ */
+HPACK_ADD_FUNC_NEW  (header_table);
+HPACK_ADD_FUNC_FREE (header_table);
+
+ret_t
+hpack_header_table_init (hpack_header_table_t *table)
+{
+    table->entries       = NULL;
+    table->entries_size  = 0;
+    table->first         = 0;
+    table->num           = 0;
+    table->data          = NULL;
+    table->data_size     = 0;
+    table->data_head     = 0;
+    table->size          = 0;
+    table->max_size      = HPACK_HEADER_TABLE_SIZE_DEFAULT;
+    table->settings_size = HPACK_HEADER_TABLE_SIZE_DEFAULT;
+    table->inserted      = 0;
+
+    return ret_ok;
+}
+
+ret_t
+hpack_header_table_mrproper (hpack_header_table_t *table)
+{
+    if (table->entries != NULL) {
+        free (table->entries);
+        table->entries = NULL;
+    }
+
+    if (table->data != NULL) {
+        free (table->data);
+        table->data = NULL;
+    }
+
+    table->entries_size = 0;
+    table->data_size    = 0;
+
+    hpack_header_table_clean (table);
+    return ret_ok;
+}
+
+void
+hpack_header_table_clean (hpack_header_table_t *table)
+{
+    table->first     = 0;
+    table->num       = 0;
+    table->data_head = 0;
+    table->size      = 0;
+}
+
+/** Reset a header table
+ *
+ * Empties the dynamic table and brings its sizes back to their
+ * initial values, keeping the rings for the next entries when they are
+ * large enough.
+ *
+ * @param table Header table
+ */
+void
+hpack_header_table_reset (hpack_header_table_t *table)
+{
+    hpack_header_table_clean (table);
+
+    table->max_size      = HPACK_HEADER_TABLE_SIZE_DEFAULT;
+    table->settings_size = HPACK_HEADER_TABLE_SIZE_DEFAULT;
+
+    if ((table->data != NULL) && (table->data_size < 2 * table->max_size)) {
+        hpack_header_table_mrproper (table);
+    }
+}
+
+/* Allocates the rings for a given table size.
+ *
+ * Every entry takes at least 32 bytes of the table size, so that bounds
+ * the number of entries. The ring of bytes is twice as large as the
+ * table size: entries are always stored contiguously, and when one does
+ * not fit before the end of the ring the remaining bytes are skipped.
+ * The skipped gap is shorter than an entry, so twice the maximum size is
+ * always enough to keep both the live entries and the gap.
+ */
+static ret_t
+reserve (hpack_header_table_t *table,
+         size_t                size)
+{
+    cuint_t                     n;
+    size_t                      pos;
+    size_t                      len;
+    cuint_t                     entries_size;
+    size_t                      data_size;
+    hpack_header_table_entry_t *entries;
+    char                       *data;
+
+    entries_size = MAX (size / HPACK_HEADER_ENTRY_OVERHEAD, 1);
+    data_size    = MAX (size * 2, 1);
+
+    entries = (hpack_header_table_entry_t *) malloc (entries_size * sizeof(hpack_header_table_entry_t));
+    if (unlikely (entries == NULL)) {
+        return ret_nomem;
+    }
+
+    data = (char *) malloc (data_size);
+    if (unlikely (data == NULL)) {
+        free (entries);
+        return ret_nomem;
+    }
+
+    /* Move the live entries, oldest first
+     */
+    pos = 0;
+    for (n = table->num; n > 0; n--) {
+        hpack_header_table_entry_t *e = ENTRY(table, n);
+
+        len = ENTRY_LEN(e);
+        memcpy (data + pos, table->data + e->offset, len);
+
+        entries[n-1]        = *e;
+        entries[n-1].offset = pos;
+        pos += len;
+    }
+
+    free (table->entries);
+    free (table->data);
+
+    table->entries      = entries;
+    table->entries_size = entries_size;
+    table->first        = 0;
+    table->data         = data;
+    table->data_size    = data_size;
+    table->data_head    = pos;
+
+    return ret_ok;
+}
+
+/* Makes the rings in use hold a table of a given size. They only ever
+ * grow, at least doubling, up to SETTINGS_HEADER_TABLE_SIZE: a peer
+ * walking the size up does not get a reallocation per step, and
+ * shrinking the table then growing it back costs nothing.
+ */
+static ret_t
+grow (hpack_header_table_t *table,
+      size_t                size)
+{
+    if ((table->data == NULL) || (size * 2 <= table->data_size)) {
+        return ret_ok;
+    }
+
+    size = MAX (size, table->data_size);
+    size = MIN (size, table->settings_size);
+
+    return reserve (table, size);
+}
+
+/* Evicts from the end of the table [4.4.]. The bytes stay where they
+ * are, so this only costs the evicted entries.
+ */
+static void
+evict_to_fit (hpack_header_table_t *table,
+              size_t                size)
+{
+    hpack_header_table_entry_t *e;
+
+    while ((table->num > 0) && (table->size + size > table->max_size)) {
+        e = ENTRY(table, table->num);
+
+        table->size -= ENTRY_LEN(e) + HPACK_HEADER_ENTRY_OVERHEAD;
+        table->num  -= 1;
+    }
+
+    if (table->num == 0) {
+        table->data_head = 0;
+    }
+}
+
+/** Get a header table entry
+ *
+ * Looks up an entry in the index address space shared by the static
+ * and the dynamic tables [2.3.3.]. The returned buffers are fake
+ * buffers pointing to the table memory, so they are only valid until
+ * the table is modified.
+ *
+ * @param      table Header table
+ * @param      index Index of the entry, starting at 1
+ * @param[out] name  Fake buffer for the name of the entry
+ * @param[out] value Fake buffer for the value of the entry (may be NULL)
+ * @retval ret_ok        Entry found
+ * @retval ret_not_found The index is out of the address space
+ */
+ret_t
+hpack_header_table_get (hpack_header_table_t *table,
+                        cuint_t               index,
+                        chula_buffer_t       *name,
+                        chula_buffer_t       *value)
+{
+    hpack_header_table_entry_t *e;
+
+    if (unlikely (index == 0)) {
+        return ret_not_found;
+    }
+
+    /* Static table
+     */
+    if (index <= HPACK_STATIC_TABLE_LEN) {
+        const hpack_static_entry_t *s = &hpack_static_table[index - 1];
+
+        chula_buffer_fake (name, s->name, s->name_len);
+        if (value != NULL) {
+            chula_buffer_fake (value, s->value, s->value_len);
+        }
+        return ret_ok;
+    }
+
+    /* Dynamic table
+     */
+    index -= HPACK_STATIC_TABLE_LEN;
+    if (unlikely (index > table->num)) {
+        return ret_not_found;
+    }
+
+    e = ENTRY(table, index);
+
+    chula_buffer_fake (name, table->data + e->offset, e->name_len);
+    if (value != NULL) {
+        chula_buffer_fake (value, table->data + e->offset + e->name_len, e->value_len);
+    }
+
+    return ret_ok;
+}
+
+/** Name ID of a header table entry
+ *
+ * Entries of the static table always have one. Entries of the dynamic
+ * table have the one they were added with.
+ *
+ * @param table Header table
+ * @param index Index of the entry, starting at 1
+ * @return The ID of the name of the entry, or hpack_header_id_unknown
+ */
+hpack_header_id_t
+hpack_header_table_get_id (hpack_header_table_t *table,
+                           cuint_t               index)
+{
+    if (index <= HPACK_STATIC_TABLE_LEN) {
+        return hpack_static_table_get_id (index);
+    }
+
+    index -= HPACK_STATIC_TABLE_LEN;
+    if (unlikely (index > table->num)) {
+        return hpack_header_id_unknown;
+    }
+
+    return ENTRY(table, index)->id;
+}
+
+/** Find a header field in the header table
+ *
+ * Looks up a name/value pair in the static and dynamic tables, as an
+ * encoder does before choosing a representation. An entry matching
+ * both the name and the value is preferred. Otherwise, the lowest
+ * index of an entry with the same name is returned.
+ *
+ * @param      table       Header table
+ * @param      name        Name of the header field
+ * @param      value       Value of the header field, or NULL to look up the name only
+ * @param[out] index       Index of the entry [2.3.3.]
+ * @param[out] value_match Whether the value of the entry matches as well
+ * @retval ret_ok        An entry was found
+ * @retval ret_not_found No entry has that name
+ */
+ret_t
+hpack_header_table_find (hpack_header_table_t *table,
+                         chula_buffer_t       *name,
+                         chula_buffer_t       *value,
+                         cuint_t              *index,
+                         bool                 *value_match)
+{
+    ret_t                       ret;
+    cuint_t                     n;
+    bool                        match;
+    cuint_t                     name_index = 0;
+    hpack_header_table_entry_t *e;
+
+    ret = hpack_static_table_find (name, value, &n, &match);
+    if (ret == ret_ok) {
+        if (match) {
+            *index       = n;
+            *value_match = true;
+            return ret_ok;
+        }
+        name_index = n;
+    }
+
+    for (n = 1; n <= table->num; n++) {
+        e = ENTRY(table, n);
+
+        if ((e->name_len != name->len) ||
+            (memcmp (table->data + e->offset, name->buf, name->len) != 0))
+        {
+            continue;
+        }
+
+        if ((value != NULL) &&
+            (e->value_len == value->len) &&
+            (memcmp (table->data + e->offset + e->name_len, value->buf, value->len) == 0))
+        {
+            *index       = HPACK_STATIC_TABLE_LEN + n;
+            *value_match = true;
+            return ret_ok;
+        }
+
+        if (name_index == 0) {
+            name_index = HPACK_STATIC_TABLE_LEN + n;
+        }
+    }
+
+    if (name_index == 0) {
+        return ret_not_found;
+    }
+
+    *index       = name_index;
+    *value_match = false;
+    return ret_ok;
+}
+
+/** Add an entry to the dynamic table
+ *
+ * Inserts a new entry at the beginning of the dynamic table, evicting
+ * entries from its end until there is room for it [4.4.]. Adding an
+ * entry larger than the maximum size empties the table.
+ *
+ * Both rings are allocated on the first insertion, for the maximum
+ * size at that point, so adding entries does not allocate memory
+ * afterwards. @name may point to the name of an entry of the table,
+ * even if it is evicted by this very insertion.
+ *
+ * @param table Header table
+ * @param name  Name of the new entry
+ * @param value Value of the new entry
+ * @retval ret_ok    The entry was added (or did not fit at all)
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_header_table_add (hpack_header_table_t *table,
+                        chula_buffer_t       *name,
+                        chula_buffer_t       *value)
+{
+    return hpack_header_table_add_id (table, name, value, hpack_header_id_unknown);
+}
+
+/** Add an entry to the dynamic table, with the ID of its name
+ *
+ * Same as hpack_header_table_add(). The decoder passes the ID it
+ * found for the name, so fields referencing the entry later get it
+ * back with hpack_header_table_get_id() instead of a lookup.
+ *
+ * @param table Header table
+ * @param name  Name of the new entry
+ * @param value Value of the new entry
+ * @param id    ID of @name
+ * @retval ret_ok    The entry was added (or did not fit at all)
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_header_table_add_id (hpack_header_table_t *table,
+                           chula_buffer_t       *name,
+                           chula_buffer_t       *value,
+                           hpack_header_id_t     id)
+{
+    ret_t                       ret;
+    size_t                      len;
+    size_t                      pos;
+    size_t                      tail;
+    hpack_header_table_entry_t *e;
+
+    len = name->len + value->len;
+
+    /* Make room for the new entry
+     */
+    evict_to_fit (table, len + HPACK_HEADER_ENTRY_OVERHEAD);
+
+    if (len + HPACK_HEADER_ENTRY_OVERHEAD > table->max_size) {
+        return ret_ok;
+    }
+
+    if (unlikely (table->data == NULL)) {
+        ret = reserve (table, table->max_size);
+        if (unlikely (ret != ret_ok)) return ret;
+    }
+
+    /* Find a contiguous spot for its bytes
+     */
+    pos = table->data_head;
+
+    if (table->num > 0) {
+        tail = ENTRY(table, table->num)->offset;
+        if ((pos >= tail) && (pos + len > table->data_size)) {
+            pos = 0;
+        }
+    }
+
+    memmove (table->data + pos, name->buf, name->len);
+    memcpy  (table->data + pos + name->len, value->buf, value->len);
+
+    /* Insert it at the front
+     */
+    table->first = (table->first + table->entries_size - 1) % table->entries_size;
+
+    e = ENTRY(table, 1);
+    e->offset    = pos;
+    e->name_len  = name->len;
+    e->value_len = value->len;
+    e->id        = id;
+
+    table->data_head  = pos + len;
+    table->size      += len + HPACK_HEADER_ENTRY_OVERHEAD;
+    table->num       += 1;
+    table->inserted  += 1;
+
+    return ret_ok;
+}
+
+/** Set the maximum size of the dynamic table
+ *
+ * Applies a dynamic table size update [6.3.]. Shrinking evicts entries
+ * until the table fits in the new size, in place. Growing past what
+ * the rings can hold reallocates them once the table is in use, to at
+ * least twice their size.
+ *
+ * @param table    Header table
+ * @param max_size New maximum size
+ * @retval ret_ok    The size was updated
+ * @retval ret_error The size exceeds SETTINGS_HEADER_TABLE_SIZE
+ * @retval ret_nomem Memory could not be allocated, nothing changed
+ */
+ret_t
+hpack_header_table_set_max_size (hpack_header_table_t *table,
+                                 size_t                max_size)
+{
+    ret_t ret;
+
+    if (unlikely (max_size > table->settings_size)) {
+        return ret_error;
+    }
+
+    ret = grow (table, max_size);
+    if (unlikely (ret != ret_ok)) return ret;
+
+    table->max_size = max_size;
+    evict_to_fit (table, 0);
+
+    return ret_ok;
+}
+
+/** Set the limit of the dynamic table size
+ *
+ * Sets the value of SETTINGS_HEADER_TABLE_SIZE, which bounds the
+ * maximum size the peer can set through table size updates. Nothing
+ * is allocated: the rings follow the maximum size actually in use.
+ *
+ * @param table         Header table
+ * @param settings_size Value of SETTINGS_HEADER_TABLE_SIZE
+ * @retval ret_ok Always
+ */
+ret_t
+hpack_header_table_set_settings_size (hpack_header_table_t *table,
+                                      size_t                settings_size)
+{
+    table->settings_size = settings_size;
+
+    if (table->max_size > settings_size) {
+        table->max_size = settings_size;
+        evict_to_fit (table, 0);
+    }
+
+    return ret_ok;
+}
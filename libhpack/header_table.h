@@ -0,0 +1,86 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBHPACK_HEADER_TABLE_H
+#define LIBHPACK_HEADER_TABLE_H
+
+#include <libhpack/common.h>
+#include <libhpack/header_field.h>
+#include <libhpack/static_table.h>
+#include <libchula/buffer.h>
+
+/* Initial value of SETTINGS_HEADER_TABLE_SIZE
+ */
+#define HPACK_HEADER_TABLE_SIZE_DEFAULT 4096
+
+typedef struct {
+    cuint_t           offset;    /**< Position of the name in the data ring */
+    cuint_t           name_len;  /**< Length of the name                     */
+    cuint_t           value_len; /**< Length of the value, stored after it   */
+    hpack_header_id_t id;        /**< ID of the name, when it was given      */
+} hpack_header_table_entry_t;
+
+typedef struct {
+    hpack_header_table_entry_t *entries;       /**< Ring of entries                        */
+    cuint_t                     entries_size;  /**< Capacity of the ring of entries        */
+    cuint_t                     first;         /**< Slot of the newest entry               */
+    cuint_t                     num;           /**< Number of entries in the dynamic table */
+    char                       *data;          /**< Ring of name and value bytes           */
+    size_t                      data_size;     /**< Capacity of the ring of bytes          */
+    size_t                      data_head;     /**< Where the next entry will be written   */
+    size_t                      size;          /**< Size of the dynamic table [4.1.]       */
+    size_t                      max_size;      /**< Maximum size of the dynamic table      */
+    size_t                      settings_size; /**< Upper bound for max_size (SETTINGS)    */
+    uint32_t                    inserted;      /**< Entries ever inserted, wrapping        */
+} hpack_header_table_t;
+
+#define HDR_TABLE(t) ((hpack_header_table_t *)(t))
+
+ret_t hpack_header_table_new      (hpack_header_table_t **table);
+ret_t hpack_header_table_free     (hpack_header_table_t  *table);
+ret_t hpack_header_table_init     (hpack_header_table_t  *table);
+ret_t hpack_header_table_mrproper (hpack_header_table_t  *table);
+void  hpack_header_table_clean    (hpack_header_table_t  *table);
+void  hpack_header_table_reset    (hpack_header_table_t  *table);
+
+ret_t hpack_header_table_get      (hpack_header_table_t *table, cuint_t index, chula_buffer_t *name, chula_buffer_t *value);
+ret_t hpack_header_table_add      (hpack_header_table_t *table, chula_buffer_t *name, chula_buffer_t *value);
+ret_t hpack_header_table_add_id   (hpack_header_table_t *table, chula_buffer_t *name, chula_buffer_t *value,
+                                   hpack_header_id_t id);
+hpack_header_id_t hpack_header_table_get_id (hpack_header_table_t *table, cuint_t index);
+ret_t hpack_header_table_find     (hpack_header_table_t *table, chula_buffer_t *name, chula_buffer_t *value,
+                                   cuint_t *index, bool *value_match);
+
+ret_t hpack_header_table_set_max_size      (hpack_header_table_t *table, size_t max_size);
+ret_t hpack_header_table_set_settings_size (hpack_header_table_t *table, size_t settings_size);
+
+#endif /* LIBHPACK_HEADER_TABLE_H */
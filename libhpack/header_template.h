@@ -0,0 +1,76 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBHPACK_HEADER_TEMPLATE_H
+#define LIBHPACK_HEADER_TEMPLATE_H
+
+#include <libhpack/common.h>
+#include <libhpack/header_list.h>
+#include <libchula/buffer.h>
+#include <stdint.h>
+
+/* Header template
+ *
+ * A header list compiled once by hpack_header_encoder_compile(), for
+ * header sets sent over and over. Fields fully matching the static
+ * table are reduced to their index, and the other strings are kept
+ * as String Literal Representations [5.2.]. Encoding a template only
+ * looks the remaining fields up in the dynamic table of the encoder
+ * and copies the precomputed octets.
+ *
+ * Encoding does not modify a template, so encoders on different
+ * threads may share one.
+ */
+typedef struct {
+    uint32_t pair_hash;   /**< hpack_hash() of the value, seeded with the name's */
+    cuint_t  static_pair; /**< Static entry matching the field, 0 if none        */
+    cuint_t  static_name; /**< First static entry with the name, 0 if none       */
+    uint32_t name_off;    /**< Representation of the name in @reps               */
+    uint32_t name_len;    /**< Its length, 0 when @static_name is set            */
+    uint32_t value_off;   /**< Representation of the value in @reps              */
+    uint32_t value_len;   /**< Its length                                        */
+} hpack_header_template_field_t;
+
+typedef struct {
+    hpack_header_list_t            list;   /**< Fields, with names as encoded */
+    hpack_header_template_field_t *fields; /**< Compiled form of each field   */
+    chula_buffer_t                 reps;   /**< String representations        */
+} hpack_header_template_t;
+
+#define HDR_TEMPLATE(t) ((hpack_header_template_t *)(t))
+
+ret_t hpack_header_template_new      (hpack_header_template_t **tmpl);
+ret_t hpack_header_template_free     (hpack_header_template_t  *tmpl);
+ret_t hpack_header_template_init     (hpack_header_template_t  *tmpl);
+ret_t hpack_header_template_mrproper (hpack_header_template_t  *tmpl);
+
+#endif /* LIBHPACK_HEADER_TEMPLATE_H */
@@ -0,0 +1,261 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Current ref:
+ * http://tools.ietf.org/html/rfc7541
+ */
+
+#include "huffman.h"
+
+#include <libchula/macros.h>
+#include <stdint.h>
+
+typedef struct {
+    uint8_t state;
+    uint8_t flags;
+    uint8_t sym;
+} huffman_decode_entry_t;
+
+#define HUFFMAN_ACCEPTED 0x1 /* Valid place to finish the string */
+#define HUFFMAN_SYM      0x2 /* A symbol has been completed        */
+#define HUFFMAN_FAIL     0x4 /* EOS found in the string            */
+
+/* Tables generated by gen-huffman.py
+ */
+#include "huffman_data.h"
+
+/** Partial Huffman decoding
+ *
+ * Decodes a fragment of a Huffman encoded string [5.2.] and appends
+ * it to a buffer. The input is consumed 4 bits per step by walking a
+ * state machine. The machine position is kept in @state, so a string
+ * split across several fragments can be decoded piece by piece
+ * without reassembling it. The shortest code is 5 bits long, so the
+ * output room is reserved once up front for 8/5 of the input length,
+ * plus the bits of a code left pending by the previous fragment.
+ *
+ * Once the last fragment has been decoded, @state->accept tells
+ * whether the string ended on a valid padding.
+ *
+ * @param      state   Decoding state, HPACK_HUFFMAN_STATE_INIT for a new string
+ * @param      encoded Fragment of the Huffman encoded string
+ * @param[out] decoded Buffer to append the decoded symbols to
+ * @retval ret_ok    The fragment was decoded
+ * @retval ret_error The string contains EOS
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_huffman_decode_partial (hpack_huffman_state_t *state,
+                              chula_buffer_t        *encoded,
+                              chula_buffer_t        *decoded)
+{
+    ret_t                         ret;
+    char                         *out;
+    const huffman_decode_entry_t *t;
+    uint8_t                       s      = state->state;
+    bool                          accept = state->accept;
+    const unsigned char          *p      = (const unsigned char *) encoded->buf;
+    const unsigned char          *end    = p + encoded->len;
+
+    ret = chula_buffer_ensure_addlen (decoded, ((size_t)encoded->len * 8 + 29) / 5);
+    if (unlikely (ret != ret_ok)) {
+        return ret;
+    }
+
+    out = decoded->buf + decoded->len;
+
+    while (p < end) {
+        t = &huffman_decode_table[s][*p >> 4];
+        if (unlikely (t->flags & HUFFMAN_FAIL)) {
+            return ret_error;
+        }
+        if (t->flags & HUFFMAN_SYM) {
+            *out++ = t->sym;
+        }
+
+        t = &huffman_decode_table[t->state][*p & 0xF];
+        if (unlikely (t->flags & HUFFMAN_FAIL)) {
+            return ret_error;
+        }
+        if (t->flags & HUFFMAN_SYM) {
+            *out++ = t->sym;
+        }
+
+        s      = t->state;
+        accept = t->flags & HUFFMAN_ACCEPTED;
+        p++;
+    }
+
+    decoded->len = out - decoded->buf;
+    decoded->buf[decoded->len] = '\0';
+
+    state->state  = s;
+    state->accept = accept;
+
+    return ret_ok;
+}
+
+/** Huffman decoding
+ *
+ * Decodes a complete Huffman encoded string [5.2.] and appends it to
+ * a buffer.
+ *
+ * @param      encoded Huffman encoded string
+ * @param[out] decoded Buffer to append the decoded string to
+ * @retval ret_ok    The string was decoded
+ * @retval ret_error The string contains EOS, or its padding is invalid [5.2.]
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_huffman_decode (chula_buffer_t *encoded,
+                      chula_buffer_t *decoded)
+{
+    ret_t                 ret;
+    hpack_huffman_state_t state = HPACK_HUFFMAN_STATE_INIT;
+
+    ret = hpack_huffman_decode_partial (&state, encoded, decoded);
+    if (unlikely (ret != ret_ok)) {
+        return ret;
+    }
+
+    /* Padding longer than 7 bits, or not made of 1s
+     */
+    if (unlikely (! state.accept)) {
+        return ret_error;
+    }
+
+    return ret_ok;
+}
+
+/** Length of a Huffman encoded string
+ *
+ * Computes the exact length of the Huffman encoding of a string, so
+ * the encoder can choose between the raw and the Huffman encoded
+ * representation, and write the length prefix, before encoding it.
+ *
+ * @param str String to encode
+ * @return Length, in bytes, of its Huffman encoding
+ */
+size_t
+hpack_huffman_encoded_length (chula_buffer_t *str)
+{
+    size_t               bits = 0;
+    const unsigned char *p    = (const unsigned char *) str->buf;
+    const unsigned char *end  = p + str->len;
+
+    while (end - p >= 4) {
+        bits += huffman_encode_lens[p[0]] + huffman_encode_lens[p[1]] +
+                huffman_encode_lens[p[2]] + huffman_encode_lens[p[3]];
+        p += 4;
+    }
+
+    while (p < end) {
+        bits += huffman_encode_lens[*p++];
+    }
+
+    return (bits + 7) / 8;
+}
+
+/** Huffman encoding
+ *
+ * Huffman encodes a string [5.2.] and appends it to a buffer. Codes
+ * are accumulated in a 64 bits register which is flushed a 32 bits
+ * word at a time. The output room is reserved up front for the exact
+ * encoded length, and the last octet is padded with the most
+ * significant bits of EOS.
+ *
+ * @param      str     String to encode
+ * @param[out] encoded Buffer to append the encoded string to
+ * @retval ret_ok    The string was encoded
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_huffman_encode (chula_buffer_t *str,
+                      chula_buffer_t *encoded)
+{
+    ret_t                ret;
+    size_t               len;
+    uint64_t             acc   = 0;
+    cuint_t              nbits = 0;
+    unsigned char       *out;
+    const unsigned char *p     = (const unsigned char *) str->buf;
+    const unsigned char *end   = p + str->len;
+
+    len = hpack_huffman_encoded_length (str);
+
+    ret = chula_buffer_ensure_addlen (encoded, len);
+    if (unlikely (ret != ret_ok)) {
+        return ret;
+    }
+
+    out = (unsigned char *) encoded->buf + encoded->len;
+
+    while (p < end) {
+        acc    = (acc << huffman_encode_lens[*p]) | huffman_encode_codes[*p];
+        nbits += huffman_encode_lens[*p];
+        p++;
+
+        /* Codes are up to 30 bits long, so the register never
+         * holds more than 61 bits.
+         */
+        if (nbits >= 32) {
+            uint32_t word = (uint32_t) (acc >> (nbits - 32));
+
+            out[0] = word >> 24;
+            out[1] = word >> 16;
+            out[2] = word >> 8;
+            out[3] = word;
+
+            out   += 4;
+            nbits -= 32;
+        }
+    }
+
+    /* Pad with 1s up to the octet boundary
+     */
+    if (nbits % 8) {
+        cuint_t pad = 8 - (nbits % 8);
+
+        acc    = (acc << pad) | ((1 << pad) - 1);
+        nbits += pad;
+    }
+
+    while (nbits > 0) {
+        nbits -= 8;
+        *out++ = (unsigned char) (acc >> nbits);
+    }
+
+    encoded->len += len;
+    encoded->buf[encoded->len] = '\0';
+
+    return ret_ok;
+}
@@ -0,0 +1,321 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Current ref:
+ * http://tools.ietf.org/html/rfc7541
+ */
+
+#include "huffman_cache.h"
+#include "integer.h"
+#include "hash.h"
+
+#include <libchula/macros.h>
+#include <string.h>
+
+#define NONE ((cuint_t) -1)
+
+#define SLOT_STR(c,e) ((c)->data + (size_t)(e) * (c)->slot_size)
+#define SLOT_REP(c,e) (SLOT_STR(c,e) + (c)->max_len)
+
+/* Implements _new() and _free()
+ */
+HPACK_ADD_FUNC_NEW  (huffman_cache);
+HPACK_ADD_FUNC_FREE (huffman_cache);
+
+ret_t
+hpack_huffman_cache_init (hpack_huffman_cache_t *cache)
+{
+    cache->entries     = NULL;
+    cache->buckets     = NULL;
+    cache->data        = NULL;
+    cache->bits        = 0;
+    cache->max_entries = 0;
+    cache->max_len     = 0;
+    cache->slot_size   = 0;
+    cache->used        = 0;
+    cache->head        = NONE;
+    cache->tail        = NONE;
+    cache->frozen      = false;
+
+    return ret_ok;
+}
+
+ret_t
+hpack_huffman_cache_mrproper (hpack_huffman_cache_t *cache)
+{
+    free (cache->entries);
+    free (cache->buckets);
+    free (cache->data);
+
+    return hpack_huffman_cache_init (cache);
+}
+
+/** Size a Huffman encoding cache
+ *
+ * Allocates every slot up front and drops the cached strings. A cache
+ * with no entries, as initialized, caches nothing.
+ *
+ * @param cache       Huffman encoding cache
+ * @param max_entries Number of strings to remember
+ * @param max_len     Longest string worth caching
+ * @retval ret_ok    The cache was sized
+ * @retval ret_deny  The cache is frozen
+ * @retval ret_error The slots would not fit in memory
+ * @retval ret_nomem Memory could not be allocated
+ */
+ret_t
+hpack_huffman_cache_set_limits (hpack_huffman_cache_t *cache,
+                                cuint_t                max_entries,
+                                cuint_t                max_len)
+{
+    cuint_t bits;
+    size_t  slot_size;
+
+    if (unlikely (cache->frozen)) {
+        return ret_deny;
+    }
+
+    hpack_huffman_cache_mrproper (cache);
+
+    if ((max_entries == 0) || (max_len == 0)) {
+        return ret_ok;
+    }
+
+    /* The Huffman encoding is only used when it is shorter, so a
+     * representation never outgrows its string plus the prefix.
+     */
+    slot_size = 2 * (size_t) max_len + INTEGER_MAX_LEN;
+    if (unlikely ((slot_size > UINT32_MAX) ||
+                  (slot_size > SIZE_MAX / max_entries) ||
+                  (max_entries > (NONE >> 1))))
+    {
+        return ret_error;
+    }
+
+    bits = 1;
+    while ((1u << bits) < max_entries) {
+        bits++;
+    }
+
+    cache->entries = (hpack_huffman_cache_entry_t *) malloc (max_entries * sizeof(hpack_huffman_cache_entry_t));
+    cache->buckets = (cuint_t *) malloc (sizeof(cuint_t) << bits);
+    cache->data    = (char *) malloc (slot_size * max_entries);
+
+    if (unlikely ((cache->entries == NULL) || (cache->buckets == NULL) || (cache->data == NULL))) {
+        hpack_huffman_cache_mrproper (cache);
+        return ret_nomem;
+    }
+
+    memset (cache->buckets, 0xff, sizeof(cuint_t) << bits);
+
+    cache->bits        = bits;
+    cache->max_entries = max_entries;
+    cache->max_len     = max_len;
+    cache->slot_size   = (cuint_t) slot_size;
+
+    return ret_ok;
+}
+
+/** Freeze a Huffman encoding cache
+ *
+ * From here on the cache is only read: lookups do not update the
+ * recency order and no string is added. Encoders on different threads
+ * may then share it.
+ *
+ * @param cache Huffman encoding cache
+ * @retval ret_ok Always
+ */
+ret_t
+hpack_huffman_cache_freeze (hpack_huffman_cache_t *cache)
+{
+    cache->frozen = true;
+    return ret_ok;
+}
+
+/* Recency list
+ */
+
+static void
+unlink_entry (hpack_huffman_cache_t *cache,
+              cuint_t                e)
+{
+    hpack_huffman_cache_entry_t *entry = &cache->entries[e];
+
+    if (entry->prev != NONE) {
+        cache->entries[entry->prev].next = entry->next;
+    } else {
+        cache->head = entry->next;
+    }
+
+    if (entry->next != NONE) {
+        cache->entries[entry->next].prev = entry->prev;
+    } else {
+        cache->tail = entry->prev;
+    }
+}
+
+static void
+push_front (hpack_huffman_cache_t *cache,
+            cuint_t                e)
+{
+    hpack_huffman_cache_entry_t *entry = &cache->entries[e];
+
+    entry->prev = NONE;
+    entry->next = cache->head;
+
+    if (cache->head != NONE) {
+        cache->entries[cache->head].prev = e;
+    } else {
+        cache->tail = e;
+    }
+
+    cache->head = e;
+}
+
+/* Buckets
+ */
+
+#define BUCKET(c,h) HPACK_HASH_SLOT(h, 0, (c)->bits)
+
+static void
+unchain_entry (hpack_huffman_cache_t *cache,
+               cuint_t                e)
+{
+    cuint_t *link = &cache->buckets[BUCKET (cache, cache->entries[e].hash)];
+
+    while (*link != e) {
+        link = &cache->entries[*link].chain;
+    }
+
+    *link = cache->entries[e].chain;
+}
+
+/** Append a cached string representation
+ *
+ * @param      cache Huffman encoding cache
+ * @param      str   String to encode
+ * @param      len   Length of @str
+ * @param      hash  hpack_hash() of @str, seeded with HPACK_HASH_INIT
+ * @param[out] out   Buffer to append the representation to
+ * @retval ret_ok        The representation was appended
+ * @retval ret_not_found The string is not cached
+ * @retval ret_nomem     Memory could not be allocated
+ */
+ret_t
+hpack_huffman_cache_get (hpack_huffman_cache_t *cache,
+                         const char            *str,
+                         cuint_t                len,
+                         uint32_t               hash,
+                         chula_buffer_t        *out)
+{
+    cuint_t                      e;
+    hpack_huffman_cache_entry_t *entry;
+
+    if ((cache->entries == NULL) || (len > cache->max_len)) {
+        return ret_not_found;
+    }
+
+    for (e = cache->buckets[BUCKET (cache, hash)]; e != NONE; e = entry->chain) {
+        entry = &cache->entries[e];
+
+        if ((entry->hash != hash) || (entry->str_len != len) ||
+            (memcmp (SLOT_STR (cache, e), str, len) != 0))
+        {
+            continue;
+        }
+
+        if ((! cache->frozen) && (cache->head != e)) {
+            unlink_entry (cache, e);
+            push_front (cache, e);
+        }
+
+        return chula_buffer_add (out, SLOT_REP (cache, e), entry->rep_len);
+    }
+
+    return ret_not_found;
+}
+
+/** Remember the representation of a string
+ *
+ * The string must not be cached already. When the cache is full, the
+ * least recently used string makes room for it.
+ *
+ * @param cache   Huffman encoding cache
+ * @param str     Encoded string
+ * @param len     Length of @str
+ * @param hash    hpack_hash() of @str, seeded with HPACK_HASH_INIT
+ * @param rep     String Literal Representation of @str [5.2.]
+ * @param rep_len Length of @rep
+ * @retval ret_ok   The string was cached
+ * @retval ret_deny The cache is frozen, disabled, or the string is too long
+ */
+ret_t
+hpack_huffman_cache_add (hpack_huffman_cache_t *cache,
+                         const char            *str,
+                         cuint_t                len,
+                         uint32_t               hash,
+                         const char            *rep,
+                         cuint_t                rep_len)
+{
+    cuint_t                      e;
+    cuint_t                     *bucket;
+    hpack_huffman_cache_entry_t *entry;
+
+    if ((cache->frozen) || (cache->entries == NULL) ||
+        (len > cache->max_len) || (rep_len > cache->slot_size - cache->max_len))
+    {
+        return ret_deny;
+    }
+
+    if (cache->used < cache->max_entries) {
+        e = cache->used++;
+    } else {
+        e = cache->tail;
+        unlink_entry (cache, e);
+        unchain_entry (cache, e);
+    }
+
+    entry = &cache->entries[e];
+    entry->hash    = hash;
+    entry->str_len = len;
+    entry->rep_len = rep_len;
+
+    memcpy (SLOT_STR (cache, e), str, len);
+    memcpy (SLOT_REP (cache, e), rep, rep_len);
+
+    bucket = &cache->buckets[BUCKET (cache, hash)];
+    entry->chain = *bucket;
+    *bucket      = e;
+
+    push_front (cache, e);
+    return ret_ok;
+}
@@ -0,0 +1,101 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBHPACK_HUFFMAN_CACHE_H
+#define LIBHPACK_HUFFMAN_CACHE_H
+
+#include <libhpack/common.h>
+#include <libchula/buffer.h>
+#include <stdint.h>
+
+/* Huffman encoding cache
+ *
+ * Remembers the String Literal Representation [5.2.] of the most
+ * recently encoded strings: the length prefix, the Huffman or raw
+ * choice, and the octets. A string seen again is appended with a
+ * single copy.
+ *
+ * Memory is bounded: every entry owns a fixed slot, allocated once by
+ * hpack_huffman_cache_set_limits(). The least recently used entry is
+ * replaced when the cache is full.
+ *
+ * Once frozen, lookups leave the cache untouched and nothing is added
+ * to it, so it can be shared by encoders on several threads.
+ */
+typedef struct {
+    uint32_t hash;     /**< hpack_hash() of the string               */
+    cuint_t  str_len;  /**< Length of the string                     */
+    cuint_t  rep_len;  /**< Length of its representation             */
+    cuint_t  chain;    /**< Next entry in the same bucket            */
+    cuint_t  prev;     /**< More recently used entry                 */
+    cuint_t  next;     /**< Less recently used entry                 */
+} hpack_huffman_cache_entry_t;
+
+typedef struct {
+    hpack_huffman_cache_entry_t *entries;     /**< Entries, in slot order         */
+    cuint_t                     *buckets;     /**< First entry of each bucket     */
+    char                        *data;        /**< Strings and representations    */
+    cuint_t                      bits;        /**< There are 2^bits buckets       */
+    cuint_t                      max_entries; /**< Number of entries              */
+    cuint_t                      max_len;     /**< Longest string that is cached  */
+    cuint_t                      slot_size;   /**< Octets of @data per entry      */
+    cuint_t                      used;        /**< Entries holding a string       */
+    cuint_t                      head;        /**< Most recently used entry       */
+    cuint_t                      tail;        /**< Least recently used entry      */
+    bool                         frozen;      /**< Read-only, see above           */
+} hpack_huffman_cache_t;
+
+#define HUFFMAN_CACHE(c) ((hpack_huffman_cache_t *)(c))
+
+ret_t hpack_huffman_cache_new        (hpack_huffman_cache_t **cache);
+ret_t hpack_huffman_cache_free       (hpack_huffman_cache_t  *cache);
+ret_t hpack_huffman_cache_init       (hpack_huffman_cache_t  *cache);
+ret_t hpack_huffman_cache_mrproper   (hpack_huffman_cache_t  *cache);
+
+ret_t hpack_huffman_cache_set_limits (hpack_huffman_cache_t  *cache,
+                                      cuint_t                 max_entries,
+                                      cuint_t                 max_len);
+ret_t hpack_huffman_cache_freeze     (hpack_huffman_cache_t  *cache);
+
+ret_t hpack_huffman_cache_get        (hpack_huffman_cache_t  *cache,
+                                      const char             *str,
+                                      cuint_t                 len,
+                                      uint32_t                hash,
+                                      chula_buffer_t         *out);
+ret_t hpack_huffman_cache_add        (hpack_huffman_cache_t  *cache,
+                                      const char             *str,
+                                      cuint_t                 len,
+                                      uint32_t                hash,
+                                      const char             *rep,
+                                      cuint_t                 rep_len);
+
+#endif /* LIBHPACK_HUFFMAN_CACHE_H */
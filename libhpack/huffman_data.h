@@ -0,0 +1,581 @@
+/* Generated by gen-huffman.py. DO NOT EDIT. */
+
+#ifndef LIBHPACK_HUFFMAN_DATA_H
+#define LIBHPACK_HUFFMAN_DATA_H
+
+/* Codes, right aligned, indexed by symbol
+ */
+static const uint32_t huffman_encode_codes[256] = {
+    0x00001ff8, 0x007fffd8, 0x0fffffe2, 0x0fffffe3, 0x0fffffe4, 0x0fffffe5, 0x0fffffe6, 0x0fffffe7,
+    0x0fffffe8, 0x00ffffea, 0x3ffffffc, 0x0fffffe9, 0x0fffffea, 0x3ffffffd, 0x0fffffeb, 0x0fffffec,
+    0x0fffffed, 0x0fffffee, 0x0fffffef, 0x0ffffff0, 0x0ffffff1, 0x0ffffff2, 0x3ffffffe, 0x0ffffff3,
+    0x0ffffff4, 0x0ffffff5, 0x0ffffff6, 0x0ffffff7, 0x0ffffff8, 0x0ffffff9, 0x0ffffffa, 0x0ffffffb,
+    0x00000014, 0x000003f8, 0x000003f9, 0x00000ffa, 0x00001ff9, 0x00000015, 0x000000f8, 0x000007fa,
+    0x000003fa, 0x000003fb, 0x000000f9, 0x000007fb, 0x000000fa, 0x00000016, 0x00000017, 0x00000018,
+    0x00000000, 0x00000001, 0x00000002, 0x00000019, 0x0000001a, 0x0000001b, 0x0000001c, 0x0000001d,
+    0x0000001e, 0x0000001f, 0x0000005c, 0x000000fb, 0x00007ffc, 0x00000020, 0x00000ffb, 0x000003fc,
+    0x00001ffa, 0x00000021, 0x0000005d, 0x0000005e, 0x0000005f, 0x00000060, 0x00000061, 0x00000062,
+    0x00000063, 0x00000064, 0x00000065, 0x00000066, 0x00000067, 0x00000068, 0x00000069, 0x0000006a,
+    0x0000006b, 0x0000006c, 0x0000006d, 0x0000006e, 0x0000006f, 0x00000070, 0x00000071, 0x00000072,
+    0x000000fc, 0x00000073, 0x000000fd, 0x00001ffb, 0x0007fff0, 0x00001ffc, 0x00003ffc, 0x00000022,
+    0x00007ffd, 0x00000003, 0x00000023, 0x00000004, 0x00000024, 0x00000005, 0x00000025, 0x00000026,
+    0x00000027, 0x00000006, 0x00000074, 0x00000075, 0x00000028, 0x00000029, 0x0000002a, 0x00000007,
+    0x0000002b, 0x00000076, 0x0000002c, 0x00000008, 0x00000009, 0x0000002d, 0x00000077, 0x00000078,
+    0x00000079, 0x0000007a, 0x0000007b, 0x00007ffe, 0x000007fc, 0x00003ffd, 0x00001ffd, 0x0ffffffc,
+    0x000fffe6, 0x003fffd2, 0x000fffe7, 0x000fffe8, 0x003fffd3, 0x003fffd4, 0x003fffd5, 0x007fffd9,
+    0x003fffd6, 0x007fffda, 0x007fffdb, 0x007fffdc, 0x007fffdd, 0x007fffde, 0x00ffffeb, 0x007fffdf,
+    0x00ffffec, 0x00ffffed, 0x003fffd7, 0x007fffe0, 0x00ffffee, 0x007fffe1, 0x007fffe2, 0x007fffe3,
+    0x007fffe4, 0x001fffdc, 0x003fffd8, 0x007fffe5, 0x003fffd9, 0x007fffe6, 0x007fffe7, 0x00ffffef,
+    0x003fffda, 0x001fffdd, 0x000fffe9, 0x003fffdb, 0x003fffdc, 0x007fffe8, 0x007fffe9, 0x001fffde,
+    0x007fffea, 0x003fffdd, 0x003fffde, 0x00fffff0, 0x001fffdf, 0x003fffdf, 0x007fffeb, 0x007fffec,
+    0x001fffe0, 0x001fffe1, 0x003fffe0, 0x001fffe2, 0x007fffed, 0x003fffe1, 0x007fffee, 0x007fffef,
+    0x000fffea, 0x003fffe2, 0x003fffe3, 0x003fffe4, 0x007ffff0, 0x003fffe5, 0x003fffe6, 0x007ffff1,
+    0x03ffffe0, 0x03ffffe1, 0x000fffeb, 0x0007fff1, 0x003fffe7, 0x007ffff2, 0x003fffe8, 0x01ffffec,
+    0x03ffffe2, 0x03ffffe3, 0x03ffffe4, 0x07ffffde, 0x07ffffdf, 0x03ffffe5, 0x00fffff1, 0x01ffffed,
+    0x0007fff2, 0x001fffe3, 0x03ffffe6, 0x07ffffe0, 0x07ffffe1, 0x03ffffe7, 0x07ffffe2, 0x00fffff2,
+    0x001fffe4, 0x001fffe5, 0x03ffffe8, 0x03ffffe9, 0x0ffffffd, 0x07ffffe3, 0x07ffffe4, 0x07ffffe5,
+    0x000fffec, 0x00fffff3, 0x000fffed, 0x001fffe6, 0x003fffe9, 0x001fffe7, 0x001fffe8, 0x007ffff3,
+    0x003fffea, 0x003fffeb, 0x01ffffee, 0x01ffffef, 0x00fffff4, 0x00fffff5, 0x03ffffea, 0x007ffff4,
+    0x03ffffeb, 0x07ffffe6, 0x03ffffec, 0x03ffffed, 0x07ffffe7, 0x07ffffe8, 0x07ffffe9, 0x07ffffea,
+    0x07ffffeb, 0x0ffffffe, 0x07ffffec, 0x07ffffed, 0x07ffffee, 0x07ffffef, 0x07fffff0, 0x03ffffee,
+};
+
+/* Code lengths in bits, indexed by symbol
+ */
+static const uint8_t huffman_encode_lens[256] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+     6, 10, 10, 12, 13,  6,  8, 11, 10, 10,  8, 11,  8,  6,  6,  6,
+     5,  5,  5,  6,  6,  6,  6,  6,  6,  6,  7,  8, 15,  6, 12, 10,
+    13,  6,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,
+     7,  7,  7,  7,  7,  7,  7,  7,  8,  7,  8, 13, 19, 13, 14,  6,
+    15,  5,  6,  5,  6,  5,  6,  6,  6,  5,  7,  7,  6,  6,  6,  5,
+     6,  7,  6,  5,  5,  6,  7,  7,  7,  7,  7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+};
+
+/* Decoding state machine: [state][nibble] -> {next state, flags, symbol}
+ */
+static const huffman_decode_entry_t huffman_decode_table[256][16] = {
+    /*   0 */ {{ 87,0,  0}, { 88,0,  0}, {131,0,  0}, {135,0,  0}, {143,0,  0}, { 69,0,  0}, { 83,0,  0}, { 90,0,  0},
+               {100,0,  0}, {132,0,  0}, {138,0,  0}, { 95,0,  0}, {105,0,  0}, {112,0,  0}, {119,0,  0}, {  4,1,  0}},
+    /*   1 */ {{101,0,  0}, {129,0,  0}, {133,0,  0}, {134,0,  0}, {139,0,  0}, {140,0,  0}, {142,0,  0}, { 96,0,  0},
+               {106,0,  0}, {109,0,  0}, {113,0,  0}, {116,0,  0}, {120,0,  0}, {136,0,  0}, {144,0,  0}, {  5,1,  0}},
+    /*   2 */ {{107,0,  0}, {108,0,  0}, {110,0,  0}, {111,0,  0}, {114,0,  0}, {115,0,  0}, {117,0,  0}, {118,0,  0},
+               {121,0,  0}, {122,0,  0}, {137,0,  0}, {141,0,  0}, {145,0,  0}, {146,0,  0}, { 75,0,  0}, {  6,1,  0}},
+    /*   3 */ {{  0,3, 85}, {  0,3, 86}, {  0,3, 87}, {  0,3, 89}, {  0,3,106}, {  0,3,107}, {  0,3,113}, {  0,3,118},
+               {  0,3,119}, {  0,3,120}, {  0,3,121}, {  0,3,122}, { 76,0,  0}, { 80,0,  0}, {123,0,  0}, {  7,1,  0}},
+    /*   4 */ {{ 66,2,119}, {  1,3,119}, { 66,2,120}, {  1,3,120}, { 66,2,121}, {  1,3,121}, { 66,2,122}, {  1,3,122},
+               {  0,3, 38}, {  0,3, 42}, {  0,3, 44}, {  0,3, 59}, {  0,3, 88}, {  0,3, 90}, { 71,0,  0}, {  8,0,  0}},
+    /*   5 */ {{ 66,2, 38}, {  1,3, 38}, { 66,2, 42}, {  1,3, 42}, { 66,2, 44}, {  1,3, 44}, { 66,2, 59}, {  1,3, 59},
+               { 66,2, 88}, {  1,3, 88}, { 66,2, 90}, {  1,3, 90}, { 72,0,  0}, { 79,0,  0}, { 77,0,  0}, {  9,0,  0}},
+    /*   6 */ {{ 85,2, 88}, { 67,2, 88}, { 93,2, 88}, {  2,3, 88}, { 85,2, 90}, { 67,2, 90}, { 93,2, 90}, {  2,3, 90},
+               {  0,3, 33}, {  0,3, 34}, {  0,3, 40}, {  0,3, 41}, {  0,3, 63}, { 78,0,  0}, { 73,0,  0}, { 10,0,  0}},
+    /*   7 */ {{ 66,2, 33}, {  1,3, 33}, { 66,2, 34}, {  1,3, 34}, { 66,2, 40}, {  1,3, 40}, { 66,2, 41}, {  1,3, 41},
+               { 66,2, 63}, {  1,3, 63}, {  0,3, 39}, {  0,3, 43}, {  0,3,124}, { 74,0,  0}, { 11,0,  0}, { 13,0,  0}},
+    /*   8 */ {{ 85,2, 63}, { 67,2, 63}, { 93,2, 63}, {  2,3, 63}, { 66,2, 39}, {  1,3, 39}, { 66,2, 43}, {  1,3, 43},
+               { 66,2,124}, {  1,3,124}, {  0,3, 35}, {  0,3, 62}, { 12,0,  0}, {102,0,  0}, {127,0,  0}, { 14,0,  0}},
+    /*   9 */ {{ 85,2,124}, { 67,2,124}, { 93,2,124}, {  2,3,124}, { 66,2, 35}, {  1,3, 35}, { 66,2, 62}, {  1,3, 62},
+               {  0,3,  0}, {  0,3, 36}, {  0,3, 64}, {  0,3, 91}, {  0,3, 93}, {  0,3,126}, {128,0,  0}, { 15,0,  0}},
+    /*  10 */ {{ 66,2,  0}, {  1,3,  0}, { 66,2, 36}, {  1,3, 36}, { 66,2, 64}, {  1,3, 64}, { 66,2, 91}, {  1,3, 91},
+               { 66,2, 93}, {  1,3, 93}, { 66,2,126}, {  1,3,126}, {  0,3, 94}, {  0,3,125}, { 98,0,  0}, { 16,0,  0}},
+    /*  11 */ {{ 85,2,  0}, { 67,2,  0}, { 93,2,  0}, {  2,3,  0}, { 85,2, 36}, { 67,2, 36}, { 93,2, 36}, {  2,3, 36},
+               { 85,2, 64}, { 67,2, 64}, { 93,2, 64}, {  2,3, 64}, { 85,2, 91}, { 67,2, 91}, { 93,2, 91}, {  2,3, 91}},
+    /*  12 */ {{ 86,2,  0}, {130,2,  0}, { 68,2,  0}, { 82,2,  0}, { 99,2,  0}, { 94,2,  0}, {104,2,  0}, {  3,3,  0},
+               { 86,2, 36}, {130,2, 36}, { 68,2, 36}, { 82,2, 36}, { 99,2, 36}, { 94,2, 36}, {104,2, 36}, {  3,3, 36}},
+    /*  13 */ {{ 85,2, 93}, { 67,2, 93}, { 93,2, 93}, {  2,3, 93}, { 85,2,126}, { 67,2,126}, { 93,2,126}, {  2,3,126},
+               { 66,2, 94}, {  1,3, 94}, { 66,2,125}, {  1,3,125}, {  0,3, 60}, {  0,3, 96}, {  0,3,123}, { 17,0,  0}},
+    /*  14 */ {{ 85,2, 94}, { 67,2, 94}, { 93,2, 94}, {  2,3, 94}, { 85,2,125}, { 67,2,125}, { 93,2,125}, {  2,3,125},
+               { 66,2, 60}, {  1,3, 60}, { 66,2, 96}, {  1,3, 96}, { 66,2,123}, {  1,3,123}, {124,0,  0}, { 18,0,  0}},
+    /*  15 */ {{ 85,2, 60}, { 67,2, 60}, { 93,2, 60}, {  2,3, 60}, { 85,2, 96}, { 67,2, 96}, { 93,2, 96}, {  2,3, 96},
+               { 85,2,123}, { 67,2,123}, { 93,2,123}, {  2,3,123}, {125,0,  0}, {155,0,  0}, {150,0,  0}, { 19,0,  0}},
+    /*  16 */ {{ 86,2,123}, {130,2,123}, { 68,2,123}, { 82,2,123}, { 99,2,123}, { 94,2,123}, {104,2,123}, {  3,3,123},
+               {126,0,  0}, {148,0,  0}, {156,0,  0}, {175,0,  0}, {196,0,  0}, {151,0,  0}, { 20,0,  0}, { 25,0,  0}},
+    /*  17 */ {{  0,3, 92}, {  0,3,195}, {  0,3,208}, {149,0,  0}, {157,0,  0}, {204,0,  0}, {241,0,  0}, {176,0,  0},
+               {197,0,  0}, {235,0,  0}, {152,0,  0}, {178,0,  0}, {199,0,  0}, { 21,0,  0}, {167,0,  0}, { 26,0,  0}},
+    /*  18 */ {{198,0,  0}, {202,0,  0}, {236,0,  0}, {242,0,  0}, {153,0,  0}, {158,0,  0}, {179,0,  0}, {183,0,  0},
+               {200,0,  0}, {206,0,  0}, {216,0,  0}, { 22,0,  0}, {168,0,  0}, {185,0,  0}, { 41,0,  0}, { 27,0,  0}},
+    /*  19 */ {{201,0,  0}, {205,0,  0}, {207,0,  0}, {210,0,  0}, {217,0,  0}, {243,0,  0}, { 23,0,  0}, {162,0,  0},
+               {169,0,  0}, {173,0,  0}, {186,0,  0}, {194,0,  0}, {208,0,  0}, { 42,0,  0}, {191,0,  0}, { 28,0,  0}},
+    /*  20 */ {{  0,3,178}, {  0,3,181}, {  0,3,185}, {  0,3,186}, {  0,3,187}, {  0,3,189}, {  0,3,190}, {  0,3,196},
+               {  0,3,198}, {  0,3,228}, {  0,3,232}, {  0,3,233}, { 24,0,  0}, {161,0,  0}, {163,0,  0}, {164,0,  0}},
+    /*  21 */ {{ 66,2,198}, {  1,3,198}, { 66,2,228}, {  1,3,228}, { 66,2,232}, {  1,3,232}, { 66,2,233}, {  1,3,233},
+               {  0,3,  1}, {  0,3,135}, {  0,3,137}, {  0,3,138}, {  0,3,139}, {  0,3,140}, {  0,3,141}, {  0,3,143}},
+    /*  22 */ {{ 66,2,  1}, {  1,3,  1}, { 66,2,135}, {  1,3,135}, { 66,2,137}, {  1,3,137}, { 66,2,138}, {  1,3,138},
+               { 66,2,139}, {  1,3,139}, { 66,2,140}, {  1,3,140}, { 66,2,141}, {  1,3,141}, { 66,2,143}, {  1,3,143}},
+    /*  23 */ {{ 85,2,  1}, { 67,2,  1}, { 93,2,  1}, {  2,3,  1}, { 85,2,135}, { 67,2,135}, { 93,2,135}, {  2,3,135},
+               { 85,2,137}, { 67,2,137}, { 93,2,137}, {  2,3,137}, { 85,2,138}, { 67,2,138}, { 93,2,138}, {  2,3,138}},
+    /*  24 */ {{ 86,2,  1}, {130,2,  1}, { 68,2,  1}, { 82,2,  1}, { 99,2,  1}, { 94,2,  1}, {104,2,  1}, {  3,3,  1},
+               { 86,2,135}, {130,2,135}, { 68,2,135}, { 82,2,135}, { 99,2,135}, { 94,2,135}, {104,2,135}, {  3,3,135}},
+    /*  25 */ {{170,0,  0}, {172,0,  0}, {174,0,  0}, {181,0,  0}, {187,0,  0}, {189,0,  0}, {195,0,  0}, {203,0,  0},
+               {209,0,  0}, {215,0,  0}, { 43,0,  0}, {165,0,  0}, {192,0,  0}, {218,0,  0}, {211,0,  0}, { 29,0,  0}},
+    /*  26 */ {{  0,3,188}, {  0,3,191}, {  0,3,197}, {  0,3,231}, {  0,3,239}, { 44,0,  0}, {166,0,  0}, {171,0,  0},
+               {193,0,  0}, {234,0,  0}, {245,0,  0}, {219,0,  0}, {212,0,  0}, {224,0,  0}, {229,0,  0}, { 30,0,  0}},
+    /*  27 */ {{  0,3,171}, {  0,3,206}, {  0,3,215}, {  0,3,225}, {  0,3,236}, {  0,3,237}, {220,0,  0}, {244,0,  0},
+               {213,0,  0}, {222,0,  0}, {237,0,  0}, {225,0,  0}, {230,0,  0}, {249,0,  0}, { 31,0,  0}, { 45,0,  0}},
+    /*  28 */ {{214,0,  0}, {221,0,  0}, {223,0,  0}, {228,0,  0}, {238,0,  0}, {246,0,  0}, {248,0,  0}, {226,0,  0},
+               {231,0,  0}, {239,0,  0}, {250,0,  0}, {253,0,  0}, { 32,0,  0}, { 38,0,  0}, { 55,0,  0}, { 46,0,  0}},
+    /*  29 */ {{232,0,  0}, {233,0,  0}, {240,0,  0}, {247,0,  0}, {251,0,  0}, {252,0,  0}, {254,0,  0}, {255,0,  0},
+               { 33,0,  0}, { 35,0,  0}, { 39,0,  0}, { 52,0,  0}, { 56,0,  0}, { 60,0,  0}, { 63,0,  0}, { 47,0,  0}},
+    /*  30 */ {{  0,3,254}, { 34,0,  0}, { 36,0,  0}, { 37,0,  0}, { 40,0,  0}, { 51,0,  0}, { 53,0,  0}, { 54,0,  0},
+               { 57,0,  0}, { 58,0,  0}, { 61,0,  0}, { 62,0,  0}, { 64,0,  0}, { 65,0,  0}, {147,0,  0}, { 48,0,  0}},
+    /*  31 */ {{ 66,2,254}, {  1,3,254}, {  0,3,  2}, {  0,3,  3}, {  0,3,  4}, {  0,3,  5}, {  0,3,  6}, {  0,3,  7},
+               {  0,3,  8}, {  0,3, 11}, {  0,3, 12}, {  0,3, 14}, {  0,3, 15}, {  0,3, 16}, {  0,3, 17}, {  0,3, 18}},
+    /*  32 */ {{ 85,2,254}, { 67,2,254}, { 93,2,254}, {  2,3,254}, { 66,2,  2}, {  1,3,  2}, { 66,2,  3}, {  1,3,  3},
+               { 66,2,  4}, {  1,3,  4}, { 66,2,  5}, {  1,3,  5}, { 66,2,  6}, {  1,3,  6}, { 66,2,  7}, {  1,3,  7}},
+    /*  33 */ {{ 86,2,254}, {130,2,254}, { 68,2,254}, { 82,2,254}, { 99,2,254}, { 94,2,254}, {104,2,254}, {  3,3,254},
+               { 85,2,  2}, { 67,2,  2}, { 93,2,  2}, {  2,3,  2}, { 85,2,  3}, { 67,2,  3}, { 93,2,  3}, {  2,3,  3}},
+    /*  34 */ {{ 86,2,  2}, {130,2,  2}, { 68,2,  2}, { 82,2,  2}, { 99,2,  2}, { 94,2,  2}, {104,2,  2}, {  3,3,  2},
+               { 86,2,  3}, {130,2,  3}, { 68,2,  3}, { 82,2,  3}, { 99,2,  3}, { 94,2,  3}, {104,2,  3}, {  3,3,  3}},
+    /*  35 */ {{ 85,2,  4}, { 67,2,  4}, { 93,2,  4}, {  2,3,  4}, { 85,2,  5}, { 67,2,  5}, { 93,2,  5}, {  2,3,  5},
+               { 85,2,  6}, { 67,2,  6}, { 93,2,  6}, {  2,3,  6}, { 85,2,  7}, { 67,2,  7}, { 93,2,  7}, {  2,3,  7}},
+    /*  36 */ {{ 86,2,  4}, {130,2,  4}, { 68,2,  4}, { 82,2,  4}, { 99,2,  4}, { 94,2,  4}, {104,2,  4}, {  3,3,  4},
+               { 86,2,  5}, {130,2,  5}, { 68,2,  5}, { 82,2,  5}, { 99,2,  5}, { 94,2,  5}, {104,2,  5}, {  3,3,  5}},
+    /*  37 */ {{ 86,2,  6}, {130,2,  6}, { 68,2,  6}, { 82,2,  6}, { 99,2,  6}, { 94,2,  6}, {104,2,  6}, {  3,3,  6},
+               { 86,2,  7}, {130,2,  7}, { 68,2,  7}, { 82,2,  7}, { 99,2,  7}, { 94,2,  7}, {104,2,  7}, {  3,3,  7}},
+    /*  38 */ {{ 66,2,  8}, {  1,3,  8}, { 66,2, 11}, {  1,3, 11}, { 66,2, 12}, {  1,3, 12}, { 66,2, 14}, {  1,3, 14},
+               { 66,2, 15}, {  1,3, 15}, { 66,2, 16}, {  1,3, 16}, { 66,2, 17}, {  1,3, 17}, { 66,2, 18}, {  1,3, 18}},
+    /*  39 */ {{ 85,2,  8}, { 67,2,  8}, { 93,2,  8}, {  2,3,  8}, { 85,2, 11}, { 67,2, 11}, { 93,2, 11}, {  2,3, 11},
+               { 85,2, 12}, { 67,2, 12}, { 93,2, 12}, {  2,3, 12}, { 85,2, 14}, { 67,2, 14}, { 93,2, 14}, {  2,3, 14}},
+    /*  40 */ {{ 86,2,  8}, {130,2,  8}, { 68,2,  8}, { 82,2,  8}, { 99,2,  8}, { 94,2,  8}, {104,2,  8}, {  3,3,  8},
+               { 86,2, 11}, {130,2, 11}, { 68,2, 11}, { 82,2, 11}, { 99,2, 11}, { 94,2, 11}, {104,2, 11}, {  3,3, 11}},
+    /*  41 */ {{ 66,2,188}, {  1,3,188}, { 66,2,191}, {  1,3,191}, { 66,2,197}, {  1,3,197}, { 66,2,231}, {  1,3,231},
+               { 66,2,239}, {  1,3,239}, {  0,3,  9}, {  0,3,142}, {  0,3,144}, {  0,3,145}, {  0,3,148}, {  0,3,159}},
+    /*  42 */ {{ 85,2,239}, { 67,2,239}, { 93,2,239}, {  2,3,239}, { 66,2,  9}, {  1,3,  9}, { 66,2,142}, {  1,3,142},
+               { 66,2,144}, {  1,3,144}, { 66,2,145}, {  1,3,145}, { 66,2,148}, {  1,3,148}, { 66,2,159}, {  1,3,159}},
+    /*  43 */ {{ 86,2,239}, {130,2,239}, { 68,2,239}, { 82,2,239}, { 99,2,239}, { 94,2,239}, {104,2,239}, {  3,3,239},
+               { 85,2,  9}, { 67,2,  9}, { 93,2,  9}, {  2,3,  9}, { 85,2,142}, { 67,2,142}, { 93,2,142}, {  2,3,142}},
+    /*  44 */ {{ 86,2,  9}, {130,2,  9}, { 68,2,  9}, { 82,2,  9}, { 99,2,  9}, { 94,2,  9}, {104,2,  9}, {  3,3,  9},
+               { 86,2,142}, {130,2,142}, { 68,2,142}, { 82,2,142}, { 99,2,142}, { 94,2,142}, {104,2,142}, {  3,3,142}},
+    /*  45 */ {{  0,3, 19}, {  0,3, 20}, {  0,3, 21}, {  0,3, 23}, {  0,3, 24}, {  0,3, 25}, {  0,3, 26}, {  0,3, 27},
+               {  0,3, 28}, {  0,3, 29}, {  0,3, 30}, {  0,3, 31}, {  0,3,127}, {  0,3,220}, {  0,3,249}, { 49,0,  0}},
+    /*  46 */ {{ 66,2, 28}, {  1,3, 28}, { 66,2, 29}, {  1,3, 29}, { 66,2, 30}, {  1,3, 30}, { 66,2, 31}, {  1,3, 31},
+               { 66,2,127}, {  1,3,127}, { 66,2,220}, {  1,3,220}, { 66,2,249}, {  1,3,249}, { 50,0,  0}, { 59,0,  0}},
+    /*  47 */ {{ 85,2,127}, { 67,2,127}, { 93,2,127}, {  2,3,127}, { 85,2,220}, { 67,2,220}, { 93,2,220}, {  2,3,220},
+               { 85,2,249}, { 67,2,249}, { 93,2,249}, {  2,3,249}, {  0,3, 10}, {  0,3, 13}, {  0,3, 22}, {  0,4,  0}},
+    /*  48 */ {{ 86,2,249}, {130,2,249}, { 68,2,249}, { 82,2,249}, { 99,2,249}, { 94,2,249}, {104,2,249}, {  3,3,249},
+               { 66,2, 10}, {  1,3, 10}, { 66,2, 13}, {  1,3, 13}, { 66,2, 22}, {  1,3, 22}, {  0,4,  0}, {  0,4,  0}},
+    /*  49 */ {{ 85,2, 10}, { 67,2, 10}, { 93,2, 10}, {  2,3, 10}, { 85,2, 13}, { 67,2, 13}, { 93,2, 13}, {  2,3, 13},
+               { 85,2, 22}, { 67,2, 22}, { 93,2, 22}, {  2,3, 22}, {  0,4,  0}, {  0,4,  0}, {  0,4,  0}, {  0,4,  0}},
+    /*  50 */ {{ 86,2, 10}, {130,2, 10}, { 68,2, 10}, { 82,2, 10}, { 99,2, 10}, { 94,2, 10}, {104,2, 10}, {  3,3, 10},
+               { 86,2, 13}, {130,2, 13}, { 68,2, 13}, { 82,2, 13}, { 99,2, 13}, { 94,2, 13}, {104,2, 13}, {  3,3, 13}},
+    /*  51 */ {{ 86,2, 12}, {130,2, 12}, { 68,2, 12}, { 82,2, 12}, { 99,2, 12}, { 94,2, 12}, {104,2, 12}, {  3,3, 12},
+               { 86,2, 14}, {130,2, 14}, { 68,2, 14}, { 82,2, 14}, { 99,2, 14}, { 94,2, 14}, {104,2, 14}, {  3,3, 14}},
+    /*  52 */ {{ 85,2, 15}, { 67,2, 15}, { 93,2, 15}, {  2,3, 15}, { 85,2, 16}, { 67,2, 16}, { 93,2, 16}, {  2,3, 16},
+               { 85,2, 17}, { 67,2, 17}, { 93,2, 17}, {  2,3, 17}, { 85,2, 18}, { 67,2, 18}, { 93,2, 18}, {  2,3, 18}},
+    /*  53 */ {{ 86,2, 15}, {130,2, 15}, { 68,2, 15}, { 82,2, 15}, { 99,2, 15}, { 94,2, 15}, {104,2, 15}, {  3,3, 15},
+               { 86,2, 16}, {130,2, 16}, { 68,2, 16}, { 82,2, 16}, { 99,2, 16}, { 94,2, 16}, {104,2, 16}, {  3,3, 16}},
+    /*  54 */ {{ 86,2, 17}, {130,2, 17}, { 68,2, 17}, { 82,2, 17}, { 99,2, 17}, { 94,2, 17}, {104,2, 17}, {  3,3, 17},
+               { 86,2, 18}, {130,2, 18}, { 68,2, 18}, { 82,2, 18}, { 99,2, 18}, { 94,2, 18}, {104,2, 18}, {  3,3, 18}},
+    /*  55 */ {{ 66,2, 19}, {  1,3, 19}, { 66,2, 20}, {  1,3, 20}, { 66,2, 21}, {  1,3, 21}, { 66,2, 23}, {  1,3, 23},
+               { 66,2, 24}, {  1,3, 24}, { 66,2, 25}, {  1,3, 25}, { 66,2, 26}, {  1,3, 26}, { 66,2, 27}, {  1,3, 27}},
+    /*  56 */ {{ 85,2, 19}, { 67,2, 19}, { 93,2, 19}, {  2,3, 19}, { 85,2, 20}, { 67,2, 20}, { 93,2, 20}, {  2,3, 20},
+               { 85,2, 21}, { 67,2, 21}, { 93,2, 21}, {  2,3, 21}, { 85,2, 23}, { 67,2, 23}, { 93,2, 23}, {  2,3, 23}},
+    /*  57 */ {{ 86,2, 19}, {130,2, 19}, { 68,2, 19}, { 82,2, 19}, { 99,2, 19}, { 94,2, 19}, {104,2, 19}, {  3,3, 19},
+               { 86,2, 20}, {130,2, 20}, { 68,2, 20}, { 82,2, 20}, { 99,2, 20}, { 94,2, 20}, {104,2, 20}, {  3,3, 20}},
+    /*  58 */ {{ 86,2, 21}, {130,2, 21}, { 68,2, 21}, { 82,2, 21}, { 99,2, 21}, { 94,2, 21}, {104,2, 21}, {  3,3, 21},
+               { 86,2, 23}, {130,2, 23}, { 68,2, 23}, { 82,2, 23}, { 99,2, 23}, { 94,2, 23}, {104,2, 23}, {  3,3, 23}},
+    /*  59 */ {{ 86,2, 22}, {130,2, 22}, { 68,2, 22}, { 82,2, 22}, { 99,2, 22}, { 94,2, 22}, {104,2, 22}, {  3,3, 22},
+               {  0,4,  0}, {  0,4,  0}, {  0,4,  0}, {  0,4,  0}, {  0,4,  0}, {  0,4,  0}, {  0,4,  0}, {  0,4,  0}},
+    /*  60 */ {{ 85,2, 24}, { 67,2, 24}, { 93,2, 24}, {  2,3, 24}, { 85,2, 25}, { 67,2, 25}, { 93,2, 25}, {  2,3, 25},
+               { 85,2, 26}, { 67,2, 26}, { 93,2, 26}, {  2,3, 26}, { 85,2, 27}, { 67,2, 27}, { 93,2, 27}, {  2,3, 27}},
+    /*  61 */ {{ 86,2, 24}, {130,2, 24}, { 68,2, 24}, { 82,2, 24}, { 99,2, 24}, { 94,2, 24}, {104,2, 24}, {  3,3, 24},
+               { 86,2, 25}, {130,2, 25}, { 68,2, 25}, { 82,2, 25}, { 99,2, 25}, { 94,2, 25}, {104,2, 25}, {  3,3, 25}},
+    /*  62 */ {{ 86,2, 26}, {130,2, 26}, { 68,2, 26}, { 82,2, 26}, { 99,2, 26}, { 94,2, 26}, {104,2, 26}, {  3,3, 26},
+               { 86,2, 27}, {130,2, 27}, { 68,2, 27}, { 82,2, 27}, { 99,2, 27}, { 94,2, 27}, {104,2, 27}, {  3,3, 27}},
+    /*  63 */ {{ 85,2, 28}, { 67,2, 28}, { 93,2, 28}, {  2,3, 28}, { 85,2, 29}, { 67,2, 29}, { 93,2, 29}, {  2,3, 29},
+               { 85,2, 30}, { 67,2, 30}, { 93,2, 30}, {  2,3, 30}, { 85,2, 31}, { 67,2, 31}, { 93,2, 31}, {  2,3, 31}},
+    /*  64 */ {{ 86,2, 28}, {130,2, 28}, { 68,2, 28}, { 82,2, 28}, { 99,2, 28}, { 94,2, 28}, {104,2, 28}, {  3,3, 28},
+               { 86,2, 29}, {130,2, 29}, { 68,2, 29}, { 82,2, 29}, { 99,2, 29}, { 94,2, 29}, {104,2, 29}, {  3,3, 29}},
+    /*  65 */ {{ 86,2, 30}, {130,2, 30}, { 68,2, 30}, { 82,2, 30}, { 99,2, 30}, { 94,2, 30}, {104,2, 30}, {  3,3, 30},
+               { 86,2, 31}, {130,2, 31}, { 68,2, 31}, { 82,2, 31}, { 99,2, 31}, { 94,2, 31}, {104,2, 31}, {  3,3, 31}},
+    /*  66 */ {{  0,3, 48}, {  0,3, 49}, {  0,3, 50}, {  0,3, 97}, {  0,3, 99}, {  0,3,101}, {  0,3,105}, {  0,3,111},
+               {  0,3,115}, {  0,3,116}, { 70,0,  0}, { 81,0,  0}, { 84,0,  0}, { 89,0,  0}, { 91,0,  0}, { 92,0,  0}},
+    /*  67 */ {{ 66,2,115}, {  1,3,115}, { 66,2,116}, {  1,3,116}, {  0,3, 32}, {  0,3, 37}, {  0,3, 45}, {  0,3, 46},
+               {  0,3, 47}, {  0,3, 51}, {  0,3, 52}, {  0,3, 53}, {  0,3, 54}, {  0,3, 55}, {  0,3, 56}, {  0,3, 57}},
+    /*  68 */ {{ 85,2,115}, { 67,2,115}, { 93,2,115}, {  2,3,115}, { 85,2,116}, { 67,2,116}, { 93,2,116}, {  2,3,116},
+               { 66,2, 32}, {  1,3, 32}, { 66,2, 37}, {  1,3, 37}, { 66,2, 45}, {  1,3, 45}, { 66,2, 46}, {  1,3, 46}},
+    /*  69 */ {{ 85,2, 32}, { 67,2, 32}, { 93,2, 32}, {  2,3, 32}, { 85,2, 37}, { 67,2, 37}, { 93,2, 37}, {  2,3, 37},
+               { 85,2, 45}, { 67,2, 45}, { 93,2, 45}, {  2,3, 45}, { 85,2, 46}, { 67,2, 46}, { 93,2, 46}, {  2,3, 46}},
+    /*  70 */ {{ 86,2, 32}, {130,2, 32}, { 68,2, 32}, { 82,2, 32}, { 99,2, 32}, { 94,2, 32}, {104,2, 32}, {  3,3, 32},
+               { 86,2, 37}, {130,2, 37}, { 68,2, 37}, { 82,2, 37}, { 99,2, 37}, { 94,2, 37}, {104,2, 37}, {  3,3, 37}},
+    /*  71 */ {{ 85,2, 33}, { 67,2, 33}, { 93,2, 33}, {  2,3, 33}, { 85,2, 34}, { 67,2, 34}, { 93,2, 34}, {  2,3, 34},
+               { 85,2, 40}, { 67,2, 40}, { 93,2, 40}, {  2,3, 40}, { 85,2, 41}, { 67,2, 41}, { 93,2, 41}, {  2,3, 41}},
+    /*  72 */ {{ 86,2, 33}, {130,2, 33}, { 68,2, 33}, { 82,2, 33}, { 99,2, 33}, { 94,2, 33}, {104,2, 33}, {  3,3, 33},
+               { 86,2, 34}, {130,2, 34}, { 68,2, 34}, { 82,2, 34}, { 99,2, 34}, { 94,2, 34}, {104,2, 34}, {  3,3, 34}},
+    /*  73 */ {{ 86,2,124}, {130,2,124}, { 68,2,124}, { 82,2,124}, { 99,2,124}, { 94,2,124}, {104,2,124}, {  3,3,124},
+               { 85,2, 35}, { 67,2, 35}, { 93,2, 35}, {  2,3, 35}, { 85,2, 62}, { 67,2, 62}, { 93,2, 62}, {  2,3, 62}},
+    /*  74 */ {{ 86,2, 35}, {130,2, 35}, { 68,2, 35}, { 82,2, 35}, { 99,2, 35}, { 94,2, 35}, {104,2, 35}, {  3,3, 35},
+               { 86,2, 62}, {130,2, 62}, { 68,2, 62}, { 82,2, 62}, { 99,2, 62}, { 94,2, 62}, {104,2, 62}, {  3,3, 62}},
+    /*  75 */ {{ 85,2, 38}, { 67,2, 38}, { 93,2, 38}, {  2,3, 38}, { 85,2, 42}, { 67,2, 42}, { 93,2, 42}, {  2,3, 42},
+               { 85,2, 44}, { 67,2, 44}, { 93,2, 44}, {  2,3, 44}, { 85,2, 59}, { 67,2, 59}, { 93,2, 59}, {  2,3, 59}},
+    /*  76 */ {{ 86,2, 38}, {130,2, 38}, { 68,2, 38}, { 82,2, 38}, { 99,2, 38}, { 94,2, 38}, {104,2, 38}, {  3,3, 38},
+               { 86,2, 42}, {130,2, 42}, { 68,2, 42}, { 82,2, 42}, { 99,2, 42}, { 94,2, 42}, {104,2, 42}, {  3,3, 42}},
+    /*  77 */ {{ 86,2, 63}, {130,2, 63}, { 68,2, 63}, { 82,2, 63}, { 99,2, 63}, { 94,2, 63}, {104,2, 63}, {  3,3, 63},
+               { 85,2, 39}, { 67,2, 39}, { 93,2, 39}, {  2,3, 39}, { 85,2, 43}, { 67,2, 43}, { 93,2, 43}, {  2,3, 43}},
+    /*  78 */ {{ 86,2, 39}, {130,2, 39}, { 68,2, 39}, { 82,2, 39}, { 99,2, 39}, { 94,2, 39}, {104,2, 39}, {  3,3, 39},
+               { 86,2, 43}, {130,2, 43}, { 68,2, 43}, { 82,2, 43}, { 99,2, 43}, { 94,2, 43}, {104,2, 43}, {  3,3, 43}},
+    /*  79 */ {{ 86,2, 40}, {130,2, 40}, { 68,2, 40}, { 82,2, 40}, { 99,2, 40}, { 94,2, 40}, {104,2, 40}, {  3,3, 40},
+               { 86,2, 41}, {130,2, 41}, { 68,2, 41}, { 82,2, 41}, { 99,2, 41}, { 94,2, 41}, {104,2, 41}, {  3,3, 41}},
+    /*  80 */ {{ 86,2, 44}, {130,2, 44}, { 68,2, 44}, { 82,2, 44}, { 99,2, 44}, { 94,2, 44}, {104,2, 44}, {  3,3, 44},
+               { 86,2, 59}, {130,2, 59}, { 68,2, 59}, { 82,2, 59}, { 99,2, 59}, { 94,2, 59}, {104,2, 59}, {  3,3, 59}},
+    /*  81 */ {{ 86,2, 45}, {130,2, 45}, { 68,2, 45}, { 82,2, 45}, { 99,2, 45}, { 94,2, 45}, {104,2, 45}, {  3,3, 45},
+               { 86,2, 46}, {130,2, 46}, { 68,2, 46}, { 82,2, 46}, { 99,2, 46}, { 94,2, 46}, {104,2, 46}, {  3,3, 46}},
+    /*  82 */ {{ 66,2, 47}, {  1,3, 47}, { 66,2, 51}, {  1,3, 51}, { 66,2, 52}, {  1,3, 52}, { 66,2, 53}, {  1,3, 53},
+               { 66,2, 54}, {  1,3, 54}, { 66,2, 55}, {  1,3, 55}, { 66,2, 56}, {  1,3, 56}, { 66,2, 57}, {  1,3, 57}},
+    /*  83 */ {{ 85,2, 47}, { 67,2, 47}, { 93,2, 47}, {  2,3, 47}, { 85,2, 51}, { 67,2, 51}, { 93,2, 51}, {  2,3, 51},
+               { 85,2, 52}, { 67,2, 52}, { 93,2, 52}, {  2,3, 52}, { 85,2, 53}, { 67,2, 53}, { 93,2, 53}, {  2,3, 53}},
+    /*  84 */ {{ 86,2, 47}, {130,2, 47}, { 68,2, 47}, { 82,2, 47}, { 99,2, 47}, { 94,2, 47}, {104,2, 47}, {  3,3, 47},
+               { 86,2, 51}, {130,2, 51}, { 68,2, 51}, { 82,2, 51}, { 99,2, 51}, { 94,2, 51}, {104,2, 51}, {  3,3, 51}},
+    /*  85 */ {{ 66,2, 48}, {  1,3, 48}, { 66,2, 49}, {  1,3, 49}, { 66,2, 50}, {  1,3, 50}, { 66,2, 97}, {  1,3, 97},
+               { 66,2, 99}, {  1,3, 99}, { 66,2,101}, {  1,3,101}, { 66,2,105}, {  1,3,105}, { 66,2,111}, {  1,3,111}},
+    /*  86 */ {{ 85,2, 48}, { 67,2, 48}, { 93,2, 48}, {  2,3, 48}, { 85,2, 49}, { 67,2, 49}, { 93,2, 49}, {  2,3, 49},
+               { 85,2, 50}, { 67,2, 50}, { 93,2, 50}, {  2,3, 50}, { 85,2, 97}, { 67,2, 97}, { 93,2, 97}, {  2,3, 97}},
+    /*  87 */ {{ 86,2, 48}, {130,2, 48}, { 68,2, 48}, { 82,2, 48}, { 99,2, 48}, { 94,2, 48}, {104,2, 48}, {  3,3, 48},
+               { 86,2, 49}, {130,2, 49}, { 68,2, 49}, { 82,2, 49}, { 99,2, 49}, { 94,2, 49}, {104,2, 49}, {  3,3, 49}},
+    /*  88 */ {{ 86,2, 50}, {130,2, 50}, { 68,2, 50}, { 82,2, 50}, { 99,2, 50}, { 94,2, 50}, {104,2, 50}, {  3,3, 50},
+               { 86,2, 97}, {130,2, 97}, { 68,2, 97}, { 82,2, 97}, { 99,2, 97}, { 94,2, 97}, {104,2, 97}, {  3,3, 97}},
+    /*  89 */ {{ 86,2, 52}, {130,2, 52}, { 68,2, 52}, { 82,2, 52}, { 99,2, 52}, { 94,2, 52}, {104,2, 52}, {  3,3, 52},
+               { 86,2, 53}, {130,2, 53}, { 68,2, 53}, { 82,2, 53}, { 99,2, 53}, { 94,2, 53}, {104,2, 53}, {  3,3, 53}},
+    /*  90 */ {{ 85,2, 54}, { 67,2, 54}, { 93,2, 54}, {  2,3, 54}, { 85,2, 55}, { 67,2, 55}, { 93,2, 55}, {  2,3, 55},
+               { 85,2, 56}, { 67,2, 56}, { 93,2, 56}, {  2,3, 56}, { 85,2, 57}, { 67,2, 57}, { 93,2, 57}, {  2,3, 57}},
+    /*  91 */ {{ 86,2, 54}, {130,2, 54}, { 68,2, 54}, { 82,2, 54}, { 99,2, 54}, { 94,2, 54}, {104,2, 54}, {  3,3, 54},
+               { 86,2, 55}, {130,2, 55}, { 68,2, 55}, { 82,2, 55}, { 99,2, 55}, { 94,2, 55}, {104,2, 55}, {  3,3, 55}},
+    /*  92 */ {{ 86,2, 56}, {130,2, 56}, { 68,2, 56}, { 82,2, 56}, { 99,2, 56}, { 94,2, 56}, {104,2, 56}, {  3,3, 56},
+               { 86,2, 57}, {130,2, 57}, { 68,2, 57}, { 82,2, 57}, { 99,2, 57}, { 94,2, 57}, {104,2, 57}, {  3,3, 57}},
+    /*  93 */ {{  0,3, 61}, {  0,3, 65}, {  0,3, 95}, {  0,3, 98}, {  0,3,100}, {  0,3,102}, {  0,3,103}, {  0,3,104},
+               {  0,3,108}, {  0,3,109}, {  0,3,110}, {  0,3,112}, {  0,3,114}, {  0,3,117}, { 97,0,  0}, {103,0,  0}},
+    /*  94 */ {{ 66,2,108}, {  1,3,108}, { 66,2,109}, {  1,3,109}, { 66,2,110}, {  1,3,110}, { 66,2,112}, {  1,3,112},
+               { 66,2,114}, {  1,3,114}, { 66,2,117}, {  1,3,117}, {  0,3, 58}, {  0,3, 66}, {  0,3, 67}, {  0,3, 68}},
+    /*  95 */ {{ 85,2,114}, { 67,2,114}, { 93,2,114}, {  2,3,114}, { 85,2,117}, { 67,2,117}, { 93,2,117}, {  2,3,117},
+               { 66,2, 58}, {  1,3, 58}, { 66,2, 66}, {  1,3, 66}, { 66,2, 67}, {  1,3, 67}, { 66,2, 68}, {  1,3, 68}},
+    /*  96 */ {{ 85,2, 58}, { 67,2, 58}, { 93,2, 58}, {  2,3, 58}, { 85,2, 66}, { 67,2, 66}, { 93,2, 66}, {  2,3, 66},
+               { 85,2, 67}, { 67,2, 67}, { 93,2, 67}, {  2,3, 67}, { 85,2, 68}, { 67,2, 68}, { 93,2, 68}, {  2,3, 68}},
+    /*  97 */ {{ 86,2, 58}, {130,2, 58}, { 68,2, 58}, { 82,2, 58}, { 99,2, 58}, { 94,2, 58}, {104,2, 58}, {  3,3, 58},
+               { 86,2, 66}, {130,2, 66}, { 68,2, 66}, { 82,2, 66}, { 99,2, 66}, { 94,2, 66}, {104,2, 66}, {  3,3, 66}},
+    /*  98 */ {{ 86,2, 60}, {130,2, 60}, { 68,2, 60}, { 82,2, 60}, { 99,2, 60}, { 94,2, 60}, {104,2, 60}, {  3,3, 60},
+               { 86,2, 96}, {130,2, 96}, { 68,2, 96}, { 82,2, 96}, { 99,2, 96}, { 94,2, 96}, {104,2, 96}, {  3,3, 96}},
+    /*  99 */ {{ 66,2, 61}, {  1,3, 61}, { 66,2, 65}, {  1,3, 65}, { 66,2, 95}, {  1,3, 95}, { 66,2, 98}, {  1,3, 98},
+               { 66,2,100}, {  1,3,100}, { 66,2,102}, {  1,3,102}, { 66,2,103}, {  1,3,103}, { 66,2,104}, {  1,3,104}},
+    /* 100 */ {{ 85,2, 61}, { 67,2, 61}, { 93,2, 61}, {  2,3, 61}, { 85,2, 65}, { 67,2, 65}, { 93,2, 65}, {  2,3, 65},
+               { 85,2, 95}, { 67,2, 95}, { 93,2, 95}, {  2,3, 95}, { 85,2, 98}, { 67,2, 98}, { 93,2, 98}, {  2,3, 98}},
+    /* 101 */ {{ 86,2, 61}, {130,2, 61}, { 68,2, 61}, { 82,2, 61}, { 99,2, 61}, { 94,2, 61}, {104,2, 61}, {  3,3, 61},
+               { 86,2, 65}, {130,2, 65}, { 68,2, 65}, { 82,2, 65}, { 99,2, 65}, { 94,2, 65}, {104,2, 65}, {  3,3, 65}},
+    /* 102 */ {{ 86,2, 64}, {130,2, 64}, { 68,2, 64}, { 82,2, 64}, { 99,2, 64}, { 94,2, 64}, {104,2, 64}, {  3,3, 64},
+               { 86,2, 91}, {130,2, 91}, { 68,2, 91}, { 82,2, 91}, { 99,2, 91}, { 94,2, 91}, {104,2, 91}, {  3,3, 91}},
+    /* 103 */ {{ 86,2, 67}, {130,2, 67}, { 68,2, 67}, { 82,2, 67}, { 99,2, 67}, { 94,2, 67}, {104,2, 67}, {  3,3, 67},
+               { 86,2, 68}, {130,2, 68}, { 68,2, 68}, { 82,2, 68}, { 99,2, 68}, { 94,2, 68}, {104,2, 68}, {  3,3, 68}},
+    /* 104 */ {{  0,3, 69}, {  0,3, 70}, {  0,3, 71}, {  0,3, 72}, {  0,3, 73}, {  0,3, 74}, {  0,3, 75}, {  0,3, 76},
+               {  0,3, 77}, {  0,3, 78}, {  0,3, 79}, {  0,3, 80}, {  0,3, 81}, {  0,3, 82}, {  0,3, 83}, {  0,3, 84}},
+    /* 105 */ {{ 66,2, 69}, {  1,3, 69}, { 66,2, 70}, {  1,3, 70}, { 66,2, 71}, {  1,3, 71}, { 66,2, 72}, {  1,3, 72},
+               { 66,2, 73}, {  1,3, 73}, { 66,2, 74}, {  1,3, 74}, { 66,2, 75}, {  1,3, 75}, { 66,2, 76}, {  1,3, 76}},
+    /* 106 */ {{ 85,2, 69}, { 67,2, 69}, { 93,2, 69}, {  2,3, 69}, { 85,2, 70}, { 67,2, 70}, { 93,2, 70}, {  2,3, 70},
+               { 85,2, 71}, { 67,2, 71}, { 93,2, 71}, {  2,3, 71}, { 85,2, 72}, { 67,2, 72}, { 93,2, 72}, {  2,3, 72}},
+    /* 107 */ {{ 86,2, 69}, {130,2, 69}, { 68,2, 69}, { 82,2, 69}, { 99,2, 69}, { 94,2, 69}, {104,2, 69}, {  3,3, 69},
+               { 86,2, 70}, {130,2, 70}, { 68,2, 70}, { 82,2, 70}, { 99,2, 70}, { 94,2, 70}, {104,2, 70}, {  3,3, 70}},
+    /* 108 */ {{ 86,2, 71}, {130,2, 71}, { 68,2, 71}, { 82,2, 71}, { 99,2, 71}, { 94,2, 71}, {104,2, 71}, {  3,3, 71},
+               { 86,2, 72}, {130,2, 72}, { 68,2, 72}, { 82,2, 72}, { 99,2, 72}, { 94,2, 72}, {104,2, 72}, {  3,3, 72}},
+    /* 109 */ {{ 85,2, 73}, { 67,2, 73}, { 93,2, 73}, {  2,3, 73}, { 85,2, 74}, { 67,2, 74}, { 93,2, 74}, {  2,3, 74},
+               { 85,2, 75}, { 67,2, 75}, { 93,2, 75}, {  2,3, 75}, { 85,2, 76}, { 67,2, 76}, { 93,2, 76}, {  2,3, 76}},
+    /* 110 */ {{ 86,2, 73}, {130,2, 73}, { 68,2, 73}, { 82,2, 73}, { 99,2, 73}, { 94,2, 73}, {104,2, 73}, {  3,3, 73},
+               { 86,2, 74}, {130,2, 74}, { 68,2, 74}, { 82,2, 74}, { 99,2, 74}, { 94,2, 74}, {104,2, 74}, {  3,3, 74}},
+    /* 111 */ {{ 86,2, 75}, {130,2, 75}, { 68,2, 75}, { 82,2, 75}, { 99,2, 75}, { 94,2, 75}, {104,2, 75}, {  3,3, 75},
+               { 86,2, 76}, {130,2, 76}, { 68,2, 76}, { 82,2, 76}, { 99,2, 76}, { 94,2, 76}, {104,2, 76}, {  3,3, 76}},
+    /* 112 */ {{ 66,2, 77}, {  1,3, 77}, { 66,2, 78}, {  1,3, 78}, { 66,2, 79}, {  1,3, 79}, { 66,2, 80}, {  1,3, 80},
+               { 66,2, 81}, {  1,3, 81}, { 66,2, 82}, {  1,3, 82}, { 66,2, 83}, {  1,3, 83}, { 66,2, 84}, {  1,3, 84}},
+    /* 113 */ {{ 85,2, 77}, { 67,2, 77}, { 93,2, 77}, {  2,3, 77}, { 85,2, 78}, { 67,2, 78}, { 93,2, 78}, {  2,3, 78},
+               { 85,2, 79}, { 67,2, 79}, { 93,2, 79}, {  2,3, 79}, { 85,2, 80}, { 67,2, 80}, { 93,2, 80}, {  2,3, 80}},
+    /* 114 */ {{ 86,2, 77}, {130,2, 77}, { 68,2, 77}, { 82,2, 77}, { 99,2, 77}, { 94,2, 77}, {104,2, 77}, {  3,3, 77},
+               { 86,2, 78}, {130,2, 78}, { 68,2, 78}, { 82,2, 78}, { 99,2, 78}, { 94,2, 78}, {104,2, 78}, {  3,3, 78}},
+    /* 115 */ {{ 86,2, 79}, {130,2, 79}, { 68,2, 79}, { 82,2, 79}, { 99,2, 79}, { 94,2, 79}, {104,2, 79}, {  3,3, 79},
+               { 86,2, 80}, {130,2, 80}, { 68,2, 80}, { 82,2, 80}, { 99,2, 80}, { 94,2, 80}, {104,2, 80}, {  3,3, 80}},
+    /* 116 */ {{ 85,2, 81}, { 67,2, 81}, { 93,2, 81}, {  2,3, 81}, { 85,2, 82}, { 67,2, 82}, { 93,2, 82}, {  2,3, 82},
+               { 85,2, 83}, { 67,2, 83}, { 93,2, 83}, {  2,3, 83}, { 85,2, 84}, { 67,2, 84}, { 93,2, 84}, {  2,3, 84}},
+    /* 117 */ {{ 86,2, 81}, {130,2, 81}, { 68,2, 81}, { 82,2, 81}, { 99,2, 81}, { 94,2, 81}, {104,2, 81}, {  3,3, 81},
+               { 86,2, 82}, {130,2, 82}, { 68,2, 82}, { 82,2, 82}, { 99,2, 82}, { 94,2, 82}, {104,2, 82}, {  3,3, 82}},
+    /* 118 */ {{ 86,2, 83}, {130,2, 83}, { 68,2, 83}, { 82,2, 83}, { 99,2, 83}, { 94,2, 83}, {104,2, 83}, {  3,3, 83},
+               { 86,2, 84}, {130,2, 84}, { 68,2, 84}, { 82,2, 84}, { 99,2, 84}, { 94,2, 84}, {104,2, 84}, {  3,3, 84}},
+    /* 119 */ {{ 66,2, 85}, {  1,3, 85}, { 66,2, 86}, {  1,3, 86}, { 66,2, 87}, {  1,3, 87}, { 66,2, 89}, {  1,3, 89},
+               { 66,2,106}, {  1,3,106}, { 66,2,107}, {  1,3,107}, { 66,2,113}, {  1,3,113}, { 66,2,118}, {  1,3,118}},
+    /* 120 */ {{ 85,2, 85}, { 67,2, 85}, { 93,2, 85}, {  2,3, 85}, { 85,2, 86}, { 67,2, 86}, { 93,2, 86}, {  2,3, 86},
+               { 85,2, 87}, { 67,2, 87}, { 93,2, 87}, {  2,3, 87}, { 85,2, 89}, { 67,2, 89}, { 93,2, 89}, {  2,3, 89}},
+    /* 121 */ {{ 86,2, 85}, {130,2, 85}, { 68,2, 85}, { 82,2, 85}, { 99,2, 85}, { 94,2, 85}, {104,2, 85}, {  3,3, 85},
+               { 86,2, 86}, {130,2, 86}, { 68,2, 86}, { 82,2, 86}, { 99,2, 86}, { 94,2, 86}, {104,2, 86}, {  3,3, 86}},
+    /* 122 */ {{ 86,2, 87}, {130,2, 87}, { 68,2, 87}, { 82,2, 87}, { 99,2, 87}, { 94,2, 87}, {104,2, 87}, {  3,3, 87},
+               { 86,2, 89}, {130,2, 89}, { 68,2, 89}, { 82,2, 89}, { 99,2, 89}, { 94,2, 89}, {104,2, 89}, {  3,3, 89}},
+    /* 123 */ {{ 86,2, 88}, {130,2, 88}, { 68,2, 88}, { 82,2, 88}, { 99,2, 88}, { 94,2, 88}, {104,2, 88}, {  3,3, 88},
+               { 86,2, 90}, {130,2, 90}, { 68,2, 90}, { 82,2, 90}, { 99,2, 90}, { 94,2, 90}, {104,2, 90}, {  3,3, 90}},
+    /* 124 */ {{ 66,2, 92}, {  1,3, 92}, { 66,2,195}, {  1,3,195}, { 66,2,208}, {  1,3,208}, {  0,3,128}, {  0,3,130},
+               {  0,3,131}, {  0,3,162}, {  0,3,184}, {  0,3,194}, {  0,3,224}, {  0,3,226}, {177,0,  0}, {188,0,  0}},
+    /* 125 */ {{ 85,2, 92}, { 67,2, 92}, { 93,2, 92}, {  2,3, 92}, { 85,2,195}, { 67,2,195}, { 93,2,195}, {  2,3,195},
+               { 85,2,208}, { 67,2,208}, { 93,2,208}, {  2,3,208}, { 66,2,128}, {  1,3,128}, { 66,2,130}, {  1,3,130}},
+    /* 126 */ {{ 86,2, 92}, {130,2, 92}, { 68,2, 92}, { 82,2, 92}, { 99,2, 92}, { 94,2, 92}, {104,2, 92}, {  3,3, 92},
+               { 86,2,195}, {130,2,195}, { 68,2,195}, { 82,2,195}, { 99,2,195}, { 94,2,195}, {104,2,195}, {  3,3,195}},
+    /* 127 */ {{ 86,2, 93}, {130,2, 93}, { 68,2, 93}, { 82,2, 93}, { 99,2, 93}, { 94,2, 93}, {104,2, 93}, {  3,3, 93},
+               { 86,2,126}, {130,2,126}, { 68,2,126}, { 82,2,126}, { 99,2,126}, { 94,2,126}, {104,2,126}, {  3,3,126}},
+    /* 128 */ {{ 86,2, 94}, {130,2, 94}, { 68,2, 94}, { 82,2, 94}, { 99,2, 94}, { 94,2, 94}, {104,2, 94}, {  3,3, 94},
+               { 86,2,125}, {130,2,125}, { 68,2,125}, { 82,2,125}, { 99,2,125}, { 94,2,125}, {104,2,125}, {  3,3,125}},
+    /* 129 */ {{ 86,2, 95}, {130,2, 95}, { 68,2, 95}, { 82,2, 95}, { 99,2, 95}, { 94,2, 95}, {104,2, 95}, {  3,3, 95},
+               { 86,2, 98}, {130,2, 98}, { 68,2, 98}, { 82,2, 98}, { 99,2, 98}, { 94,2, 98}, {104,2, 98}, {  3,3, 98}},
+    /* 130 */ {{ 85,2, 99}, { 67,2, 99}, { 93,2, 99}, {  2,3, 99}, { 85,2,101}, { 67,2,101}, { 93,2,101}, {  2,3,101},
+               { 85,2,105}, { 67,2,105}, { 93,2,105}, {  2,3,105}, { 85,2,111}, { 67,2,111}, { 93,2,111}, {  2,3,111}},
+    /* 131 */ {{ 86,2, 99}, {130,2, 99}, { 68,2, 99}, { 82,2, 99}, { 99,2, 99}, { 94,2, 99}, {104,2, 99}, {  3,3, 99},
+               { 86,2,101}, {130,2,101}, { 68,2,101}, { 82,2,101}, { 99,2,101}, { 94,2,101}, {104,2,101}, {  3,3,101}},
+    /* 132 */ {{ 85,2,100}, { 67,2,100}, { 93,2,100}, {  2,3,100}, { 85,2,102}, { 67,2,102}, { 93,2,102}, {  2,3,102},
+               { 85,2,103}, { 67,2,103}, { 93,2,103}, {  2,3,103}, { 85,2,104}, { 67,2,104}, { 93,2,104}, {  2,3,104}},
+    /* 133 */ {{ 86,2,100}, {130,2,100}, { 68,2,100}, { 82,2,100}, { 99,2,100}, { 94,2,100}, {104,2,100}, {  3,3,100},
+               { 86,2,102}, {130,2,102}, { 68,2,102}, { 82,2,102}, { 99,2,102}, { 94,2,102}, {104,2,102}, {  3,3,102}},
+    /* 134 */ {{ 86,2,103}, {130,2,103}, { 68,2,103}, { 82,2,103}, { 99,2,103}, { 94,2,103}, {104,2,103}, {  3,3,103},
+               { 86,2,104}, {130,2,104}, { 68,2,104}, { 82,2,104}, { 99,2,104}, { 94,2,104}, {104,2,104}, {  3,3,104}},
+    /* 135 */ {{ 86,2,105}, {130,2,105}, { 68,2,105}, { 82,2,105}, { 99,2,105}, { 94,2,105}, {104,2,105}, {  3,3,105},
+               { 86,2,111}, {130,2,111}, { 68,2,111}, { 82,2,111}, { 99,2,111}, { 94,2,111}, {104,2,111}, {  3,3,111}},
+    /* 136 */ {{ 85,2,106}, { 67,2,106}, { 93,2,106}, {  2,3,106}, { 85,2,107}, { 67,2,107}, { 93,2,107}, {  2,3,107},
+               { 85,2,113}, { 67,2,113}, { 93,2,113}, {  2,3,113}, { 85,2,118}, { 67,2,118}, { 93,2,118}, {  2,3,118}},
+    /* 137 */ {{ 86,2,106}, {130,2,106}, { 68,2,106}, { 82,2,106}, { 99,2,106}, { 94,2,106}, {104,2,106}, {  3,3,106},
+               { 86,2,107}, {130,2,107}, { 68,2,107}, { 82,2,107}, { 99,2,107}, { 94,2,107}, {104,2,107}, {  3,3,107}},
+    /* 138 */ {{ 85,2,108}, { 67,2,108}, { 93,2,108}, {  2,3,108}, { 85,2,109}, { 67,2,109}, { 93,2,109}, {  2,3,109},
+               { 85,2,110}, { 67,2,110}, { 93,2,110}, {  2,3,110}, { 85,2,112}, { 67,2,112}, { 93,2,112}, {  2,3,112}},
+    /* 139 */ {{ 86,2,108}, {130,2,108}, { 68,2,108}, { 82,2,108}, { 99,2,108}, { 94,2,108}, {104,2,108}, {  3,3,108},
+               { 86,2,109}, {130,2,109}, { 68,2,109}, { 82,2,109}, { 99,2,109}, { 94,2,109}, {104,2,109}, {  3,3,109}},
+    /* 140 */ {{ 86,2,110}, {130,2,110}, { 68,2,110}, { 82,2,110}, { 99,2,110}, { 94,2,110}, {104,2,110}, {  3,3,110},
+               { 86,2,112}, {130,2,112}, { 68,2,112}, { 82,2,112}, { 99,2,112}, { 94,2,112}, {104,2,112}, {  3,3,112}},
+    /* 141 */ {{ 86,2,113}, {130,2,113}, { 68,2,113}, { 82,2,113}, { 99,2,113}, { 94,2,113}, {104,2,113}, {  3,3,113},
+               { 86,2,118}, {130,2,118}, { 68,2,118}, { 82,2,118}, { 99,2,118}, { 94,2,118}, {104,2,118}, {  3,3,118}},
+    /* 142 */ {{ 86,2,114}, {130,2,114}, { 68,2,114}, { 82,2,114}, { 99,2,114}, { 94,2,114}, {104,2,114}, {  3,3,114},
+               { 86,2,117}, {130,2,117}, { 68,2,117}, { 82,2,117}, { 99,2,117}, { 94,2,117}, {104,2,117}, {  3,3,117}},
+    /* 143 */ {{ 86,2,115}, {130,2,115}, { 68,2,115}, { 82,2,115}, { 99,2,115}, { 94,2,115}, {104,2,115}, {  3,3,115},
+               { 86,2,116}, {130,2,116}, { 68,2,116}, { 82,2,116}, { 99,2,116}, { 94,2,116}, {104,2,116}, {  3,3,116}},
+    /* 144 */ {{ 85,2,119}, { 67,2,119}, { 93,2,119}, {  2,3,119}, { 85,2,120}, { 67,2,120}, { 93,2,120}, {  2,3,120},
+               { 85,2,121}, { 67,2,121}, { 93,2,121}, {  2,3,121}, { 85,2,122}, { 67,2,122}, { 93,2,122}, {  2,3,122}},
+    /* 145 */ {{ 86,2,119}, {130,2,119}, { 68,2,119}, { 82,2,119}, { 99,2,119}, { 94,2,119}, {104,2,119}, {  3,3,119},
+               { 86,2,120}, {130,2,120}, { 68,2,120}, { 82,2,120}, { 99,2,120}, { 94,2,120}, {104,2,120}, {  3,3,120}},
+    /* 146 */ {{ 86,2,121}, {130,2,121}, { 68,2,121}, { 82,2,121}, { 99,2,121}, { 94,2,121}, {104,2,121}, {  3,3,121},
+               { 86,2,122}, {130,2,122}, { 68,2,122}, { 82,2,122}, { 99,2,122}, { 94,2,122}, {104,2,122}, {  3,3,122}},
+    /* 147 */ {{ 86,2,127}, {130,2,127}, { 68,2,127}, { 82,2,127}, { 99,2,127}, { 94,2,127}, {104,2,127}, {  3,3,127},
+               { 86,2,220}, {130,2,220}, { 68,2,220}, { 82,2,220}, { 99,2,220}, { 94,2,220}, {104,2,220}, {  3,3,220}},
+    /* 148 */ {{ 86,2,208}, {130,2,208}, { 68,2,208}, { 82,2,208}, { 99,2,208}, { 94,2,208}, {104,2,208}, {  3,3,208},
+               { 85,2,128}, { 67,2,128}, { 93,2,128}, {  2,3,128}, { 85,2,130}, { 67,2,130}, { 93,2,130}, {  2,3,130}},
+    /* 149 */ {{ 86,2,128}, {130,2,128}, { 68,2,128}, { 82,2,128}, { 99,2,128}, { 94,2,128}, {104,2,128}, {  3,3,128},
+               { 86,2,130}, {130,2,130}, { 68,2,130}, { 82,2,130}, { 99,2,130}, { 94,2,130}, {104,2,130}, {  3,3,130}},
+    /* 150 */ {{  0,3,176}, {  0,3,177}, {  0,3,179}, {  0,3,209}, {  0,3,216}, {  0,3,217}, {  0,3,227}, {  0,3,229},
+               {  0,3,230}, {154,0,  0}, {159,0,  0}, {160,0,  0}, {180,0,  0}, {182,0,  0}, {184,0,  0}, {190,0,  0}},
+    /* 151 */ {{ 66,2,230}, {  1,3,230}, {  0,3,129}, {  0,3,132}, {  0,3,133}, {  0,3,134}, {  0,3,136}, {  0,3,146},
+               {  0,3,154}, {  0,3,156}, {  0,3,160}, {  0,3,163}, {  0,3,164}, {  0,3,169}, {  0,3,170}, {  0,3,173}},
+    /* 152 */ {{ 85,2,230}, { 67,2,230}, { 93,2,230}, {  2,3,230}, { 66,2,129}, {  1,3,129}, { 66,2,132}, {  1,3,132},
+               { 66,2,133}, {  1,3,133}, { 66,2,134}, {  1,3,134}, { 66,2,136}, {  1,3,136}, { 66,2,146}, {  1,3,146}},
+    /* 153 */ {{ 86,2,230}, {130,2,230}, { 68,2,230}, { 82,2,230}, { 99,2,230}, { 94,2,230}, {104,2,230}, {  3,3,230},
+               { 85,2,129}, { 67,2,129}, { 93,2,129}, {  2,3,129}, { 85,2,132}, { 67,2,132}, { 93,2,132}, {  2,3,132}},
+    /* 154 */ {{ 86,2,129}, {130,2,129}, { 68,2,129}, { 82,2,129}, { 99,2,129}, { 94,2,129}, {104,2,129}, {  3,3,129},
+               { 86,2,132}, {130,2,132}, { 68,2,132}, { 82,2,132}, { 99,2,132}, { 94,2,132}, {104,2,132}, {  3,3,132}},
+    /* 155 */ {{ 66,2,131}, {  1,3,131}, { 66,2,162}, {  1,3,162}, { 66,2,184}, {  1,3,184}, { 66,2,194}, {  1,3,194},
+               { 66,2,224}, {  1,3,224}, { 66,2,226}, {  1,3,226}, {  0,3,153}, {  0,3,161}, {  0,3,167}, {  0,3,172}},
+    /* 156 */ {{ 85,2,131}, { 67,2,131}, { 93,2,131}, {  2,3,131}, { 85,2,162}, { 67,2,162}, { 93,2,162}, {  2,3,162},
+               { 85,2,184}, { 67,2,184}, { 93,2,184}, {  2,3,184}, { 85,2,194}, { 67,2,194}, { 93,2,194}, {  2,3,194}},
+    /* 157 */ {{ 86,2,131}, {130,2,131}, { 68,2,131}, { 82,2,131}, { 99,2,131}, { 94,2,131}, {104,2,131}, {  3,3,131},
+               { 86,2,162}, {130,2,162}, { 68,2,162}, { 82,2,162}, { 99,2,162}, { 94,2,162}, {104,2,162}, {  3,3,162}},
+    /* 158 */ {{ 85,2,133}, { 67,2,133}, { 93,2,133}, {  2,3,133}, { 85,2,134}, { 67,2,134}, { 93,2,134}, {  2,3,134},
+               { 85,2,136}, { 67,2,136}, { 93,2,136}, {  2,3,136}, { 85,2,146}, { 67,2,146}, { 93,2,146}, {  2,3,146}},
+    /* 159 */ {{ 86,2,133}, {130,2,133}, { 68,2,133}, { 82,2,133}, { 99,2,133}, { 94,2,133}, {104,2,133}, {  3,3,133},
+               { 86,2,134}, {130,2,134}, { 68,2,134}, { 82,2,134}, { 99,2,134}, { 94,2,134}, {104,2,134}, {  3,3,134}},
+    /* 160 */ {{ 86,2,136}, {130,2,136}, { 68,2,136}, { 82,2,136}, { 99,2,136}, { 94,2,136}, {104,2,136}, {  3,3,136},
+               { 86,2,146}, {130,2,146}, { 68,2,146}, { 82,2,146}, { 99,2,146}, { 94,2,146}, {104,2,146}, {  3,3,146}},
+    /* 161 */ {{ 86,2,137}, {130,2,137}, { 68,2,137}, { 82,2,137}, { 99,2,137}, { 94,2,137}, {104,2,137}, {  3,3,137},
+               { 86,2,138}, {130,2,138}, { 68,2,138}, { 82,2,138}, { 99,2,138}, { 94,2,138}, {104,2,138}, {  3,3,138}},
+    /* 162 */ {{ 85,2,139}, { 67,2,139}, { 93,2,139}, {  2,3,139}, { 85,2,140}, { 67,2,140}, { 93,2,140}, {  2,3,140},
+               { 85,2,141}, { 67,2,141}, { 93,2,141}, {  2,3,141}, { 85,2,143}, { 67,2,143}, { 93,2,143}, {  2,3,143}},
+    /* 163 */ {{ 86,2,139}, {130,2,139}, { 68,2,139}, { 82,2,139}, { 99,2,139}, { 94,2,139}, {104,2,139}, {  3,3,139},
+               { 86,2,140}, {130,2,140}, { 68,2,140}, { 82,2,140}, { 99,2,140}, { 94,2,140}, {104,2,140}, {  3,3,140}},
+    /* 164 */ {{ 86,2,141}, {130,2,141}, { 68,2,141}, { 82,2,141}, { 99,2,141}, { 94,2,141}, {104,2,141}, {  3,3,141},
+               { 86,2,143}, {130,2,143}, { 68,2,143}, { 82,2,143}, { 99,2,143}, { 94,2,143}, {104,2,143}, {  3,3,143}},
+    /* 165 */ {{ 85,2,144}, { 67,2,144}, { 93,2,144}, {  2,3,144}, { 85,2,145}, { 67,2,145}, { 93,2,145}, {  2,3,145},
+               { 85,2,148}, { 67,2,148}, { 93,2,148}, {  2,3,148}, { 85,2,159}, { 67,2,159}, { 93,2,159}, {  2,3,159}},
+    /* 166 */ {{ 86,2,144}, {130,2,144}, { 68,2,144}, { 82,2,144}, { 99,2,144}, { 94,2,144}, {104,2,144}, {  3,3,144},
+               { 86,2,145}, {130,2,145}, { 68,2,145}, { 82,2,145}, { 99,2,145}, { 94,2,145}, {104,2,145}, {  3,3,145}},
+    /* 167 */ {{  0,3,147}, {  0,3,149}, {  0,3,150}, {  0,3,151}, {  0,3,152}, {  0,3,155}, {  0,3,157}, {  0,3,158},
+               {  0,3,165}, {  0,3,166}, {  0,3,168}, {  0,3,174}, {  0,3,175}, {  0,3,180}, {  0,3,182}, {  0,3,183}},
+    /* 168 */ {{ 66,2,147}, {  1,3,147}, { 66,2,149}, {  1,3,149}, { 66,2,150}, {  1,3,150}, { 66,2,151}, {  1,3,151},
+               { 66,2,152}, {  1,3,152}, { 66,2,155}, {  1,3,155}, { 66,2,157}, {  1,3,157}, { 66,2,158}, {  1,3,158}},
+    /* 169 */ {{ 85,2,147}, { 67,2,147}, { 93,2,147}, {  2,3,147}, { 85,2,149}, { 67,2,149}, { 93,2,149}, {  2,3,149},
+               { 85,2,150}, { 67,2,150}, { 93,2,150}, {  2,3,150}, { 85,2,151}, { 67,2,151}, { 93,2,151}, {  2,3,151}},
+    /* 170 */ {{ 86,2,147}, {130,2,147}, { 68,2,147}, { 82,2,147}, { 99,2,147}, { 94,2,147}, {104,2,147}, {  3,3,147},
+               { 86,2,149}, {130,2,149}, { 68,2,149}, { 82,2,149}, { 99,2,149}, { 94,2,149}, {104,2,149}, {  3,3,149}},
+    /* 171 */ {{ 86,2,148}, {130,2,148}, { 68,2,148}, { 82,2,148}, { 99,2,148}, { 94,2,148}, {104,2,148}, {  3,3,148},
+               { 86,2,159}, {130,2,159}, { 68,2,159}, { 82,2,159}, { 99,2,159}, { 94,2,159}, {104,2,159}, {  3,3,159}},
+    /* 172 */ {{ 86,2,150}, {130,2,150}, { 68,2,150}, { 82,2,150}, { 99,2,150}, { 94,2,150}, {104,2,150}, {  3,3,150},
+               { 86,2,151}, {130,2,151}, { 68,2,151}, { 82,2,151}, { 99,2,151}, { 94,2,151}, {104,2,151}, {  3,3,151}},
+    /* 173 */ {{ 85,2,152}, { 67,2,152}, { 93,2,152}, {  2,3,152}, { 85,2,155}, { 67,2,155}, { 93,2,155}, {  2,3,155},
+               { 85,2,157}, { 67,2,157}, { 93,2,157}, {  2,3,157}, { 85,2,158}, { 67,2,158}, { 93,2,158}, {  2,3,158}},
+    /* 174 */ {{ 86,2,152}, {130,2,152}, { 68,2,152}, { 82,2,152}, { 99,2,152}, { 94,2,152}, {104,2,152}, {  3,3,152},
+               { 86,2,155}, {130,2,155}, { 68,2,155}, { 82,2,155}, { 99,2,155}, { 94,2,155}, {104,2,155}, {  3,3,155}},
+    /* 175 */ {{ 85,2,224}, { 67,2,224}, { 93,2,224}, {  2,3,224}, { 85,2,226}, { 67,2,226}, { 93,2,226}, {  2,3,226},
+               { 66,2,153}, {  1,3,153}, { 66,2,161}, {  1,3,161}, { 66,2,167}, {  1,3,167}, { 66,2,172}, {  1,3,172}},
+    /* 176 */ {{ 85,2,153}, { 67,2,153}, { 93,2,153}, {  2,3,153}, { 85,2,161}, { 67,2,161}, { 93,2,161}, {  2,3,161},
+               { 85,2,167}, { 67,2,167}, { 93,2,167}, {  2,3,167}, { 85,2,172}, { 67,2,172}, { 93,2,172}, {  2,3,172}},
+    /* 177 */ {{ 86,2,153}, {130,2,153}, { 68,2,153}, { 82,2,153}, { 99,2,153}, { 94,2,153}, {104,2,153}, {  3,3,153},
+               { 86,2,161}, {130,2,161}, { 68,2,161}, { 82,2,161}, { 99,2,161}, { 94,2,161}, {104,2,161}, {  3,3,161}},
+    /* 178 */ {{ 66,2,154}, {  1,3,154}, { 66,2,156}, {  1,3,156}, { 66,2,160}, {  1,3,160}, { 66,2,163}, {  1,3,163},
+               { 66,2,164}, {  1,3,164}, { 66,2,169}, {  1,3,169}, { 66,2,170}, {  1,3,170}, { 66,2,173}, {  1,3,173}},
+    /* 179 */ {{ 85,2,154}, { 67,2,154}, { 93,2,154}, {  2,3,154}, { 85,2,156}, { 67,2,156}, { 93,2,156}, {  2,3,156},
+               { 85,2,160}, { 67,2,160}, { 93,2,160}, {  2,3,160}, { 85,2,163}, { 67,2,163}, { 93,2,163}, {  2,3,163}},
+    /* 180 */ {{ 86,2,154}, {130,2,154}, { 68,2,154}, { 82,2,154}, { 99,2,154}, { 94,2,154}, {104,2,154}, {  3,3,154},
+               { 86,2,156}, {130,2,156}, { 68,2,156}, { 82,2,156}, { 99,2,156}, { 94,2,156}, {104,2,156}, {  3,3,156}},
+    /* 181 */ {{ 86,2,157}, {130,2,157}, { 68,2,157}, { 82,2,157}, { 99,2,157}, { 94,2,157}, {104,2,157}, {  3,3,157},
+               { 86,2,158}, {130,2,158}, { 68,2,158}, { 82,2,158}, { 99,2,158}, { 94,2,158}, {104,2,158}, {  3,3,158}},
+    /* 182 */ {{ 86,2,160}, {130,2,160}, { 68,2,160}, { 82,2,160}, { 99,2,160}, { 94,2,160}, {104,2,160}, {  3,3,160},
+               { 86,2,163}, {130,2,163}, { 68,2,163}, { 82,2,163}, { 99,2,163}, { 94,2,163}, {104,2,163}, {  3,3,163}},
+    /* 183 */ {{ 85,2,164}, { 67,2,164}, { 93,2,164}, {  2,3,164}, { 85,2,169}, { 67,2,169}, { 93,2,169}, {  2,3,169},
+               { 85,2,170}, { 67,2,170}, { 93,2,170}, {  2,3,170}, { 85,2,173}, { 67,2,173}, { 93,2,173}, {  2,3,173}},
+    /* 184 */ {{ 86,2,164}, {130,2,164}, { 68,2,164}, { 82,2,164}, { 99,2,164}, { 94,2,164}, {104,2,164}, {  3,3,164},
+               { 86,2,169}, {130,2,169}, { 68,2,169}, { 82,2,169}, { 99,2,169}, { 94,2,169}, {104,2,169}, {  3,3,169}},
+    /* 185 */ {{ 66,2,165}, {  1,3,165}, { 66,2,166}, {  1,3,166}, { 66,2,168}, {  1,3,168}, { 66,2,174}, {  1,3,174},
+               { 66,2,175}, {  1,3,175}, { 66,2,180}, {  1,3,180}, { 66,2,182}, {  1,3,182}, { 66,2,183}, {  1,3,183}},
+    /* 186 */ {{ 85,2,165}, { 67,2,165}, { 93,2,165}, {  2,3,165}, { 85,2,166}, { 67,2,166}, { 93,2,166}, {  2,3,166},
+               { 85,2,168}, { 67,2,168}, { 93,2,168}, {  2,3,168}, { 85,2,174}, { 67,2,174}, { 93,2,174}, {  2,3,174}},
+    /* 187 */ {{ 86,2,165}, {130,2,165}, { 68,2,165}, { 82,2,165}, { 99,2,165}, { 94,2,165}, {104,2,165}, {  3,3,165},
+               { 86,2,166}, {130,2,166}, { 68,2,166}, { 82,2,166}, { 99,2,166}, { 94,2,166}, {104,2,166}, {  3,3,166}},
+    /* 188 */ {{ 86,2,167}, {130,2,167}, { 68,2,167}, { 82,2,167}, { 99,2,167}, { 94,2,167}, {104,2,167}, {  3,3,167},
+               { 86,2,172}, {130,2,172}, { 68,2,172}, { 82,2,172}, { 99,2,172}, { 94,2,172}, {104,2,172}, {  3,3,172}},
+    /* 189 */ {{ 86,2,168}, {130,2,168}, { 68,2,168}, { 82,2,168}, { 99,2,168}, { 94,2,168}, {104,2,168}, {  3,3,168},
+               { 86,2,174}, {130,2,174}, { 68,2,174}, { 82,2,174}, { 99,2,174}, { 94,2,174}, {104,2,174}, {  3,3,174}},
+    /* 190 */ {{ 86,2,170}, {130,2,170}, { 68,2,170}, { 82,2,170}, { 99,2,170}, { 94,2,170}, {104,2,170}, {  3,3,170},
+               { 86,2,173}, {130,2,173}, { 68,2,173}, { 82,2,173}, { 99,2,173}, { 94,2,173}, {104,2,173}, {  3,3,173}},
+    /* 191 */ {{ 66,2,171}, {  1,3,171}, { 66,2,206}, {  1,3,206}, { 66,2,215}, {  1,3,215}, { 66,2,225}, {  1,3,225},
+               { 66,2,236}, {  1,3,236}, { 66,2,237}, {  1,3,237}, {  0,3,199}, {  0,3,207}, {  0,3,234}, {  0,3,235}},
+    /* 192 */ {{ 85,2,171}, { 67,2,171}, { 93,2,171}, {  2,3,171}, { 85,2,206}, { 67,2,206}, { 93,2,206}, {  2,3,206},
+               { 85,2,215}, { 67,2,215}, { 93,2,215}, {  2,3,215}, { 85,2,225}, { 67,2,225}, { 93,2,225}, {  2,3,225}},
+    /* 193 */ {{ 86,2,171}, {130,2,171}, { 68,2,171}, { 82,2,171}, { 99,2,171}, { 94,2,171}, {104,2,171}, {  3,3,171},
+               { 86,2,206}, {130,2,206}, { 68,2,206}, { 82,2,206}, { 99,2,206}, { 94,2,206}, {104,2,206}, {  3,3,206}},
+    /* 194 */ {{ 85,2,175}, { 67,2,175}, { 93,2,175}, {  2,3,175}, { 85,2,180}, { 67,2,180}, { 93,2,180}, {  2,3,180},
+               { 85,2,182}, { 67,2,182}, { 93,2,182}, {  2,3,182}, { 85,2,183}, { 67,2,183}, { 93,2,183}, {  2,3,183}},
+    /* 195 */ {{ 86,2,175}, {130,2,175}, { 68,2,175}, { 82,2,175}, { 99,2,175}, { 94,2,175}, {104,2,175}, {  3,3,175},
+               { 86,2,180}, {130,2,180}, { 68,2,180}, { 82,2,180}, { 99,2,180}, { 94,2,180}, {104,2,180}, {  3,3,180}},
+    /* 196 */ {{ 66,2,176}, {  1,3,176}, { 66,2,177}, {  1,3,177}, { 66,2,179}, {  1,3,179}, { 66,2,209}, {  1,3,209},
+               { 66,2,216}, {  1,3,216}, { 66,2,217}, {  1,3,217}, { 66,2,227}, {  1,3,227}, { 66,2,229}, {  1,3,229}},
+    /* 197 */ {{ 85,2,176}, { 67,2,176}, { 93,2,176}, {  2,3,176}, { 85,2,177}, { 67,2,177}, { 93,2,177}, {  2,3,177},
+               { 85,2,179}, { 67,2,179}, { 93,2,179}, {  2,3,179}, { 85,2,209}, { 67,2,209}, { 93,2,209}, {  2,3,209}},
+    /* 198 */ {{ 86,2,176}, {130,2,176}, { 68,2,176}, { 82,2,176}, { 99,2,176}, { 94,2,176}, {104,2,176}, {  3,3,176},
+               { 86,2,177}, {130,2,177}, { 68,2,177}, { 82,2,177}, { 99,2,177}, { 94,2,177}, {104,2,177}, {  3,3,177}},
+    /* 199 */ {{ 66,2,178}, {  1,3,178}, { 66,2,181}, {  1,3,181}, { 66,2,185}, {  1,3,185}, { 66,2,186}, {  1,3,186},
+               { 66,2,187}, {  1,3,187}, { 66,2,189}, {  1,3,189}, { 66,2,190}, {  1,3,190}, { 66,2,196}, {  1,3,196}},
+    /* 200 */ {{ 85,2,178}, { 67,2,178}, { 93,2,178}, {  2,3,178}, { 85,2,181}, { 67,2,181}, { 93,2,181}, {  2,3,181},
+               { 85,2,185}, { 67,2,185}, { 93,2,185}, {  2,3,185}, { 85,2,186}, { 67,2,186}, { 93,2,186}, {  2,3,186}},
+    /* 201 */ {{ 86,2,178}, {130,2,178}, { 68,2,178}, { 82,2,178}, { 99,2,178}, { 94,2,178}, {104,2,178}, {  3,3,178},
+               { 86,2,181}, {130,2,181}, { 68,2,181}, { 82,2,181}, { 99,2,181}, { 94,2,181}, {104,2,181}, {  3,3,181}},
+    /* 202 */ {{ 86,2,179}, {130,2,179}, { 68,2,179}, { 82,2,179}, { 99,2,179}, { 94,2,179}, {104,2,179}, {  3,3,179},
+               { 86,2,209}, {130,2,209}, { 68,2,209}, { 82,2,209}, { 99,2,209}, { 94,2,209}, {104,2,209}, {  3,3,209}},
+    /* 203 */ {{ 86,2,182}, {130,2,182}, { 68,2,182}, { 82,2,182}, { 99,2,182}, { 94,2,182}, {104,2,182}, {  3,3,182},
+               { 86,2,183}, {130,2,183}, { 68,2,183}, { 82,2,183}, { 99,2,183}, { 94,2,183}, {104,2,183}, {  3,3,183}},
+    /* 204 */ {{ 86,2,184}, {130,2,184}, { 68,2,184}, { 82,2,184}, { 99,2,184}, { 94,2,184}, {104,2,184}, {  3,3,184},
+               { 86,2,194}, {130,2,194}, { 68,2,194}, { 82,2,194}, { 99,2,194}, { 94,2,194}, {104,2,194}, {  3,3,194}},
+    /* 205 */ {{ 86,2,185}, {130,2,185}, { 68,2,185}, { 82,2,185}, { 99,2,185}, { 94,2,185}, {104,2,185}, {  3,3,185},
+               { 86,2,186}, {130,2,186}, { 68,2,186}, { 82,2,186}, { 99,2,186}, { 94,2,186}, {104,2,186}, {  3,3,186}},
+    /* 206 */ {{ 85,2,187}, { 67,2,187}, { 93,2,187}, {  2,3,187}, { 85,2,189}, { 67,2,189}, { 93,2,189}, {  2,3,189},
+               { 85,2,190}, { 67,2,190}, { 93,2,190}, {  2,3,190}, { 85,2,196}, { 67,2,196}, { 93,2,196}, {  2,3,196}},
+    /* 207 */ {{ 86,2,187}, {130,2,187}, { 68,2,187}, { 82,2,187}, { 99,2,187}, { 94,2,187}, {104,2,187}, {  3,3,187},
+               { 86,2,189}, {130,2,189}, { 68,2,189}, { 82,2,189}, { 99,2,189}, { 94,2,189}, {104,2,189}, {  3,3,189}},
+    /* 208 */ {{ 85,2,188}, { 67,2,188}, { 93,2,188}, {  2,3,188}, { 85,2,191}, { 67,2,191}, { 93,2,191}, {  2,3,191},
+               { 85,2,197}, { 67,2,197}, { 93,2,197}, {  2,3,197}, { 85,2,231}, { 67,2,231}, { 93,2,231}, {  2,3,231}},
+    /* 209 */ {{ 86,2,188}, {130,2,188}, { 68,2,188}, { 82,2,188}, { 99,2,188}, { 94,2,188}, {104,2,188}, {  3,3,188},
+               { 86,2,191}, {130,2,191}, { 68,2,191}, { 82,2,191}, { 99,2,191}, { 94,2,191}, {104,2,191}, {  3,3,191}},
+    /* 210 */ {{ 86,2,190}, {130,2,190}, { 68,2,190}, { 82,2,190}, { 99,2,190}, { 94,2,190}, {104,2,190}, {  3,3,190},
+               { 86,2,196}, {130,2,196}, { 68,2,196}, { 82,2,196}, { 99,2,196}, { 94,2,196}, {104,2,196}, {  3,3,196}},
+    /* 211 */ {{  0,3,192}, {  0,3,193}, {  0,3,200}, {  0,3,201}, {  0,3,202}, {  0,3,205}, {  0,3,210}, {  0,3,213},
+               {  0,3,218}, {  0,3,219}, {  0,3,238}, {  0,3,240}, {  0,3,242}, {  0,3,243}, {  0,3,255}, {227,0,  0}},
+    /* 212 */ {{ 66,2,192}, {  1,3,192}, { 66,2,193}, {  1,3,193}, { 66,2,200}, {  1,3,200}, { 66,2,201}, {  1,3,201},
+               { 66,2,202}, {  1,3,202}, { 66,2,205}, {  1,3,205}, { 66,2,210}, {  1,3,210}, { 66,2,213}, {  1,3,213}},
+    /* 213 */ {{ 85,2,192}, { 67,2,192}, { 93,2,192}, {  2,3,192}, { 85,2,193}, { 67,2,193}, { 93,2,193}, {  2,3,193},
+               { 85,2,200}, { 67,2,200}, { 93,2,200}, {  2,3,200}, { 85,2,201}, { 67,2,201}, { 93,2,201}, {  2,3,201}},
+    /* 214 */ {{ 86,2,192}, {130,2,192}, { 68,2,192}, { 82,2,192}, { 99,2,192}, { 94,2,192}, {104,2,192}, {  3,3,192},
+               { 86,2,193}, {130,2,193}, { 68,2,193}, { 82,2,193}, { 99,2,193}, { 94,2,193}, {104,2,193}, {  3,3,193}},
+    /* 215 */ {{ 86,2,197}, {130,2,197}, { 68,2,197}, { 82,2,197}, { 99,2,197}, { 94,2,197}, {104,2,197}, {  3,3,197},
+               { 86,2,231}, {130,2,231}, { 68,2,231}, { 82,2,231}, { 99,2,231}, { 94,2,231}, {104,2,231}, {  3,3,231}},
+    /* 216 */ {{ 85,2,198}, { 67,2,198}, { 93,2,198}, {  2,3,198}, { 85,2,228}, { 67,2,228}, { 93,2,228}, {  2,3,228},
+               { 85,2,232}, { 67,2,232}, { 93,2,232}, {  2,3,232}, { 85,2,233}, { 67,2,233}, { 93,2,233}, {  2,3,233}},
+    /* 217 */ {{ 86,2,198}, {130,2,198}, { 68,2,198}, { 82,2,198}, { 99,2,198}, { 94,2,198}, {104,2,198}, {  3,3,198},
+               { 86,2,228}, {130,2,228}, { 68,2,228}, { 82,2,228}, { 99,2,228}, { 94,2,228}, {104,2,228}, {  3,3,228}},
+    /* 218 */ {{ 85,2,236}, { 67,2,236}, { 93,2,236}, {  2,3,236}, { 85,2,237}, { 67,2,237}, { 93,2,237}, {  2,3,237},
+               { 66,2,199}, {  1,3,199}, { 66,2,207}, {  1,3,207}, { 66,2,234}, {  1,3,234}, { 66,2,235}, {  1,3,235}},
+    /* 219 */ {{ 85,2,199}, { 67,2,199}, { 93,2,199}, {  2,3,199}, { 85,2,207}, { 67,2,207}, { 93,2,207}, {  2,3,207},
+               { 85,2,234}, { 67,2,234}, { 93,2,234}, {  2,3,234}, { 85,2,235}, { 67,2,235}, { 93,2,235}, {  2,3,235}},
+    /* 220 */ {{ 86,2,199}, {130,2,199}, { 68,2,199}, { 82,2,199}, { 99,2,199}, { 94,2,199}, {104,2,199}, {  3,3,199},
+               { 86,2,207}, {130,2,207}, { 68,2,207}, { 82,2,207}, { 99,2,207}, { 94,2,207}, {104,2,207}, {  3,3,207}},
+    /* 221 */ {{ 86,2,200}, {130,2,200}, { 68,2,200}, { 82,2,200}, { 99,2,200}, { 94,2,200}, {104,2,200}, {  3,3,200},
+               { 86,2,201}, {130,2,201}, { 68,2,201}, { 82,2,201}, { 99,2,201}, { 94,2,201}, {104,2,201}, {  3,3,201}},
+    /* 222 */ {{ 85,2,202}, { 67,2,202}, { 93,2,202}, {  2,3,202}, { 85,2,205}, { 67,2,205}, { 93,2,205}, {  2,3,205},
+               { 85,2,210}, { 67,2,210}, { 93,2,210}, {  2,3,210}, { 85,2,213}, { 67,2,213}, { 93,2,213}, {  2,3,213}},
+    /* 223 */ {{ 86,2,202}, {130,2,202}, { 68,2,202}, { 82,2,202}, { 99,2,202}, { 94,2,202}, {104,2,202}, {  3,3,202},
+               { 86,2,205}, {130,2,205}, { 68,2,205}, { 82,2,205}, { 99,2,205}, { 94,2,205}, {104,2,205}, {  3,3,205}},
+    /* 224 */ {{ 66,2,218}, {  1,3,218}, { 66,2,219}, {  1,3,219}, { 66,2,238}, {  1,3,238}, { 66,2,240}, {  1,3,240},
+               { 66,2,242}, {  1,3,242}, { 66,2,243}, {  1,3,243}, { 66,2,255}, {  1,3,255}, {  0,3,203}, {  0,3,204}},
+    /* 225 */ {{ 85,2,242}, { 67,2,242}, { 93,2,242}, {  2,3,242}, { 85,2,243}, { 67,2,243}, { 93,2,243}, {  2,3,243},
+               { 85,2,255}, { 67,2,255}, { 93,2,255}, {  2,3,255}, { 66,2,203}, {  1,3,203}, { 66,2,204}, {  1,3,204}},
+    /* 226 */ {{ 86,2,255}, {130,2,255}, { 68,2,255}, { 82,2,255}, { 99,2,255}, { 94,2,255}, {104,2,255}, {  3,3,255},
+               { 85,2,203}, { 67,2,203}, { 93,2,203}, {  2,3,203}, { 85,2,204}, { 67,2,204}, { 93,2,204}, {  2,3,204}},
+    /* 227 */ {{ 86,2,203}, {130,2,203}, { 68,2,203}, { 82,2,203}, { 99,2,203}, { 94,2,203}, {104,2,203}, {  3,3,203},
+               { 86,2,204}, {130,2,204}, { 68,2,204}, { 82,2,204}, { 99,2,204}, { 94,2,204}, {104,2,204}, {  3,3,204}},
+    /* 228 */ {{ 86,2,210}, {130,2,210}, { 68,2,210}, { 82,2,210}, { 99,2,210}, { 94,2,210}, {104,2,210}, {  3,3,210},
+               { 86,2,213}, {130,2,213}, { 68,2,213}, { 82,2,213}, { 99,2,213}, { 94,2,213}, {104,2,213}, {  3,3,213}},
+    /* 229 */ {{  0,3,211}, {  0,3,212}, {  0,3,214}, {  0,3,221}, {  0,3,222}, {  0,3,223}, {  0,3,241}, {  0,3,244},
+               {  0,3,245}, {  0,3,246}, {  0,3,247}, {  0,3,248}, {  0,3,250}, {  0,3,251}, {  0,3,252}, {  0,3,253}},
+    /* 230 */ {{ 66,2,211}, {  1,3,211}, { 66,2,212}, {  1,3,212}, { 66,2,214}, {  1,3,214}, { 66,2,221}, {  1,3,221},
+               { 66,2,222}, {  1,3,222}, { 66,2,223}, {  1,3,223}, { 66,2,241}, {  1,3,241}, { 66,2,244}, {  1,3,244}},
+    /* 231 */ {{ 85,2,211}, { 67,2,211}, { 93,2,211}, {  2,3,211}, { 85,2,212}, { 67,2,212}, { 93,2,212}, {  2,3,212},
+               { 85,2,214}, { 67,2,214}, { 93,2,214}, {  2,3,214}, { 85,2,221}, { 67,2,221}, { 93,2,221}, {  2,3,221}},
+    /* 232 */ {{ 86,2,211}, {130,2,211}, { 68,2,211}, { 82,2,211}, { 99,2,211}, { 94,2,211}, {104,2,211}, {  3,3,211},
+               { 86,2,212}, {130,2,212}, { 68,2,212}, { 82,2,212}, { 99,2,212}, { 94,2,212}, {104,2,212}, {  3,3,212}},
+    /* 233 */ {{ 86,2,214}, {130,2,214}, { 68,2,214}, { 82,2,214}, { 99,2,214}, { 94,2,214}, {104,2,214}, {  3,3,214},
+               { 86,2,221}, {130,2,221}, { 68,2,221}, { 82,2,221}, { 99,2,221}, { 94,2,221}, {104,2,221}, {  3,3,221}},
+    /* 234 */ {{ 86,2,215}, {130,2,215}, { 68,2,215}, { 82,2,215}, { 99,2,215}, { 94,2,215}, {104,2,215}, {  3,3,215},
+               { 86,2,225}, {130,2,225}, { 68,2,225}, { 82,2,225}, { 99,2,225}, { 94,2,225}, {104,2,225}, {  3,3,225}},
+    /* 235 */ {{ 85,2,216}, { 67,2,216}, { 93,2,216}, {  2,3,216}, { 85,2,217}, { 67,2,217}, { 93,2,217}, {  2,3,217},
+               { 85,2,227}, { 67,2,227}, { 93,2,227}, {  2,3,227}, { 85,2,229}, { 67,2,229}, { 93,2,229}, {  2,3,229}},
+    /* 236 */ {{ 86,2,216}, {130,2,216}, { 68,2,216}, { 82,2,216}, { 99,2,216}, { 94,2,216}, {104,2,216}, {  3,3,216},
+               { 86,2,217}, {130,2,217}, { 68,2,217}, { 82,2,217}, { 99,2,217}, { 94,2,217}, {104,2,217}, {  3,3,217}},
+    /* 237 */ {{ 85,2,218}, { 67,2,218}, { 93,2,218}, {  2,3,218}, { 85,2,219}, { 67,2,219}, { 93,2,219}, {  2,3,219},
+               { 85,2,238}, { 67,2,238}, { 93,2,238}, {  2,3,238}, { 85,2,240}, { 67,2,240}, { 93,2,240}, {  2,3,240}},
+    /* 238 */ {{ 86,2,218}, {130,2,218}, { 68,2,218}, { 82,2,218}, { 99,2,218}, { 94,2,218}, {104,2,218}, {  3,3,218},
+               { 86,2,219}, {130,2,219}, { 68,2,219}, { 82,2,219}, { 99,2,219}, { 94,2,219}, {104,2,219}, {  3,3,219}},
+    /* 239 */ {{ 85,2,222}, { 67,2,222}, { 93,2,222}, {  2,3,222}, { 85,2,223}, { 67,2,223}, { 93,2,223}, {  2,3,223},
+               { 85,2,241}, { 67,2,241}, { 93,2,241}, {  2,3,241}, { 85,2,244}, { 67,2,244}, { 93,2,244}, {  2,3,244}},
+    /* 240 */ {{ 86,2,222}, {130,2,222}, { 68,2,222}, { 82,2,222}, { 99,2,222}, { 94,2,222}, {104,2,222}, {  3,3,222},
+               { 86,2,223}, {130,2,223}, { 68,2,223}, { 82,2,223}, { 99,2,223}, { 94,2,223}, {104,2,223}, {  3,3,223}},
+    /* 241 */ {{ 86,2,224}, {130,2,224}, { 68,2,224}, { 82,2,224}, { 99,2,224}, { 94,2,224}, {104,2,224}, {  3,3,224},
+               { 86,2,226}, {130,2,226}, { 68,2,226}, { 82,2,226}, { 99,2,226}, { 94,2,226}, {104,2,226}, {  3,3,226}},
+    /* 242 */ {{ 86,2,227}, {130,2,227}, { 68,2,227}, { 82,2,227}, { 99,2,227}, { 94,2,227}, {104,2,227}, {  3,3,227},
+               { 86,2,229}, {130,2,229}, { 68,2,229}, { 82,2,229}, { 99,2,229}, { 94,2,229}, {104,2,229}, {  3,3,229}},
+    /* 243 */ {{ 86,2,232}, {130,2,232}, { 68,2,232}, { 82,2,232}, { 99,2,232}, { 94,2,232}, {104,2,232}, {  3,3,232},
+               { 86,2,233}, {130,2,233}, { 68,2,233}, { 82,2,233}, { 99,2,233}, { 94,2,233}, {104,2,233}, {  3,3,233}},
+    /* 244 */ {{ 86,2,234}, {130,2,234}, { 68,2,234}, { 82,2,234}, { 99,2,234}, { 94,2,234}, {104,2,234}, {  3,3,234},
+               { 86,2,235}, {130,2,235}, { 68,2,235}, { 82,2,235}, { 99,2,235}, { 94,2,235}, {104,2,235}, {  3,3,235}},
+    /* 245 */ {{ 86,2,236}, {130,2,236}, { 68,2,236}, { 82,2,236}, { 99,2,236}, { 94,2,236}, {104,2,236}, {  3,3,236},
+               { 86,2,237}, {130,2,237}, { 68,2,237}, { 82,2,237}, { 99,2,237}, { 94,2,237}, {104,2,237}, {  3,3,237}},
+    /* 246 */ {{ 86,2,238}, {130,2,238}, { 68,2,238}, { 82,2,238}, { 99,2,238}, { 94,2,238}, {104,2,238}, {  3,3,238},
+               { 86,2,240}, {130,2,240}, { 68,2,240}, { 82,2,240}, { 99,2,240}, { 94,2,240}, {104,2,240}, {  3,3,240}},
+    /* 247 */ {{ 86,2,241}, {130,2,241}, { 68,2,241}, { 82,2,241}, { 99,2,241}, { 94,2,241}, {104,2,241}, {  3,3,241},
+               { 86,2,244}, {130,2,244}, { 68,2,244}, { 82,2,244}, { 99,2,244}, { 94,2,244}, {104,2,244}, {  3,3,244}},
+    /* 248 */ {{ 86,2,242}, {130,2,242}, { 68,2,242}, { 82,2,242}, { 99,2,242}, { 94,2,242}, {104,2,242}, {  3,3,242},
+               { 86,2,243}, {130,2,243}, { 68,2,243}, { 82,2,243}, { 99,2,243}, { 94,2,243}, {104,2,243}, {  3,3,243}},
+    /* 249 */ {{ 66,2,245}, {  1,3,245}, { 66,2,246}, {  1,3,246}, { 66,2,247}, {  1,3,247}, { 66,2,248}, {  1,3,248},
+               { 66,2,250}, {  1,3,250}, { 66,2,251}, {  1,3,251}, { 66,2,252}, {  1,3,252}, { 66,2,253}, {  1,3,253}},
+    /* 250 */ {{ 85,2,245}, { 67,2,245}, { 93,2,245}, {  2,3,245}, { 85,2,246}, { 67,2,246}, { 93,2,246}, {  2,3,246},
+               { 85,2,247}, { 67,2,247}, { 93,2,247}, {  2,3,247}, { 85,2,248}, { 67,2,248}, { 93,2,248}, {  2,3,248}},
+    /* 251 */ {{ 86,2,245}, {130,2,245}, { 68,2,245}, { 82,2,245}, { 99,2,245}, { 94,2,245}, {104,2,245}, {  3,3,245},
+               { 86,2,246}, {130,2,246}, { 68,2,246}, { 82,2,246}, { 99,2,246}, { 94,2,246}, {104,2,246}, {  3,3,246}},
+    /* 252 */ {{ 86,2,247}, {130,2,247}, { 68,2,247}, { 82,2,247}, { 99,2,247}, { 94,2,247}, {104,2,247}, {  3,3,247},
+               { 86,2,248}, {130,2,248}, { 68,2,248}, { 82,2,248}, { 99,2,248}, { 94,2,248}, {104,2,248}, {  3,3,248}},
+    /* 253 */ {{ 85,2,250}, { 67,2,250}, { 93,2,250}, {  2,3,250}, { 85,2,251}, { 67,2,251}, { 93,2,251}, {  2,3,251},
+               { 85,2,252}, { 67,2,252}, { 93,2,252}, {  2,3,252}, { 85,2,253}, { 67,2,253}, { 93,2,253}, {  2,3,253}},
+    /* 254 */ {{ 86,2,250}, {130,2,250}, { 68,2,250}, { 82,2,250}, { 99,2,250}, { 94,2,250}, {104,2,250}, {  3,3,250},
+               { 86,2,251}, {130,2,251}, { 68,2,251}, { 82,2,251}, { 99,2,251}, { 94,2,251}, {104,2,251}, {  3,3,251}},
+    /* 255 */ {{ 86,2,252}, {130,2,252}, { 68,2,252}, { 82,2,252}, { 99,2,252}, { 94,2,252}, {104,2,252}, {  3,3,252},
+               { 86,2,253}, {130,2,253}, { 68,2,253}, { 82,2,253}, { 99,2,253}, { 94,2,253}, {104,2,253}, {  3,3,253}},
+};
+
+#endif /* LIBHPACK_HUFFMAN_DATA_H */
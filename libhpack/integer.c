@@ -35,8 +35,12 @@
  */
 
 #include "integer.h"
+#include "simd.h"
 #include <stdio.h>
-#include <math.h>
+#include <string.h>
+#include <limits.h>
+
+#include <libchula/macros.h>
 
 static const unsigned char limits[] = {0, 1, 3, 7, 15, 31, 63, 127, 255};
 
@@ -92,6 +96,73 @@ integer_encode (int            N,
     return ret_OK;
 }
 
+/* Continuation octets accepted by integer_decode_bounded(). Five of
+ * them carry up to 35 bits, enough for any 32 bits value.
+ */
+#define MAX_CONT_OCTETS 5
+
+/** Bounded integer decoding
+ *
+ * Decodes an integer number from a HPACK representation in memory,
+ * discovering its length on the way. Continuation octets are combined
+ * with shifts, and the readable size is checked before each of them.
+ *
+ * @param      N        Number of bits of the prefix
+ * @param      mem      Pointer to the first byte of memory containing the number
+ * @param      mem_size Number of readable bytes at @mem
+ * @param[out] ret      Decoded number
+ * @param[out] consumed Number of bytes the representation takes
+ * @retval ret_OK     Number was read successfully
+ * @retval ret_eagain The representation continues past @mem_size
+ * @retval ret_ERROR  The number does not fit in 32 bits
+ */
+ret_t
+integer_decode_bounded (int                  N,
+                        const unsigned char *mem,
+                        size_t               mem_size,
+                        uint32_t            *ret,
+                        size_t              *consumed)
+{
+    uint64_t            value;
+    size_t              i;
+    const unsigned char limit = limits[N];
+
+    if (unlikely (mem_size == 0)) {
+        return ret_eagain;
+    }
+
+    /* Trivial 1 byte number
+     */
+    value = mem[0] & limit;
+    if (likely (value < limit)) {
+        *ret      = (uint32_t) value;
+        *consumed = 1;
+        return ret_OK;
+    }
+
+    /* Octet at a time
+     */
+    for (i = 1; i <= MAX_CONT_OCTETS; i++) {
+        if (unlikely (i >= mem_size)) {
+            return ret_eagain;
+        }
+
+        value += (uint64_t)(mem[i] & 0x7F) << (7 * (i-1));
+
+        if ((mem[i] & 0x80) == 0) {
+            if (unlikely (value > UINT32_MAX)) {
+                return ret_ERROR;
+            }
+
+            *ret      = (uint32_t) value;
+            *consumed = i + 1;
+            return ret_OK;
+        }
+    }
+
+    return ret_ERROR;
+}
+
 /** Integer decoding
  *
  * Decodes an integer number from a HPACK representation in memory. A
@@ -111,29 +182,590 @@ integer_decode (int            N,
                 unsigned char  mem_len,
                 int           *ret)
 {
+    ret_t    re;
+    uint32_t value;
+    size_t   consumed;
+
+    re = integer_decode_bounded (N, mem, mem_len, &value, &consumed);
+    if (unlikely ((re != ret_OK) || (consumed != mem_len) || (value > INT_MAX))) {
+        return ret_ERROR;
+    }
+
+    *ret = (int) value;
+    return ret_OK;
+}
+
+
+/* 64 bits codec
+ *
+ * Ten continuation octets carry up to 70 bits, enough for any 64 bits
+ * value.
+ */
+#define MAX_CONT_OCTETS_64 10
+
+/** 64 bits integer encoding
+ *
+ * Encodes a number of up to 64 bits into memory of a given capacity.
+ * Nothing is written unless the whole representation fits.
+ *
+ * @param      N        Number of bits of the prefix
+ * @param      pattern  Bits above the prefix of the first octet
+ * @param      value    Number to encode
+ * @param[out] mem      Memory where the number has to be encoded to
+ * @param      mem_size Capacity of @mem, INTEGER_MAX_LEN_64 is always enough
+ * @param[out] written  Number of bytes written
+ * @retval ret_OK     Number encoded
+ * @retval ret_eagain The representation takes more than @mem_size bytes
+ */
+ret_t
+integer_encode_64 (int            N,
+                   unsigned char  pattern,
+                   uint64_t       value,
+                   unsigned char *mem,
+                   size_t         mem_size,
+                   size_t        *written)
+{
+    size_t              i;
+    size_t              len;
+    uint64_t            rest;
     const unsigned char limit = limits[N];
 
-    /* Trivial 1 byte number
-     */
-    if (mem_len == 1) {
-        *ret = mem[0] & limit;
+    if (value < limit) {
+        if (unlikely (mem_size < 1)) {
+            return ret_eagain;
+        }
+
+        mem[0]   = (pattern & ~limit) | (unsigned char)value;
+        *written = 1;
         return ret_OK;
     }
 
-    /* Sanity check:
-     * All non-masked bits of the 1st byte must be 1s
-     */
-    if ((mem[0] & limit) != limit) {
-        return ret_ERROR;
+    /* Length first, so a short buffer is left untouched */
+    rest = value - limit;
+    for (len = 2; rest >= 128; len++) {
+        rest >>= 7;
+    }
+
+    if (unlikely (len > mem_size)) {
+        return ret_eagain;
+    }
+
+    mem[0] = pattern | limit;
+    rest   = value - limit;
+
+    for (i = 1; i < len - 1; i++) {
+        mem[i] = 0x80 | (rest & 0x7F);
+        rest >>= 7;
     }
 
-    /* Unsigned variable length integer
+    mem[i]   = (unsigned char)rest;
+    *written = len;
+    return ret_OK;
+}
+
+/** 64 bits integer decoding
+ *
+ * Decodes a number of up to 64 bits from memory, discovering its length
+ * on the way.
+ *
+ * @param      N        Number of bits of the prefix
+ * @param      mem      Pointer to the first byte of memory containing the number
+ * @param      mem_size Number of readable bytes at @mem
+ * @param[out] ret      Decoded number
+ * @param[out] consumed Number of bytes the representation takes
+ * @retval ret_OK     Number was read successfully
+ * @retval ret_eagain The representation continues past @mem_size
+ * @retval ret_ERROR  The number does not fit in 64 bits
+ */
+ret_t
+integer_decode_64 (int                  N,
+                   const unsigned char *mem,
+                   size_t               mem_size,
+                   uint64_t            *ret,
+                   size_t              *consumed)
+{
+    size_t              i;
+    uint64_t            bits;
+    uint64_t            value = 0;
+    const unsigned char limit = limits[N];
+
+    if (unlikely (mem_size == 0)) {
+        return ret_eagain;
+    }
+
+    if (likely ((mem[0] & limit) < limit)) {
+        *ret      = mem[0] & limit;
+        *consumed = 1;
+        return ret_OK;
+    }
+
+    for (i = 1; i <= MAX_CONT_OCTETS_64; i++) {
+        if (unlikely (i >= mem_size)) {
+            return ret_eagain;
+        }
+
+        /* The tenth octet only has room for one bit */
+        bits = mem[i] & 0x7F;
+        if (unlikely ((i == MAX_CONT_OCTETS_64) && (bits > 1))) {
+            return ret_ERROR;
+        }
+
+        value |= bits << (7 * (i-1));
+
+        if ((mem[i] & 0x80) == 0) {
+            if (unlikely (value > UINT64_MAX - limit)) {
+                return ret_ERROR;
+            }
+
+            *ret      = value + limit;
+            *consumed = i + 1;
+            return ret_OK;
+        }
+    }
+
+    return ret_ERROR;
+}
+
+
+/* Batch codecs
+ *
+ * Runs of integers sharing a prefix length. Every implementation
+ * produces exactly what integer_encode() and integer_decode_bounded()
+ * do, one integer at a time: the vector ones only handle single octet
+ * integers, and leave everything else to the scalar code.
+ */
+
+typedef size_t (*encode_batch_func_t) (int             N,
+                                       unsigned char   pattern,
+                                       const uint32_t *values,
+                                       size_t          num,
+                                       unsigned char  *mem);
+
+typedef ret_t (*decode_batch_func_t) (int                  N,
+                                      const unsigned char *mem,
+                                      size_t               mem_size,
+                                      uint32_t            *values,
+                                      size_t               max_values,
+                                      size_t              *num,
+                                      size_t              *consumed);
+
+static encode_batch_func_t encode_batch_func = NULL;
+static decode_batch_func_t decode_batch_func = NULL;
+
+static size_t
+encode_batch_scalar (int             N,
+                     unsigned char   pattern,
+                     const uint32_t *values,
+                     size_t          num,
+                     unsigned char  *mem)
+{
+    size_t i;
+    size_t len = 0;
+
+    for (i = 0; i < num; i++) {
+        len += integer_encode_prefix (N, pattern, values[i], mem + len);
+    }
+
+    return len;
+}
+
+static ret_t
+decode_batch_scalar (int                  N,
+                     const unsigned char *mem,
+                     size_t               mem_size,
+                     uint32_t            *values,
+                     size_t               max_values,
+                     size_t              *num,
+                     size_t              *consumed)
+{
+    ret_t  ret = ret_OK;
+    size_t n   = 0;
+    size_t p   = 0;
+    size_t used;
+
+    while ((n < max_values) && (p < mem_size)) {
+        ret = integer_decode_bounded (N, mem + p, mem_size - p, &values[n], &used);
+        if (ret != ret_OK) {
+            break;
+        }
+
+        p += used;
+        n++;
+    }
+
+    *num      = n;
+    *consumed = p;
+    return ret;
+}
+
+#if defined(HAVE_SSE2)
+
+/* The vector codecs work on windows of consecutive integers. Every
+ * step writes a whole window of single octet integers, speculatively,
+ * and keeps the run of them up to the first integer that is not. That
+ * one is then handled by the scalar code.
+ */
+
+static inline ret_t
+decode_step (int                  N,
+             const unsigned char *mem,
+             size_t               mem_size,
+             uint32_t            *value,
+             size_t              *p)
+{
+    ret_t  ret;
+    size_t used;
+
+    ret = integer_decode_bounded (N, mem + *p, mem_size - *p, value, &used);
+    if (ret == ret_OK) {
+        *p += used;
+    }
+
+    return ret;
+}
+
+static size_t
+encode_batch_sse2 (int             N,
+                   unsigned char   pattern,
+                   const uint32_t *values,
+                   size_t          num,
+                   unsigned char  *mem)
+{
+    __m128i             v, small, packed;
+    uint32_t            word;
+    unsigned int        run;
+    int                 mask;
+    size_t              i      = 0;
+    size_t              len    = 0;
+    const unsigned char limit  = limits[N];
+    __m128i             zero   = _mm_setzero_si128();
+    __m128i             vlimit = _mm_set1_epi32 (limit);
+    __m128i             vpat   = _mm_set1_epi8 ((char)(pattern & ~limit));
+
+    /* At least 4 bytes are left in @mem while 4 values are */
+    while (i + 4 <= num) {
+        v      = _mm_loadu_si128 ((const __m128i *)(values + i));
+        small  = _mm_and_si128 (_mm_cmplt_epi32 (v, vlimit),
+                                _mm_cmpeq_epi32 (_mm_srli_epi32 (v, 8), zero));
+        packed = _mm_packus_epi16 (_mm_packs_epi32 (v, zero), zero);
+        word   = (uint32_t) _mm_cvtsi128_si32 (_mm_or_si128 (packed, vpat));
+        memcpy (mem + len, &word, sizeof(word));
+
+        mask   = _mm_movemask_ps (_mm_castsi128_ps (small));
+
+        if (likely (mask == 0xF)) {
+            len += 4;
+            i   += 4;
+            continue;
+        }
+
+        run  = __builtin_ctz (~mask);
+        len += run;
+        i   += run;
+        len += integer_encode_prefix (N, pattern, values[i++], mem + len);
+    }
+
+    return len + encode_batch_scalar (N, pattern, values + i, num - i, mem + len);
+}
+
+static ret_t
+decode_batch_sse2 (int                  N,
+                   const unsigned char *mem,
+                   size_t               mem_size,
+                   uint32_t            *values,
+                   size_t               max_values,
+                   size_t              *num,
+                   size_t              *consumed)
+{
+    ret_t               ret;
+    __m128i             bytes, lo, hi;
+    unsigned int        run;
+    size_t              used, tail;
+    size_t              n      = 0;
+    size_t              p      = 0;
+    const unsigned char limit  = limits[N];
+    __m128i             zero   = _mm_setzero_si128();
+    __m128i             vlimit = _mm_set1_epi8 ((char)limit);
+
+    while ((max_values - n >= 16) && (mem_size - p >= 16)) {
+        bytes = _mm_and_si128 (_mm_loadu_si128 ((const __m128i *)(mem + p)), vlimit);
+        run   = __builtin_ctz (_mm_movemask_epi8 (_mm_cmpeq_epi8 (bytes, vlimit)) | 0x10000);
+
+        lo = _mm_unpacklo_epi8 (bytes, zero);
+        hi = _mm_unpackhi_epi8 (bytes, zero);
+        _mm_storeu_si128 ((__m128i *)(values + n),      _mm_unpacklo_epi16 (lo, zero));
+        _mm_storeu_si128 ((__m128i *)(values + n + 4),  _mm_unpackhi_epi16 (lo, zero));
+        _mm_storeu_si128 ((__m128i *)(values + n + 8),  _mm_unpacklo_epi16 (hi, zero));
+        _mm_storeu_si128 ((__m128i *)(values + n + 12), _mm_unpackhi_epi16 (hi, zero));
+
+        n += run;
+        p += run;
+
+        if (run < 16) {
+            ret = decode_step (N, mem, mem_size, &values[n], &p);
+            if (unlikely (ret != ret_OK)) {
+                *num      = n;
+                *consumed = p;
+                return ret;
+            }
+            n++;
+        }
+    }
+
+    ret = decode_batch_scalar (N, mem + p, mem_size - p, values + n, max_values - n, &used, &tail);
+
+    *num      = n + used;
+    *consumed = p + tail;
+    return ret;
+}
+
+#endif /* HAVE_SSE2 */
+
+#if defined(HAVE_AVX2)
+
+__attribute__((target("avx2")))
+static size_t
+encode_batch_avx2 (int             N,
+                   unsigned char   pattern,
+                   const uint32_t *values,
+                   size_t          num,
+                   unsigned char  *mem)
+{
+    __m256i             v, small, packed;
+    uint32_t            word;
+    unsigned int        run;
+    int                 mask;
+    size_t              i      = 0;
+    size_t              len    = 0;
+    const unsigned char limit  = limits[N];
+    __m256i             zero   = _mm256_setzero_si256();
+    __m256i             vlimit = _mm256_set1_epi32 (limit);
+    __m256i             vpat   = _mm256_set1_epi8 ((char)(pattern & ~limit));
+
+    while (i + 8 <= num) {
+        v      = _mm256_loadu_si256 ((const __m256i *)(values + i));
+        small  = _mm256_and_si256 (_mm256_cmpgt_epi32 (vlimit, v),
+                                   _mm256_cmpeq_epi32 (_mm256_srli_epi32 (v, 8), zero));
+
+        /* Packing works on 128 bits lanes: four octets land at the
+         * bottom of each */
+        packed = _mm256_packus_epi16 (_mm256_packs_epi32 (v, zero), zero);
+        packed = _mm256_or_si256 (packed, vpat);
+
+        word = (uint32_t) _mm_cvtsi128_si32 (_mm256_castsi256_si128 (packed));
+        memcpy (mem + len, &word, sizeof(word));
+        word = (uint32_t) _mm_cvtsi128_si32 (_mm256_extracti128_si256 (packed, 1));
+        memcpy (mem + len + 4, &word, sizeof(word));
+
+        mask = _mm256_movemask_ps (_mm256_castsi256_ps (small));
+
+        if (likely (mask == 0xFF)) {
+            len += 8;
+            i   += 8;
+            continue;
+        }
+
+        run  = __builtin_ctz (~mask);
+        len += run;
+        i   += run;
+        len += integer_encode_prefix (N, pattern, values[i++], mem + len);
+    }
+
+    return len + encode_batch_scalar (N, pattern, values + i, num - i, mem + len);
+}
+
+__attribute__((target("avx2")))
+static ret_t
+decode_batch_avx2 (int                  N,
+                   const unsigned char *mem,
+                   size_t               mem_size,
+                   uint32_t            *values,
+                   size_t               max_values,
+                   size_t              *num,
+                   size_t              *consumed)
+{
+    ret_t               ret;
+    __m256i             bytes;
+    __m128i             lo, hi;
+    uint64_t            full;
+    unsigned int        run;
+    unsigned int        width;
+    size_t              used, tail;
+    size_t              n      = 0;
+    size_t              p      = 0;
+    const unsigned char limit  = limits[N];
+    __m256i             vlimit = _mm256_set1_epi8 ((char)limit);
+
+    /* Windows are 32 octets wide while the runs of single octet
+     * integers are long, and 16 after a short one, so mixed input is
+     * not widened far past the next boundary. Only the groups of 8
+     * values covering the run are stored.
      */
-    *ret = mem[0] & limit;
+    width = 32;
+
+    while ((max_values - n >= 32) && (mem_size - p >= 32)) {
+        if (width == 32) {
+            bytes = _mm256_and_si256 (_mm256_loadu_si256 ((const __m256i *)(mem + p)), vlimit);
+            full  = (uint32_t) _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (bytes, vlimit));
+            lo    = _mm256_castsi256_si128 (bytes);
+            hi    = _mm256_extracti128_si256 (bytes, 1);
+        } else {
+            lo    = _mm_and_si128 (_mm_loadu_si128 ((const __m128i *)(mem + p)),
+                                   _mm256_castsi256_si128 (vlimit));
+            full  = (uint32_t) _mm_movemask_epi8 (_mm_cmpeq_epi8 (lo, _mm256_castsi256_si128 (vlimit)));
+            hi    = lo;
+        }
+
+        run = __builtin_ctzll (full | (1ULL << width));
+
+        if (run > 0) {
+            _mm256_storeu_si256 ((__m256i *)(values + n), _mm256_cvtepu8_epi32 (lo));
+        }
+        if (run > 8) {
+            _mm256_storeu_si256 ((__m256i *)(values + n + 8), _mm256_cvtepu8_epi32 (_mm_srli_si128 (lo, 8)));
+        }
+        if (run > 16) {
+            _mm256_storeu_si256 ((__m256i *)(values + n + 16), _mm256_cvtepu8_epi32 (hi));
+        }
+        if (run > 24) {
+            _mm256_storeu_si256 ((__m256i *)(values + n + 24), _mm256_cvtepu8_epi32 (_mm_srli_si128 (hi, 8)));
+        }
+
+        n += run;
+        p += run;
+
+        if (run < width) {
+            ret = decode_step (N, mem, mem_size, &values[n], &p);
+            if (unlikely (ret != ret_OK)) {
+                *num      = n;
+                *consumed = p;
+                _mm256_zeroupper ();
+                return ret;
+            }
+            n++;
+        }
+
+        width = (run >= 16) ? 32 : 16;
+    }
+
+    _mm256_zeroupper ();
+    ret = decode_batch_scalar (N, mem + p, mem_size - p, values + n, max_values - n, &used, &tail);
+
+    *num      = n + used;
+    *consumed = p + tail;
+    return ret;
+}
+
+#endif /* HAVE_AVX2 */
+
+/** Select the batch codecs implementation
+ *
+ * SSE2 is picked on the first use of the batch codecs where it is
+ * available. AVX2 is only ahead on blocks made of single octet
+ * integers, and falls behind as soon as larger ones are mixed in, so
+ * it has to be asked for. This overrides the choice.
+ *
+ * @param impl Implementation, or integer_impl_auto for the default one
+ * @retval ret_OK        The implementation is in use
+ * @retval ret_not_found Not supported by this build or CPU
+ */
+ret_t
+integer_set_impl (integer_impl_t impl)
+{
+    switch (impl) {
+    case integer_impl_auto:
+#if defined(HAVE_SSE2)
+        return integer_set_impl (integer_impl_sse2);
+#else
+        return integer_set_impl (integer_impl_scalar);
+#endif
+
+    case integer_impl_scalar:
+        encode_batch_func = encode_batch_scalar;
+        decode_batch_func = decode_batch_scalar;
+        return ret_OK;
 
-    for (int i=1; i < mem_len; i++) {
-        *ret += (mem[i]%128) * pow(128, i-1);
+#if defined(HAVE_SSE2)
+    case integer_impl_sse2:
+        encode_batch_func = encode_batch_sse2;
+        decode_batch_func = decode_batch_sse2;
+        return ret_OK;
+#endif
+
+#if defined(HAVE_AVX2)
+    case integer_impl_avx2:
+        if (! __builtin_cpu_supports ("avx2"))
+            return ret_not_found;
+
+        encode_batch_func = encode_batch_avx2;
+        decode_batch_func = decode_batch_avx2;
+        return ret_OK;
+#endif
+
+    default:
+        return ret_not_found;
+    }
+}
+
+/** Batch integer encoding
+ *
+ * Encodes a run of integers, back to back. Same output as calling
+ * integer_encode() on each with the first octet preset to @pattern.
+ *
+ * @param      N        Number of bits of the prefixes
+ * @param      pattern  Bits above the prefix of every first octet
+ * @param      values   Numbers to encode
+ * @param      num      Number of @values
+ * @param[out] mem      Memory to encode them to, INTEGER_MAX_LEN * @num bytes at most
+ * @param[out] mem_len  Total amount of memory used
+ * @retval ret_OK Always
+ */
+ret_t
+integer_encode_batch (int             N,
+                      unsigned char   pattern,
+                      const uint32_t *values,
+                      size_t          num,
+                      unsigned char  *mem,
+                      size_t         *mem_len)
+{
+    if (unlikely (encode_batch_func == NULL)) {
+        integer_set_impl (integer_impl_auto);
     }
 
+    *mem_len = encode_batch_func (N, pattern, values, num, mem);
     return ret_OK;
 }
+
+/** Batch integer decoding
+ *
+ * Decodes a run of integers laid back to back, until @max_values are
+ * decoded or the memory is exhausted. Same results as calling
+ * integer_decode_bounded() on each in turn.
+ *
+ * @param      N          Number of bits of the prefixes
+ * @param      mem        Memory to read
+ * @param      mem_size   Number of readable bytes at @mem
+ * @param[out] values     Decoded numbers
+ * @param      max_values Room in @values
+ * @param[out] num        Number of integers decoded
+ * @param[out] consumed   Number of bytes they take
+ * @retval ret_OK     Done
+ * @retval ret_eagain The last representation continues past @mem_size
+ * @retval ret_ERROR  A number does not fit in 32 bits. @num and @consumed
+ *                    cover the integers before it.
+ */
+ret_t
+integer_decode_batch (int                  N,
+                      const unsigned char *mem,
+                      size_t               mem_size,
+                      uint32_t            *values,
+                      size_t               max_values,
+                      size_t              *num,
+                      size_t              *consumed)
+{
+    if (unlikely (decode_batch_func == NULL)) {
+        integer_set_impl (integer_impl_auto);
+    }
+
+    return decode_batch_func (N, mem, mem_size, values, max_values, num, consumed);
+}
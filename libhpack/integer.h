@@ -34,6 +34,8 @@
 #define LIBHPACK_INTEGER_H
 
 #include <libhpack/common.h>
+#include <stddef.h>
+#include <stdint.h>
 
 ret_t
 integer_encode (int            N,        /* Prefix length in bits  */
@@ -47,4 +49,132 @@ integer_decode (int            N,         /* Prefix length in bits  */
                 unsigned char  mem_len,   /* Length of the memory   */
                 int           *ret);      /* Value return           */
 
+ret_t
+integer_decode_bounded (int                  N,         /* Prefix length in bits  */
+                        const unsigned char *mem,       /* Memory to read         */
+                        size_t               mem_size,  /* Readable memory        */
+                        uint32_t            *ret,       /* Value return           */
+                        size_t              *consumed); /* Memory used            */
+
+#define INTEGER_MAX_LEN    6  /* Longest representation of a 32 bits number */
+#define INTEGER_MAX_LEN_64 11 /* Longest representation of a 64 bits number */
+
+/* 64 bits codec, with explicit bounds
+ */
+ret_t
+integer_encode_64 (int            N,          /* Prefix length in bits  */
+                   unsigned char  pattern,    /* Bits above the prefix  */
+                   uint64_t       value,      /* Number to encode       */
+                   unsigned char *mem,        /* Memory to encode it to */
+                   size_t         mem_size,   /* Capacity of the memory */
+                   size_t        *written);   /* Memory used            */
+
+ret_t
+integer_decode_64 (int                  N,          /* Prefix length in bits  */
+                   const unsigned char *mem,        /* Memory to read         */
+                   size_t               mem_size,   /* Readable memory        */
+                   uint64_t            *ret,        /* Value return           */
+                   size_t              *consumed);  /* Memory used            */
+
+/* Prefix specialized codecs
+ *
+ * Inline versions of integer_encode() and integer_decode_bounded() for
+ * callers that know N at compile time: the prefix mask is a constant
+ * and single octet numbers never leave the caller. integer_encode_N()
+ * and integer_decode_N() fix N for the prefixes HPACK uses [5.1.].
+ */
+static inline size_t
+integer_encode_prefix (int            N,        /* Prefix length in bits  */
+                       unsigned char  pattern,  /* Bits above the prefix  */
+                       uint32_t       value,    /* Number to encode       */
+                       unsigned char *mem)      /* Memory to encode it to */
+{
+    size_t              i     = 1;
+    const unsigned char limit = (unsigned char)((1u << N) - 1);
+
+    if (value < limit) {
+        mem[0] = (pattern & ~limit) | (unsigned char)value;
+        return 1;
+    }
+
+    mem[0] = pattern | limit;
+    value -= limit;
+
+    while (value >= 128) {
+        mem[i++] = 0x80 | (value & 0x7F);
+        value >>= 7;
+    }
+
+    mem[i++] = (unsigned char)value;
+    return i;
+}
+
+static inline ret_t
+integer_decode_prefix (int                  N,         /* Prefix length in bits  */
+                       const unsigned char *mem,       /* Memory to read         */
+                       size_t               mem_size,  /* Readable memory        */
+                       uint32_t            *ret,       /* Value return           */
+                       size_t              *consumed)  /* Memory used            */
+{
+    const unsigned char limit = (unsigned char)((1u << N) - 1);
+
+    if ((mem_size > 0) && ((mem[0] & limit) != limit)) {
+        *ret      = mem[0] & limit;
+        *consumed = 1;
+        return ret_OK;
+    }
+
+    return integer_decode_bounded (N, mem, mem_size, ret, consumed);
+}
+
+#define INTEGER_SPECIALIZE(N)                                               \
+    static inline size_t                                                    \
+    integer_encode_ ## N (unsigned char pattern, uint32_t value,            \
+                          unsigned char *mem)                               \
+    {                                                                       \
+        return integer_encode_prefix (N, pattern, value, mem);              \
+    }                                                                       \
+                                                                            \
+    static inline ret_t                                                     \
+    integer_decode_ ## N (const unsigned char *mem, size_t mem_size,        \
+                          uint32_t *ret, size_t *consumed)                  \
+    {                                                                       \
+        return integer_decode_prefix (N, mem, mem_size, ret, consumed);     \
+    }
+
+INTEGER_SPECIALIZE(4)
+INTEGER_SPECIALIZE(5)
+INTEGER_SPECIALIZE(6)
+INTEGER_SPECIALIZE(7)
+INTEGER_SPECIALIZE(8)
+
+/* Batch codecs
+ */
+typedef enum {
+    integer_impl_auto,
+    integer_impl_scalar,
+    integer_impl_sse2,
+    integer_impl_avx2
+} integer_impl_t;
+
+ret_t
+integer_set_impl (integer_impl_t impl);
+
+ret_t
+integer_encode_batch (int             N,         /* Prefix length in bits     */
+                      unsigned char   pattern,   /* Bits above the prefixes   */
+                      const uint32_t *values,    /* Numbers to encode         */
+                      size_t          num,       /* Number of values          */
+                      unsigned char  *mem,       /* Memory to encode them to  */
+                      size_t         *mem_len);  /* Memory used               */
+
+ret_t
+integer_decode_batch (int                  N,           /* Prefix length in bits  */
+                      const unsigned char *mem,         /* Memory to read         */
+                      size_t               mem_size,    /* Readable memory        */
+                      uint32_t            *values,      /* Values return          */
+                      size_t               max_values,  /* Room in values         */
+                      size_t              *num,         /* Values decoded         */
+                      size_t              *consumed);   /* Memory used            */
+
 #endif /* LIBHPACK_INTEGER_H */
@@ -0,0 +1,629 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Current ref:
+ * http://tools.ietf.org/html/rfc7541
+ */
+
+#include "literal.h"
+#include "hash.h"
+#include "simd.h"
+
+#include <libchula/macros.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Octets allowed in a header name: lowercase token characters
+ */
+static const uint8_t name_chars[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 1, 0, 1, 1, 1, 1, 1, 0, 0, 1, 1, 0, 1, 1, 0,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 0, 1, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+#define is_upper(c) (((c) >= 'A') && ((c) <= 'Z'))
+
+/* One octet of a name, lowercased first if @lower. Returns false if
+ * it is not allowed at position @pos.
+ */
+static inline bool
+name_octet (char *dst, unsigned char c, size_t pos, bool lower)
+{
+    if (lower && is_upper (c)) {
+        c += 'a' - 'A';
+    }
+
+    if (dst != NULL) {
+        *dst = c;
+    }
+
+    return name_chars[c] || ((c == ':') && (pos == 0));
+}
+
+/* Field values must not carry NUL, CR or LF [RFC 7540, 10.3.]
+ */
+#define value_octet(c) (((c) != '\0') && ((c) != '\r') && ((c) != '\n'))
+
+/* Kernels. @dst is NULL to only check. Every octet is read once and,
+ * when copying, written once.
+ */
+typedef ret_t (*name_func_t)  (char *dst, const char *name, size_t len, size_t offset, bool lower);
+typedef ret_t (*value_func_t) (char *dst, const char *value, size_t len);
+
+static name_func_t  name_func  = NULL;
+static value_func_t value_func = NULL;
+
+static ret_t
+name_scalar (char       *dst,
+             const char *name,
+             size_t      len,
+             size_t      offset,
+             bool        lower)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        if (unlikely (! name_octet ((dst != NULL) ? dst + i : NULL, name[i], offset + i, lower)))
+            return ret_error;
+    }
+
+    return ret_ok;
+}
+
+static ret_t
+value_scalar (char       *dst,
+              const char *value,
+              size_t      len)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        if (unlikely (! value_octet (value[i])))
+            return ret_error;
+
+        if (dst != NULL) {
+            dst[i] = value[i];
+        }
+    }
+
+    return ret_ok;
+}
+
+#if defined(HAVE_SSE2)
+
+/* Whether a word has a NUL, CR or LF octet. The zero octet test has no
+ * false positives once an octet is found.
+ */
+#define ONES        0x0101010101010101ULL
+#define HIGHS       0x8080808080808080ULL
+#define has_zero(x) (((x) - ONES) & ~(x) & HIGHS)
+
+static inline bool
+value_word (uint64_t w)
+{
+    return ! (has_zero (w) | has_zero (w ^ (ONES * '\r')) | has_zero (w ^ (ONES * '\n')));
+}
+
+/* Values shorter than a vector: two overlapping words cover 8 to 16
+ * octets.
+ */
+static inline ret_t
+value_short (char       *dst,
+             const char *value,
+             size_t      len)
+{
+    uint64_t w1, w2;
+
+    if (len < 8) {
+        return value_scalar (dst, value, len);
+    }
+
+    memcpy (&w1, value, 8);
+    memcpy (&w2, value + len - 8, 8);
+
+    if (unlikely (! (value_word (w1) && value_word (w2))))
+        return ret_error;
+
+    if (dst != NULL) {
+        memcpy (dst, &w1, 8);
+        memcpy (dst + len - 8, &w2, 8);
+    }
+
+    return ret_ok;
+}
+
+#endif /* HAVE_SSE2 */
+
+#if defined(HAVE_SSE2)
+
+/* Sixteen octets at a time. A block made only of lowercase letters,
+ * digits and dashes, the bulk of real names, passes with a few
+ * compares; any other block is handed back to the scalar loop. Octets
+ * past 0x7F compare as negative, so they never pass.
+ */
+static inline bool
+common_block (__m128i x)
+{
+    __m128i lower = _mm_and_si128 (_mm_cmpgt_epi8 (x, _mm_set1_epi8 ('a' - 1)),
+                                   _mm_cmplt_epi8 (x, _mm_set1_epi8 ('z' + 1)));
+    __m128i digit = _mm_and_si128 (_mm_cmpgt_epi8 (x, _mm_set1_epi8 ('0' - 1)),
+                                   _mm_cmplt_epi8 (x, _mm_set1_epi8 ('9' + 1)));
+    __m128i dash  = _mm_cmpeq_epi8 (x, _mm_set1_epi8 ('-'));
+
+    return _mm_movemask_epi8 (_mm_or_si128 (_mm_or_si128 (lower, digit), dash)) == 0xFFFF;
+}
+
+static inline __m128i
+to_lower_block (__m128i x)
+{
+    __m128i upper = _mm_and_si128 (_mm_cmpgt_epi8 (x, _mm_set1_epi8 ('A' - 1)),
+                                   _mm_cmplt_epi8 (x, _mm_set1_epi8 ('Z' + 1)));
+
+    return _mm_add_epi8 (x, _mm_and_si128 (upper, _mm_set1_epi8 ('a' - 'A')));
+}
+
+static inline bool
+value_block (__m128i x)
+{
+    __m128i bad = _mm_or_si128 (_mm_cmpeq_epi8 (x, _mm_setzero_si128 ()),
+                                _mm_or_si128 (_mm_cmpeq_epi8 (x, _mm_set1_epi8 ('\r')),
+                                              _mm_cmpeq_epi8 (x, _mm_set1_epi8 ('\n'))));
+
+    return _mm_movemask_epi8 (bad) == 0;
+}
+
+static inline ret_t
+name_block_sse2 (char       *dst,
+                 const char *name,
+                 size_t      pos,
+                 size_t      offset,
+                 bool        lower)
+{
+    __m128i x = _mm_loadu_si128 ((const __m128i *)(name + pos));
+
+    if (lower) {
+        x = to_lower_block (x);
+    }
+
+    if (likely (common_block (x))) {
+        if (dst != NULL) {
+            _mm_storeu_si128 ((__m128i *)(dst + pos), x);
+        }
+        return ret_ok;
+    }
+
+    return name_scalar ((dst != NULL) ? dst + pos : NULL, name + pos, 16, offset + pos, lower);
+}
+
+/* Strings of a vector or more end with a block overlapping the
+ * previous one, rather than with a loop over the last octets.
+ */
+static ret_t
+name_sse2 (char       *dst,
+           const char *name,
+           size_t      len,
+           size_t      offset,
+           bool        lower)
+{
+    size_t i;
+
+    if (len < 16) {
+        return name_scalar (dst, name, len, offset, lower);
+    }
+
+    for (i = 0; i + 16 <= len; i += 16) {
+        if (unlikely (name_block_sse2 (dst, name, i, offset, lower) != ret_ok))
+            return ret_error;
+    }
+
+    if (i < len) {
+        return name_block_sse2 (dst, name, len - 16, offset, lower);
+    }
+
+    return ret_ok;
+}
+
+static inline ret_t
+value_block_sse2 (char       *dst,
+                  const char *value,
+                  size_t      pos)
+{
+    __m128i x = _mm_loadu_si128 ((const __m128i *)(value + pos));
+
+    if (unlikely (! value_block (x)))
+        return ret_error;
+
+    if (dst != NULL) {
+        _mm_storeu_si128 ((__m128i *)(dst + pos), x);
+    }
+
+    return ret_ok;
+}
+
+static ret_t
+value_sse2 (char       *dst,
+            const char *value,
+            size_t      len)
+{
+    size_t i;
+
+    if (len < 16) {
+        return value_short (dst, value, len);
+    }
+
+    for (i = 0; i + 16 <= len; i += 16) {
+        if (unlikely (value_block_sse2 (dst, value, i) != ret_ok))
+            return ret_error;
+    }
+
+    if (i < len) {
+        return value_block_sse2 (dst, value, len - 16);
+    }
+
+    return ret_ok;
+}
+
+#endif /* HAVE_SSE2 */
+
+#if defined(HAVE_AVX2)
+
+/* Same, thirty-two octets at a time. Strings shorter than that are
+ * handed over to the SSE2 kernels, once the upper halves of the
+ * registers are cleared so their legacy encoded instructions do not
+ * pay for the transition.
+ */
+__attribute__((target("avx2")))
+static inline ret_t
+name_block_avx2 (char       *dst,
+                 const char *name,
+                 size_t      pos,
+                 size_t      offset,
+                 bool        lower)
+{
+    __m256i x = _mm256_loadu_si256 ((const __m256i *)(name + pos));
+    __m256i ok;
+
+    if (lower) {
+        __m256i upper = _mm256_and_si256 (_mm256_cmpgt_epi8 (x, _mm256_set1_epi8 ('A' - 1)),
+                                          _mm256_cmpgt_epi8 (_mm256_set1_epi8 ('Z' + 1), x));
+        x = _mm256_add_epi8 (x, _mm256_and_si256 (upper, _mm256_set1_epi8 ('a' - 'A')));
+    }
+
+    ok = _mm256_or_si256 (
+        _mm256_or_si256 (_mm256_and_si256 (_mm256_cmpgt_epi8 (x, _mm256_set1_epi8 ('a' - 1)),
+                                           _mm256_cmpgt_epi8 (_mm256_set1_epi8 ('z' + 1), x)),
+                         _mm256_and_si256 (_mm256_cmpgt_epi8 (x, _mm256_set1_epi8 ('0' - 1)),
+                                           _mm256_cmpgt_epi8 (_mm256_set1_epi8 ('9' + 1), x))),
+        _mm256_cmpeq_epi8 (x, _mm256_set1_epi8 ('-')));
+
+    if (likely (_mm256_movemask_epi8 (ok) == -1)) {
+        if (dst != NULL) {
+            _mm256_storeu_si256 ((__m256i *)(dst + pos), x);
+        }
+        return ret_ok;
+    }
+
+    return name_scalar ((dst != NULL) ? dst + pos : NULL, name + pos, 32, offset + pos, lower);
+}
+
+__attribute__((target("avx2")))
+static ret_t
+name_avx2 (char       *dst,
+           const char *name,
+           size_t      len,
+           size_t      offset,
+           bool        lower)
+{
+    ret_t  ret = ret_ok;
+    size_t i;
+
+    if (len < 32) {
+        return name_sse2 (dst, name, len, offset, lower);
+    }
+
+    for (i = 0; i + 32 <= len; i += 32) {
+        ret = name_block_avx2 (dst, name, i, offset, lower);
+        if (unlikely (ret != ret_ok))
+            break;
+    }
+
+    if ((ret == ret_ok) && (i < len)) {
+        ret = name_block_avx2 (dst, name, len - 32, offset, lower);
+    }
+
+    _mm256_zeroupper ();
+    return ret;
+}
+
+__attribute__((target("avx2")))
+static inline ret_t
+value_block_avx2 (char       *dst,
+                  const char *value,
+                  size_t      pos)
+{
+    __m256i x   = _mm256_loadu_si256 ((const __m256i *)(value + pos));
+    __m256i bad = _mm256_or_si256 (_mm256_cmpeq_epi8 (x, _mm256_setzero_si256 ()),
+                                   _mm256_or_si256 (_mm256_cmpeq_epi8 (x, _mm256_set1_epi8 ('\r')),
+                                                    _mm256_cmpeq_epi8 (x, _mm256_set1_epi8 ('\n'))));
+
+    if (unlikely (_mm256_movemask_epi8 (bad) != 0))
+        return ret_error;
+
+    if (dst != NULL) {
+        _mm256_storeu_si256 ((__m256i *)(dst + pos), x);
+    }
+
+    return ret_ok;
+}
+
+__attribute__((target("avx2")))
+static ret_t
+value_avx2 (char       *dst,
+            const char *value,
+            size_t      len)
+{
+    ret_t  ret = ret_ok;
+    size_t i;
+
+    if (len < 32) {
+        return value_sse2 (dst, value, len);
+    }
+
+    for (i = 0; i + 32 <= len; i += 32) {
+        ret = value_block_avx2 (dst, value, i);
+        if (unlikely (ret != ret_ok))
+            break;
+    }
+
+    if ((ret == ret_ok) && (i < len)) {
+        ret = value_block_avx2 (dst, value, len - 32);
+    }
+
+    _mm256_zeroupper ();
+    return ret;
+}
+
+#endif /* HAVE_AVX2 */
+
+/** Select the literal kernels implementation
+ *
+ * SSE2 is picked on the first use where it is available. Header names
+ * and values are mostly shorter than 32 octets, which the AVX2 kernels
+ * hand over to SSE2 anyway, so they only pay off on long literals and
+ * have to be asked for. This overrides the choice.
+ *
+ * @param impl Implementation, or hpack_literal_impl_auto for the default one
+ * @retval ret_ok        The implementation is in use
+ * @retval ret_not_found Not supported by this build or CPU
+ */
+ret_t
+hpack_literal_set_impl (hpack_literal_impl_t impl)
+{
+    switch (impl) {
+    case hpack_literal_impl_auto:
+#if defined(HAVE_SSE2)
+        return hpack_literal_set_impl (hpack_literal_impl_sse2);
+#else
+        return hpack_literal_set_impl (hpack_literal_impl_scalar);
+#endif
+
+    case hpack_literal_impl_scalar:
+        name_func  = name_scalar;
+        value_func = value_scalar;
+        return ret_ok;
+
+#if defined(HAVE_SSE2)
+    case hpack_literal_impl_sse2:
+        name_func  = name_sse2;
+        value_func = value_sse2;
+        return ret_ok;
+#endif
+
+#if defined(HAVE_AVX2)
+    case hpack_literal_impl_avx2:
+        if (! __builtin_cpu_supports ("avx2"))
+            return ret_not_found;
+
+        name_func  = name_avx2;
+        value_func = value_avx2;
+        return ret_ok;
+#endif
+
+    default:
+        return ret_not_found;
+    }
+}
+
+static inline ret_t
+scan_name (char       *dst,
+           const char *name,
+           size_t      len,
+           size_t      offset,
+           bool        lower)
+{
+    if (unlikely (name_func == NULL)) {
+        hpack_literal_set_impl (hpack_literal_impl_auto);
+    }
+
+    return name_func (dst, name, len, offset, lower);
+}
+
+static inline ret_t
+scan_value (char       *dst,
+            const char *value,
+            size_t      len)
+{
+    if (unlikely (value_func == NULL)) {
+        hpack_literal_set_impl (hpack_literal_impl_auto);
+    }
+
+    return value_func (dst, value, len);
+}
+
+/** Check a header name
+ *
+ * @param name   Octets of the name
+ * @param len    Number of octets
+ * @param offset Position of @name within the whole name
+ * @retval ret_ok    The octets are valid
+ * @retval ret_error An octet is not allowed in an HTTP/2 name
+ */
+ret_t
+hpack_literal_check_name (const char *name,
+                          size_t      len,
+                          size_t      offset)
+{
+    return scan_name (NULL, name, len, offset, false);
+}
+
+/** Copy and check a header name
+ *
+ * Same as hpack_literal_check_name(), copying the octets to @dst in
+ * the same pass. @dst must have room for @len octets; its contents are
+ * undefined on error.
+ *
+ * @param[out] dst    Memory to copy the name to
+ * @param      name   Octets of the name
+ * @param      len    Number of octets
+ * @param      offset Position of @name within the whole name
+ * @retval ret_ok    The octets are valid
+ * @retval ret_error An octet is not allowed in an HTTP/2 name
+ */
+ret_t
+hpack_literal_copy_name (char       *dst,
+                         const char *name,
+                         size_t      len,
+                         size_t      offset)
+{
+    return scan_name (dst, name, len, offset, false);
+}
+
+/** Lowercase and check a header name
+ *
+ * Translates an HTTP/1.1 name, which is case insensitive, to its
+ * HTTP/2 form while checking it, in a single pass. @dst must have
+ * room for @len octets.
+ *
+ * @param[out] dst  Memory to copy the lowercased name to
+ * @param      name Octets of the whole name
+ * @param      len  Number of octets
+ * @retval ret_ok    The name is valid once lowercased
+ * @retval ret_error An octet is not allowed in a name
+ */
+ret_t
+hpack_literal_lower_name (char       *dst,
+                          const char *name,
+                          size_t      len)
+{
+    return scan_name (dst, name, len, 0, true);
+}
+
+/** Lowercase, check and hash a header name
+ *
+ * Same as hpack_literal_lower_name(), hashing the lowercased octets as
+ * hpack_hash() does in the same pass. The hash takes an octet at a
+ * time, so this is the scalar kernel with the hash step folded in.
+ *
+ * @param[out]    dst  Memory to copy the lowercased name to
+ * @param         name Octets of the whole name
+ * @param         len  Number of octets
+ * @param[in,out] hash Seed of the hash, and the hash of the name
+ * @retval ret_ok    The name is valid once lowercased
+ * @retval ret_error An octet is not allowed in a name
+ */
+ret_t
+hpack_literal_lower_name_hash (char       *dst,
+                               const char *name,
+                               size_t      len,
+                               uint32_t   *hash)
+{
+    size_t   i;
+    uint32_t h = *hash;
+
+    for (i = 0; i < len; i++) {
+        if (unlikely (! name_octet (dst + i, name[i], i, true)))
+            return ret_error;
+
+        h ^= (unsigned char) dst[i];
+        h *= HPACK_HASH_PRIME;
+    }
+
+    *hash = h;
+    return ret_ok;
+}
+
+/** Check a header value
+ *
+ * @param value Octets of the value, or of a piece of it
+ * @param len   Number of octets
+ * @retval ret_ok    The octets are valid
+ * @retval ret_error The value carries NUL, CR or LF
+ */
+ret_t
+hpack_literal_check_value (const char *value,
+                           size_t      len)
+{
+    return scan_value (NULL, value, len);
+}
+
+/** Copy and check a header value
+ *
+ * Same as hpack_literal_check_value(), copying the octets to @dst in
+ * the same pass. @dst must have room for @len octets; its contents
+ * are undefined on error.
+ *
+ * @param[out] dst   Memory to copy the value to
+ * @param      value Octets of the value, or of a piece of it
+ * @param      len   Number of octets
+ * @retval ret_ok    The octets are valid
+ * @retval ret_error The value carries NUL, CR or LF
+ */
+ret_t
+hpack_literal_copy_value (char       *dst,
+                          const char *value,
+                          size_t      len)
+{
+    return scan_value (dst, value, len);
+}
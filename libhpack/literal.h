@@ -0,0 +1,85 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBHPACK_LITERAL_H
+#define LIBHPACK_LITERAL_H
+
+#include <libhpack/common.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Header name octets
+ *
+ * HTTP/2 field names are tokens [RFC 7230, 3.2.6.] with no uppercase
+ * characters [RFC 7540, 8.1.2.]; pseudo-header names start with a
+ * colon. @offset is the position of @name within the whole name, so a
+ * name can be checked as it arrives in pieces.
+ */
+ret_t hpack_literal_check_name (const char *name,
+                                size_t      len,
+                                size_t      offset);
+
+ret_t hpack_literal_copy_name  (char       *dst,
+                                const char *name,
+                                size_t      len,
+                                size_t      offset);
+
+ret_t hpack_literal_lower_name (char       *dst,
+                                const char *name,
+                                size_t      len);
+
+ret_t hpack_literal_lower_name_hash (char       *dst,
+                                     const char *name,
+                                     size_t      len,
+                                     uint32_t   *hash);
+
+/* Header value octets: anything but NUL, CR and LF [RFC 7540, 10.3.]
+ */
+ret_t hpack_literal_check_value (const char *value,
+                                 size_t      len);
+
+ret_t hpack_literal_copy_value  (char       *dst,
+                                 const char *value,
+                                 size_t      len);
+
+/* Kernels implementation
+ */
+typedef enum {
+    hpack_literal_impl_auto,
+    hpack_literal_impl_scalar,
+    hpack_literal_impl_sse2,
+    hpack_literal_impl_avx2
+} hpack_literal_impl_t;
+
+ret_t hpack_literal_set_impl (hpack_literal_impl_t impl);
+
+#endif /* LIBHPACK_LITERAL_H */
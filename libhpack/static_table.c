@@ -0,0 +1,168 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "static_table.h"
+#include "hash.h"
+
+#include <libchula/macros.h>
+#include <string.h>
+
+/* Static table and its hash tables, generated by gen-static-table.py
+ */
+#include "static_table_data.h"
+
+#define SLOT_BITS 8
+
+static inline bool
+entry_is (cuint_t         n,
+          chula_buffer_t *name,
+          chula_buffer_t *value)
+{
+    const hpack_static_entry_t *e = &hpack_static_table[n - 1];
+
+    if ((e->name_len != name->len) ||
+        (memcmp (e->name, name->buf, name->len) != 0))
+        return false;
+
+    if (value == NULL)
+        return true;
+
+    return ((e->value_len == value->len) &&
+            (memcmp (e->value, value->buf, value->len) == 0));
+}
+
+/** Find a header field in the static table
+ *
+ * Looks up a name/value pair in the static table. Both the pair and
+ * the name are found through a perfect hash, so a lookup costs a hash
+ * and a comparison of the candidate entry.
+ *
+ * @param      name        Name of the header field
+ * @param      value       Value of the header field, or NULL to look up the name only
+ * @param[out] index       Index of the entry in the static table
+ * @param[out] value_match Whether the value of the entry matches as well
+ * @retval ret_ok        An entry was found
+ * @retval ret_not_found No entry has that name
+ */
+ret_t
+hpack_static_table_find (chula_buffer_t *name,
+                         chula_buffer_t *value,
+                         cuint_t        *index,
+                         bool           *value_match)
+{
+    uint32_t hash;
+
+    hash = hpack_hash (name->buf, name->len, HPACK_HASH_INIT);
+
+    return hpack_static_table_find_hashed (name, value, hash,
+                                           (value != NULL) ? hpack_hash (value->buf, value->len, hash) : 0,
+                                           index, value_match);
+}
+
+/** Find a header field in the static table, given its hashes
+ *
+ * Same as hpack_static_table_find(), for callers that already hashed
+ * the field with hpack_hash(): @name_hash from HPACK_HASH_INIT, and
+ * @pair_hash of the value from @name_hash. @pair_hash is ignored when
+ * @value is NULL.
+ */
+ret_t
+hpack_static_table_find_hashed (chula_buffer_t *name,
+                                chula_buffer_t *value,
+                                uint32_t        name_hash,
+                                uint32_t        pair_hash,
+                                cuint_t        *index,
+                                bool           *value_match)
+{
+    cuint_t n;
+
+    /* Name and value
+     */
+    if (value != NULL) {
+        n = pair_slots[HPACK_HASH_SLOT (pair_hash, PAIR_SEED, SLOT_BITS)];
+        if ((n != 0) && entry_is (n, name, value)) {
+            *index       = n;
+            *value_match = true;
+            return ret_ok;
+        }
+    }
+
+    /* Name
+     */
+    n = name_slots[HPACK_HASH_SLOT (name_hash, NAME_SEED, SLOT_BITS)];
+    if ((n != 0) && entry_is (n, name, NULL)) {
+        *index       = n;
+        *value_match = false;
+        return ret_ok;
+    }
+
+    return ret_not_found;
+}
+
+/** Name ID of a header table index
+ *
+ * @param index Index in the static table
+ * @return The ID of the name of the entry, or hpack_header_id_unknown
+ *         if @index is not in the static table
+ */
+hpack_header_id_t
+hpack_static_table_get_id (cuint_t index)
+{
+    if (unlikely ((index == 0) || (index > HPACK_STATIC_TABLE_LEN))) {
+        return hpack_header_id_unknown;
+    }
+
+    return (hpack_header_id_t) name_ids[index];
+}
+
+/** Name ID of a header name
+ *
+ * Looks a name up in the static table through its perfect hash. The
+ * slot of a name holds its lowest index, which is its ID.
+ *
+ * @param name      Header name
+ * @param name_hash hpack_hash() of @name from HPACK_HASH_INIT
+ * @return The ID of @name, or hpack_header_id_unknown
+ */
+hpack_header_id_t
+hpack_static_table_find_id (chula_buffer_t *name,
+                            uint32_t        name_hash)
+{
+    cuint_t n;
+
+    n = name_slots[HPACK_HASH_SLOT (name_hash, NAME_SEED, SLOT_BITS)];
+    if ((n != 0) && entry_is (n, name, NULL)) {
+        return (hpack_header_id_t) n;
+    }
+
+    return hpack_header_id_unknown;
+}
@@ -0,0 +1,127 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBHPACK_STATIC_TABLE_H
+#define LIBHPACK_STATIC_TABLE_H
+
+#include <libhpack/common.h>
+#include <libchula/buffer.h>
+
+/* Static table [Appendix A.]
+ */
+#define HPACK_STATIC_TABLE_LEN 61
+
+/* Header name IDs: the lowest static table index with the name, so
+ * fields can be dispatched on an integer. Names missing from the
+ * static table are hpack_header_id_unknown.
+ */
+typedef enum {
+    hpack_header_id_unknown                     =  0,  /**< Not in the static table     */
+    hpack_header_id_authority                   =  1,  /**< :authority                  */
+    hpack_header_id_method                      =  2,  /**< :method                     */
+    hpack_header_id_path                        =  4,  /**< :path                       */
+    hpack_header_id_scheme                      =  6,  /**< :scheme                     */
+    hpack_header_id_status                      =  8,  /**< :status                     */
+    hpack_header_id_accept_charset              = 15,  /**< accept-charset              */
+    hpack_header_id_accept_encoding             = 16,  /**< accept-encoding             */
+    hpack_header_id_accept_language             = 17,  /**< accept-language             */
+    hpack_header_id_accept_ranges               = 18,  /**< accept-ranges               */
+    hpack_header_id_accept                      = 19,  /**< accept                      */
+    hpack_header_id_access_control_allow_origin = 20,  /**< access-control-allow-origin */
+    hpack_header_id_age                         = 21,  /**< age                         */
+    hpack_header_id_allow                       = 22,  /**< allow                       */
+    hpack_header_id_authorization               = 23,  /**< authorization               */
+    hpack_header_id_cache_control               = 24,  /**< cache-control               */
+    hpack_header_id_content_disposition         = 25,  /**< content-disposition         */
+    hpack_header_id_content_encoding            = 26,  /**< content-encoding            */
+    hpack_header_id_content_language            = 27,  /**< content-language            */
+    hpack_header_id_content_length              = 28,  /**< content-length              */
+    hpack_header_id_content_location            = 29,  /**< content-location            */
+    hpack_header_id_content_range               = 30,  /**< content-range               */
+    hpack_header_id_content_type                = 31,  /**< content-type                */
+    hpack_header_id_cookie                      = 32,  /**< cookie                      */
+    hpack_header_id_date                        = 33,  /**< date                        */
+    hpack_header_id_etag                        = 34,  /**< etag                        */
+    hpack_header_id_expect                      = 35,  /**< expect                      */
+    hpack_header_id_expires                     = 36,  /**< expires                     */
+    hpack_header_id_from                        = 37,  /**< from                        */
+    hpack_header_id_host                        = 38,  /**< host                        */
+    hpack_header_id_if_match                    = 39,  /**< if-match                    */
+    hpack_header_id_if_modified_since           = 40,  /**< if-modified-since           */
+    hpack_header_id_if_none_match               = 41,  /**< if-none-match               */
+    hpack_header_id_if_range                    = 42,  /**< if-range                    */
+    hpack_header_id_if_unmodified_since         = 43,  /**< if-unmodified-since         */
+    hpack_header_id_last_modified               = 44,  /**< last-modified               */
+    hpack_header_id_link                        = 45,  /**< link                        */
+    hpack_header_id_location                    = 46,  /**< location                    */
+    hpack_header_id_max_forwards                = 47,  /**< max-forwards                */
+    hpack_header_id_proxy_authenticate          = 48,  /**< proxy-authenticate          */
+    hpack_header_id_proxy_authorization         = 49,  /**< proxy-authorization         */
+    hpack_header_id_range                       = 50,  /**< range                       */
+    hpack_header_id_referer                     = 51,  /**< referer                     */
+    hpack_header_id_refresh                     = 52,  /**< refresh                     */
+    hpack_header_id_retry_after                 = 53,  /**< retry-after                 */
+    hpack_header_id_server                      = 54,  /**< server                      */
+    hpack_header_id_set_cookie                  = 55,  /**< set-cookie                  */
+    hpack_header_id_strict_transport_security   = 56,  /**< strict-transport-security   */
+    hpack_header_id_transfer_encoding           = 57,  /**< transfer-encoding           */
+    hpack_header_id_user_agent                  = 58,  /**< user-agent                  */
+    hpack_header_id_vary                        = 59,  /**< vary                        */
+    hpack_header_id_via                         = 60,  /**< via                         */
+    hpack_header_id_www_authenticate            = 61   /**< www-authenticate            */
+} hpack_header_id_t;
+
+typedef struct {
+    const char *name;
+    cuint_t     name_len;
+    const char *value;
+    cuint_t     value_len;
+} hpack_static_entry_t;
+
+extern const hpack_static_entry_t hpack_static_table[HPACK_STATIC_TABLE_LEN];
+
+ret_t hpack_static_table_find        (chula_buffer_t *name,
+                                      chula_buffer_t *value,
+                                      cuint_t        *index,
+                                      bool           *value_match);
+ret_t hpack_static_table_find_hashed (chula_buffer_t *name,
+                                      chula_buffer_t *value,
+                                      uint32_t        name_hash,
+                                      uint32_t        pair_hash,
+                                      cuint_t        *index,
+                                      bool           *value_match);
+
+hpack_header_id_t hpack_static_table_get_id  (cuint_t         index);
+hpack_header_id_t hpack_static_table_find_id (chula_buffer_t *name,
+                                              uint32_t        name_hash);
+
+#endif /* LIBHPACK_STATIC_TABLE_H */
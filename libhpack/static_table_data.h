@@ -0,0 +1,133 @@
+/* Generated by gen-static-table.py. DO NOT EDIT. */
+
+#ifndef LIBHPACK_STATIC_TABLE_DATA_H
+#define LIBHPACK_STATIC_TABLE_DATA_H
+
+#define E(n,v) {n, sizeof(n)-1, v, sizeof(v)-1}
+
+/* Static table [Appendix A.]
+ */
+const hpack_static_entry_t hpack_static_table[HPACK_STATIC_TABLE_LEN] = {
+    E(":authority",                  ""),
+    E(":method",                     "GET"),
+    E(":method",                     "POST"),
+    E(":path",                       "/"),
+    E(":path",                       "/index.html"),
+    E(":scheme",                     "http"),
+    E(":scheme",                     "https"),
+    E(":status",                     "200"),
+    E(":status",                     "204"),
+    E(":status",                     "206"),
+    E(":status",                     "304"),
+    E(":status",                     "400"),
+    E(":status",                     "404"),
+    E(":status",                     "500"),
+    E("accept-charset",              ""),
+    E("accept-encoding",             "gzip, deflate"),
+    E("accept-language",             ""),
+    E("accept-ranges",               ""),
+    E("accept",                      ""),
+    E("access-control-allow-origin", ""),
+    E("age",                         ""),
+    E("allow",                       ""),
+    E("authorization",               ""),
+    E("cache-control",               ""),
+    E("content-disposition",         ""),
+    E("content-encoding",            ""),
+    E("content-language",            ""),
+    E("content-length",              ""),
+    E("content-location",            ""),
+    E("content-range",               ""),
+    E("content-type",                ""),
+    E("cookie",                      ""),
+    E("date",                        ""),
+    E("etag",                        ""),
+    E("expect",                      ""),
+    E("expires",                     ""),
+    E("from",                        ""),
+    E("host",                        ""),
+    E("if-match",                    ""),
+    E("if-modified-since",           ""),
+    E("if-none-match",               ""),
+    E("if-range",                    ""),
+    E("if-unmodified-since",         ""),
+    E("last-modified",               ""),
+    E("link",                        ""),
+    E("location",                    ""),
+    E("max-forwards",                ""),
+    E("proxy-authenticate",          ""),
+    E("proxy-authorization",         ""),
+    E("range",                       ""),
+    E("referer",                     ""),
+    E("refresh",                     ""),
+    E("retry-after",                 ""),
+    E("server",                      ""),
+    E("set-cookie",                  ""),
+    E("strict-transport-security",   ""),
+    E("transfer-encoding",           ""),
+    E("user-agent",                  ""),
+    E("vary",                        ""),
+    E("via",                         ""),
+    E("www-authenticate",            ""),
+};
+
+#undef E
+
+/* Name ID of every static index: the lowest index with the same name
+ */
+static const unsigned char name_ids[HPACK_STATIC_TABLE_LEN + 1] = {
+     0,  1,  2,  2,  4,  4,  6,  6,  8,  8,  8,  8,  8,  8,  8, 15,
+    16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31,
+    32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47,
+    48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61,
+};
+
+/* Perfect hash of the names. Slots hold the lowest static index
+ * with that name, or 0 if empty.
+ */
+#define NAME_SEED 0x000001aeu
+
+static const unsigned char name_slots[256] = {
+     0,  0,  0, 39,  0,  0,  0,  0,  0,  0, 55,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0, 36,  0,  0, 59,  0,  0, 52,  0,  0, 17,
+     0, 26,  0,  4,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 40,
+     0,  0,  0,  0,  0,  0,  0, 61,  0,  0,  0,  0,  0,  0,  0,  0,
+     0, 32,  0,  0,  2, 42,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    33,  0,  0, 24,  0,  0,  0,  0, 35,  0,  0, 18,  0,  0,  0, 30,
+     0,  0, 27,  0,  0, 57, 16, 58,  0,  0, 46, 20,  0,  0,  0,  0,
+     0,  0, 23,  0,  0,  0,  0,  0,  0,  0, 22,  0,  0,  0, 43,  0,
+     0,  0,  0,  0,  0,  8,  0,  0,  0,  0,  0,  0,  0,  0, 38,  0,
+    29, 56,  0,  0, 44,  0,  0,  0, 45, 19,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0, 54,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0, 60,  0,  0, 51,  0,  0,  0,  0,  0,  0,
+     0, 49, 41,  0,  0, 37,  0,  0,  0, 15,  0,  0,  0,  0, 25,  0,
+     0,  0,  0, 21,  0,  0, 34, 48, 31,  0, 47,  0,  0,  0,  1,  0,
+     0,  0, 50,  0,  0,  0,  0,  0,  0,  0,  0,  0, 53,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0, 28,  6,  0,  0,  0,  0,  0,  0,  0,
+};
+
+/* Perfect hash of the name/value pairs. Slots hold the static index
+ * of the entry, or 0 if empty.
+ */
+#define PAIR_SEED 0x00000394u
+
+static const unsigned char pair_slots[256] = {
+     2,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 36,  0,
+     0,  0,  0,  0,  0, 23,  0, 22,  0,  0,  0,  0,  0, 51,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 61,
+     0,  0,  0,  0, 55,  0,  0,  0,  0,  0,  0, 30,  0,  0,  0,  0,
+    48,  0, 49,  0,  0,  0,  0,  0,  0,  0,  0,  0, 21, 12,  0,  0,
+    17,  0,  0,  0,  0,  0, 34,  9,  0,  0, 43, 14, 20,  0,  0, 41,
+     0,  0, 26, 52,  0,  0,  0,  0,  0,  0, 25,  0,  0, 39, 31,  0,
+     0, 28, 27, 16,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  3, 10,  0,  0, 13,  0, 45, 19,  0,  0,  0,  0,  0,
+     0,  0,  8, 24,  0,  0,  7, 15, 59,  0,  0,  0,  6,  0, 56,  0,
+     0,  0,  0,  0,  0, 57,  0,  0,  0,  0,  0, 53,  0,  0,  0,  0,
+     0,  0,  0,  0,  0, 54,  0,  0,  0,  4,  0,  0,  0,  0,  5,  0,
+     0, 32,  0,  0,  0,  0, 60,  0,  0,  0, 33,  0,  0,  0,  0, 46,
+     0, 58,  0,  0,  0, 38,  0, 29,  0,  0,  0,  0,  0,  0,  0,  0,
+     0, 18,  0,  0,  0,  0, 11,  0, 42, 37, 47,  0,  0,  0,  0,  0,
+     0, 50,  0,  1, 35,  0,  0,  0,  0,  0,  0,  0,  0, 44, 40,  0,
+};
+
+#endif /* LIBHPACK_STATIC_TABLE_DATA_H */
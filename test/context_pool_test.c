@@ -0,0 +1,179 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "test.h"
+#include "libhpack/context_pool.h"
+
+static void
+add_field (chula_list_t *fields, const char *name, const char *value)
+{
+    hpack_header_field_t *field;
+
+    hpack_header_field_new (&field);
+    chula_buffer_add (&field->name,  name,  strlen(name));
+    chula_buffer_add (&field->value, value, strlen(value));
+    chula_list_add_tail (&field->entry, fields);
+}
+
+
+START_TEST (recycle)
+{
+    ret_t                   ret;
+    cuint_t                 consumed;
+    hpack_header_encoder_t *encoder;
+    hpack_header_encoder_t *recycled;
+    hpack_header_encoder_t  fresh;
+    hpack_header_parser_t  *parser;
+    hpack_header_parser_t  *reparser;
+    chula_list_t            fields  = LIST_HEAD_INIT(fields);
+    chula_list_t            decoded = LIST_HEAD_INIT(decoded);
+    chula_buffer_t          out1    = CHULA_BUF_INIT;
+    chula_buffer_t          out2    = CHULA_BUF_INIT;
+
+    add_field (&fields, ":authority", "www.example.com");
+    add_field (&fields, "x-custom", "value");
+
+    /* A connection leaves state behind */
+    ret = hpack_context_pool_get_encoder (&encoder);
+    ck_assert (ret == ret_ok);
+    ret = hpack_context_pool_get_parser (&parser);
+    ck_assert (ret == ret_ok);
+
+    hpack_header_encoder_set_lowercase (encoder, true);
+    hpack_header_encoder_set_max_size (encoder, HPACK_HEADER_TABLE_SIZE_DEFAULT);
+    hpack_header_encoder_all (encoder, &fields, &out1);
+    ck_assert (encoder->table.num == 2);
+
+    hpack_header_parser_set_validate (parser, true);
+    hpack_header_parser_all (parser, &out1, 0, &decoded, &consumed);
+    ck_assert (parser->table.num == 2);
+    hpack_header_field_list_free (&decoded);
+
+    hpack_context_pool_put_encoder (encoder);
+    hpack_context_pool_put_parser (parser);
+
+    /* The next one gets them back as new, with their memory */
+    ret = hpack_context_pool_get_encoder (&recycled);
+    ck_assert (ret == ret_ok);
+    ck_assert (recycled == encoder);
+    ck_assert (recycled->table.num == 0);
+    ck_assert (recycled->table.max_size == HPACK_HEADER_TABLE_SIZE_DEFAULT);
+    ck_assert (recycled->table.data != NULL);
+    ck_assert (recycled->index.pairs != NULL);
+    ck_assert (! recycled->lowercase);
+    ck_assert (! recycled->size_update);
+
+    ret = hpack_context_pool_get_parser (&reparser);
+    ck_assert (ret == ret_ok);
+    ck_assert (reparser == parser);
+    ck_assert (reparser->table.num == 0);
+    ck_assert (! reparser->validate);
+
+    /* And encode like a new encoder */
+    hpack_header_encoder_init (&fresh);
+
+    chula_buffer_clean (&out1);
+    hpack_header_encoder_all (recycled, &fields, &out1);
+    hpack_header_encoder_all (&fresh, &fields, &out2);
+    ck_assert (out1.len == out2.len);
+    ck_assert (memcmp (out1.buf, out2.buf, out1.len) == 0);
+
+    ret = hpack_header_parser_all (reparser, &out1, 0, &decoded, &consumed);
+    ck_assert (ret == ret_ok);
+    ck_assert (consumed == out1.len);
+    ck_assert (reparser->table.num == 2);
+
+    hpack_header_field_list_free (&decoded);
+    hpack_header_field_list_free (&fields);
+    hpack_header_encoder_mrproper (&fresh);
+    chula_buffer_mrproper (&out1);
+    chula_buffer_mrproper (&out2);
+
+    hpack_context_pool_put_encoder (recycled);
+    hpack_context_pool_put_parser (reparser);
+    hpack_context_pool_flush ();
+}
+END_TEST
+
+START_TEST (limits)
+{
+    hpack_header_encoder_t      *enc1;
+    hpack_header_encoder_t      *enc2;
+    hpack_header_encoder_t      *enc3;
+    chula_list_t                 fields = LIST_HEAD_INIT(fields);
+    chula_buffer_t               out    = CHULA_BUF_INIT;
+    hpack_context_pool_limits_t  limits = {1, 1024};
+    hpack_context_pool_limits_t  defaults;
+
+    defaults.max_free       = 16;
+    defaults.max_table_size = 4 * HPACK_HEADER_TABLE_SIZE_DEFAULT;
+    hpack_context_pool_set_limits (&limits);
+
+    add_field (&fields, "x-custom", "value");
+
+    hpack_context_pool_get_encoder (&enc1);
+    hpack_context_pool_get_encoder (&enc2);
+    ck_assert (enc1 != enc2);
+
+    /* Tables larger than the limit give their memory back */
+    hpack_header_encoder_all (enc1, &fields, &out);
+    ck_assert (enc1->table.data != NULL);
+
+    hpack_context_pool_put_encoder (enc1);
+    ck_assert (enc1->table.data == NULL);
+    ck_assert (enc1->index.pairs == NULL);
+
+    /* Only one is kept */
+    hpack_context_pool_put_encoder (enc2);
+
+    hpack_context_pool_get_encoder (&enc3);
+    ck_assert (enc3 == enc1);
+    hpack_context_pool_put_encoder (enc3);
+
+    hpack_header_field_list_free (&fields);
+    chula_buffer_mrproper (&out);
+
+    hpack_context_pool_flush ();
+    hpack_context_pool_set_limits (&defaults);
+}
+END_TEST
+
+int
+context_pool_tests (void)
+{
+    Suite *s1 = suite_create("Context pool");
+
+    check_add (s1, recycle);
+    check_add (s1, limits);
+
+    run_test (s1);
+}
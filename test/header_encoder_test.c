@@ -0,0 +1,593 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+
+#include "test.h"
+#include "libhpack/header_encoder.h"
+#include "libhpack/header_parser.h"
+
+/* All examples came from:
+ * http://tools.ietf.org/html/rfc7541
+ */
+
+#define add_field(l,n,v)                                          \
+    do {                                                          \
+        hpack_header_field_t *_f;                                 \
+        hpack_header_field_new (&_f);                             \
+        chula_buffer_add_str (&_f->name, n);                      \
+        chula_buffer_add_str (&_f->value, v);                     \
+        chula_list_add_tail (&_f->entry, l);                      \
+    } while (0)
+
+#define check_block(b,exp)                                        \
+    do {                                                          \
+        ck_assert ((b)->len == sizeof(exp));                      \
+        ck_assert (memcmp ((b)->buf, exp, sizeof(exp)) == 0);     \
+    } while (0)
+
+
+/* Indexes every literal, as the examples of the RFC do
+ */
+static hpack_field_rep_t
+index_all (hpack_encoder_policy_t *policy,
+           hpack_header_encoder_t *encoder,
+           hpack_header_field_t   *field)
+{
+    UNUSED (policy);
+    UNUSED (encoder);
+    UNUSED (field);
+
+    return hpack_field_rep_literal_inc_index;
+}
+
+START_TEST (requests_without_huffman)
+{
+    ret_t                  ret;
+    hpack_header_encoder_t encoder;
+    hpack_encoder_policy_t policy;
+    chula_list_t           fields = LIST_HEAD_INIT(fields);
+    chula_buffer_t         out    = CHULA_BUF_INIT;
+    unsigned char          req1[] = {0x82, 0x86, 0x84, 0x41, 0x0f, 'w','w','w','.','e','x','a','m','p','l','e','.','c','o','m'};
+    unsigned char          req2[] = {0x82, 0x86, 0x84, 0xbe, 0x58, 0x08, 'n','o','-','c','a','c','h','e'};
+    unsigned char          req3[] = {0x82, 0x87, 0x85, 0xbf, 0x40, 0x0a, 'c','u','s','t','o','m','-','k','e','y',
+                                     0x0c, 'c','u','s','t','o','m','-','v','a','l','u','e'};
+
+    hpack_header_encoder_init (&encoder);
+    hpack_encoder_policy_init (&policy);
+    policy.rep = index_all;
+    hpack_header_encoder_set_policy (&encoder, &policy);
+    encoder.huffman = false;
+
+    /* C.3.1.  First Request
+     */
+    add_field (&fields, ":method", "GET");
+    add_field (&fields, ":scheme", "http");
+    add_field (&fields, ":path", "/");
+    add_field (&fields, ":authority", "www.example.com");
+
+    ret = hpack_header_encoder_all (&encoder, &fields, &out);
+    ck_assert (ret == ret_ok);
+    check_block (&out, req1);
+    ck_assert (encoder.table.size == 57);
+    hpack_header_field_list_free (&fields);
+
+    /* C.3.2.  Second Request
+     */
+    chula_buffer_clean (&out);
+    add_field (&fields, ":method", "GET");
+    add_field (&fields, ":scheme", "http");
+    add_field (&fields, ":path", "/");
+    add_field (&fields, ":authority", "www.example.com");
+    add_field (&fields, "cache-control", "no-cache");
+
+    ret = hpack_header_encoder_all (&encoder, &fields, &out);
+    ck_assert (ret == ret_ok);
+    check_block (&out, req2);
+    ck_assert (encoder.table.size == 110);
+    hpack_header_field_list_free (&fields);
+
+    /* C.3.3.  Third Request
+     */
+    chula_buffer_clean (&out);
+    add_field (&fields, ":method", "GET");
+    add_field (&fields, ":scheme", "https");
+    add_field (&fields, ":path", "/index.html");
+    add_field (&fields, ":authority", "www.example.com");
+    add_field (&fields, "custom-key", "custom-value");
+
+    ret = hpack_header_encoder_all (&encoder, &fields, &out);
+    ck_assert (ret == ret_ok);
+    check_block (&out, req3);
+    ck_assert (encoder.table.size == 164);
+    hpack_header_field_list_free (&fields);
+
+    chula_buffer_mrproper (&out);
+    hpack_header_encoder_mrproper (&encoder);
+}
+END_TEST
+
+START_TEST (requests_with_huffman)
+{
+    ret_t                  ret;
+    hpack_header_encoder_t encoder;
+    hpack_encoder_policy_t policy;
+    chula_list_t           fields = LIST_HEAD_INIT(fields);
+    chula_buffer_t         out    = CHULA_BUF_INIT;
+    unsigned char          req1[] = {0x82, 0x86, 0x84, 0x41, 0x8c, 0xf1, 0xe3, 0xc2, 0xe5, 0xf2, 0x3a, 0x6b,
+                                     0xa0, 0xab, 0x90, 0xf4, 0xff};
+    unsigned char          req3[] = {0x82, 0x87, 0x85, 0xbe, 0x40, 0x88, 0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xa9,
+                                     0x7d, 0x7f, 0x89, 0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xb8, 0xe8, 0xb4, 0xbf};
+
+    hpack_header_encoder_init (&encoder);
+    hpack_encoder_policy_init (&policy);
+    policy.rep = index_all;
+    hpack_header_encoder_set_policy (&encoder, &policy);
+
+    /* C.4.1.  First Request
+     */
+    add_field (&fields, ":method", "GET");
+    add_field (&fields, ":scheme", "http");
+    add_field (&fields, ":path", "/");
+    add_field (&fields, ":authority", "www.example.com");
+
+    ret = hpack_header_encoder_all (&encoder, &fields, &out);
+    ck_assert (ret == ret_ok);
+    check_block (&out, req1);
+    hpack_header_field_list_free (&fields);
+
+    /* C.4.3.  Third Request, without the second one
+     */
+    chula_buffer_clean (&out);
+    add_field (&fields, ":method", "GET");
+    add_field (&fields, ":scheme", "https");
+    add_field (&fields, ":path", "/index.html");
+    add_field (&fields, ":authority", "www.example.com");
+    add_field (&fields, "custom-key", "custom-value");
+
+    ret = hpack_header_encoder_all (&encoder, &fields, &out);
+    ck_assert (ret == ret_ok);
+    check_block (&out, req3);
+    hpack_header_field_list_free (&fields);
+
+    chula_buffer_mrproper (&out);
+    hpack_header_encoder_mrproper (&encoder);
+}
+END_TEST
+
+START_TEST (default_policy)
+{
+    ret_t                  ret;
+    cuint_t                consumed;
+    hpack_header_encoder_t encoder;
+    hpack_header_parser_t  parser;
+    chula_list_t           fields  = LIST_HEAD_INIT(fields);
+    chula_list_t           decoded = LIST_HEAD_INIT(decoded);
+    chula_list_t          *i, *j;
+    chula_buffer_t         out     = CHULA_BUF_INIT;
+    hpack_field_rep_t      reps[]  = {hpack_field_rep_indexed,
+                                      hpack_field_rep_literal_inc_index,
+                                      hpack_field_rep_literal_without_index,
+                                      hpack_field_rep_literal_never_index,
+                                      hpack_field_rep_literal_never_index,
+                                      hpack_field_rep_literal_without_index,
+                                      hpack_field_rep_literal_never_index};
+    cuint_t                n;
+
+    hpack_header_encoder_init (&encoder);
+    hpack_header_parser_init (&parser);
+
+    add_field (&fields, ":method", "GET");
+    add_field (&fields, ":authority", "www.example.com");
+    add_field (&fields, ":path", "/search?q=hpack");
+    add_field (&fields, "authorization", "Basic dXNlcjpwYXNz");
+    add_field (&fields, "cookie", "id=42");
+    add_field (&fields, "content-length", "1024");
+    add_field (&fields, "x-secret", "s3cr3t");
+
+    /* Kept never indexed, as decoded from a previous hop */
+    HDR_FIELD(fields.prev)->rep = hpack_field_rep_literal_never_index;
+
+    ret = hpack_header_encoder_all (&encoder, &fields, &out);
+    ck_assert (ret == ret_ok);
+    ck_assert (encoder.table.num == 1);
+
+    ret = hpack_header_parser_all (&parser, &out, 0, &decoded, &consumed);
+    ck_assert (ret == ret_ok);
+    ck_assert (consumed == out.len);
+    ck_assert (parser.table.num == 1);
+
+    n = 0;
+    for (i = fields.next, j = decoded.next; i != &fields; i = i->next, j = j->next, n++) {
+        ck_assert (j != &decoded);
+        ck_assert (chula_buffer_cmp_buf (&HDR_FIELD(i)->name,  &HDR_FIELD(j)->name)  == 0);
+        ck_assert (chula_buffer_cmp_buf (&HDR_FIELD(i)->value, &HDR_FIELD(j)->value) == 0);
+        ck_assert (HDR_FIELD(j)->rep == reps[n]);
+    }
+    ck_assert (j == &decoded);
+
+    /* Indexed the second time */
+    chula_buffer_clean (&out);
+    ret = hpack_header_encoder_field (&encoder, HDR_FIELD(fields.next->next), &out);
+    ck_assert (ret == ret_ok);
+    ck_assert (out.len == 1);
+    ck_assert ((unsigned char)out.buf[0] == 0xbe);
+
+    hpack_header_field_list_free (&fields);
+    hpack_header_field_list_free (&decoded);
+    chula_buffer_mrproper (&out);
+    hpack_header_parser_mrproper (&parser);
+    hpack_header_encoder_mrproper (&encoder);
+}
+END_TEST
+
+START_TEST (table_size_update)
+{
+    ret_t                  ret;
+    hpack_header_encoder_t encoder;
+    chula_list_t           fields = LIST_HEAD_INIT(fields);
+    chula_buffer_t         out    = CHULA_BUF_INIT;
+    unsigned char          upd1[] = {0x20, 0x82};
+    unsigned char          upd2[] = {0x3f, 0x45, 0x3f, 0xe1, 0x1f, 0x82};
+
+    hpack_header_encoder_init (&encoder);
+    add_field (&fields, ":method", "GET");
+
+    /* Emptied */
+    ret = hpack_header_encoder_set_max_size (&encoder, 0);
+    ck_assert (ret == ret_ok);
+    ret = hpack_header_encoder_all (&encoder, &fields, &out);
+    ck_assert (ret == ret_ok);
+    check_block (&out, upd1);
+
+    /* Smallest size first, then the final one */
+    chula_buffer_clean (&out);
+    hpack_header_encoder_set_max_size (&encoder, 200);
+    hpack_header_encoder_set_max_size (&encoder, 100);
+    hpack_header_encoder_set_max_size (&encoder, 4096);
+    ret = hpack_header_encoder_all (&encoder, &fields, &out);
+    ck_assert (ret == ret_ok);
+    check_block (&out, upd2);
+
+    /* Beyond SETTINGS_HEADER_TABLE_SIZE */
+    ret = hpack_header_encoder_set_max_size (&encoder, 8192);
+    ck_assert (ret == ret_error);
+
+    hpack_header_field_list_free (&fields);
+    chula_buffer_mrproper (&out);
+    hpack_header_encoder_mrproper (&encoder);
+}
+END_TEST
+
+START_TEST (batch)
+{
+    ret_t                  ret;
+    cuint_t                n;
+    cuint_t                ends[3];
+    hpack_header_encoder_t encoder;
+    hpack_header_encoder_t single;
+    hpack_encoder_policy_t policy;
+    chula_list_t           lists[3];
+    chula_buffer_t         out    = CHULA_BUF_INIT;
+    chula_buffer_t         out2   = CHULA_BUF_INIT;
+    unsigned char          upd[]  = {0x3f, 0xe1, 0x1f};
+    unsigned char          req1[] = {0x82, 0x86, 0x84, 0x41, 0x0f, 'w','w','w','.','e','x','a','m','p','l','e','.','c','o','m'};
+    unsigned char          req2[] = {0x82, 0x86, 0x84, 0xbe, 0x58, 0x08, 'n','o','-','c','a','c','h','e'};
+    unsigned char          req3[] = {0x82, 0x87, 0x85, 0xbf, 0x40, 0x0a, 'c','u','s','t','o','m','-','k','e','y',
+                                     0x0c, 'c','u','s','t','o','m','-','v','a','l','u','e'};
+
+    hpack_header_encoder_init (&encoder);
+    hpack_encoder_policy_init (&policy);
+    policy.rep = index_all;
+    hpack_header_encoder_set_policy (&encoder, &policy);
+    hpack_header_encoder_set_max_size (&encoder, 4096);
+    encoder.huffman = false;
+
+    for (n = 0; n < 3; n++) {
+        INIT_LIST_HEAD (&lists[n]);
+    }
+
+    /* C.3.  Request Examples without Huffman Coding, in one call
+     */
+    add_field (&lists[0], ":method", "GET");
+    add_field (&lists[0], ":scheme", "http");
+    add_field (&lists[0], ":path", "/");
+    add_field (&lists[0], ":authority", "www.example.com");
+
+    add_field (&lists[1], ":method", "GET");
+    add_field (&lists[1], ":scheme", "http");
+    add_field (&lists[1], ":path", "/");
+    add_field (&lists[1], ":authority", "www.example.com");
+    add_field (&lists[1], "cache-control", "no-cache");
+
+    add_field (&lists[2], ":method", "GET");
+    add_field (&lists[2], ":scheme", "https");
+    add_field (&lists[2], ":path", "/index.html");
+    add_field (&lists[2], ":authority", "www.example.com");
+    add_field (&lists[2], "custom-key", "custom-value");
+
+    ret = hpack_header_encoder_batch (&encoder, lists, 3, &out, ends);
+    ck_assert (ret == ret_ok);
+    ck_assert (encoder.table.size == 164);
+
+    /* The size update only goes in front of the first block */
+    ck_assert (ends[0] == sizeof(upd) + sizeof(req1));
+    ck_assert (ends[1] == ends[0] + sizeof(req2));
+    ck_assert (ends[2] == ends[1] + sizeof(req3));
+    ck_assert (out.len == ends[2]);
+
+    ck_assert (memcmp (out.buf, upd, sizeof(upd)) == 0);
+    ck_assert (memcmp (out.buf + sizeof(upd), req1, sizeof(req1)) == 0);
+    ck_assert (memcmp (out.buf + ends[0], req2, sizeof(req2)) == 0);
+    ck_assert (memcmp (out.buf + ends[1], req3, sizeof(req3)) == 0);
+
+    /* Names repeated across the batch, in and out of the static table,
+     * encode as they do one list at a time
+     */
+    for (n = 0; n < 3; n++) {
+        hpack_header_field_list_free (&lists[n]);
+        INIT_LIST_HEAD (&lists[n]);
+    }
+
+    add_field (&lists[0], "custom-key", "custom-value");
+    add_field (&lists[0], "cache-control", "no-cache");
+    add_field (&lists[0], "x-id", "1");
+
+    add_field (&lists[1], "custom-key", "other-value");
+    add_field (&lists[1], "cache-control", "no-cache");
+    add_field (&lists[1], "x-id", "2");
+
+    add_field (&lists[2], "custom-key", "custom-value");
+    add_field (&lists[2], "cache-control", "max-age=0");
+    add_field (&lists[2], "x-id", "2");
+
+    hpack_header_encoder_mrproper (&encoder);
+    hpack_header_encoder_init (&encoder);
+    hpack_header_encoder_init (&single);
+
+    chula_buffer_clean (&out);
+    ret = hpack_header_encoder_batch (&encoder, lists, 3, &out, NULL);
+    ck_assert (ret == ret_ok);
+
+    for (n = 0; n < 3; n++) {
+        ret = hpack_header_encoder_all (&single, &lists[n], &out2);
+        ck_assert (ret == ret_ok);
+    }
+
+    ck_assert (out.len == out2.len);
+    ck_assert (memcmp (out.buf, out2.buf, out.len) == 0);
+    ck_assert (encoder.table.size == single.table.size);
+
+    for (n = 0; n < 3; n++) {
+        hpack_header_field_list_free (&lists[n]);
+    }
+
+    chula_buffer_mrproper (&out);
+    chula_buffer_mrproper (&out2);
+    hpack_header_encoder_mrproper (&encoder);
+    hpack_header_encoder_mrproper (&single);
+}
+END_TEST
+
+START_TEST (lowercase)
+{
+    ret_t                  ret;
+    cuint_t                n;
+    hpack_header_encoder_t encoder;
+    hpack_header_encoder_t plain;
+    hpack_header_list_t    packed;
+    chula_list_t           mixed = LIST_HEAD_INIT(mixed);
+    chula_list_t           lower = LIST_HEAD_INIT(lower);
+    chula_list_t           bad   = LIST_HEAD_INIT(bad);
+    chula_buffer_t         out1  = CHULA_BUF_INIT;
+    chula_buffer_t         out2  = CHULA_BUF_INIT;
+
+    /* HTTP/1.1 names encode as their HTTP/2 form
+     */
+    add_field (&mixed, ":method", "GET");
+    add_field (&mixed, "Host", "www.example.com");
+    add_field (&mixed, "Content-Type", "text/html");
+    add_field (&mixed, "X-Forwarded-For-Original", "192.0.2.1");
+
+    add_field (&lower, ":method", "GET");
+    add_field (&lower, "host", "www.example.com");
+    add_field (&lower, "content-type", "text/html");
+    add_field (&lower, "x-forwarded-for-original", "192.0.2.1");
+
+    hpack_header_encoder_init (&encoder);
+    hpack_header_encoder_init (&plain);
+    hpack_header_encoder_set_lowercase (&encoder, true);
+
+    ret = hpack_header_encoder_all (&encoder, &mixed, &out1);
+    ck_assert (ret == ret_ok);
+    ret = hpack_header_encoder_all (&plain, &lower, &out2);
+    ck_assert (ret == ret_ok);
+
+    ck_assert (out1.len == out2.len);
+    ck_assert (memcmp (out1.buf, out2.buf, out1.len) == 0);
+    ck_assert (encoder.table.size == plain.table.size);
+
+    /* The fields are left alone */
+    ck_assert (chula_buffer_cmp_str (&HDR_FIELD(mixed.next->next)->name, "Host") == 0);
+
+    /* Same from a packed list, against the populated table */
+    hpack_header_list_init (&packed);
+    hpack_header_list_add (&packed, "HOST", 4, "www.example.com", 15, hpack_field_rep_literal_inc_index);
+    hpack_header_list_add (&packed, "Cache-Control", 13, "no-cache", 8, hpack_field_rep_literal_inc_index);
+
+    chula_buffer_clean (&out1);
+    chula_buffer_clean (&out2);
+    ret = hpack_header_encoder_list (&encoder, &packed, &out1);
+    ck_assert (ret == ret_ok);
+
+    hpack_header_list_clean (&packed);
+    hpack_header_list_add (&packed, "host", 4, "www.example.com", 15, hpack_field_rep_literal_inc_index);
+    hpack_header_list_add (&packed, "cache-control", 13, "no-cache", 8, hpack_field_rep_literal_inc_index);
+    ret = hpack_header_encoder_list (&plain, &packed, &out2);
+    ck_assert (ret == ret_ok);
+
+    ck_assert (out1.len == out2.len);
+    ck_assert (memcmp (out1.buf, out2.buf, out1.len) == 0);
+
+    /* Names that are not tokens can not be translated */
+    add_field (&bad, "Bad Name", "x");
+    ret = hpack_header_encoder_all (&encoder, &bad, &out1);
+    ck_assert (ret == ret_error);
+
+    /* Without Huffman, new names stay where they were lowercased. The
+     * second pass finds them in the dynamic table.
+     */
+    hpack_header_encoder_mrproper (&encoder);
+    hpack_header_encoder_mrproper (&plain);
+    hpack_header_encoder_init (&encoder);
+    hpack_header_encoder_init (&plain);
+    hpack_header_encoder_set_lowercase (&encoder, true);
+    encoder.huffman = false;
+    plain.huffman   = false;
+
+    for (n = 0; n < 2; n++) {
+        chula_buffer_clean (&out1);
+        chula_buffer_clean (&out2);
+
+        ret = hpack_header_encoder_all (&encoder, &mixed, &out1);
+        ck_assert (ret == ret_ok);
+        ret = hpack_header_encoder_all (&plain, &lower, &out2);
+        ck_assert (ret == ret_ok);
+
+        ck_assert (out1.len == out2.len);
+        ck_assert (memcmp (out1.buf, out2.buf, out1.len) == 0);
+        ck_assert (encoder.table.size == plain.table.size);
+    }
+
+    hpack_header_field_list_free (&mixed);
+    hpack_header_field_list_free (&lower);
+    hpack_header_field_list_free (&bad);
+    hpack_header_list_mrproper (&packed);
+    chula_buffer_mrproper (&out1);
+    chula_buffer_mrproper (&out2);
+    hpack_header_encoder_mrproper (&encoder);
+    hpack_header_encoder_mrproper (&plain);
+}
+END_TEST
+
+START_TEST (template)
+{
+    ret_t                   ret;
+    cuint_t                 n;
+    hpack_header_encoder_t  enc1;
+    hpack_header_encoder_t  enc2;
+    hpack_header_list_t     list;
+    hpack_header_template_t tmpl;
+    chula_buffer_t          out1 = CHULA_BUF_INIT;
+    chula_buffer_t          out2 = CHULA_BUF_INIT;
+
+    /* Static matches, static and new names, never indexed fields */
+    hpack_header_list_init (&list);
+    hpack_header_list_add (&list, ":status", 7, "304", 3, hpack_field_rep_literal_inc_index);
+    hpack_header_list_add (&list, "server", 6, "libhpack", 8, hpack_field_rep_literal_inc_index);
+    hpack_header_list_add (&list, "cookie", 6, "", 0, hpack_field_rep_literal_inc_index);
+    hpack_header_list_add (&list, "etag", 4, "\"abc\"", 5, hpack_field_rep_literal_inc_index);
+    hpack_header_list_add (&list, "x-request", 9, "static", 6, hpack_field_rep_literal_inc_index);
+    hpack_header_list_add (&list, "x-secret", 8, "value", 5, hpack_field_rep_literal_never_index);
+    hpack_header_list_add (&list, "accept-encoding", 15, "gzip, deflate", 13, hpack_field_rep_literal_inc_index);
+
+    hpack_header_encoder_init (&enc1);
+    hpack_header_encoder_init (&enc2);
+    hpack_header_template_init (&tmpl);
+
+    ret = hpack_header_encoder_compile (&enc2, &list, &tmpl);
+    ck_assert (ret == ret_ok);
+    ck_assert (tmpl.list.num == list.num);
+    ck_assert (tmpl.fields[0].static_pair == 11);
+    ck_assert (tmpl.fields[0].static_name == 8);
+    ck_assert (tmpl.fields[6].static_pair == 16);
+    ck_assert (tmpl.fields[4].name_len > 0);
+
+    /* Same blocks as the list, as the dynamic table fills up and once
+     * it is shrunk.
+     */
+    for (n = 0; n < 4; n++) {
+        if (n == 2) {
+            hpack_header_encoder_set_max_size (&enc1, 64);
+            hpack_header_encoder_set_max_size (&enc2, 64);
+        }
+
+        chula_buffer_clean (&out1);
+        chula_buffer_clean (&out2);
+
+        ret = hpack_header_encoder_list (&enc1, &list, &out1);
+        ck_assert (ret == ret_ok);
+        ret = hpack_header_encoder_template (&enc2, &tmpl, &out2);
+        ck_assert (ret == ret_ok);
+
+        ck_assert (out1.len == out2.len);
+        ck_assert (memcmp (out1.buf, out2.buf, out1.len) == 0);
+        ck_assert (enc1.table.num == enc2.table.num);
+    }
+
+    /* Names are lowercased and checked at compile time */
+    hpack_header_encoder_set_lowercase (&enc2, true);
+    hpack_header_list_clean (&list);
+    hpack_header_list_add (&list, "X-Request", 9, "static", 6, hpack_field_rep_literal_inc_index);
+
+    ret = hpack_header_encoder_compile (&enc2, &list, &tmpl);
+    ck_assert (ret == ret_ok);
+    ck_assert (strcmp (HPACK_LIST_NAME(&tmpl.list, 0), "x-request") == 0);
+
+    hpack_header_list_add (&list, "Bad Name", 8, "x", 1, hpack_field_rep_literal_inc_index);
+    ret = hpack_header_encoder_compile (&enc2, &list, &tmpl);
+    ck_assert (ret == ret_error);
+
+    hpack_header_template_mrproper (&tmpl);
+    hpack_header_list_mrproper (&list);
+    chula_buffer_mrproper (&out1);
+    chula_buffer_mrproper (&out2);
+    hpack_header_encoder_mrproper (&enc1);
+    hpack_header_encoder_mrproper (&enc2);
+}
+END_TEST
+
+int
+header_encoder_tests (void)
+{
+    Suite *s1 = suite_create("Header encoder");
+
+    check_add (s1, requests_without_huffman);
+    check_add (s1, requests_with_huffman);
+    check_add (s1, default_policy);
+    check_add (s1, table_size_update);
+    check_add (s1, batch);
+    check_add (s1, lowercase);
+    check_add (s1, template);
+
+    run_test (s1);
+}
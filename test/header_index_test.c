@@ -0,0 +1,160 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "test.h"
+#include "libhpack/header_index.h"
+
+#include <stdio.h>
+
+
+START_TEST (add_find)
+{
+    ret_t                ret;
+    cuint_t              pos;
+    bool                 match;
+    hpack_header_table_t table;
+    hpack_header_index_t index;
+    chula_buffer_t       name;
+    chula_buffer_t       value;
+
+    hpack_header_table_init (&table);
+    hpack_header_index_init (&index);
+
+    chula_buffer_fake_str (&name, "custom-key");
+    chula_buffer_fake_str (&value, "one");
+    ret = hpack_header_index_find (&index, &table, &name, &value, &pos, &match);
+    ck_assert (ret == ret_not_found);
+
+    hpack_header_table_add (&table, &name, &value);
+    hpack_header_index_add (&index, &table);
+    chula_buffer_fake_str (&value, "two");
+    hpack_header_table_add (&table, &name, &value);
+    hpack_header_index_add (&index, &table);
+
+    /* Pair, then the newest entry with the name */
+    chula_buffer_fake_str (&value, "one");
+    ret = hpack_header_index_find (&index, &table, &name, &value, &pos, &match);
+    ck_assert ((ret == ret_ok) && match && (pos == 2));
+
+    chula_buffer_fake_str (&value, "three");
+    ret = hpack_header_index_find (&index, &table, &name, &value, &pos, &match);
+    ck_assert ((ret == ret_ok) && (! match) && (pos == 1));
+
+    ret = hpack_header_index_find (&index, &table, &name, NULL, &pos, &match);
+    ck_assert ((ret == ret_ok) && (! match) && (pos == 1));
+
+    /* Evicted entries are not found */
+    hpack_header_table_set_max_size (&table, 0);
+    ret = hpack_header_index_find (&index, &table, &name, NULL, &pos, &match);
+    ck_assert (ret == ret_not_found);
+
+    hpack_header_index_mrproper (&index);
+    hpack_header_table_mrproper (&table);
+}
+END_TEST
+
+/* Checks the index against a linear scan of the dynamic table, across
+ * insertions, evictions and table size changes.
+ */
+START_TEST (random_ops)
+{
+    int                  i;
+    ret_t                ret1, ret2;
+    cuint_t              index1, pos;
+    bool                 match1, match2;
+    unsigned int         seed = 11;
+    char                 nbuf[16];
+    char                 vbuf[64];
+    hpack_header_table_t table;
+    hpack_header_index_t index;
+    chula_buffer_t       name;
+    chula_buffer_t       value;
+
+    hpack_header_table_init (&table);
+    hpack_header_index_init (&index);
+    hpack_header_table_set_settings_size (&table, 8192);
+
+    for (i = 0; i < 20000; i++) {
+        seed = seed * 1103515245 + 12345;
+        snprintf (nbuf, sizeof(nbuf), "x-name-%u", (seed >> 16) % 23);
+        seed = seed * 1103515245 + 12345;
+        snprintf (vbuf, sizeof(vbuf), "%u%.*s", (seed >> 16) % 7,
+                  (int)((seed >> 8) % 40), "0123456789012345678901234567890123456789");
+
+        chula_buffer_fake_str (&name, nbuf);
+        chula_buffer_fake_str (&value, vbuf);
+
+        seed = seed * 1103515245 + 12345;
+        switch ((seed >> 16) % 8) {
+        case 0:
+            ret1 = hpack_header_table_find (&table, &name, NULL, &index1, &match1);
+            ret2 = hpack_header_index_find (&index, &table, &name, NULL, &pos, &match2);
+            break;
+        case 1:
+        case 2:
+        case 3:
+            ret1 = hpack_header_table_find (&table, &name, &value, &index1, &match1);
+            ret2 = hpack_header_index_find (&index, &table, &name, &value, &pos, &match2);
+            break;
+        case 4:
+            if ((seed >> 8) % 16 == 0) {
+                hpack_header_table_set_max_size (&table, ((seed >> 12) % 9) * 1024);
+            }
+            continue;
+        default:
+            hpack_header_table_add (&table, &name, &value);
+            ck_assert (hpack_header_index_add (&index, &table) == ret_ok);
+            continue;
+        }
+
+        ck_assert (ret1 == ret2);
+        if (ret1 == ret_ok) {
+            ck_assert (index1 == HPACK_STATIC_TABLE_LEN + pos);
+            ck_assert (match1 == match2);
+        }
+    }
+
+    hpack_header_index_mrproper (&index);
+    hpack_header_table_mrproper (&table);
+}
+END_TEST
+
+int
+header_index_tests (void)
+{
+    Suite *s1 = suite_create("Header index");
+
+    check_add (s1, add_find);
+    check_add (s1, random_ops);
+
+    run_test (s1);
+}
@@ -0,0 +1,221 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "test.h"
+#include "libhpack/header_list.h"
+#include "libhpack/header_parser.h"
+#include "libhpack/header_encoder.h"
+
+#include <stdio.h>
+
+#define check_entry(l,i,n,v)                                          \
+    do {                                                              \
+        chula_buffer_t _n, _v;                                        \
+        ck_assert (hpack_header_list_get (l, i, &_n, &_v) == ret_ok); \
+        ck_assert (_n.len == strlen(n));                              \
+        ck_assert (memcmp (_n.buf, n, _n.len) == 0);                  \
+        ck_assert (_v.len == strlen(v));                              \
+        ck_assert (memcmp (_v.buf, v, _v.len) == 0);                  \
+    } while (0)
+
+
+START_TEST (add_get)
+{
+    int                 i;
+    char                name[16];
+    char                value[16];
+    hpack_header_list_t list;
+
+    hpack_header_list_init (&list);
+
+    hpack_header_list_add (&list, ":status", 7, "200", 3, hpack_field_rep_indexed);
+    hpack_header_list_add (&list, "empty", 5, NULL, 0, hpack_field_rep_literal_never_index);
+
+    ck_assert (list.num == 2);
+    check_entry (&list, 0, ":status", "200");
+    check_entry (&list, 1, "empty", "");
+    ck_assert (HPACK_LIST_REP(&list, 0) == hpack_field_rep_indexed);
+    ck_assert (HPACK_LIST_REP(&list, 1) == hpack_field_rep_literal_never_index);
+    ck_assert (strcmp (HPACK_LIST_VALUE(&list, 0), "200") == 0);
+    ck_assert (hpack_header_list_get (&list, 2, NULL, NULL) == ret_not_found);
+
+    /* Growing keeps what was there */
+    for (i = 0; i < 100; i++) {
+        snprintf (name,  sizeof(name),  "x-%d", i);
+        snprintf (value, sizeof(value), "%d", i * 7);
+        hpack_header_list_add (&list, name, strlen(name), value, strlen(value),
+                               hpack_field_rep_literal_inc_index);
+    }
+
+    ck_assert (list.num == 102);
+    ck_assert (list.size >= 102);
+    check_entry (&list, 0, ":status", "200");
+    check_entry (&list, 2, "x-0", "0");
+    check_entry (&list, 101, "x-99", "693");
+
+    hpack_header_list_clean (&list);
+    ck_assert (list.num == 0);
+    ck_assert (list.data.len == 0);
+
+    hpack_header_list_mrproper (&list);
+}
+END_TEST
+
+START_TEST (find)
+{
+    ret_t               ret;
+    cuint_t             n;
+    hpack_header_list_t list;
+
+    hpack_header_list_init (&list);
+
+    hpack_header_list_add (&list, "cookie", 6, "a=1", 3, hpack_field_rep_literal_inc_index);
+    hpack_header_list_add (&list, "accept", 6, "*/*", 3, hpack_field_rep_literal_inc_index);
+    hpack_header_list_add (&list, "cookie", 6, "b=2", 3, hpack_field_rep_literal_inc_index);
+
+    ret = hpack_header_list_find (&list, "cookie", 6, 0, &n);
+    ck_assert ((ret == ret_ok) && (n == 0));
+
+    ret = hpack_header_list_find (&list, "cookie", 6, n + 1, &n);
+    ck_assert ((ret == ret_ok) && (n == 2));
+    check_entry (&list, n, "cookie", "b=2");
+
+    ret = hpack_header_list_find (&list, "cookie", 6, n + 1, &n);
+    ck_assert (ret == ret_not_found);
+
+    ret = hpack_header_list_find (&list, "cookies", 7, 0, &n);
+    ck_assert (ret == ret_not_found);
+
+    hpack_header_list_mrproper (&list);
+}
+END_TEST
+
+START_TEST (decode_into)
+{
+    ret_t                 ret;
+    cuint_t               consumed;
+    hpack_header_parser_t parser;
+    hpack_header_list_t   list;
+    chula_buffer_t        raw;
+    unsigned char         req1[] = {0x82, 0x86, 0x84, 0x41, 0x0f, 'w','w','w','.','e','x','a','m','p','l','e','.','c','o','m'};
+    unsigned char         req2[] = {0x82, 0x86, 0x84, 0xbe, 0x58, 0x08, 'n','o','-','c','a','c','h','e'};
+
+    hpack_header_parser_init (&parser);
+    hpack_header_list_init (&list);
+    hpack_header_parser_set_list (&parser, &list);
+
+    /* C.3.1. and C.3.2., back to back in the same list */
+    chula_buffer_fake (&raw, (const char *)req1, sizeof(req1));
+    ret = hpack_header_parser_all (&parser, &raw, 0, NULL, &consumed);
+    ck_assert ((ret == ret_ok) && (consumed == sizeof(req1)));
+
+    chula_buffer_fake (&raw, (const char *)req2, sizeof(req2));
+    ret = hpack_header_parser_all (&parser, &raw, 0, NULL, &consumed);
+    ck_assert ((ret == ret_ok) && (consumed == sizeof(req2)));
+
+    ck_assert (list.num == 9);
+    check_entry (&list, 0, ":method", "GET");
+    check_entry (&list, 3, ":authority", "www.example.com");
+    check_entry (&list, 7, ":authority", "www.example.com");
+    check_entry (&list, 8, "cache-control", "no-cache");
+    ck_assert (HPACK_LIST_REP(&list, 3) == hpack_field_rep_literal_inc_index);
+    ck_assert (HPACK_LIST_REP(&list, 7) == hpack_field_rep_indexed);
+
+    hpack_header_list_mrproper (&list);
+    hpack_header_parser_mrproper (&parser);
+}
+END_TEST
+
+START_TEST (encode_from)
+{
+    ret_t                  ret;
+    cuint_t                n;
+    hpack_header_encoder_t enc1;
+    hpack_header_encoder_t enc2;
+    hpack_header_list_t    list;
+    chula_list_t           fields = LIST_HEAD_INIT(fields);
+    chula_buffer_t         out1   = CHULA_BUF_INIT;
+    chula_buffer_t         out2   = CHULA_BUF_INIT;
+    hpack_header_field_t  *field;
+    const char            *pairs[][2] = {{":method", "GET"}, {":path", "/search?q=list"},
+                                         {":authority", "www.example.com"}, {"authorization", "secret"},
+                                         {"accept", "*/*"}, {"x-custom", "one"}, {"x-custom", "two"}};
+
+    hpack_header_encoder_init (&enc1);
+    hpack_header_encoder_init (&enc2);
+    hpack_header_list_init (&list);
+
+    for (n = 0; n < sizeof(pairs) / sizeof(pairs[0]); n++) {
+        hpack_header_field_new (&field);
+        chula_buffer_add (&field->name,  pairs[n][0], strlen(pairs[n][0]));
+        chula_buffer_add (&field->value, pairs[n][1], strlen(pairs[n][1]));
+        chula_list_add_tail (&field->entry, &fields);
+
+        hpack_header_list_add_field (&list, field);
+    }
+
+    /* Twice, the second time against a populated table */
+    for (n = 0; n < 2; n++) {
+        chula_buffer_clean (&out1);
+        chula_buffer_clean (&out2);
+
+        ret = hpack_header_encoder_all (&enc1, &fields, &out1);
+        ck_assert (ret == ret_ok);
+        ret = hpack_header_encoder_list (&enc2, &list, &out2);
+        ck_assert (ret == ret_ok);
+
+        ck_assert (out1.len == out2.len);
+        ck_assert (memcmp (out1.buf, out2.buf, out1.len) == 0);
+        ck_assert (enc1.table.num == enc2.table.num);
+    }
+
+    hpack_header_field_list_free (&fields);
+    hpack_header_list_mrproper (&list);
+    chula_buffer_mrproper (&out1);
+    chula_buffer_mrproper (&out2);
+    hpack_header_encoder_mrproper (&enc1);
+    hpack_header_encoder_mrproper (&enc2);
+}
+END_TEST
+
+int
+header_list_tests (void)
+{
+    Suite *s1 = suite_create("Header list");
+
+    check_add (s1, add_get);
+    check_add (s1, find);
+    check_add (s1, decode_into);
+    check_add (s1, encode_from);
+
+    run_test (s1);
+}
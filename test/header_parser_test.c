@@ -0,0 +1,952 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "test.h"
+#include "libhpack/header_parser.h"
+
+/* All examples came from:
+ * http://tools.ietf.org/html/rfc7541
+ */
+
+#define fake_raw(b,s) chula_buffer_fake (b, (const char *)s, sizeof(s))
+
+#define check_field(f,n,v)                                    \
+    do {                                                      \
+        ck_assert ((f)->name.len == sizeof(n)-1);             \
+        ck_assert (memcmp ((f)->name.buf, n, sizeof(n)-1) == 0);  \
+        ck_assert ((f)->value.len == sizeof(v)-1);            \
+        ck_assert (memcmp ((f)->value.buf, v, sizeof(v)-1) == 0); \
+    } while (0)
+
+
+START_TEST (literal_inc_index)
+{
+    ret_t                 ret;
+    cuint_t               consumed = 0;
+    hpack_header_parser_t parser;
+    hpack_header_field_t  field;
+    chula_buffer_t        raw;
+    unsigned char         block[] = {0x40, 0x0a, 'c','u','s','t','o','m','-','k','e','y',
+                                     0x0d, 'c','u','s','t','o','m','-','h','e','a','d','e','r'};
+
+    /* C.2.1.  Literal Header Field with Indexing
+     */
+    hpack_header_parser_init (&parser);
+    hpack_header_field_init (&field);
+    fake_raw (&raw, block);
+
+    ret = hpack_header_parser_field (&parser, &raw, 0, &field, &consumed);
+    ck_assert (ret == ret_ok);
+    ck_assert (consumed == sizeof(block));
+    ck_assert (field.rep == hpack_field_rep_literal_inc_index);
+    check_field (&field, "custom-key", "custom-header");
+
+    ck_assert (parser.table.num == 1);
+    ck_assert (parser.table.size == 55);
+
+    hpack_header_field_mrproper (&field);
+    hpack_header_parser_mrproper (&parser);
+}
+END_TEST
+
+START_TEST (literal_without_index)
+{
+    ret_t                 ret;
+    cuint_t               consumed = 0;
+    hpack_header_parser_t parser;
+    hpack_header_field_t  field;
+    chula_buffer_t        raw;
+    unsigned char         block[] = {0x04, 0x0c, '/','s','a','m','p','l','e','/','p','a','t','h'};
+
+    /* C.2.2.  Literal Header Field without Indexing
+     */
+    hpack_header_parser_init (&parser);
+    hpack_header_field_init (&field);
+    fake_raw (&raw, block);
+
+    ret = hpack_header_parser_field (&parser, &raw, 0, &field, &consumed);
+    ck_assert (ret == ret_ok);
+    ck_assert (consumed == sizeof(block));
+    ck_assert (field.rep == hpack_field_rep_literal_without_index);
+    check_field (&field, ":path", "/sample/path");
+    ck_assert (parser.table.num == 0);
+
+    hpack_header_field_mrproper (&field);
+    hpack_header_parser_mrproper (&parser);
+}
+END_TEST
+
+START_TEST (literal_never_index)
+{
+    ret_t                 ret;
+    cuint_t               consumed = 0;
+    hpack_header_parser_t parser;
+    hpack_header_field_t  field;
+    chula_buffer_t        raw;
+    unsigned char         block[] = {0x10, 0x08, 'p','a','s','s','w','o','r','d',
+                                     0x06, 's','e','c','r','e','t'};
+
+    /* C.2.3.  Literal Header Field Never Indexed
+     */
+    hpack_header_parser_init (&parser);
+    hpack_header_field_init (&field);
+    fake_raw (&raw, block);
+
+    ret = hpack_header_parser_field (&parser, &raw, 0, &field, &consumed);
+    ck_assert (ret == ret_ok);
+    ck_assert (consumed == sizeof(block));
+    ck_assert (field.rep == hpack_field_rep_literal_never_index);
+    check_field (&field, "password", "secret");
+    ck_assert (parser.table.num == 0);
+
+    hpack_header_field_mrproper (&field);
+    hpack_header_parser_mrproper (&parser);
+}
+END_TEST
+
+START_TEST (indexed)
+{
+    ret_t                 ret;
+    cuint_t               consumed = 0;
+    hpack_header_parser_t parser;
+    hpack_header_field_t  field;
+    chula_buffer_t        raw;
+    unsigned char         block[] = {0x82};
+
+    /* C.2.4.  Indexed Header Field
+     */
+    hpack_header_parser_init (&parser);
+    hpack_header_field_init (&field);
+    fake_raw (&raw, block);
+
+    ret = hpack_header_parser_field (&parser, &raw, 0, &field, &consumed);
+    ck_assert (ret == ret_ok);
+    ck_assert (consumed == 1);
+    ck_assert (field.rep == hpack_field_rep_indexed);
+    check_field (&field, ":method", "GET");
+
+    hpack_header_field_mrproper (&field);
+    hpack_header_parser_mrproper (&parser);
+}
+END_TEST
+
+START_TEST (requests_without_huffman)
+{
+    ret_t                 ret;
+    cuint_t               consumed = 0;
+    hpack_header_parser_t parser;
+    chula_list_t          fields   = LIST_HEAD_INIT(fields);
+    chula_list_t         *i;
+    chula_buffer_t        raw;
+    unsigned char         req1[]   = {0x82, 0x86, 0x84, 0x41, 0x0f, 'w','w','w','.','e','x','a','m','p','l','e','.','c','o','m'};
+    unsigned char         req2[]   = {0x82, 0x86, 0x84, 0xbe, 0x58, 0x08, 'n','o','-','c','a','c','h','e'};
+    unsigned char         req3[]   = {0x82, 0x87, 0x85, 0xbf, 0x40, 0x0a, 'c','u','s','t','o','m','-','k','e','y',
+                                      0x0c, 'c','u','s','t','o','m','-','v','a','l','u','e'};
+
+    hpack_header_parser_init (&parser);
+
+    /* C.3.1.  First Request
+     */
+    fake_raw (&raw, req1);
+    ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+    ck_assert (ret == ret_ok);
+    ck_assert (consumed == sizeof(req1));
+
+    i = fields.next;
+    check_field (HDR_FIELD(i), ":method", "GET");    i = i->next;
+    check_field (HDR_FIELD(i), ":scheme", "http");   i = i->next;
+    check_field (HDR_FIELD(i), ":path", "/");        i = i->next;
+    check_field (HDR_FIELD(i), ":authority", "www.example.com");
+    ck_assert (i->next == &fields);
+    ck_assert (parser.table.size == 57);
+
+    hpack_header_field_list_free (&fields);
+    ck_assert (chula_list_empty (&fields));
+
+    /* C.3.2.  Second Request
+     */
+    fake_raw (&raw, req2);
+    ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+    ck_assert (ret == ret_ok);
+    ck_assert (consumed == sizeof(req2));
+
+    i = fields.prev->prev;
+    check_field (HDR_FIELD(i), ":authority", "www.example.com"); i = i->next;
+    check_field (HDR_FIELD(i), "cache-control", "no-cache");
+    ck_assert (parser.table.num == 2);
+    ck_assert (parser.table.size == 110);
+
+    hpack_header_field_list_free (&fields);
+
+    /* C.3.3.  Third Request
+     */
+    fake_raw (&raw, req3);
+    ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+    ck_assert (ret == ret_ok);
+    ck_assert (consumed == sizeof(req3));
+
+    i = fields.next;
+    check_field (HDR_FIELD(i), ":method", "GET");              i = i->next;
+    check_field (HDR_FIELD(i), ":scheme", "https");            i = i->next;
+    check_field (HDR_FIELD(i), ":path", "/index.html");        i = i->next;
+    check_field (HDR_FIELD(i), ":authority", "www.example.com"); i = i->next;
+    check_field (HDR_FIELD(i), "custom-key", "custom-value");
+    ck_assert (parser.table.num == 3);
+    ck_assert (parser.table.size == 164);
+
+    hpack_header_field_list_free (&fields);
+    hpack_header_parser_mrproper (&parser);
+}
+END_TEST
+
+START_TEST (requests_with_huffman)
+{
+    ret_t                 ret;
+    cuint_t               consumed = 0;
+    hpack_header_parser_t parser;
+    chula_list_t          fields   = LIST_HEAD_INIT(fields);
+    chula_list_t         *i;
+    chula_buffer_t        raw;
+    unsigned char         req1[]   = {0x82, 0x86, 0x84, 0x41, 0x8c, 0xf1, 0xe3, 0xc2, 0xe5, 0xf2, 0x3a, 0x6b,
+                                      0xa0, 0xab, 0x90, 0xf4, 0xff};
+    unsigned char         req2[]   = {0x82, 0x86, 0x84, 0xbe, 0x58, 0x86, 0xa8, 0xeb, 0x10, 0x64, 0x9c, 0xbf};
+    unsigned char         req3[]   = {0x82, 0x87, 0x85, 0xbf, 0x40, 0x88, 0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xa9,
+                                      0x7d, 0x7f, 0x89, 0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xb8, 0xe8, 0xb4, 0xbf};
+
+    hpack_header_parser_init (&parser);
+
+    /* C.4.1.  First Request
+     */
+    fake_raw (&raw, req1);
+    ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+    ck_assert (ret == ret_ok);
+    ck_assert (consumed == sizeof(req1));
+
+    i = fields.prev;
+    check_field (HDR_FIELD(i), ":authority", "www.example.com");
+    ck_assert (parser.table.size == 57);
+    hpack_header_field_list_free (&fields);
+
+    /* C.4.2.  Second Request
+     */
+    fake_raw (&raw, req2);
+    ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+    ck_assert (ret == ret_ok);
+    ck_assert (consumed == sizeof(req2));
+
+    i = fields.prev->prev;
+    check_field (HDR_FIELD(i), ":authority", "www.example.com"); i = i->next;
+    check_field (HDR_FIELD(i), "cache-control", "no-cache");
+    ck_assert (parser.table.size == 110);
+    hpack_header_field_list_free (&fields);
+
+    /* C.4.3.  Third Request
+     */
+    fake_raw (&raw, req3);
+    ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+    ck_assert (ret == ret_ok);
+    ck_assert (consumed == sizeof(req3));
+
+    i = fields.prev;
+    check_field (HDR_FIELD(i), "custom-key", "custom-value");
+    ck_assert (parser.table.num == 3);
+    ck_assert (parser.table.size == 164);
+
+    hpack_header_field_list_free (&fields);
+    hpack_header_parser_mrproper (&parser);
+}
+END_TEST
+
+START_TEST (table_size_update)
+{
+    ret_t                 ret;
+    cuint_t               consumed = 0;
+    hpack_header_parser_t parser;
+    chula_list_t          fields   = LIST_HEAD_INIT(fields);
+    chula_buffer_t        raw;
+    unsigned char         req1[]   = {0x41, 0x03, 'f','o','o'};
+    unsigned char         req2[]   = {0x20, 0x3f, 0xe1, 0x1f, 0x82};
+    unsigned char         late[]   = {0x82, 0x20};
+    unsigned char         big[]    = {0x3f, 0xe2, 0x1f};
+
+    hpack_header_parser_init (&parser);
+
+    fake_raw (&raw, req1);
+    ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+    ck_assert (ret == ret_ok);
+    ck_assert (parser.table.num == 1);
+    hpack_header_field_list_free (&fields);
+
+    /* Emptied, then back to 4096 */
+    fake_raw (&raw, req2);
+    ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+    ck_assert (ret == ret_ok);
+    ck_assert (consumed == sizeof(req2));
+    ck_assert (parser.table.num == 0);
+    ck_assert (parser.table.max_size == 4096);
+    hpack_header_field_list_free (&fields);
+
+    /* Updates must precede the first field */
+    fake_raw (&raw, late);
+    ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+    ck_assert (ret == ret_error);
+    hpack_header_field_list_free (&fields);
+
+    /* Beyond SETTINGS_HEADER_TABLE_SIZE */
+    fake_raw (&raw, big);
+    ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+    ck_assert (ret == ret_error);
+
+    hpack_header_parser_mrproper (&parser);
+}
+END_TEST
+
+START_TEST (errors)
+{
+    ret_t                 ret;
+    cuint_t               consumed = 0;
+    hpack_header_parser_t parser;
+    hpack_header_field_t  field;
+    chula_buffer_t        raw;
+    unsigned char         zero[]   = {0x80};
+    unsigned char         range[]  = {0xbe};
+    unsigned char         trunc[]  = {0x04, 0x0c, '/','s','a','m'};
+    unsigned char         intlen[] = {0xff, 0xff, 0xff, 0xff, 0xff, 0x01};
+
+    hpack_header_parser_init (&parser);
+    hpack_header_field_init (&field);
+
+    fake_raw (&raw, zero);
+    ret = hpack_header_parser_field (&parser, &raw, 0, &field, &consumed);
+    ck_assert (ret == ret_error);
+
+    fake_raw (&raw, range);
+    ret = hpack_header_parser_field (&parser, &raw, 0, &field, &consumed);
+    ck_assert (ret == ret_error);
+
+    fake_raw (&raw, trunc);
+    ret = hpack_header_parser_field (&parser, &raw, 0, &field, &consumed);
+    ck_assert (ret == ret_eagain);
+
+    fake_raw (&raw, intlen);
+    ret = hpack_header_parser_field (&parser, &raw, 0, &field, &consumed);
+    ck_assert (ret == ret_error);
+
+    hpack_header_field_mrproper (&field);
+    hpack_header_parser_mrproper (&parser);
+}
+END_TEST
+
+static void
+check_same_fields (chula_list_t *a, chula_list_t *b)
+{
+    chula_list_t *i, *j;
+
+    for (i = a->next, j = b->next; (i != a) && (j != b); i = i->next, j = j->next) {
+        ck_assert (HDR_FIELD(i)->rep == HDR_FIELD(j)->rep);
+        ck_assert (chula_buffer_cmp_buf (&HDR_FIELD(i)->name,  &HDR_FIELD(j)->name)  == 0);
+        ck_assert (chula_buffer_cmp_buf (&HDR_FIELD(i)->value, &HDR_FIELD(j)->value) == 0);
+    }
+
+    ck_assert ((i == a) && (j == b));
+}
+
+/* Feeds a block in two fragments split at @cut, the second one
+ * delivered in pieces of @step bytes.
+ */
+static void
+feed_block (hpack_header_parser_t *parser,
+            unsigned char         *block,
+            cuint_t                len,
+            cuint_t                cut,
+            cuint_t                step,
+            chula_list_t          *fields)
+{
+    ret_t          ret;
+    cuint_t        off;
+    chula_buffer_t chunk;
+
+    ret = hpack_header_parser_begin (parser);
+    ck_assert (ret == ret_ok);
+
+    chula_buffer_fake (&chunk, (const char *)block, cut);
+    ret = hpack_header_parser_feed (parser, &chunk, fields);
+    ck_assert (ret == ret_ok);
+
+    for (off = cut; off < len; off += step) {
+        chula_buffer_fake (&chunk, (const char *)block + off, MIN (step, len - off));
+        ret = hpack_header_parser_feed (parser, &chunk, fields);
+        ck_assert (ret == ret_ok);
+    }
+
+    ret = hpack_header_parser_end (parser);
+    ck_assert (ret == ret_ok);
+}
+
+START_TEST (fragmented)
+{
+    ret_t                 ret;
+    cuint_t               consumed;
+    cuint_t               n, cut, step;
+    hpack_header_parser_t parser;
+    hpack_header_parser_t whole;
+    chula_list_t          fields   = LIST_HEAD_INIT(fields);
+    chula_list_t          expected = LIST_HEAD_INIT(expected);
+    chula_buffer_t        raw;
+    unsigned char         req1[]   = {0x82, 0x86, 0x84, 0x41, 0x8c, 0xf1, 0xe3, 0xc2, 0xe5, 0xf2, 0x3a, 0x6b,
+                                      0xa0, 0xab, 0x90, 0xf4, 0xff};
+    unsigned char         req2[]   = {0x3f, 0xe1, 0x1f, 0x82, 0x86, 0x84, 0xbe, 0x58, 0x86, 0xa8, 0xeb, 0x10,
+                                      0x64, 0x9c, 0xbf};
+    unsigned char         req3[24 + 7 + 130];
+    unsigned char         head3[]  = {0x82, 0x87, 0x85, 0xbf, 0x40, 0x88, 0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xa9,
+                                      0x7d, 0x7f, 0x89, 0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xb8, 0xe8, 0xb4, 0xbf,
+                                      0x00, 0x03, 'f','o','o', 0x7f, 0x03};
+    unsigned char        *blocks[] = {req1, req2, req3};
+    cuint_t               lens[]   = {sizeof(req1), sizeof(req2), sizeof(req3)};
+
+    /* C.4. with a table size update and a literal whose length
+     * spans two octets. Every split point is tried.
+     */
+    memcpy (req3, head3, sizeof(head3));
+    memset (req3 + sizeof(head3), 'x', sizeof(req3) - sizeof(head3));
+
+    for (cut = 0; cut <= sizeof(req3); cut++) {
+        for (step = 1; step <= 3; step++) {
+            hpack_header_parser_init (&parser);
+            hpack_header_parser_init (&whole);
+
+            for (n = 0; n < 3; n++) {
+                fake_raw (&raw, blocks[n]);
+                raw.len = lens[n];
+
+                ret = hpack_header_parser_all (&whole, &raw, 0, &expected, &consumed);
+                ck_assert (ret == ret_ok);
+
+                feed_block (&parser, blocks[n], lens[n], MIN (cut, lens[n]), step, &fields);
+                check_same_fields (&fields, &expected);
+                ck_assert (parser.table.size == whole.table.size);
+
+                hpack_header_field_list_free (&fields);
+                hpack_header_field_list_free (&expected);
+            }
+
+            hpack_header_parser_mrproper (&parser);
+            hpack_header_parser_mrproper (&whole);
+        }
+    }
+}
+END_TEST
+
+START_TEST (fragmented_errors)
+{
+    ret_t                 ret;
+    hpack_header_parser_t parser;
+    chula_list_t          fields   = LIST_HEAD_INIT(fields);
+    chula_buffer_t        chunk;
+    unsigned char         trunc[]  = {0x04, 0x0c, '/','s','a','m'};
+    unsigned char         eos[]    = {0x00, 0x84, 0xff, 0xff, 0xff, 0xff};
+    unsigned char         late[]   = {0x82, 0x20};
+
+    hpack_header_parser_init (&parser);
+
+    /* Block ends in the middle of a literal */
+    hpack_header_parser_begin (&parser);
+    fake_raw (&chunk, trunc);
+    ret = hpack_header_parser_feed (&parser, &chunk, &fields);
+    ck_assert (ret == ret_ok);
+    ret = hpack_header_parser_end (&parser);
+    ck_assert (ret == ret_error);
+
+    /* EOS in a Huffman string split across fragments */
+    hpack_header_parser_begin (&parser);
+    chula_buffer_fake (&chunk, (const char *)eos, 4);
+    ret = hpack_header_parser_feed (&parser, &chunk, &fields);
+    ck_assert (ret == ret_ok);
+    chula_buffer_fake (&chunk, (const char *)eos + 4, 2);
+    ret = hpack_header_parser_feed (&parser, &chunk, &fields);
+    ck_assert (ret == ret_error);
+
+    /* Table size update after a field, in the next fragment */
+    hpack_header_parser_begin (&parser);
+    chula_buffer_fake (&chunk, (const char *)late, 1);
+    ret = hpack_header_parser_feed (&parser, &chunk, &fields);
+    ck_assert (ret == ret_ok);
+    chula_buffer_fake (&chunk, (const char *)late + 1, 1);
+    ret = hpack_header_parser_feed (&parser, &chunk, &fields);
+    ck_assert (ret == ret_error);
+
+    hpack_header_field_list_free (&fields);
+    hpack_header_parser_mrproper (&parser);
+}
+END_TEST
+
+START_TEST (views)
+{
+    ret_t                 ret;
+    cuint_t               consumed = 0;
+    hpack_header_parser_t parser;
+    chula_list_t          fields   = LIST_HEAD_INIT(fields);
+    chula_list_t         *i;
+    chula_buffer_t        raw;
+    chula_buffer_t        chunk;
+    unsigned char         req1[]   = {0x82, 0x86, 0x84, 0x41, 0x0f, 'w','w','w','.','e','x','a','m','p','l','e','.','c','o','m'};
+    unsigned char         req3[]   = {0x82, 0x87, 0x85, 0xbe, 0x40, 0x0a, 'c','u','s','t','o','m','-','k','e','y',
+                                      0x0c, 'c','u','s','t','o','m','-','v','a','l','u','e'};
+    unsigned char         huff[]   = {0x40, 0x88, 0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xa9, 0x7d, 0x7f,
+                                      0x89, 0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xb8, 0xe8, 0xb4, 0xbf};
+
+    hpack_header_parser_init (&parser);
+    hpack_header_parser_set_views (&parser, true);
+
+    /* Raw literal value: view. Static table name: copy.
+     */
+    fake_raw (&raw, req1);
+    ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+    ck_assert (ret == ret_ok);
+
+    i = fields.prev;
+    check_field (HDR_FIELD(i), ":authority", "www.example.com");
+    ck_assert (! HDR_FIELD(i)->name_view);
+    ck_assert (HDR_FIELD(i)->value_view);
+    ck_assert (HDR_FIELD(i)->value.buf == (char *)req1 + 5);
+    hpack_header_field_list_free (&fields);
+
+    /* Dynamic table reference: copy */
+    ck_assert (parser.table.num == 1);
+    memset (req1, 0, sizeof(req1));
+
+    /* Raw literal name and value, the first one split across
+     * fragments
+     */
+    hpack_header_parser_begin (&parser);
+    chula_buffer_fake (&chunk, (const char *)req3, 9);
+    ret = hpack_header_parser_feed (&parser, &chunk, &fields);
+    ck_assert (ret == ret_ok);
+    chula_buffer_fake (&chunk, (const char *)req3 + 9, sizeof(req3) - 9);
+    ret = hpack_header_parser_feed (&parser, &chunk, &fields);
+    ck_assert (ret == ret_ok);
+    ck_assert (hpack_header_parser_end (&parser) == ret_ok);
+
+    i = fields.prev->prev;
+    check_field (HDR_FIELD(i), ":authority", "www.example.com");
+    ck_assert (! HDR_FIELD(i)->value_view);
+
+    i = fields.prev;
+    check_field (HDR_FIELD(i), "custom-key", "custom-value");
+    ck_assert (! HDR_FIELD(i)->name_view);
+    ck_assert (HDR_FIELD(i)->value_view);
+    ck_assert (HDR_FIELD(i)->value.buf == (char *)req3 + 17);
+    hpack_header_field_list_free (&fields);
+
+    /* Huffman encoded literals: copies */
+    fake_raw (&raw, huff);
+    ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+    ck_assert (ret == ret_ok);
+
+    i = fields.prev;
+    check_field (HDR_FIELD(i), "custom-key", "custom-value");
+    ck_assert (! HDR_FIELD(i)->name_view);
+    ck_assert (! HDR_FIELD(i)->value_view);
+
+    hpack_header_field_list_free (&fields);
+    hpack_header_parser_mrproper (&parser);
+}
+END_TEST
+
+START_TEST (arena)
+{
+    ret_t                 ret;
+    cuint_t               consumed = 0;
+    hpack_header_parser_t parser;
+    chula_arena_t         arena;
+    chula_list_t          fields   = LIST_HEAD_INIT(fields);
+    chula_list_t         *i;
+    chula_buffer_t        raw;
+    unsigned char         req1[]   = {0x82, 0x86, 0x84, 0x41, 0x8c, 0xf1, 0xe3, 0xc2, 0xe5, 0xf2, 0x3a, 0x6b,
+                                      0xa0, 0xab, 0x90, 0xf4, 0xff};
+    unsigned char         req2[]   = {0x82, 0x86, 0x84, 0xbe, 0x58, 0x08, 'n','o','-','c','a','c','h','e'};
+
+    hpack_header_parser_init (&parser);
+    chula_arena_init (&arena);
+    hpack_header_parser_set_arena (&parser, &arena);
+
+    /* Huffman decoded strings are copied to the arena
+     */
+    fake_raw (&raw, req1);
+    ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+    ck_assert (ret == ret_ok);
+    ck_assert (consumed == sizeof(req1));
+
+    i = fields.next;
+    check_field (HDR_FIELD(i), ":method", "GET");
+    ck_assert (HDR_FIELD(i)->rep == hpack_field_rep_indexed);
+    ck_assert (HDR_FIELD(i)->name_view);
+
+    i = fields.prev;
+    check_field (HDR_FIELD(i), ":authority", "www.example.com");
+    ck_assert (HDR_FIELD(i)->rep == hpack_field_rep_literal_inc_index);
+    ck_assert (HDR_FIELD(i)->value_view);
+    ck_assert (HDR_FIELD(i)->value.buf[HDR_FIELD(i)->value.len] == '\0');
+
+    /* The whole list goes away at once */
+    INIT_LIST_HEAD (&fields);
+    chula_arena_reset (&arena);
+
+    /* Views into the input are kept as views
+     */
+    hpack_header_parser_set_views (&parser, true);
+
+    fake_raw (&raw, req2);
+    ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+    ck_assert (ret == ret_ok);
+
+    i = fields.prev;
+    check_field (HDR_FIELD(i), "cache-control", "no-cache");
+    ck_assert (HDR_FIELD(i)->value.buf == (char *)req2 + 6);
+
+    i = i->prev;
+    check_field (HDR_FIELD(i), ":authority", "www.example.com");
+
+    chula_arena_mrproper (&arena);
+    hpack_header_parser_mrproper (&parser);
+}
+END_TEST
+
+START_TEST (validate)
+{
+    ret_t                 ret;
+    cuint_t               consumed;
+    cuint_t               cut;
+    hpack_header_parser_t parser;
+    chula_list_t          fields    = LIST_HEAD_INIT(fields);
+    chula_buffer_t        raw;
+    chula_buffer_t        chunk;
+    chula_buffer_t        name      = CHULA_BUF_INIT;
+    chula_buffer_t        block     = CHULA_BUF_INIT;
+    unsigned char         req1[]    = {0x82, 0x86, 0x84, 0x41, 0x0f, 'w','w','w','.','e','x','a','m','p','l','e','.','c','o','m'};
+    unsigned char         upper[]   = {0x00, 0x0a, 'C','u','s','t','o','m','-','K','e','y', 0x01, 'v'};
+    unsigned char         empty[]   = {0x00, 0x00, 0x01, 'v'};
+    unsigned char         colon[]   = {0x00, 0x05, 'a','b',':','c','d', 0x01, 'v'};
+    unsigned char         pseudo[]  = {0x00, 0x05, ':','p','a','t','h', 0x01, '/'};
+    unsigned char         crlf[]    = {0x00, 0x01, 'x', 0x04, 'a','\r','\n','b'};
+    unsigned char        *bad[]     = {upper, empty, colon, crlf};
+    cuint_t               bad_len[] = {sizeof(upper), sizeof(empty), sizeof(colon), sizeof(crlf)};
+    cuint_t               n, views;
+
+    /* Nothing is checked unless asked for */
+    hpack_header_parser_init (&parser);
+    fake_raw (&raw, upper);
+    ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+    ck_assert (ret == ret_ok);
+    check_field (HDR_FIELD(fields.next), "Custom-Key", "v");
+    hpack_header_field_list_free (&fields);
+    hpack_header_parser_mrproper (&parser);
+
+    /* Raw names, copied and as views
+     */
+    for (views = 0; views < 2; views++) {
+        hpack_header_parser_init (&parser);
+        hpack_header_parser_set_validate (&parser, true);
+        hpack_header_parser_set_views (&parser, views);
+
+        fake_raw (&raw, req1);
+        ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+        ck_assert (ret == ret_ok);
+        hpack_header_field_list_free (&fields);
+
+        fake_raw (&raw, pseudo);
+        ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+        ck_assert (ret == ret_ok);
+        check_field (HDR_FIELD(fields.next), ":path", "/");
+        hpack_header_field_list_free (&fields);
+
+        for (n = 0; n < 4; n++) {
+            chula_buffer_fake (&raw, (const char *)bad[n], bad_len[n]);
+            ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+            ck_assert (ret == ret_error);
+            hpack_header_field_list_free (&fields);
+        }
+
+        hpack_header_parser_mrproper (&parser);
+    }
+
+    /* Names split across fragments: a colon is only allowed in front
+     */
+    for (cut = 1; cut < sizeof(colon); cut++) {
+        hpack_header_parser_init (&parser);
+        hpack_header_parser_set_validate (&parser, true);
+
+        feed_block (&parser, pseudo, sizeof(pseudo), cut, sizeof(pseudo), &fields);
+        check_field (HDR_FIELD(fields.next), ":path", "/");
+        hpack_header_field_list_free (&fields);
+
+        hpack_header_parser_begin (&parser);
+        chula_buffer_fake (&chunk, (const char *)colon, cut);
+        ret = hpack_header_parser_feed (&parser, &chunk, &fields);
+        if (ret == ret_ok) {
+            chula_buffer_fake (&chunk, (const char *)colon + cut, sizeof(colon) - cut);
+            ret = hpack_header_parser_feed (&parser, &chunk, &fields);
+        }
+        ck_assert (ret == ret_error);
+        hpack_header_field_list_free (&fields);
+
+        hpack_header_parser_mrproper (&parser);
+    }
+
+    /* Huffman encoded names are checked once decoded
+     */
+    chula_buffer_add_str (&name, "X-Custom");
+    chula_buffer_add_char (&block, 0x00);
+    chula_buffer_add_char (&block, 0x80 | hpack_huffman_encoded_length (&name));
+    hpack_huffman_encode (&name, &block);
+    chula_buffer_add_str (&block, "\x01v");
+
+    hpack_header_parser_init (&parser);
+    ret = hpack_header_parser_all (&parser, &block, 0, &fields, &consumed);
+    ck_assert (ret == ret_ok);
+    check_field (HDR_FIELD(fields.next), "X-Custom", "v");
+    hpack_header_field_list_free (&fields);
+
+    hpack_header_parser_set_validate (&parser, true);
+    ret = hpack_header_parser_all (&parser, &block, 0, &fields, &consumed);
+    ck_assert (ret == ret_error);
+    hpack_header_field_list_free (&fields);
+    hpack_header_parser_mrproper (&parser);
+
+    chula_buffer_mrproper (&name);
+    chula_buffer_mrproper (&block);
+}
+END_TEST
+
+START_TEST (limits)
+{
+    ret_t                 ret;
+    cuint_t               consumed;
+    hpack_header_parser_t parser;
+    hpack_parser_limits_t limits;
+    chula_list_t          fields  = LIST_HEAD_INIT(fields);
+    chula_buffer_t        raw;
+    chula_buffer_t        value   = CHULA_BUF_INIT;
+    chula_buffer_t        block   = CHULA_BUF_INIT;
+    unsigned char         req1[]  = {0x82, 0x86, 0x84, 0x41, 0x0f, 'w','w','w','.','e','x','a','m','p','l','e','.','c','o','m'};
+    unsigned char         huge[]  = {0x00, 0x01, 'x', 0x7f, 0x81, 0xff, 0x7f, 'y', 'y'};
+    unsigned char         again[] = {0xbe};
+
+    /* C.3.1. holds 4 fields, for a header list size of 180
+     */
+    struct {
+        size_t  list;
+        size_t  field;
+        cuint_t fields;
+        ret_t   ret;
+    } cases[] = {
+        {  0,  0, 4, ret_ok  }, {  0,  0, 3, ret_deny },
+        {180,  0, 0, ret_ok  }, {179,  0, 0, ret_deny },
+        {  0, 25, 0, ret_ok  }, {  0, 24, 0, ret_deny },
+    };
+    cuint_t n;
+
+    for (n = 0; n < sizeof(cases) / sizeof(cases[0]); n++) {
+        hpack_header_parser_init (&parser);
+
+        limits.max_list_size  = cases[n].list;
+        limits.max_field_size = cases[n].field;
+        limits.max_fields     = cases[n].fields;
+        hpack_header_parser_set_limits (&parser, &limits);
+
+        fake_raw (&raw, req1);
+        ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+        ck_assert (ret == cases[n].ret);
+
+        hpack_header_field_list_free (&fields);
+        hpack_header_parser_mrproper (&parser);
+    }
+
+    /* A string is refused on its length, before its octets arrive
+     */
+    hpack_header_parser_init (&parser);
+    hpack_header_parser_begin (&parser);
+    fake_raw (&raw, huge);
+    ret = hpack_header_parser_feed (&parser, &raw, &fields);
+    ck_assert (ret == ret_ok);
+    hpack_header_parser_mrproper (&parser);
+
+    memset (&limits, 0, sizeof(limits));
+    limits.max_field_size = 1000;
+
+    hpack_header_parser_init (&parser);
+    hpack_header_parser_set_limits (&parser, &limits);
+    hpack_header_parser_begin (&parser);
+    ret = hpack_header_parser_feed (&parser, &raw, &fields);
+    ck_assert (ret == ret_deny);
+    ck_assert (chula_list_empty (&fields));
+
+    /* Huffman strings are dropped while they are decoded: 2000 'a's
+     * take 1250 octets, and decode past the limit
+     */
+    for (n = 0; n < 2000; n++) {
+        chula_buffer_add_char (&value, 'a');
+    }
+
+    chula_buffer_add (&block, "\x00\x01x\xff", 4);
+    n = hpack_huffman_encoded_length (&value) - 127;
+    chula_buffer_add_char (&block, 0x80 | (n & 0x7f));
+    chula_buffer_add_char (&block, n >> 7);
+    hpack_huffman_encode (&value, &block);
+
+    ret = hpack_header_parser_all (&parser, &block, 0, &fields, &consumed);
+    ck_assert (ret == ret_deny);
+    ck_assert (parser.field->value.len <= 1000 + 256 * 8 / 5);
+
+    /* Without the limits, it decodes */
+    hpack_header_parser_set_limits (&parser, NULL);
+    ret = hpack_header_parser_all (&parser, &block, 0, &fields, &consumed);
+    ck_assert (ret == ret_ok);
+    ck_assert (HDR_FIELD(fields.next)->value.len == 2000);
+    hpack_header_field_list_free (&fields);
+    hpack_header_parser_mrproper (&parser);
+
+    /* Entries of the header table are checked before being copied
+     */
+    hpack_header_parser_init (&parser);
+    chula_buffer_clean (&block);
+    chula_buffer_add (&block, "\x40\x01x\x7f\xe9\x06", 6);
+    for (n = 0; n < 1000; n++) {
+        chula_buffer_add_char (&block, 'b');
+    }
+
+    ret = hpack_header_parser_all (&parser, &block, 0, &fields, &consumed);
+    ck_assert (ret == ret_ok);
+    hpack_header_field_list_free (&fields);
+
+    hpack_header_parser_set_limits (&parser, &limits);
+    fake_raw (&raw, again);
+    ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+    ck_assert (ret == ret_deny);
+    ck_assert (parser.field->value.len == 0);
+
+    hpack_header_parser_mrproper (&parser);
+    chula_buffer_mrproper (&value);
+    chula_buffer_mrproper (&block);
+}
+END_TEST
+
+START_TEST (ids)
+{
+    ret_t                 ret;
+    cuint_t               consumed;
+    hpack_header_parser_t parser;
+    hpack_header_list_t   list;
+    chula_list_t          fields = LIST_HEAD_INIT(fields);
+    chula_list_t         *i;
+    chula_buffer_t        raw;
+    unsigned char         req[]  = {0x82, 0x86, 0x84, 0x41, 0x0f, 'w','w','w','.','e','x','a','m','p','l','e','.','c','o','m',
+                                    0x40, 0x0c, 'c','o','n','t','e','n','t','-','t','y','p','e', 0x01, 'x',
+                                    0x40, 0x03, 'f','o','o', 0x01, 'y'};
+    unsigned char         again[] = {0xbf, 0xbe, 0x7f, 0x01, 0x01, 'z'};
+    hpack_header_id_t     ids1[] = {hpack_header_id_method, hpack_header_id_scheme, hpack_header_id_path,
+                                    hpack_header_id_authority, hpack_header_id_content_type, hpack_header_id_unknown};
+    hpack_header_id_t     ids2[] = {hpack_header_id_content_type, hpack_header_id_unknown, hpack_header_id_authority};
+    hpack_header_id_t     ids3[] = {hpack_header_id_unknown, hpack_header_id_authority, hpack_header_id_content_type};
+    cuint_t               n;
+
+    /* Static references, literal names and dynamic references: the
+     * last ones get the ID the entry was added with
+     */
+    hpack_header_parser_init (&parser);
+
+    fake_raw (&raw, req);
+    ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+    ck_assert (ret == ret_ok);
+
+    n = 0;
+    list_for_each (i, &fields) {
+        ck_assert (HDR_FIELD(i)->id == ids1[n++]);
+    }
+    ck_assert (n == 6);
+    hpack_header_field_list_free (&fields);
+
+    fake_raw (&raw, again);
+    ret = hpack_header_parser_all (&parser, &raw, 0, &fields, &consumed);
+    ck_assert (ret == ret_ok);
+
+    n = 0;
+    list_for_each (i, &fields) {
+        ck_assert (HDR_FIELD(i)->id == ids2[n++]);
+    }
+    ck_assert (n == 3);
+    hpack_header_field_list_free (&fields);
+
+    /* Packed lists keep them next to the representation. The table
+     * moved by one entry since.
+     */
+    hpack_header_list_init (&list);
+    hpack_header_parser_set_list (&parser, &list);
+
+    ret = hpack_header_parser_all (&parser, &raw, 0, NULL, &consumed);
+    ck_assert (ret == ret_ok);
+    ck_assert (list.num == 3);
+
+    for (n = 0; n < 3; n++) {
+        ck_assert (HPACK_LIST_ID(&list, n) == ids3[n]);
+    }
+    ck_assert (HPACK_LIST_REP(&list, 0) == hpack_field_rep_indexed);
+    ck_assert (HPACK_LIST_REP(&list, 2) == hpack_field_rep_literal_inc_index);
+
+    hpack_header_list_mrproper (&list);
+    hpack_header_parser_mrproper (&parser);
+}
+END_TEST
+
+int
+header_parser_tests (void)
+{
+    Suite *s1 = suite_create("Header parser");
+
+    check_add (s1, literal_inc_index);
+    check_add (s1, literal_without_index);
+    check_add (s1, literal_never_index);
+    check_add (s1, indexed);
+    check_add (s1, requests_without_huffman);
+    check_add (s1, requests_with_huffman);
+    check_add (s1, table_size_update);
+    check_add (s1, errors);
+    check_add (s1, fragmented);
+    check_add (s1, fragmented_errors);
+    check_add (s1, views);
+    check_add (s1, arena);
+    check_add (s1, validate);
+    check_add (s1, limits);
+    check_add (s1, ids);
+
+    run_test (s1);
+}
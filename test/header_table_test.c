@@ -0,0 +1,313 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "test.h"
+#include "libhpack/header_table.h"
+
+#define check_entry(t,i,n,v)                                        \
+    do {                                                            \
+        chula_buffer_t _n, _v;                                      \
+        ck_assert (hpack_header_table_get (t, i, &_n, &_v) == ret_ok); \
+        ck_assert (_n.len == strlen(n));                            \
+        ck_assert (memcmp (_n.buf, n, _n.len) == 0);                \
+        ck_assert (_v.len == strlen(v));                            \
+        ck_assert (memcmp (_v.buf, v, _v.len) == 0);                \
+    } while (0)
+
+
+START_TEST (static_table)
+{
+    hpack_header_table_t table;
+    chula_buffer_t       name;
+
+    hpack_header_table_init (&table);
+
+    check_entry (&table, 1, ":authority", "");
+    check_entry (&table, 2, ":method", "GET");
+    check_entry (&table, 16, "accept-encoding", "gzip, deflate");
+    check_entry (&table, 61, "www-authenticate", "");
+
+    ck_assert (hpack_header_table_get (&table, 0, &name, NULL) == ret_not_found);
+    ck_assert (hpack_header_table_get (&table, 62, &name, NULL) == ret_not_found);
+
+    hpack_header_table_mrproper (&table);
+}
+END_TEST
+
+START_TEST (add_evict)
+{
+    hpack_header_table_t table;
+    chula_buffer_t       name  = CHULA_BUF_INIT;
+    chula_buffer_t       value = CHULA_BUF_INIT;
+
+    hpack_header_table_init (&table);
+    hpack_header_table_set_max_size (&table, 100);
+
+    chula_buffer_fake_str (&name, "name1");
+    chula_buffer_fake_str (&value, "value");
+    hpack_header_table_add (&table, &name, &value);
+    ck_assert (table.num == 1);
+    ck_assert (table.size == 42);
+
+    chula_buffer_fake_str (&name, "name2");
+    hpack_header_table_add (&table, &name, &value);
+    ck_assert (table.num == 2);
+    ck_assert (table.size == 84);
+    check_entry (&table, 62, "name2", "value");
+    check_entry (&table, 63, "name1", "value");
+
+    /* The oldest entry is evicted */
+    chula_buffer_fake_str (&name, "name3");
+    hpack_header_table_add (&table, &name, &value);
+    ck_assert (table.num == 2);
+    ck_assert (table.size == 84);
+    check_entry (&table, 62, "name3", "value");
+    check_entry (&table, 63, "name2", "value");
+    ck_assert (hpack_header_table_get (&table, 64, &name, NULL) == ret_not_found);
+
+    /* Shrinking the table evicts */
+    hpack_header_table_set_max_size (&table, 50);
+    ck_assert (table.num == 1);
+    check_entry (&table, 62, "name3", "value");
+
+    /* An entry larger than the table empties it */
+    chula_buffer_fake_str (&value, "a value far too long for this table");
+    hpack_header_table_add (&table, &name, &value);
+    ck_assert (table.num == 0);
+    ck_assert (table.size == 0);
+
+    /* Beyond SETTINGS_HEADER_TABLE_SIZE */
+    ck_assert (hpack_header_table_set_max_size (&table, 4097) == ret_error);
+
+    hpack_header_table_mrproper (&table);
+}
+END_TEST
+
+START_TEST (name_from_table)
+{
+    hpack_header_table_t table;
+    chula_buffer_t       name  = CHULA_BUF_INIT;
+    chula_buffer_t       value = CHULA_BUF_INIT;
+
+    hpack_header_table_init (&table);
+    hpack_header_table_set_max_size (&table, 80);
+
+    chula_buffer_fake_str (&name, "referenced");
+    chula_buffer_fake_str (&value, "value");
+    hpack_header_table_add (&table, &name, &value);
+
+    /* The new entry evicts the one its name comes from */
+    hpack_header_table_get (&table, 62, &name, NULL);
+    chula_buffer_fake_str (&value, "another value");
+    hpack_header_table_add (&table, &name, &value);
+
+    ck_assert (table.num == 1);
+    check_entry (&table, 62, "referenced", "another value");
+
+    hpack_header_table_mrproper (&table);
+}
+END_TEST
+
+START_TEST (find)
+{
+    ret_t                ret;
+    cuint_t              index;
+    bool                 match;
+    hpack_header_table_t table;
+    chula_buffer_t       name;
+    chula_buffer_t       value;
+
+    hpack_header_table_init (&table);
+
+    chula_buffer_fake_str (&name, "custom-key");
+    chula_buffer_fake_str (&value, "one");
+    hpack_header_table_add (&table, &name, &value);
+    chula_buffer_fake_str (&value, "two");
+    hpack_header_table_add (&table, &name, &value);
+
+    /* Static table first */
+    chula_buffer_fake_str (&name, ":method");
+    chula_buffer_fake_str (&value, "POST");
+    ret = hpack_header_table_find (&table, &name, &value, &index, &match);
+    ck_assert ((ret == ret_ok) && match && (index == 3));
+
+    chula_buffer_fake_str (&value, "PUT");
+    ret = hpack_header_table_find (&table, &name, &value, &index, &match);
+    ck_assert ((ret == ret_ok) && (! match) && (index == 2));
+
+    /* Dynamic table: pair, then the newest name */
+    chula_buffer_fake_str (&name, "custom-key");
+    chula_buffer_fake_str (&value, "one");
+    ret = hpack_header_table_find (&table, &name, &value, &index, &match);
+    ck_assert ((ret == ret_ok) && match && (index == 63));
+
+    ret = hpack_header_table_find (&table, &name, NULL, &index, &match);
+    ck_assert ((ret == ret_ok) && (! match) && (index == 62));
+
+    chula_buffer_fake_str (&name, "missing");
+    ret = hpack_header_table_find (&table, &name, &value, &index, &match);
+    ck_assert (ret == ret_not_found);
+
+    hpack_header_table_mrproper (&table);
+}
+END_TEST
+
+START_TEST (ring_wrap)
+{
+    int                  i, j;
+    unsigned int         seed  = 7;
+    char                 names[64][40];
+    char                 values[64][80];
+    int                  sizes[64];
+    int                  num   = 0;
+    int                  used  = 0;
+    hpack_header_table_t table;
+    chula_buffer_t       name;
+    chula_buffer_t       value;
+
+    hpack_header_table_init (&table);
+    hpack_header_table_set_settings_size (&table, 512);
+    hpack_header_table_set_max_size (&table, 512);
+
+    for (i = 0; i < 5000; i++) {
+        int nlen, vlen;
+
+        seed = seed * 1103515245 + 12345;
+        nlen = 1 + (seed >> 16) % 38;
+        seed = seed * 1103515245 + 12345;
+        vlen = (seed >> 16) % 79;
+
+        /* Model of the table */
+        memmove (&names[1], &names[0], sizeof(names[0]) * 63);
+        memmove (&values[1], &values[0], sizeof(values[0]) * 63);
+        memmove (&sizes[1], &sizes[0], sizeof(sizes[0]) * 63);
+
+        memset (names[0], 'a' + i % 26, nlen);
+        names[0][nlen] = '\0';
+        memset (values[0], 'A' + i % 26, vlen);
+        values[0][vlen] = '\0';
+        sizes[0] = nlen + vlen + 32;
+
+        num  += 1;
+        used += sizes[0];
+        while (used > 512) {
+            used -= sizes[--num];
+        }
+
+        /* Table */
+        chula_buffer_fake (&name, names[0], nlen);
+        chula_buffer_fake (&value, values[0], vlen);
+        hpack_header_table_add (&table, &name, &value);
+
+        ck_assert (table.num == (cuint_t)num);
+        ck_assert (table.size == (size_t)used);
+        for (j = 0; j < num; j++) {
+            check_entry (&table, 62 + j, names[j], values[j]);
+        }
+    }
+
+    /* Growing the limit keeps the entries */
+    hpack_header_table_set_settings_size (&table, 4096);
+    ck_assert (table.num == (cuint_t)num);
+    for (j = 0; j < num; j++) {
+        check_entry (&table, 62 + j, names[j], values[j]);
+    }
+
+    hpack_header_table_mrproper (&table);
+}
+END_TEST
+
+START_TEST (resize)
+{
+    hpack_header_table_t  table;
+    chula_buffer_t        name;
+    chula_buffer_t        value;
+    char                 *data;
+
+    hpack_header_table_init (&table);
+    hpack_header_table_set_settings_size (&table, 65536);
+
+    /* Sized for the maximum size in use, not for the settings */
+    chula_buffer_fake_str (&name, "x-first");
+    chula_buffer_fake_str (&value, "1");
+    hpack_header_table_add (&table, &name, &value);
+    ck_assert (table.data_size == 2 * 4096);
+
+    /* Small steps up reallocate once, doubling */
+    ck_assert (hpack_header_table_set_max_size (&table, 4200) == ret_ok);
+    ck_assert (table.data_size == 2 * 8192);
+    data = table.data;
+
+    ck_assert (hpack_header_table_set_max_size (&table, 4300) == ret_ok);
+    ck_assert (hpack_header_table_set_max_size (&table, 8000) == ret_ok);
+    ck_assert (table.data == data);
+    check_entry (&table, 62, "x-first", "1");
+
+    /* Shrinking evicts in place, growing back is free */
+    chula_buffer_fake_str (&name, "x-second");
+    chula_buffer_fake_str (&value, "2");
+    hpack_header_table_add (&table, &name, &value);
+
+    ck_assert (hpack_header_table_set_max_size (&table, 50) == ret_ok);
+    ck_assert (table.num == 1);
+    check_entry (&table, 62, "x-second", "2");
+
+    ck_assert (hpack_header_table_set_max_size (&table, 8192) == ret_ok);
+    ck_assert (table.data == data);
+    ck_assert (table.num == 1);
+
+    /* Growth stops at the settings */
+    hpack_header_table_set_settings_size (&table, 10000);
+    ck_assert (table.data_size == 2 * 8192);
+    ck_assert (hpack_header_table_set_max_size (&table, 9000) == ret_ok);
+    ck_assert (table.data_size == 2 * 10000);
+    ck_assert (table.entries_size == 10000 / 32);
+    check_entry (&table, 62, "x-second", "2");
+
+    hpack_header_table_mrproper (&table);
+}
+END_TEST
+
+int
+header_table_tests (void)
+{
+    Suite *s1 = suite_create("Header table");
+
+    check_add (s1, static_table);
+    check_add (s1, add_evict);
+    check_add (s1, name_from_table);
+    check_add (s1, find);
+    check_add (s1, ring_wrap);
+    check_add (s1, resize);
+
+    run_test (s1);
+}
@@ -0,0 +1,216 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "test.h"
+#include "libhpack/huffman_cache.h"
+#include "libhpack/header_encoder.h"
+#include "libhpack/hash.h"
+
+#define cache_add(c,s,r) \
+    hpack_huffman_cache_add (c, s, strlen(s), hpack_hash (s, strlen(s), HPACK_HASH_INIT), r, strlen(r))
+
+#define cache_get(c,s,o) \
+    hpack_huffman_cache_get (c, s, strlen(s), hpack_hash (s, strlen(s), HPACK_HASH_INIT), o)
+
+
+START_TEST (add_get)
+{
+    ret_t                 ret;
+    hpack_huffman_cache_t cache;
+    chula_buffer_t        out = CHULA_BUF_INIT;
+
+    hpack_huffman_cache_init (&cache);
+
+    /* Disabled until it is sized */
+    ret = cache_add (&cache, "gzip", "\x03gz");
+    ck_assert (ret == ret_deny);
+    ret = cache_get (&cache, "gzip", &out);
+    ck_assert (ret == ret_not_found);
+
+    ret = hpack_huffman_cache_set_limits (&cache, 4, 8);
+    ck_assert (ret == ret_ok);
+
+    ret = cache_add (&cache, "gzip", "\x03gz");
+    ck_assert (ret == ret_ok);
+    ret = cache_add (&cache, "too-long-to-cache", "x");
+    ck_assert (ret == ret_deny);
+
+    ret = cache_get (&cache, "gzip", &out);
+    ck_assert (ret == ret_ok);
+    ret = cache_get (&cache, "gzip", &out);
+    ck_assert (ret == ret_ok);
+    ck_assert_str_eq (out.buf, "\x03gz\x03gz");
+
+    ret = cache_get (&cache, "gzi", &out);
+    ck_assert (ret == ret_not_found);
+    ret = cache_get (&cache, "too-long-to-cache", &out);
+    ck_assert (ret == ret_not_found);
+
+    chula_buffer_mrproper (&out);
+    hpack_huffman_cache_mrproper (&cache);
+}
+END_TEST
+
+START_TEST (evict)
+{
+    ret_t                 ret;
+    hpack_huffman_cache_t cache;
+    chula_buffer_t        out = CHULA_BUF_INIT;
+
+    hpack_huffman_cache_init (&cache);
+    hpack_huffman_cache_set_limits (&cache, 3, 8);
+
+    cache_add (&cache, "a", "1");
+    cache_add (&cache, "b", "2");
+    cache_add (&cache, "c", "3");
+
+    /* "a" becomes the most recently used, "b" the least */
+    ret = cache_get (&cache, "a", &out);
+    ck_assert (ret == ret_ok);
+
+    cache_add (&cache, "d", "4");
+    ck_assert (cache.used == 3);
+
+    ck_assert (cache_get (&cache, "b", &out) == ret_not_found);
+    ck_assert (cache_get (&cache, "a", &out) == ret_ok);
+    ck_assert (cache_get (&cache, "c", &out) == ret_ok);
+    ck_assert (cache_get (&cache, "d", &out) == ret_ok);
+    ck_assert_str_eq (out.buf, "1134");
+
+    /* Then "a", now the least recently used */
+    cache_add (&cache, "e", "5");
+    ck_assert (cache_get (&cache, "a", &out) == ret_not_found);
+    ck_assert (cache_get (&cache, "e", &out) == ret_ok);
+
+    chula_buffer_mrproper (&out);
+    hpack_huffman_cache_mrproper (&cache);
+}
+END_TEST
+
+START_TEST (frozen)
+{
+    ret_t                 ret;
+    hpack_huffman_cache_t cache;
+    chula_buffer_t        out = CHULA_BUF_INIT;
+
+    hpack_huffman_cache_init (&cache);
+    ret = hpack_huffman_cache_set_limits (&cache, 2, 8);
+    ck_assert (ret == ret_ok);
+
+    cache_add (&cache, "a", "1");
+    cache_add (&cache, "b", "2");
+    hpack_huffman_cache_freeze (&cache);
+
+    /* Lookups do not reorder, nothing is added */
+    ck_assert (cache_get (&cache, "a", &out) == ret_ok);
+    ck_assert (cache.head == 1);
+    ck_assert (cache_add (&cache, "c", "3") == ret_deny);
+    ck_assert (cache_get (&cache, "c", &out) == ret_not_found);
+    ck_assert (hpack_huffman_cache_set_limits (&cache, 4, 8) == ret_deny);
+
+    chula_buffer_mrproper (&out);
+    hpack_huffman_cache_mrproper (&cache);
+}
+END_TEST
+
+START_TEST (encoder)
+{
+    ret_t                  ret;
+    cuint_t                n;
+    hpack_header_encoder_t enc1;
+    hpack_header_encoder_t enc2;
+    hpack_huffman_cache_t  cache;
+    hpack_header_field_t   field;
+    chula_buffer_t         out1 = CHULA_BUF_INIT;
+    chula_buffer_t         out2 = CHULA_BUF_INIT;
+    const char            *pairs[][2] = {{"content-type", "application/json"},
+                                         {"server", "libhpack"},
+                                         {"x-trace", "0123456789abcdef"},
+                                         {"vary", "accept-encoding"}};
+
+    hpack_header_encoder_init (&enc1);
+    hpack_header_encoder_init (&enc2);
+    hpack_header_field_init (&field);
+    hpack_huffman_cache_init (&cache);
+    hpack_huffman_cache_set_limits (&cache, 16, 64);
+
+    hpack_header_encoder_set_cache (&enc2, &cache);
+
+    /* Literals without indexing: cached from the second round, and
+     * from the frozen cache on the third.
+     */
+    for (n = 0; n < 3 * 4; n++) {
+        if (n == 2 * 4) {
+            hpack_huffman_cache_freeze (&cache);
+        }
+
+        hpack_header_field_clean (&field);
+        chula_buffer_add (&field.name,  pairs[n % 4][0], strlen(pairs[n % 4][0]));
+        chula_buffer_add (&field.value, pairs[n % 4][1], strlen(pairs[n % 4][1]));
+        field.rep = hpack_field_rep_literal_never_index;
+
+        chula_buffer_clean (&out1);
+        chula_buffer_clean (&out2);
+
+        ret = hpack_header_encoder_field (&enc1, &field, &out1);
+        ck_assert (ret == ret_ok);
+        ret = hpack_header_encoder_field (&enc2, &field, &out2);
+        ck_assert (ret == ret_ok);
+
+        ck_assert (out1.len == out2.len);
+        ck_assert (memcmp (out1.buf, out2.buf, out1.len) == 0);
+    }
+
+    /* The four values, and the one name not in the static table */
+    ck_assert (cache.used == 5);
+
+    hpack_huffman_cache_mrproper (&cache);
+    hpack_header_field_mrproper (&field);
+    chula_buffer_mrproper (&out1);
+    chula_buffer_mrproper (&out2);
+    hpack_header_encoder_mrproper (&enc1);
+    hpack_header_encoder_mrproper (&enc2);
+}
+END_TEST
+
+int
+huffman_cache_tests (void)
+{
+    Suite *s1 = suite_create("Huffman cache");
+
+    check_add (s1, add_get);
+    check_add (s1, evict);
+    check_add (s1, frozen);
+    check_add (s1, encoder);
+
+    run_test (s1);
+}
@@ -0,0 +1,243 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "test.h"
+#include "libhpack/huffman.h"
+
+/* All examples came from:
+ * http://tools.ietf.org/html/rfc7541
+ */
+
+#define fake_raw(b,s) chula_buffer_fake (b, (const char *)s, sizeof(s))
+
+#define check_decode(enc,str)                               \
+    do {                                                    \
+        chula_buffer_t _e;                                  \
+        chula_buffer_t _d = CHULA_BUF_INIT;                 \
+        fake_raw (&_e, enc);                                \
+        ck_assert (hpack_huffman_decode (&_e, &_d) == ret_ok); \
+        ck_assert (_d.len == sizeof(str)-1);                \
+        ck_assert_str_eq (_d.buf, str);                     \
+        chula_buffer_mrproper (&_d);                        \
+    } while (0)
+
+#define check_encode(str,enc)                                       \
+    do {                                                            \
+        chula_buffer_t _s;                                          \
+        chula_buffer_t _e = CHULA_BUF_INIT;                         \
+        chula_buffer_fake_str (&_s, str);                           \
+        ck_assert (hpack_huffman_encoded_length (&_s) == sizeof(enc)); \
+        ck_assert (hpack_huffman_encode (&_s, &_e) == ret_ok);      \
+        ck_assert (_e.len == sizeof(enc));                          \
+        ck_assert (memcmp (_e.buf, enc, sizeof(enc)) == 0);         \
+        chula_buffer_mrproper (&_e);                                \
+    } while (0)
+
+
+START_TEST (decode_requests)
+{
+    unsigned char authority[] = {0xf1, 0xe3, 0xc2, 0xe5, 0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff};
+    unsigned char no_cache[]  = {0xa8, 0xeb, 0x10, 0x64, 0x9c, 0xbf};
+    unsigned char key[]       = {0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xa9, 0x7d, 0x7f};
+    unsigned char value[]     = {0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xb8, 0xe8, 0xb4, 0xbf};
+
+    /* C.4.  Request Examples with Huffman Coding
+     */
+    check_decode (authority, "www.example.com");
+    check_decode (no_cache, "no-cache");
+    check_decode (key, "custom-key");
+    check_decode (value, "custom-value");
+}
+END_TEST
+
+START_TEST (decode_responses)
+{
+    unsigned char status[]   = {0x64, 0x02};
+    unsigned char private[]  = {0xae, 0xc3, 0x77, 0x1a, 0x4b};
+    unsigned char date[]     = {0xd0, 0x7a, 0xbe, 0x94, 0x10, 0x54, 0xd4, 0x44, 0xa8, 0x20, 0x05, 0x95,
+                                0x04, 0x0b, 0x81, 0x66, 0xe0, 0x82, 0xa6, 0x2d, 0x1b, 0xff};
+    unsigned char location[] = {0x9d, 0x29, 0xad, 0x17, 0x18, 0x63, 0xc7, 0x8f, 0x0b, 0x97, 0xc8, 0xe9,
+                                0xae, 0x82, 0xae, 0x43, 0xd3};
+
+    /* C.6.  Response Examples with Huffman Coding
+     */
+    check_decode (status, "302");
+    check_decode (private, "private");
+    check_decode (date, "Mon, 21 Oct 2013 20:13:21 GMT");
+    check_decode (location, "https://www.example.com");
+}
+END_TEST
+
+START_TEST (decode_append)
+{
+    chula_buffer_t enc;
+    chula_buffer_t dec     = CHULA_BUF_INIT;
+    unsigned char  value[] = {0x25, 0xa8, 0x49, 0xe9, 0x5b, 0xb8, 0xe8, 0xb4, 0xbf};
+
+    chula_buffer_add_str (&dec, "x-");
+    fake_raw (&enc, value);
+
+    ck_assert (hpack_huffman_decode (&enc, &dec) == ret_ok);
+    ck_assert_str_eq (dec.buf, "x-custom-value");
+
+    chula_buffer_mrproper (&dec);
+}
+END_TEST
+
+START_TEST (decode_partial)
+{
+    cuint_t               i;
+    chula_buffer_t        enc;
+    chula_buffer_t        dec    = CHULA_BUF_INIT;
+    hpack_huffman_state_t state  = HPACK_HUFFMAN_STATE_INIT;
+    unsigned char         date[] = {0xd0, 0x7a, 0xbe, 0x94, 0x10, 0x54, 0xd4, 0x44, 0xa8, 0x20, 0x05, 0x95,
+                                    0x04, 0x0b, 0x81, 0x66, 0xe0, 0x82, 0xa6, 0x2d, 0x1b, 0xff};
+
+    /* One octet at a time */
+    for (i = 0; i < sizeof(date); i++) {
+        chula_buffer_fake (&enc, (const char *)date + i, 1);
+        ck_assert (hpack_huffman_decode_partial (&state, &enc, &dec) == ret_ok);
+    }
+
+    ck_assert (state.accept);
+    ck_assert_str_eq (dec.buf, "Mon, 21 Oct 2013 20:13:21 GMT");
+
+    chula_buffer_mrproper (&dec);
+}
+END_TEST
+
+START_TEST (decode_errors)
+{
+    chula_buffer_t enc;
+    chula_buffer_t dec       = CHULA_BUF_INIT;
+    unsigned char  eos[]     = {0xff, 0xff, 0xff, 0xfc};
+    unsigned char  long_pad[]= {0x1f, 0xff};
+    unsigned char  zero_pad[]= {0x18};
+    unsigned char  good_pad[]= {0x1f};
+
+    /* EOS in the string */
+    fake_raw (&enc, eos);
+    ck_assert (hpack_huffman_decode (&enc, &dec) == ret_error);
+
+    /* More than 7 bits of padding */
+    chula_buffer_clean (&dec);
+    fake_raw (&enc, long_pad);
+    ck_assert (hpack_huffman_decode (&enc, &dec) == ret_error);
+
+    /* Padding not made of 1s */
+    chula_buffer_clean (&dec);
+    fake_raw (&enc, zero_pad);
+    ck_assert (hpack_huffman_decode (&enc, &dec) == ret_error);
+
+    /* 'a' (00011) + 111 */
+    chula_buffer_clean (&dec);
+    fake_raw (&enc, good_pad);
+    ck_assert (hpack_huffman_decode (&enc, &dec) == ret_ok);
+    ck_assert_str_eq (dec.buf, "a");
+
+    chula_buffer_mrproper (&dec);
+}
+END_TEST
+
+START_TEST (encode_examples)
+{
+    unsigned char authority[] = {0xf1, 0xe3, 0xc2, 0xe5, 0xf2, 0x3a, 0x6b, 0xa0, 0xab, 0x90, 0xf4, 0xff};
+    unsigned char no_cache[]  = {0xa8, 0xeb, 0x10, 0x64, 0x9c, 0xbf};
+    unsigned char status[]    = {0x64, 0x02};
+    unsigned char date[]      = {0xd0, 0x7a, 0xbe, 0x94, 0x10, 0x54, 0xd4, 0x44, 0xa8, 0x20, 0x05, 0x95,
+                                 0x04, 0x0b, 0x81, 0x66, 0xe0, 0x82, 0xa6, 0x2d, 0x1b, 0xff};
+    unsigned char location[]  = {0x9d, 0x29, 0xad, 0x17, 0x18, 0x63, 0xc7, 0x8f, 0x0b, 0x97, 0xc8, 0xe9,
+                                 0xae, 0x82, 0xae, 0x43, 0xd3};
+
+    /* C.4. and C.6.
+     */
+    check_encode ("www.example.com", authority);
+    check_encode ("no-cache", no_cache);
+    check_encode ("302", status);
+    check_encode ("Mon, 21 Oct 2013 20:13:21 GMT", date);
+    check_encode ("https://www.example.com", location);
+}
+END_TEST
+
+START_TEST (encode_round_trip)
+{
+    int            n;
+    char           str[256 * 3];
+    chula_buffer_t raw;
+    chula_buffer_t enc = CHULA_BUF_INIT;
+    chula_buffer_t dec = CHULA_BUF_INIT;
+
+    /* Every symbol, in a few different bit alignments */
+    for (n = 0; n < (int)sizeof(str); n++) {
+        str[n] = (char) ((n * 7) % 256);
+    }
+
+    for (n = 0; n < 16; n++) {
+        chula_buffer_clean (&enc);
+        chula_buffer_clean (&dec);
+
+        chula_buffer_fake (&raw, str + n, sizeof(str) - n);
+        ck_assert (hpack_huffman_encode (&raw, &enc) == ret_ok);
+        ck_assert (enc.len == hpack_huffman_encoded_length (&raw));
+
+        ck_assert (hpack_huffman_decode (&enc, &dec) == ret_ok);
+        ck_assert (dec.len == raw.len);
+        ck_assert (memcmp (dec.buf, raw.buf, raw.len) == 0);
+    }
+
+    /* Empty string */
+    chula_buffer_clean (&enc);
+    chula_buffer_fake (&raw, "", 0);
+    ck_assert (hpack_huffman_encoded_length (&raw) == 0);
+    ck_assert (hpack_huffman_encode (&raw, &enc) == ret_ok);
+    ck_assert (enc.len == 0);
+
+    chula_buffer_mrproper (&enc);
+    chula_buffer_mrproper (&dec);
+}
+END_TEST
+
+int
+huffman_tests (void)
+{
+    Suite *s1 = suite_create("Huffman");
+
+    check_add (s1, decode_requests);
+    check_add (s1, decode_responses);
+    check_add (s1, decode_append);
+    check_add (s1, decode_partial);
+    check_add (s1, decode_errors);
+    check_add (s1, encode_examples);
+    check_add (s1, encode_round_trip);
+
+    run_test (s1);
+}
@@ -30,24 +30,14 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <check.h>
+#include "test.h"
 #include "libhpack/integer.h"
+#include <string.h>
 
 /* All examples came from:
  * http://tools.ietf.org/html/draft-ietf-httpbis-header-compression-05
  */
 
-#define check_add(suit,func)                             \
-    TCase *testcase_ ## func = tcase_create(#func);      \
-    suite_add_tcase (suit, testcase_ ## func);           \
-    tcase_add_test (testcase_ ##func, func);
-
-#define run_test(suit)                          \
-    SRunner *sr = srunner_create(suit);         \
-    srunner_run_all(sr, CK_VERBOSE);            \
-    return srunner_ntests_failed(sr);
-
-
 START_TEST (encode_10_5bits)
 {
     unsigned char len   = 0xFF;
@@ -167,8 +157,338 @@ START_TEST (en_decode_2147483647_5bits)
 }
 END_TEST
 
+START_TEST (decode_bounded)
+{
+    ret_t         ret;
+    uint32_t      num      = 0;
+    size_t        consumed = 0;
+    unsigned char tmp[16];
+
+    /* Whatever the readable size */
+    for (size_t size = 3; size <= sizeof(tmp); size++) {
+        memset (tmp, 0xEE, sizeof(tmp));
+        tmp[0] = 0xE0 | 31; tmp[1] = 154; tmp[2] = 10;
+
+        ret = integer_decode_bounded (5, tmp, size, &num, &consumed);
+        ck_assert (ret == ret_OK);
+        ck_assert (num == 1337);
+        ck_assert (consumed == 3);
+    }
+
+    /* Single octet */
+    tmp[0] = 0x80 | 19;
+    ret = integer_decode_bounded (6, tmp, 1, &num, &consumed);
+    ck_assert (ret == ret_OK);
+    ck_assert (num == 19);
+    ck_assert (consumed == 1);
 
-int
+    /* Truncated */
+    tmp[0] = 31; tmp[1] = 154;
+    ck_assert (integer_decode_bounded (5, tmp, 0, &num, &consumed) == ret_eagain);
+    ck_assert (integer_decode_bounded (5, tmp, 1, &num, &consumed) == ret_eagain);
+    ck_assert (integer_decode_bounded (5, tmp, 2, &num, &consumed) == ret_eagain);
+}
+END_TEST
+
+#define BATCH_LEN 300
+
+static const integer_impl_t impls[] = {integer_impl_scalar, integer_impl_sse2, integer_impl_avx2};
+
+/* Long runs of small numbers, with a few larger ones
+ */
+static void
+batch_values (uint32_t *values, unsigned int seed)
+{
+    int i;
+
+    for (i = 0; i < BATCH_LEN; i++) {
+        seed = seed * 1103515245 + 12345;
+        switch ((seed >> 16) % 16) {
+        case 0:
+            values[i] = seed % 20000;
+            break;
+        case 1:
+            values[i] = seed >> 1;
+            break;
+        default:
+            values[i] = (seed >> 8) % 40;
+            break;
+        }
+    }
+}
+
+START_TEST (encode_batch)
+{
+    int           N, i;
+    unsigned int  k;
+    size_t        len;
+    size_t        ref_len;
+    uint32_t      values[BATCH_LEN];
+    unsigned char mem[BATCH_LEN * INTEGER_MAX_LEN];
+    unsigned char ref[BATCH_LEN * INTEGER_MAX_LEN];
+    unsigned char one_len;
+
+    for (N = 1; N <= 8; N++) {
+        batch_values (values, N);
+
+        /* One at a time */
+        ref_len = 0;
+        for (i = 0; i < BATCH_LEN; i++) {
+            ref[ref_len] = 0xA5;
+            integer_encode (N, values[i], &ref[ref_len], &one_len);
+            ref_len += one_len;
+        }
+
+        for (k = 0; k < sizeof(impls) / sizeof(impls[0]); k++) {
+            if (integer_set_impl (impls[k]) != ret_OK)
+                continue;
+
+            ck_assert (integer_encode_batch (N, 0xA5, values, BATCH_LEN, mem, &len) == ret_OK);
+            ck_assert (len == ref_len);
+            ck_assert (memcmp (mem, ref, len) == 0);
+        }
+    }
+
+    integer_set_impl (integer_impl_auto);
+}
+END_TEST
+
+START_TEST (decode_batch)
+{
+    int           N, i;
+    unsigned int  k;
+    ret_t         ret;
+    size_t        len, cut, num, consumed;
+    size_t        ends[BATCH_LEN];
+    uint32_t      values[BATCH_LEN];
+    uint32_t      decoded[BATCH_LEN];
+    unsigned char mem[BATCH_LEN * INTEGER_MAX_LEN];
+    unsigned char one_len;
+
+    for (N = 1; N <= 8; N++) {
+        batch_values (values, 100 + N);
+
+        len = 0;
+        for (i = 0; i < BATCH_LEN; i++) {
+            mem[len] = 0;
+            integer_encode (N, values[i], &mem[len], &one_len);
+            len += one_len;
+            ends[i] = len;
+        }
+
+        for (k = 0; k < sizeof(impls) / sizeof(impls[0]); k++) {
+            if (integer_set_impl (impls[k]) != ret_OK)
+                continue;
+
+            ret = integer_decode_batch (N, mem, len, decoded, BATCH_LEN, &num, &consumed);
+            ck_assert (ret == ret_OK);
+            ck_assert (num == BATCH_LEN);
+            ck_assert (consumed == len);
+            ck_assert (memcmp (decoded, values, sizeof(values)) == 0);
+
+            /* Room for fewer values */
+            ret = integer_decode_batch (N, mem, len, decoded, 37, &num, &consumed);
+            ck_assert ((ret == ret_OK) && (num == 37) && (consumed == ends[36]));
+
+            /* Truncated anywhere */
+            for (cut = 0, i = 0; cut < len; cut++) {
+                while (ends[i] <= cut) i++;
+
+                ret = integer_decode_batch (N, mem, cut, decoded, BATCH_LEN, &num, &consumed);
+                ck_assert (num == (size_t) i);
+                ck_assert (consumed == ((i > 0) ? ends[i-1] : 0));
+                ck_assert (ret == ((consumed == cut) ? ret_OK : ret_eagain));
+            }
+        }
+    }
+
+    integer_set_impl (integer_impl_auto);
+}
+END_TEST
+
+START_TEST (decode_batch_errors)
+{
+    unsigned int  k;
+    size_t        i, num, consumed;
+    uint32_t      decoded[64];
+    unsigned char mem[64];
+    unsigned char over[] = {0xFF, 0x81, 0xFE, 0xFF, 0xFF, 0x0F};
+    unsigned char max[]  = {0xFF, 0x80, 0xFE, 0xFF, 0xFF, 0x0F};
+
+    for (k = 0; k < sizeof(impls) / sizeof(impls[0]); k++) {
+        if (integer_set_impl (impls[k]) != ret_OK)
+            continue;
+
+        /* Largest number, then one past it, after 20 small ones */
+        memset (mem, 7, sizeof(mem));
+        memcpy (mem + 20, max, sizeof(max));
+        memcpy (mem + 26, over, sizeof(over));
+
+        ck_assert (integer_decode_batch (8, mem, sizeof(mem), decoded, 64, &num, &consumed) == ret_ERROR);
+        ck_assert ((num == 21) && (consumed == 26));
+        ck_assert (decoded[20] == UINT32_MAX);
+
+        /* Too many continuation octets */
+        memset (mem, 0x80, sizeof(mem));
+        mem[10] = 0x7F;
+
+        ck_assert (integer_decode_batch (7, mem, sizeof(mem), decoded, 64, &num, &consumed) == ret_ERROR);
+        ck_assert ((num == 10) && (consumed == 10));
+        for (i = 0; i < 10; i++) {
+            ck_assert (decoded[i] == 0);
+        }
+    }
+
+    integer_set_impl (integer_impl_auto);
+}
+END_TEST
+
+START_TEST (specialized)
+{
+    int           N;
+    unsigned int  i;
+    ret_t         ret1, ret2;
+    size_t        len, c1, c2;
+    uint32_t      v1, v2;
+    unsigned char one_len;
+    unsigned char mem[16];
+    unsigned char ref[16];
+    uint32_t      values[] = {0, 1, 14, 15, 16, 30, 31, 32, 62, 63, 64, 126, 127, 128,
+                              254, 255, 256, 1337, 16384, 2097151, 2147483647};
+
+    typedef size_t (*enc_t) (unsigned char, uint32_t, unsigned char *);
+    typedef ret_t  (*dec_t) (const unsigned char *, size_t, uint32_t *, size_t *);
+
+    enc_t enc[] = {integer_encode_4, integer_encode_5, integer_encode_6, integer_encode_7, integer_encode_8};
+    dec_t dec[] = {integer_decode_4, integer_decode_5, integer_decode_6, integer_decode_7, integer_decode_8};
+
+    for (N = 4; N <= 8; N++) {
+        for (i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+            /* Same octets as the generic encoder */
+            memset (ref, 0xC3, sizeof(ref));
+            integer_encode (N, values[i], ref, &one_len);
+
+            len = enc[N-4] (0xC3, values[i], mem);
+            ck_assert (len == one_len);
+            ck_assert (memcmp (mem, ref, len) == 0);
+
+            /* Same results as the generic decoder, truncated or not */
+            for (len = 0; len <= one_len; len++) {
+                ret1 = integer_decode_bounded (N, mem, len, &v1, &c1);
+                ret2 = dec[N-4] (mem, len, &v2, &c2);
+                ck_assert (ret1 == ret2);
+                if (ret1 == ret_OK) {
+                    ck_assert ((v1 == v2) && (c1 == c2));
+                }
+            }
+            ck_assert ((ret2 == ret_OK) && (v2 == values[i]));
+        }
+    }
+
+    /* Numbers past INT_MAX */
+    len = integer_encode_8 (0, UINT32_MAX, mem);
+    ck_assert (len == 6);
+    ck_assert (integer_decode_8 (mem, len, &v2, &c2) == ret_OK);
+    ck_assert ((v2 == UINT32_MAX) && (c2 == 6));
+}
+END_TEST
+
+START_TEST (codec_64)
+{
+    int           N;
+    unsigned int  i;
+    size_t        len, size, consumed;
+    uint64_t      num;
+    unsigned char mem[INTEGER_MAX_LEN_64 + 1];
+    unsigned char ref[8];
+    unsigned char ref_len;
+    uint64_t      values[] = {0, 1, 30, 31, 32, 1337, 2147483647, UINT32_MAX,
+                              (uint64_t)UINT32_MAX + 1, 1ULL << 56, UINT64_MAX - 255, UINT64_MAX};
+
+    for (N = 1; N <= 8; N++) {
+        for (i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+            memset (mem, 0xAB, sizeof(mem));
+            ck_assert (integer_encode_64 (N, 0xE0, values[i], mem, INTEGER_MAX_LEN_64, &len) == ret_OK);
+            ck_assert (len <= INTEGER_MAX_LEN_64);
+            ck_assert (mem[len] == 0xAB);
+
+            /* Same octets as the 32 bits encoder */
+            if (values[i] <= 2147483647) {
+                ref[0] = 0xE0;
+                integer_encode (N, values[i], ref, &ref_len);
+                ck_assert ((len == ref_len) && (memcmp (mem, ref, len) == 0));
+            }
+
+            ck_assert (integer_decode_64 (N, mem, len, &num, &consumed) == ret_OK);
+            ck_assert ((num == values[i]) && (consumed == len));
+
+            /* Short buffers: nothing written, or the input ends early */
+            for (size = 0; size < len; size++) {
+                memset (ref, 0xAB, sizeof(ref));
+                ck_assert (integer_encode_64 (N, 0xE0, values[i], ref, size, &consumed) == ret_eagain);
+                ck_assert (ref[0] == 0xAB);
+                ck_assert (integer_decode_64 (N, mem, size, &num, &consumed) == ret_eagain);
+            }
+        }
+    }
+
+    /* Largest 64 bits number with a 1 bit prefix takes the longest form */
+    ck_assert (integer_encode_64 (1, 0, UINT64_MAX, mem, sizeof(mem), &len) == ret_OK);
+    ck_assert (len == INTEGER_MAX_LEN_64);
+}
+END_TEST
+
+START_TEST (codec_64_limits)
+{
+    uint64_t      num;
+    size_t        consumed;
+    unsigned char max[]   = {0xFF, 0x80, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01};
+    unsigned char over[]  = {0xFF, 0x81, 0xFE, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01};
+    unsigned char wide[]  = {0xFF, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x02};
+    unsigned char extra[] = {0x7F, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00};
+
+    /* 255 + 0xFFFFFFFFFFFFFF00 = 2^64 - 1 */
+    ck_assert (integer_decode_64 (8, max, sizeof(max), &num, &consumed) == ret_OK);
+    ck_assert ((num == UINT64_MAX) && (consumed == sizeof(max)));
+
+    /* 2^64 */
+    ck_assert (integer_decode_64 (8, over, sizeof(over), &num, &consumed) == ret_ERROR);
+
+    /* Bits past the 64th */
+    ck_assert (integer_decode_64 (8, wide, sizeof(wide), &num, &consumed) == ret_ERROR);
+
+    /* Too many continuation octets */
+    ck_assert (integer_decode_64 (7, extra, sizeof(extra), &num, &consumed) == ret_ERROR);
+}
+END_TEST
+
+START_TEST (decode_bounded_limits)
+{
+    size_t        size;
+    uint32_t      num      = 0;
+    size_t        consumed = 0;
+    unsigned char max[16]  = {0xFF, 0x80, 0xFE, 0xFF, 0xFF, 0x0F};
+    unsigned char over[16] = {0xFF, 0x81, 0xFE, 0xFF, 0xFF, 0x0F};
+    unsigned char zero[16] = {0x7F, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00};
+
+    for (size = 6; size <= sizeof(max); size += 10) {
+        /* 255 + 0xFFFFFF00 = 2^32 - 1 */
+        ck_assert (integer_decode_bounded (8, max, size, &num, &consumed) == ret_OK);
+        ck_assert (num == UINT32_MAX);
+        ck_assert (consumed == 6);
+
+        /* 2^32 */
+        ck_assert (integer_decode_bounded (8, over, size, &num, &consumed) == ret_ERROR);
+    }
+
+    /* Too many continuation octets */
+    ck_assert (integer_decode_bounded (7, zero, 7,  &num, &consumed) == ret_ERROR);
+    ck_assert (integer_decode_bounded (7, zero, 16, &num, &consumed) == ret_ERROR);
+}
+END_TEST
+
+
+static int
 encode_tests (void)
 {
     Suite *s1 = suite_create("Encoding");
@@ -178,11 +498,12 @@ encode_tests (void)
     check_add (s1, encode_42_8bits);
     check_add (s1, encode_12_6bits);
     check_add (s1, encode_1338_5bits);
+    check_add (s1, encode_batch);
 
     run_test (s1);
 }
 
-int
+static int
 decode_tests (void)
 {
     Suite *s1 = suite_create("Decoding");
@@ -190,12 +511,19 @@ decode_tests (void)
     check_add (s1, decode_19_6bits);
     check_add (s1, decode_1337_5bits);
     check_add (s1, en_decode_2147483647_5bits);
+    check_add (s1, decode_bounded);
+    check_add (s1, decode_bounded_limits);
+    check_add (s1, decode_batch);
+    check_add (s1, specialized);
+    check_add (s1, codec_64);
+    check_add (s1, codec_64_limits);
+    check_add (s1, decode_batch_errors);
 
     run_test (s1);
 }
 
 int
-main (void)
+integer_tests (void)
 {
     int ret;
 
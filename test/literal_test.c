@@ -0,0 +1,253 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <ctype.h>
+
+#include "test.h"
+#include "libhpack/literal.h"
+#include "libhpack/hash.h"
+
+/* Token characters [RFC 7230, 3.2.6.]
+ */
+static bool
+ref_name_char (unsigned char c, size_t pos)
+{
+    if ((c == ':') && (pos == 0))
+        return true;
+
+    return ((c >= 'a') && (c <= 'z')) || ((c >= '0') && (c <= '9')) ||
+           ((c != 0) && (strchr ("!#$%&'*+-.^_`|~", c) != NULL));
+}
+
+static const hpack_literal_impl_t impls[] = {hpack_literal_impl_scalar, hpack_literal_impl_sse2, hpack_literal_impl_avx2};
+
+static void
+check_name_impl (void)
+{
+    ret_t   ret;
+    cuint_t c, len, pos;
+    char    name[70];
+    char    copy[70];
+    bool    valid;
+
+    /* Valid names, through both the vector blocks and the tail */
+    ck_assert (hpack_literal_check_name (":authority", 10, 0) == ret_ok);
+    ck_assert (hpack_literal_check_name ("x-forwarded-for-0123456789", 26, 0) == ret_ok);
+    ck_assert (hpack_literal_check_name ("access-control-allow-credentials", 32, 0) == ret_ok);
+    ck_assert (hpack_literal_check_name ("x_a.b~c|d^e`f!#$%&'*+", 21, 0) == ret_ok);
+    ck_assert (hpack_literal_check_name ("", 0, 0) == ret_ok);
+
+    /* A colon is only allowed in front of the whole name */
+    ck_assert (hpack_literal_check_name ("path", 4, 1) == ret_ok);
+    ck_assert (hpack_literal_check_name (":path", 5, 1) == ret_error);
+    ck_assert (hpack_literal_check_name ("a:b", 3, 0) == ret_error);
+
+    /* Every octet, at every position of names of several lengths */
+    for (len = 1; len < sizeof(name); len += 7) {
+        for (pos = 0; pos < len; pos++) {
+            for (c = 0; c < 256; c++) {
+                memset (name, 'a', len);
+                name[pos] = (char) c;
+                valid = ref_name_char (c, pos);
+
+                ret = hpack_literal_check_name (name, len, 0);
+                ck_assert (ret == (valid ? ret_ok : ret_error));
+
+                ret = hpack_literal_copy_name (copy, name, len, 0);
+                ck_assert (ret == (valid ? ret_ok : ret_error));
+                if (valid) {
+                    ck_assert (memcmp (copy, name, len) == 0);
+                }
+            }
+        }
+    }
+}
+
+static void
+lower_name_impl (void)
+{
+    ret_t   ret;
+    cuint_t c, len, pos;
+    char    name[70];
+    char    lower[70];
+    bool    valid;
+
+    ret = hpack_literal_lower_name (lower, "Content-Type", 12);
+    ck_assert (ret == ret_ok);
+    ck_assert (memcmp (lower, "content-type", 12) == 0);
+
+    ret = hpack_literal_lower_name (lower, "X-Forwarded-For-Original-Host", 29);
+    ck_assert (ret == ret_ok);
+    ck_assert (memcmp (lower, "x-forwarded-for-original-host", 29) == 0);
+
+    ret = hpack_literal_lower_name (lower, "Bad Name", 8);
+    ck_assert (ret == ret_error);
+
+    for (len = 1; len < sizeof(name); len += 7) {
+        for (pos = 0; pos < len; pos++) {
+            for (c = 0; c < 256; c++) {
+                memset (name, 'A', len);
+                name[pos] = (char) c;
+                valid = ref_name_char (tolower (c), pos);
+
+                ret = hpack_literal_lower_name (lower, name, len);
+                ck_assert (ret == (valid ? ret_ok : ret_error));
+                if (valid) {
+                    ck_assert (lower[pos] == (char) tolower (c));
+                    ck_assert (lower[(pos + 1) % len] == ((len > 1) ? 'a' : (char) tolower (c)));
+                }
+            }
+        }
+    }
+}
+
+static void
+value_impl (void)
+{
+    ret_t   ret;
+    cuint_t c, len, pos;
+    char    value[100];
+    char    copy[100];
+    bool    valid;
+
+    ck_assert (hpack_literal_check_value ("", 0) == ret_ok);
+    ck_assert (hpack_literal_check_value ("text/html; charset=utf-8", 24) == ret_ok);
+    ck_assert (hpack_literal_check_value ("Mozilla/5.0 (X11; Linux x86_64)\t\x7f\xff", 34) == ret_ok);
+    ck_assert (hpack_literal_check_value ("evil\r\nset-cookie: x", 19) == ret_error);
+
+    /* Every octet, at every position, through blocks of 32 and 16
+     * octets and the tail
+     */
+    for (len = 1; len < sizeof(value); len += 9) {
+        for (pos = 0; pos < len; pos++) {
+            for (c = 0; c < 256; c++) {
+                memset (value, 'V', len);
+                value[pos] = (char) c;
+                valid = (c != 0) && (c != '\r') && (c != '\n');
+
+                ret = hpack_literal_check_value (value, len);
+                ck_assert (ret == (valid ? ret_ok : ret_error));
+
+                ret = hpack_literal_copy_value (copy, value, len);
+                ck_assert (ret == (valid ? ret_ok : ret_error));
+                if (valid) {
+                    ck_assert (memcmp (copy, value, len) == 0);
+                }
+            }
+        }
+    }
+}
+
+/* Every kernel the CPU supports gives the same results
+ */
+#define for_each_impl(func)                                           \
+    do {                                                              \
+        cuint_t _k;                                                   \
+        for (_k = 0; _k < sizeof(impls) / sizeof(impls[0]); _k++) {  \
+            if (hpack_literal_set_impl (impls[_k]) != ret_ok)         \
+                continue;                                             \
+            func ();                                                  \
+        }                                                             \
+        hpack_literal_set_impl (hpack_literal_impl_auto);             \
+    } while (0)
+
+START_TEST (check_name)
+{
+    for_each_impl (check_name_impl);
+}
+END_TEST
+
+START_TEST (lower_name)
+{
+    for_each_impl (lower_name_impl);
+}
+END_TEST
+
+START_TEST (value)
+{
+    for_each_impl (value_impl);
+}
+END_TEST
+
+START_TEST (lower_name_hash)
+{
+    ret_t    ret;
+    cuint_t  c, len, pos;
+    uint32_t hash;
+    char     name[40];
+    char     lower[40];
+    char     fused[40];
+
+    hash = HPACK_HASH_INIT;
+    ret = hpack_literal_lower_name_hash (fused, "Content-Type", 12, &hash);
+    ck_assert (ret == ret_ok);
+    ck_assert (memcmp (fused, "content-type", 12) == 0);
+    ck_assert (hash == hpack_hash ("content-type", 12, HPACK_HASH_INIT));
+
+    hash = HPACK_HASH_INIT;
+    ret = hpack_literal_lower_name_hash (fused, "Bad Name", 8, &hash);
+    ck_assert (ret == ret_error);
+
+    /* Same octets and result as lowercasing, then hashing
+     */
+    for (len = 1; len < sizeof(name); len += 5) {
+        for (pos = 0; pos < len; pos++) {
+            for (c = 0; c < 256; c++) {
+                memset (name, 'A', len);
+                name[pos] = (char) c;
+
+                hash = HPACK_HASH_INIT;
+                ret = hpack_literal_lower_name_hash (fused, name, len, &hash);
+                ck_assert (ret == hpack_literal_lower_name (lower, name, len));
+                if (ret == ret_ok) {
+                    ck_assert (memcmp (fused, lower, len) == 0);
+                    ck_assert (hash == hpack_hash (lower, len, HPACK_HASH_INIT));
+                }
+            }
+        }
+    }
+}
+END_TEST
+
+int
+literal_tests (void)
+{
+    Suite *s1 = suite_create("Literals");
+
+    check_add (s1, check_name);
+    check_add (s1, lower_name);
+    check_add (s1, value);
+    check_add (s1, lower_name_hash);
+
+    run_test (s1);
+}
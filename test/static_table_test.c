@@ -0,0 +1,168 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+
+/* All files in libhpack are Copyright (C) 2014 Alvaro Lopez Ortega.
+ *
+ *   Authors:
+ *     * Alvaro Lopez Ortega <alvaro@gnu.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "test.h"
+#include "libhpack/static_table.h"
+#include "libhpack/hash.h"
+
+
+START_TEST (pairs)
+{
+    ret_t          ret;
+    cuint_t        n;
+    cuint_t        index;
+    bool           value_match;
+    chula_buffer_t name;
+    chula_buffer_t value;
+
+    for (n = 1; n <= HPACK_STATIC_TABLE_LEN; n++) {
+        const hpack_static_entry_t *e = &hpack_static_table[n-1];
+
+        chula_buffer_fake (&name, e->name, e->name_len);
+        chula_buffer_fake (&value, e->value, e->value_len);
+
+        ret = hpack_static_table_find (&name, &value, &index, &value_match);
+        ck_assert (ret == ret_ok);
+        ck_assert (index == n);
+        ck_assert (value_match == true);
+    }
+}
+END_TEST
+
+START_TEST (names)
+{
+    ret_t          ret;
+    cuint_t        n;
+    cuint_t        index;
+    bool           value_match;
+    chula_buffer_t name;
+    chula_buffer_t value;
+
+    chula_buffer_fake_str (&value, "not in the table");
+
+    for (n = 1; n <= HPACK_STATIC_TABLE_LEN; n++) {
+        const hpack_static_entry_t *e = &hpack_static_table[n-1];
+
+        chula_buffer_fake (&name, e->name, e->name_len);
+
+        ret = hpack_static_table_find (&name, &value, &index, &value_match);
+        ck_assert (ret == ret_ok);
+        ck_assert (value_match == false);
+
+        /* Lowest index with that name */
+        ck_assert (hpack_static_table[index-1].name_len == e->name_len);
+        ck_assert (memcmp (hpack_static_table[index-1].name, e->name, e->name_len) == 0);
+        ck_assert ((index == 1) ||
+                   (hpack_static_table[index-2].name_len != e->name_len) ||
+                   (memcmp (hpack_static_table[index-2].name, e->name, e->name_len) != 0));
+
+        ret = hpack_static_table_find (&name, NULL, &index, &value_match);
+        ck_assert (ret == ret_ok);
+        ck_assert (value_match == false);
+    }
+
+    chula_buffer_fake_str (&name, ":status");
+    chula_buffer_fake_str (&value, "201");
+    ret = hpack_static_table_find (&name, &value, &index, &value_match);
+    ck_assert (ret == ret_ok);
+    ck_assert (index == 8);
+    ck_assert (value_match == false);
+}
+END_TEST
+
+START_TEST (misses)
+{
+    cuint_t        index;
+    bool           value_match;
+    chula_buffer_t name;
+    chula_buffer_t value = CHULA_BUF_INIT;
+
+    chula_buffer_fake_str (&name, "x-custom");
+    ck_assert (hpack_static_table_find (&name, &value, &index, &value_match) == ret_not_found);
+
+    chula_buffer_fake_str (&name, "Content-Type");
+    ck_assert (hpack_static_table_find (&name, NULL, &index, &value_match) == ret_not_found);
+
+    chula_buffer_fake_str (&name, "");
+    ck_assert (hpack_static_table_find (&name, &value, &index, &value_match) == ret_not_found);
+}
+END_TEST
+
+START_TEST (ids)
+{
+    cuint_t                     n;
+    hpack_header_id_t           id;
+    chula_buffer_t              name;
+    const hpack_static_entry_t *e;
+
+    /* Every entry gets the lowest index with its name, by index and
+     * by name
+     */
+    for (n = 1; n <= HPACK_STATIC_TABLE_LEN; n++) {
+        e  = &hpack_static_table[n - 1];
+        id = hpack_static_table_get_id (n);
+
+        ck_assert (id > hpack_header_id_unknown);
+        ck_assert (id <= n);
+        ck_assert (strcmp (hpack_static_table[id - 1].name, e->name) == 0);
+        ck_assert ((id == 1) || (strcmp (hpack_static_table[id - 2].name, e->name) != 0));
+
+        chula_buffer_fake (&name, e->name, e->name_len);
+        ck_assert (hpack_static_table_find_id (&name, hpack_hash (name.buf, name.len, HPACK_HASH_INIT)) == id);
+    }
+
+    ck_assert (hpack_static_table_get_id (2)  == hpack_header_id_method);
+    ck_assert (hpack_static_table_get_id (14) == hpack_header_id_status);
+    ck_assert (hpack_static_table_get_id (31) == hpack_header_id_content_type);
+    ck_assert (hpack_static_table_get_id (0)  == hpack_header_id_unknown);
+    ck_assert (hpack_static_table_get_id (62) == hpack_header_id_unknown);
+
+    chula_buffer_fake_str (&name, "x-custom");
+    ck_assert (hpack_static_table_find_id (&name, hpack_hash (name.buf, name.len, HPACK_HASH_INIT)) == hpack_header_id_unknown);
+
+    chula_buffer_fake_str (&name, "Cookie");
+    ck_assert (hpack_static_table_find_id (&name, hpack_hash (name.buf, name.len, HPACK_HASH_INIT)) == hpack_header_id_unknown);
+}
+END_TEST
+
+int
+static_table_tests (void)
+{
+    Suite *s1 = suite_create("Static table");
+
+    check_add (s1, pairs);
+    check_add (s1, names);
+    check_add (s1, misses);
+    check_add (s1, ids);
+
+    run_test (s1);
+}